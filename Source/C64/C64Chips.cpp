@@ -48,6 +48,7 @@
 
 #include "CodeAnalyser/CodeAnalyser.h"
 #include "CodeAnalyser/UI/CodeAnalyserUI.h"
+#include "CodeAnalyser/UI/MemorySearchUI.h"
 #include "Util/MemoryBuffer.h"
 #include "Util/FileUtil.h"
 #include "IOAnalysis/C64IOAnalysis.h"
@@ -88,6 +89,7 @@ public:
     void WriteByte(uint16_t address, uint8_t value) override
     {
         mem_wr(&C64Emu.mem_cpu, address, value);
+        InvalidateDecodedInstructions(CodeAnalysis, address);
     }
 
     uint16_t	GetPC(void) override
@@ -128,19 +130,40 @@ public:
     {
     }
 
-     bool	IsAddressBreakpointed(uint16_t addr) override
+    bool	IsAddressBreakpointed(uint16_t addr) override
     {
-        return false;
+        return HasBreakpointAtAddress(CodeAnalysis, addr);
     }
 
     bool	ToggleExecBreakpointAtAddress(uint16_t addr) override
     {
-        return false;
+        const int index = FindBreakpoint(CodeAnalysis, BreakpointType_Exec, addr);
+        if (index != -1)
+        {
+            RemoveBreakpoint(CodeAnalysis, index);
+            return false;
+        }
+
+        AddBreakpoint(CodeAnalysis, BreakpointType_Exec, addr);
+        return true;
     }
 
     bool	ToggleDataBreakpointAtAddress(uint16_t addr, uint16_t dataSize) override
     {
-        return false;
+        const int index = FindBreakpoint(CodeAnalysis, BreakpointType_Write, addr);
+        if (index != -1)
+        {
+            RemoveBreakpoint(CodeAnalysis, index);
+            return false;
+        }
+
+        AddBreakpoint(CodeAnalysis, BreakpointType_Write, addr, dataSize);
+        return true;
+    }
+
+    void*	GetCPUEmulator(void) override
+    {
+        return &C64Emu.cpu;
     }
 
     bool	ShouldExecThisFrame(void) const override { return true; }
@@ -162,6 +185,7 @@ public:
     void ResetCodeAnalysis(void);
     bool SaveCodeAnalysis(const FGameInfo* pGameInfo);
     bool LoadCodeAnalysis(const FGameInfo* pGameInfo);
+    void GetMemorySearchBanks(std::vector<FMemorySearchBank>& outBanks) const;
 
     // Emulator Event Handlers
     void    OnBoot(void);
@@ -191,8 +215,14 @@ private:
     uint8_t             LastMemPort = 0x7;  // Default startup
     uint16_t            LastPC = 0;
 
+    // data accesses that hit a breakpoint bitmap during the current instruction
+    static const int    kMaxBreakpointAccesses = 4;
+    FBreakpointAccess   BreakpointAccesses[kMaxBreakpointAccesses];
+    int                 NoBreakpointAccesses = 0;
+
     FC64IOAnalysis      IOAnalysis;
     FC64GraphicsViewer  GraphicsViewer;
+    FMemorySearchUIState    MemorySearch;
     std::set<uint16_t>  InterruptHandlers;
 
     // Mapping status
@@ -615,6 +645,25 @@ void FC64Emulator::Shutdown()
     c64_discard(&C64Emu);
 }
 
+// All 64K of RAM is one bank, pages with ROM or IO over them are marked as not paged in so hits behind ROM are still found
+void FC64Emulator::GetMemorySearchBanks(std::vector<FMemorySearchBank>& outBanks) const
+{
+    outBanks.clear();
+    mem_t* pMem = const_cast<mem_t*>(&C64Emu.mem_cpu);
+
+    FMemorySearchBank ramBank = { "RAM", C64Emu.ram, sizeof(C64Emu.ram), 0 };
+    for (uint32_t addr = 0; addr < sizeof(C64Emu.ram); addr += kMemorySearchPageSize)
+    {
+        if (mem_readptr(pMem, (uint16_t)addr) != &C64Emu.ram[addr])
+            ramBank.PagedInPages &= ~(1 << (addr / kMemorySearchPageSize));
+    }
+    outBanks.push_back(ramBank);
+
+    outBanks.push_back({ "BASIC", C64Emu.rom_basic, sizeof(C64Emu.rom_basic), bBasicROMMapped ? 0xA000 : -1, true });
+    outBanks.push_back({ "KERNAL", C64Emu.rom_kernal, sizeof(C64Emu.rom_kernal), bKernelROMMapped ? 0xE000 : -1, true });
+    outBanks.push_back({ "CHAR", C64Emu.rom_char, sizeof(C64Emu.rom_char), bCharacterROMMapped ? 0xD000 : -1, true });
+}
+
 void FC64Emulator::Tick()
 {
     const float frameTime = min(1000000.0f / ImGui::GetIO().Framerate, 32000.0f) * 1.0f;// speccyInstance.ExecSpeedScale;
@@ -625,6 +674,7 @@ void FC64Emulator::Tick()
         c64_exec(&C64Emu, max(static_cast<uint32_t>(frameTime), uint32_t(1)));
         ui_c64_after_exec(&C64UI);
     }
+    UpdateStaticAnalysis(CodeAnalysis, kStaticAnalysisFrameBudget);
 
     ui_c64_draw(&C64UI, ExecTime);
     if (ImGui::Begin("C64 Screen"))
@@ -683,6 +733,14 @@ void FC64Emulator::Tick()
     }
     ImGui::End();
 
+    if (ImGui::Begin("Memory Search"))
+    {
+        std::vector<FMemorySearchBank> banks;
+        GetMemorySearchBanks(banks);
+        DrawMemorySearchUI(CodeAnalysis, MemorySearch, banks);
+    }
+    ImGui::End();
+
     if (ImGui::Begin("Games List"))
     {
         GamesList.DrawGameSelect();
@@ -829,6 +887,33 @@ int    FC64Emulator::OnCPUTrap(uint16_t pc, int ticks, uint64_t pins)
         return UI_DBG_BP_BASE_TRAPID;
 
     LastPC = pc;
+
+    // breakpoints - data accesses were recorded in OnCPUTick, exec is checked before the next instruction runs
+    if (NoBreakpointAccesses != 0)
+    {
+        const int hit = RegisterBreakpointAccessHits(CodeAnalysis, BreakpointAccesses, NoBreakpointAccesses);
+        NoBreakpointAccesses = 0;
+        if (hit != -1)
+        {
+            CodeAnalysis.LastHitBreakpoint = hit;
+            return UI_DBG_BP_BASE_TRAPID;
+        }
+    }
+
+    if (CodeAnalysis.IsExecBreakpointed(pc))
+    {
+        FBreakpointContext context;
+        context.pCPUInterface = this;
+        context.Address = pc;
+        context.FrameNo = CodeAnalysis.CurrentFrameNo;
+        const int hit = RegisterBreakpointHit(CodeAnalysis, BreakpointType_Exec, context);
+        if (hit != -1)
+        {
+            CodeAnalysis.LastHitBreakpoint = hit;
+            return UI_DBG_BP_BASE_TRAPID;
+        }
+    }
+
     return 0;
 }
 
@@ -862,6 +947,14 @@ uint64_t FC64Emulator::OnCPUTick(uint64_t pins)
             if (CodeAnalysis.bRegisterDataAccesses)
                 RegisterDataRead(CodeAnalysis, pc, addr);
 
+            if (CodeAnalysis.IsReadBreakpointed(addr) && NoBreakpointAccesses < kMaxBreakpointAccesses)
+            {
+                FBreakpointAccess& access = BreakpointAccesses[NoBreakpointAccesses++];
+                access.Type = BreakpointType_Read;
+                access.Address = addr;
+                access.Value = access.OldValue = ReadByte(addr);
+            }
+
             if (bIOMapped && (addr >> 12) == 0xd)
             {
                 IOAnalysis.RegisterIORead(addr, pc);
@@ -872,6 +965,15 @@ uint64_t FC64Emulator::OnCPUTick(uint64_t pins)
             if (CodeAnalysis.bRegisterDataAccesses)
                 RegisterDataWrite(CodeAnalysis, pc, addr);
 
+            if (CodeAnalysis.IsWriteBreakpointed(addr) && NoBreakpointAccesses < kMaxBreakpointAccesses)
+            {
+                FBreakpointAccess& access = BreakpointAccesses[NoBreakpointAccesses++];
+                access.Type = BreakpointType_Write;
+                access.Address = addr;
+                access.Value = val;
+                access.OldValue = ReadByte(addr);   // memory hasn't been written yet
+            }
+
             CodeAnalysis.SetLastWriterForAddress(addr, pc);
 
             if (bIOMapped && (addr >> 12) == 0xd)
@@ -882,6 +984,7 @@ uint64_t FC64Emulator::OnCPUTick(uint64_t pins)
             FCodeInfo* pCodeWrittenTo = CodeAnalysis.GetCodeInfoForAddress(addr);
             if (pCodeWrittenTo != nullptr && pCodeWrittenTo->bSelfModifyingCode == false)
                 pCodeWrittenTo->bSelfModifyingCode = true;
+            InvalidateDecodedInstructions(CodeAnalysis, addr);
         }
     }
 
@@ -9,4 +9,9 @@ bool CheckPointerRefInstruction6502(ICPUInterface* pCPUInterface, uint16_t pc, u
 bool CheckJumpInstruction6502(ICPUInterface* pCPUInterface, uint16_t pc, uint16_t* out_addr);
 bool CheckCallInstruction6502(ICPUInterface* pCPUInterface, uint16_t pc);
 bool CheckStopInstruction6502(ICPUInterface* pCPUInterface, uint16_t pc);
-bool RegisterCodeExecuted6502(FCodeAnalysisState& state, uint16_t pc, uint16_t nextpc);
\ No newline at end of file
+bool CheckFallThroughInstruction6502(ICPUInterface* pCPUInterface, uint16_t pc);
+bool RegisterCodeExecuted6502(FCodeAnalysisState& state, uint16_t pc, uint16_t nextpc);
+
+// Register lookup for breakpoint conditions
+int			Get6502RegisterId(const char* pName, bool* pIsPointer = nullptr);	// returns -1 if not a register
+uint16_t	Get6502RegisterValue(void* pCPU, int regId);
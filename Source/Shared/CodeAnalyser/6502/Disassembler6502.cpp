@@ -0,0 +1,61 @@
+#include "../Disassembler.h"
+#include "OpcodeTable6502.h"
+
+// Output matches the chips m6502dasm disassembler, undocumented instructions are prefixed with '*'
+
+int Disassemble6502(const uint8_t* pBytes, uint16_t pc, FDasmInstruction& outInstruction)
+{
+	outInstruction = FDasmInstruction();
+
+	const uint8_t op = pBytes[0];
+	const F6502OpcodeInfo& info = GetOpcodeInfo6502(op);
+
+	outInstruction.pMnemonic = info.pMnemonic;
+	outInstruction.ByteSize = info.Length;
+
+	const uint8_t u8 = pBytes[1];
+	const uint16_t u16 = pBytes[1] | (pBytes[2] << 8);
+	FDasmOperand& operand = outInstruction.Operands[0];
+
+	switch (info.AddressMode)
+	{
+	case E6502AddressMode::Immediate:
+		operand = { EDasmOperandKind::Imm8, "#", "", u8 };
+		break;
+	case E6502AddressMode::ZP:
+		operand = { EDasmOperandKind::Imm8, "", "", u8 };
+		break;
+	case E6502AddressMode::ZP_X:
+		operand = { EDasmOperandKind::Imm8, "", ",X", u8 };
+		break;
+	case E6502AddressMode::ZP_Y:
+		operand = { EDasmOperandKind::Imm8, "", ",Y", u8 };
+		break;
+	case E6502AddressMode::Absolute:
+		operand = { EDasmOperandKind::Address, "", "", u16 };
+		break;
+	case E6502AddressMode::Indirect:
+		operand = { EDasmOperandKind::Address, "(", ")", u16 };
+		break;
+	case E6502AddressMode::Absolute_X:
+		operand = { EDasmOperandKind::Address, "", ",X", u16 };
+		break;
+	case E6502AddressMode::Absolute_Y:
+		operand = { EDasmOperandKind::Address, "", ",Y", u16 };
+		break;
+	case E6502AddressMode::ZPIndirect_X:
+		operand = { EDasmOperandKind::Imm8, "(", ",X)", u8 };
+		break;
+	case E6502AddressMode::ZPIndirect_Y:
+		operand = { EDasmOperandKind::Imm8, "(", "),Y", u8 };
+		break;
+	case E6502AddressMode::Relative:
+		operand = { EDasmOperandKind::Address, "", "", (uint16_t)(pc + 2 + (int8_t)u8) };
+		break;
+	default:
+		return outInstruction.ByteSize;
+	}
+
+	outInstruction.NoOperands = 1;
+	return outInstruction.ByteSize;
+}
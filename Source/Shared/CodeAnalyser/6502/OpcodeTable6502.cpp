@@ -0,0 +1,286 @@
+#include "OpcodeTable6502.h"
+
+#include <array>
+
+// 6502 opcode metadata table, generated at compile time
+// opcodes are split into aaa/bbb/cc fields - mnemonics & addressing modes match the chips m6502dasm disassembler
+
+typedef E6502AddressMode EMode;
+
+static constexpr EMode M_IMP = EMode::Implied;
+static constexpr EMode M_IMM = EMode::Immediate;
+static constexpr EMode M_ZER = EMode::ZP;
+static constexpr EMode M_ZPX = EMode::ZP_X;
+static constexpr EMode M_ZPY = EMode::ZP_Y;
+static constexpr EMode M_ABS = EMode::Absolute;
+static constexpr EMode M_ABX = EMode::Absolute_X;
+static constexpr EMode M_ABY = EMode::Absolute_Y;
+static constexpr EMode M_IDX = EMode::ZPIndirect_X;
+static constexpr EMode M_IDY = EMode::ZPIndirect_Y;
+static constexpr EMode M_BRA = EMode::Relative;
+static constexpr EMode M_INV = EMode::Invalid;
+
+// indexed by [cc][bbb][aaa]
+static constexpr EMode g_AddressModes[4][8][8] =
+{
+	// cc = 00
+	{
+		//---  BIT    JMP    JMP()  STY    LDY    CPY    CPX
+		{M_IMP, M_ABS, M_IMP, M_IMP, M_IMM, M_IMM, M_IMM, M_IMM},
+		{M_ZER, M_ZER, M_ZER, M_ZER, M_ZER, M_ZER, M_ZER, M_ZER},
+		{M_IMP, M_IMP, M_IMP, M_IMP, M_IMP, M_IMP, M_IMP, M_IMP},
+		{M_ABS, M_ABS, M_ABS, M_ABS, M_ABS, M_ABS, M_ABS, M_ABS},
+		{M_BRA, M_BRA, M_BRA, M_BRA, M_BRA, M_BRA, M_BRA, M_BRA},
+		{M_ZPX, M_ZPX, M_ZPX, M_ZPX, M_ZPX, M_ZPX, M_ZPX, M_ZPX},
+		{M_IMP, M_IMP, M_IMP, M_IMP, M_IMP, M_IMP, M_IMP, M_IMP},
+		{M_ABX, M_ABX, M_ABS, M_ABS, M_INV, M_ABX, M_ABX, M_ABX}
+	},
+	// cc = 01
+	{
+		//ORA  AND    EOR    ADC    STA    LDA    CMP    SBC
+		{M_IDX, M_IDX, M_IDX, M_IDX, M_IDX, M_IDX, M_IDX, M_IDX},
+		{M_ZER, M_ZER, M_ZER, M_ZER, M_ZER, M_ZER, M_ZER, M_ZER},
+		{M_IMM, M_IMM, M_IMM, M_IMM, M_IMM, M_IMM, M_IMM, M_IMM},
+		{M_ABS, M_ABS, M_ABS, M_ABS, M_ABS, M_ABS, M_ABS, M_ABS},
+		{M_IDY, M_IDY, M_IDY, M_IDY, M_IDY, M_IDY, M_IDY, M_IDY},
+		{M_ZPX, M_ZPX, M_ZPX, M_ZPX, M_ZPX, M_ZPX, M_ZPX, M_ZPX},
+		{M_ABY, M_ABY, M_ABY, M_ABY, M_ABY, M_ABY, M_ABY, M_ABY},
+		{M_ABX, M_ABX, M_ABX, M_ABX, M_ABX, M_ABX, M_ABX, M_ABX},
+	},
+	// cc = 02
+	{
+		//ASL  ROL    LSR    ROR    STX    LDX    DEC    INC
+		{M_INV, M_INV, M_INV, M_INV, M_IMM, M_IMM, M_IMM, M_IMM},
+		{M_ZER, M_ZER, M_ZER, M_ZER, M_ZER, M_ZER, M_ZER, M_ZER},
+		{M_IMP, M_IMP, M_IMP, M_IMP, M_IMP, M_IMP, M_IMP, M_IMP},
+		{M_ABS, M_ABS, M_ABS, M_ABS, M_ABS, M_ABS, M_ABS, M_ABS},
+		{M_INV, M_INV, M_INV, M_INV, M_INV, M_INV, M_INV, M_INV},
+		{M_ZPX, M_ZPX, M_ZPX, M_ZPX, M_ZPY, M_ZPY, M_ZPX, M_ZPX},
+		{M_IMP, M_IMP, M_IMP, M_IMP, M_IMP, M_IMP, M_IMP, M_IMP},
+		{M_ABX, M_ABX, M_ABX, M_ABX, M_INV, M_ABY, M_ABX, M_ABX},
+	},
+	// cc = 03
+	{
+		{M_IDX, M_IDX, M_IDX, M_IDX, M_IDX, M_IDX, M_IDX, M_IDX},
+		{M_ZER, M_ZER, M_ZER, M_ZER, M_ZER, M_ZER, M_ZER, M_ZER},
+		{M_INV, M_INV, M_INV, M_INV, M_INV, M_INV, M_INV, M_IMM},
+		{M_ABS, M_ABS, M_ABS, M_ABS, M_ABS, M_ABS, M_ABS, M_ABS},
+		{M_IDY, M_IDY, M_IDY, M_IDY, M_INV, M_IDY, M_IDY, M_IDY},
+		{M_ZPX, M_ZPX, M_ZPX, M_ZPX, M_ZPY, M_ZPY, M_ZPX, M_ZPX},
+		{M_ABY, M_ABY, M_ABY, M_ABY, M_INV, M_INV, M_ABY, M_ABY},
+		{M_ABX, M_ABX, M_ABX, M_ABX, M_INV, M_ABY, M_ABX, M_ABX}
+	}
+};
+
+// indexed by [cc][aaa][bbb]
+static constexpr const char* g_Mnemonics[4][8][8] =
+{
+	// cc = 00
+	{
+		{ "BRK", "*NOP", "PHP", "*NOP", "BPL", "*NOP", "CLC", "*NOP" },
+		{ "JSR", "BIT", "PLP", "BIT", "BMI", "*NOP", "SEC", "*NOP" },
+		{ "RTI", "*NOP", "PHA", "JMP", "BVC", "*NOP", "CLI", "*NOP" },
+		{ "RTS", "*NOP", "PLA", "JMP", "BVS", "*NOP", "SEI", "*NOP" },
+		{ "*NOP", "STY", "DEY", "STY", "BCC", "STY", "TYA", "STY" },
+		{ "LDY", "LDY", "TAY", "LDY", "BCS", "LDY", "CLV", "LDY" },
+		{ "CPY", "CPY", "INY", "CPY", "BNE", "*NOP", "CLD", "*NOP" },
+		{ "CPX", "CPX", "INX", "CPX", "BEQ", "*NOP", "SED", "*NOP" },
+	},
+	// cc = 01
+	{
+		{ "ORA", "ORA", "ORA", "ORA", "ORA", "ORA", "ORA", "ORA" },
+		{ "AND", "AND", "AND", "AND", "AND", "AND", "AND", "AND" },
+		{ "EOR", "EOR", "EOR", "EOR", "EOR", "EOR", "EOR", "EOR" },
+		{ "ADC", "ADC", "ADC", "ADC", "ADC", "ADC", "ADC", "ADC" },
+		{ "STA", "STA", "*NOP", "STA", "STA", "STA", "STA", "STA" },
+		{ "LDA", "LDA", "LDA", "LDA", "LDA", "LDA", "LDA", "LDA" },
+		{ "CMP", "CMP", "CMP", "CMP", "CMP", "CMP", "CMP", "CMP" },
+		{ "SBC", "SBC", "SBC", "SBC", "SBC", "SBC", "SBC", "SBC" },
+	},
+	// cc = 02
+	{
+		{ "ASL", "ASL", "ASL", "ASL", "ASL", "ASL", "*NOP", "ASL" },
+		{ "ROL", "ROL", "ROL", "ROL", "ROL", "ROL", "*NOP", "ROL" },
+		{ "LSR", "LSR", "LSR", "LSR", "LSR", "LSR", "*NOP", "LSR" },
+		{ "ROR", "ROR", "ROR", "ROR", "ROR", "ROR", "*NOP", "ROR" },
+		{ "*NOP", "STX", "TXA", "STX", "STX", "STX", "TXS", "STX" },
+		{ "LDX", "LDX", "TAX", "LDX", "LDX", "LDX", "TSX", "LDX" },
+		{ "*NOP", "DEC", "DEX", "DEC", "DEC", "DEC", "*NOP", "DEC" },
+		{ "*NOP", "INC", "NOP", "INC", "INC", "INC", "*NOP", "INC" },
+	},
+	// cc = 03
+	{
+		{ "*SLO", "*SLO", "*SLO", "*SLO", "*SLO", "*SLO", "*SLO", "*SLO" },
+		{ "*RLA", "*RLA", "*RLA", "*RLA", "*RLA", "*RLA", "*RLA", "*RLA" },
+		{ "*SRE", "*SRE", "*SRE", "*SRE", "*SRE", "*SRE", "*SRE", "*SRE" },
+		{ "*RRA", "*RRA", "*RRA", "*RRA", "*RRA", "*RRA", "*RRA", "*RRA" },
+		{ "*SAX", "*SAX", "*SAX", "*SAX", "*SAX", "*SAX", "*SAX", "*SAX" },
+		{ "*LAX", "*LAX", "*LAX", "*LAX", "*LAX", "*LAX", "*LAX", "*LAX" },
+		{ "*DCP", "*DCP", "*DCP", "*DCP", "*DCP", "*DCP", "*DCP", "*DCP" },
+		{ "*ISB", "*ISB", "*SBC", "*ISB", "*ISB", "*ISB", "*ISB", "*ISB" },
+	},
+};
+
+// base cycle counts
+static constexpr uint8_t g_Cycles[256] =
+{
+	//0 1 2 3 4 5 6 7 8 9 A B C D E F
+	7,6,2,8,3,3,5,5,3,2,2,2,4,4,6,6,	// 0x00
+	2,5,2,8,4,4,6,6,2,4,2,7,4,4,7,7,	// 0x10
+	6,6,2,8,3,3,5,5,4,2,2,2,4,4,6,6,	// 0x20
+	2,5,2,8,4,4,6,6,2,4,2,7,4,4,7,7,	// 0x30
+	6,6,2,8,3,3,5,5,3,2,2,2,3,4,6,6,	// 0x40
+	2,5,2,8,4,4,6,6,2,4,2,7,4,4,7,7,	// 0x50
+	6,6,2,8,3,3,5,5,4,2,2,2,5,4,6,6,	// 0x60
+	2,5,2,8,4,4,6,6,2,4,2,7,4,4,7,7,	// 0x70
+	2,6,2,6,3,3,3,3,2,2,2,2,4,4,4,4,	// 0x80
+	2,6,2,6,4,4,4,4,2,5,2,5,5,5,5,5,	// 0x90
+	2,6,2,6,3,3,3,3,2,2,2,2,4,4,4,4,	// 0xA0
+	2,5,2,5,4,4,4,4,2,4,2,4,4,4,4,4,	// 0xB0
+	2,6,2,8,3,3,5,5,2,2,2,2,4,4,6,6,	// 0xC0
+	2,5,2,8,4,4,6,6,2,4,2,7,4,4,7,7,	// 0xD0
+	2,6,2,8,3,3,5,5,2,2,2,2,4,4,6,6,	// 0xE0
+	2,5,2,8,4,4,6,6,2,4,2,7,4,4,7,7,	// 0xF0
+};
+
+// registers used by each instruction, excluding index registers used for addressing
+struct F6502MnemonicRegs
+{
+	const char*	pMnemonic;
+	uint8_t		RegsRead;
+	uint8_t		RegsWritten;
+};
+
+namespace
+{
+	using namespace M6502Reg;
+
+	constexpr F6502MnemonicRegs g_MnemonicRegs[] =
+	{
+		{ "ADC", A | P, A | P },	{ "AND", A, A | P },		{ "ASL", 0, P },			{ "BCC", P, 0 },
+		{ "BCS", P, 0 },			{ "BEQ", P, 0 },			{ "BIT", A, P },			{ "BMI", P, 0 },
+		{ "BNE", P, 0 },			{ "BPL", P, 0 },			{ "BRK", S | P, S | P },	{ "BVC", P, 0 },
+		{ "BVS", P, 0 },			{ "CLC", 0, P },			{ "CLD", 0, P },			{ "CLI", 0, P },
+		{ "CLV", 0, P },			{ "CMP", A, P },			{ "CPX", X, P },			{ "CPY", Y, P },
+		{ "DEC", 0, P },			{ "DEX", X, X | P },		{ "DEY", Y, Y | P },		{ "EOR", A, A | P },
+		{ "INC", 0, P },			{ "INX", X, X | P },		{ "INY", Y, Y | P },		{ "JMP", 0, 0 },
+		{ "JSR", S, S },			{ "LDA", 0, A | P },		{ "LDX", 0, X | P },		{ "LDY", 0, Y | P },
+		{ "LSR", 0, P },			{ "NOP", 0, 0 },			{ "ORA", A, A | P },		{ "PHA", A | S, S },
+		{ "PHP", P | S, S },		{ "PLA", S, A | S | P },	{ "PLP", S, S | P },		{ "ROL", P, P },
+		{ "ROR", P, P },			{ "RTI", S, S | P },		{ "RTS", S, S },			{ "SBC", A | P, A | P },
+		{ "SEC", 0, P },			{ "SED", 0, P },			{ "SEI", 0, P },			{ "STA", A, 0 },
+		{ "STX", X, 0 },			{ "STY", Y, 0 },			{ "TAX", A, X | P },		{ "TAY", A, Y | P },
+		{ "TSX", S, X | P },		{ "TXA", X, A | P },		{ "TXS", X, S },			{ "TYA", Y, A | P },
+		// undocumented
+		{ "*NOP", 0, 0 },			{ "*SLO", A, A | P },		{ "*RLA", A | P, A | P },	{ "*SRE", A, A | P },
+		{ "*RRA", A | P, A | P },	{ "*SAX", A | X, 0 },		{ "*LAX", 0, A | X | P },	{ "*DCP", A, P },
+		{ "*ISB", A | P, A | P },	{ "*SBC", A | P, A | P },
+	};
+}
+
+constexpr bool MnemonicEquals(const char* pA, const char* pB)
+{
+	while (*pA != 0 && *pA == *pB)
+	{
+		pA++;
+		pB++;
+	}
+	return *pA == *pB;
+}
+
+constexpr F6502OpcodeInfo Make6502OpcodeInfo(int op)
+{
+	const int cc = op & 0x03;
+	const int bbb = (op >> 2) & 0x07;
+	const int aaa = (op >> 5) & 0x07;
+
+	F6502OpcodeInfo info;
+	info.pMnemonic = g_Mnemonics[cc][aaa][bbb];
+	info.AddressMode = g_AddressModes[cc][bbb][aaa];
+	info.Cycles = g_Cycles[op];
+
+	// shifts & rotates without an operand use the accumulator
+	if (cc == 2 && bbb == 2 && aaa < 4)
+		info.AddressMode = EMode::Accumulator;
+
+	switch (op)
+	{
+	case 0x00: info.Flow = E6502Flow::Break; break;
+	case 0x20: info.Flow = E6502Flow::Call; break;
+	case 0x40:
+	case 0x60: info.Flow = E6502Flow::Return; break;
+	case 0x4C: info.Flow = E6502Flow::Jump; break;
+	case 0x6C: info.Flow = E6502Flow::JumpIndirect; info.AddressMode = EMode::Indirect; break;
+	default:
+		if (info.AddressMode == EMode::Relative)
+			info.Flow = E6502Flow::Branch;
+		break;
+	}
+
+	switch (info.AddressMode)
+	{
+	case EMode::Immediate:
+	case EMode::ZP:
+	case EMode::ZP_X:
+	case EMode::ZP_Y:
+	case EMode::ZPIndirect_X:
+	case EMode::ZPIndirect_Y:
+	case EMode::Relative:
+		info.Length = 2;
+		break;
+	case EMode::Absolute:
+	case EMode::Absolute_X:
+	case EMode::Absolute_Y:
+	case EMode::Indirect:
+		info.Length = 3;
+		break;
+	default:
+		info.Length = 1;
+		break;
+	}
+
+	for (const F6502MnemonicRegs& mnemonicRegs : g_MnemonicRegs)
+	{
+		if (MnemonicEquals(mnemonicRegs.pMnemonic, info.pMnemonic))
+		{
+			info.RegsRead = mnemonicRegs.RegsRead;
+			info.RegsWritten = mnemonicRegs.RegsWritten;
+			break;
+		}
+	}
+
+	if (info.AddressMode == EMode::Accumulator)
+	{
+		info.RegsRead |= M6502Reg::A;
+		info.RegsWritten |= M6502Reg::A;
+	}
+	else if (info.AddressMode == EMode::ZP_X || info.AddressMode == EMode::Absolute_X || info.AddressMode == EMode::ZPIndirect_X)
+	{
+		info.RegsRead |= M6502Reg::X;
+	}
+	else if (info.AddressMode == EMode::ZP_Y || info.AddressMode == EMode::Absolute_Y || info.AddressMode == EMode::ZPIndirect_Y)
+	{
+		info.RegsRead |= M6502Reg::Y;
+	}
+
+	return info;
+}
+
+constexpr std::array<F6502OpcodeInfo, 256> Make6502OpcodeTable()
+{
+	std::array<F6502OpcodeInfo, 256> table = {};
+	for (int op = 0; op < 256; op++)
+		table[op] = Make6502OpcodeInfo(op);
+	return table;
+}
+
+static constexpr std::array<F6502OpcodeInfo, 256> g_OpcodeTable = Make6502OpcodeTable();
+
+static_assert(g_OpcodeTable[0x20].Length == 3 && g_OpcodeTable[0x20].Flow == E6502Flow::Call, "JSR");
+static_assert(g_OpcodeTable[0x6C].AddressMode == E6502AddressMode::Indirect, "JMP (addr)");
+static_assert(g_OpcodeTable[0xB6].RegsRead == M6502Reg::Y && g_OpcodeTable[0xB6].RegsWritten == (M6502Reg::X | M6502Reg::P), "LDX zp,Y");
+
+const F6502OpcodeInfo& GetOpcodeInfo6502(uint8_t opcode)
+{
+	return g_OpcodeTable[opcode];
+}
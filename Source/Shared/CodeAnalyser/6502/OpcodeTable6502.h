@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+
+// register bits
+namespace M6502Reg
+{
+	const uint8_t	A = 0x01;
+	const uint8_t	X = 0x02;
+	const uint8_t	Y = 0x04;
+	const uint8_t	S = 0x08;
+	const uint8_t	P = 0x10;
+}
+
+enum class E6502AddressMode : uint8_t
+{
+	Implied,
+	Accumulator,
+	Immediate,
+	ZP,
+	ZP_X,
+	ZP_Y,
+	Absolute,
+	Absolute_X,
+	Absolute_Y,
+	ZPIndirect_X,
+	ZPIndirect_Y,
+	Indirect,		// JMP (addr)
+	Relative,		// branches
+	Invalid,
+};
+
+// how an instruction affects the flow of execution
+enum class E6502Flow : uint8_t
+{
+	None,		// carries on to the next instruction
+	Branch,		// conditional relative branch
+	Jump,		// JMP addr
+	JumpIndirect,	// JMP (addr)
+	Call,		// JSR
+	Return,		// RTS & RTI
+	Break,		// BRK
+};
+
+struct F6502OpcodeInfo
+{
+	const char*			pMnemonic = "";		// undocumented instructions are prefixed with '*'
+	uint8_t				Length = 1;
+	E6502AddressMode	AddressMode = E6502AddressMode::Implied;
+	E6502Flow			Flow = E6502Flow::None;
+	uint8_t				Cycles = 2;			// base cycles - branches & indexed reads can take longer
+	uint8_t				RegsRead = 0;		// M6502Reg bits
+	uint8_t				RegsWritten = 0;
+};
+
+const F6502OpcodeInfo&	GetOpcodeInfo6502(uint8_t opcode);
@@ -0,0 +1,141 @@
+#include "AnalysisSnapshot.h"
+
+#include <cstring>
+#include <unordered_map>
+
+// CPU interface for a snapshot - memory is read from the copy, there's nothing to run or debug
+class FSnapshotCPUInterface : public ICPUInterface
+{
+public:
+	uint8_t		ReadByte(uint16_t address) const override { return Memory[address]; }
+	uint16_t	ReadWord(uint16_t address) const override { return Memory[address] | (Memory[(uint16_t)(address + 1)] << 8); }
+	const uint8_t*	GetMemPtr(uint16_t address) const override { return &Memory[address]; }
+	void		WriteByte(uint16_t address, uint8_t value) override {}
+	uint16_t	GetPC(void) override { return PC; }
+	uint16_t	GetSP(void) override { return SP; }
+
+	bool	IsAddressBreakpointed(uint16_t addr) override { return false; }
+	bool	ToggleExecBreakpointAtAddress(uint16_t addr) override { return false; }
+	bool	ToggleDataBreakpointAtAddress(uint16_t addr, uint16_t dataSize) override { return false; }
+
+	void	Break() override {}
+	void	Continue() override {}
+	void	StepOver() override {}
+	void	StepInto() override {}
+	void	StepFrame() override {}
+	void	StepScreenWrite() override {}
+	void	GraphicsViewerSetView(uint16_t address, int charWidth) override {}
+
+	bool	ShouldExecThisFrame(void) const override { return false; }
+	bool	IsStopped(void) const override { return true; }
+
+	uint8_t		Memory[FCodeAnalysisState::kAddressSize];
+	uint16_t	PC = 0;
+	uint16_t	SP = 0;
+};
+
+FAnalysisSnapshot::~FAnalysisSnapshot()
+{
+	for (FLabelInfo* pLabel : Labels)
+		delete pLabel;
+	for (FCodeInfo* pCodeInfo : CodeInfo)
+		delete pCodeInfo;
+	for (FCommentBlock* pCommentBlock : CommentBlocks)
+		delete pCommentBlock;
+	for (FCodeAnalysisPage* pPage : Pages)
+		delete pPage;
+}
+
+FAnalysisSnapshot* CreateAnalysisSnapshot(FCodeAnalysisState& state, const uint8_t* const pMemoryPages[])
+{
+	FAnalysisSnapshot* pSnapshot = new FAnalysisSnapshot;
+	FCodeAnalysisState& snapshotState = pSnapshot->State;
+
+	FSnapshotCPUInterface* pCPUInterface = new FSnapshotCPUInterface;
+	pCPUInterface->CPUType = state.CPUInterface->CPUType;
+	pCPUInterface->PC = state.CPUInterface->GetPC();
+	pCPUInterface->SP = state.CPUInterface->GetSP();
+	for (int pageNo = 0; pageNo < FCodeAnalysisState::kAddressSize / FCodeAnalysisPage::kPageSize; pageNo++)
+		memcpy(&pCPUInterface->Memory[pageNo * FCodeAnalysisPage::kPageSize], pMemoryPages[pageNo], FCodeAnalysisPage::kPageSize);
+	pSnapshot->CPUInterface.reset(pCPUInterface);
+	snapshotState.CPUInterface = pCPUInterface;
+
+	// pages can be mapped in more than once and multi-byte instructions share code info
+	std::unordered_map<const FCodeAnalysisPage*, FCodeAnalysisPage*> pageCopies;
+	std::unordered_map<const FCodeInfo*, FCodeInfo*> codeInfoCopies;
+
+	auto copyPage = [&](const FCodeAnalysisPage* pPage) -> FCodeAnalysisPage*
+	{
+		if (pPage == nullptr)
+			return nullptr;
+		auto pageIt = pageCopies.find(pPage);
+		if (pageIt != pageCopies.end())
+			return pageIt->second;
+
+		FCodeAnalysisPage* pCopy = new FCodeAnalysisPage(*pPage);
+		pSnapshot->Pages.push_back(pCopy);
+		pageCopies[pPage] = pCopy;
+
+		for (int i = 0; i < FCodeAnalysisPage::kPageSize; i++)
+		{
+			if (pCopy->Labels[i] != nullptr)
+			{
+				pCopy->Labels[i] = new FLabelInfo(*pCopy->Labels[i]);
+				pSnapshot->Labels.push_back(pCopy->Labels[i]);
+				snapshotState.EnsureUniqueLabelName(pCopy->Labels[i]->Name);	// register the name so new labels don't clash
+			}
+
+			if (pCopy->CodeInfo[i] != nullptr)
+			{
+				FCodeInfo*& pCodeInfoCopy = codeInfoCopies[pCopy->CodeInfo[i]];
+				if (pCodeInfoCopy == nullptr)
+				{
+					pCodeInfoCopy = new FCodeInfo(*pCopy->CodeInfo[i]);
+					pSnapshot->CodeInfo.push_back(pCodeInfoCopy);
+				}
+				pCopy->CodeInfo[i] = pCodeInfoCopy;
+			}
+
+			if (pCopy->CommentBlocks[i] != nullptr)
+			{
+				pCopy->CommentBlocks[i] = new FCommentBlock(*pCopy->CommentBlocks[i]);
+				pSnapshot->CommentBlocks.push_back(pCopy->CommentBlocks[i]);
+			}
+
+			// owned by the live state & not saved
+			if (pCopy->DataInfo[i].DataType == EDataType::Image)
+				pCopy->DataInfo[i].ImageData = nullptr;
+			pCopy->MachineState[i] = nullptr;
+		}
+
+		return pCopy;
+	};
+
+	for (int pageNo = 0; pageNo < FCodeAnalysisState::kAddressSize / FCodeAnalysisPage::kPageSize; pageNo++)
+	{
+		snapshotState.ReadPageTable[pageNo] = copyPage(state.ReadPageTable[pageNo]);
+		snapshotState.WritePageTable[pageNo] = copyPage(state.WritePageTable[pageNo]);
+	}
+
+	snapshotState.CurrentFrameNo = state.CurrentFrameNo;
+	snapshotState.Watches = state.Watches;
+	snapshotState.StackMin = state.StackMin;
+	snapshotState.StackMax = state.StackMax;
+	snapshotState.Config = state.Config;
+	snapshotState.bRegisterDataAccesses = false;
+	snapshotState.SetCodeAnalysisDirty();
+
+	GetCharacterSetParams(pSnapshot->CharacterSets);
+	GetCharacterMapParams(pSnapshot->CharacterMaps);
+	pSnapshot->NumberMode = GetNumberDisplayMode();
+
+	return pSnapshot;
+}
+
+void FreeSnapshotThreadItems()
+{
+	FLabelInfo::FreeAll();
+	FCodeInfo::FreeAll();
+	FCommentBlock::FreeAll();
+	FCommentLine::FreeAll();
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "CodeAnalyser.h"
+#include "Util/GraphicsView.h"
+
+// Copy of the analysis taken on the emulator thread so it can be saved or exported on a worker thread
+// The pages mapped into the address space are copied along with their labels, code info & comment blocks
+// This is a full copy rather than copy-on-write page sharing - every page the game runs in has its LastFrameRead/Written
+// updated each frame, so nearly all the pages would be copied on the next frame anyway, and the analysis is written through
+// raw page & item pointers all over the code which would each need a write barrier.
+// and the memory is copied into a flat 64K buffer. Anything the worker adds to the snapshot (e.g. labels from
+// export passes) is allocated from the worker's own item lists - call FreeSnapshotThreadItems when done.
+struct FAnalysisSnapshot
+{
+	FAnalysisSnapshot() = default;
+	FAnalysisSnapshot(const FAnalysisSnapshot&) = delete;
+	FAnalysisSnapshot& operator=(const FAnalysisSnapshot&) = delete;
+	~FAnalysisSnapshot();
+
+	FCodeAnalysisState					State;			// page tables point at the copied pages
+	std::vector<FCharSetCreateParams>	CharacterSets;	// the registries are per thread so are copied over
+	std::vector<FCharMapCreateParams>	CharacterMaps;
+	ENumberDisplayMode					NumberMode = ENumberDisplayMode::HexAitch;
+
+private:
+	friend FAnalysisSnapshot* CreateAnalysisSnapshot(FCodeAnalysisState& state, const uint8_t* const pMemoryPages[]);
+
+	std::unique_ptr<ICPUInterface>		CPUInterface;	// reads from the memory copy
+	std::vector<FCodeAnalysisPage*>		Pages;
+	std::vector<FLabelInfo*>			Labels;
+	std::vector<FCodeInfo*>				CodeInfo;
+	std::vector<FCommentBlock*>			CommentBlocks;
+};
+
+// Must be called on the thread that owns the state
+// pMemoryPages has a pointer to the CPU visible memory for each FCodeAnalysisPage::kPageSize page of the address space
+// Takes 5-12ms after 30 seconds of play (SpectrumAnalyserHeadless -benchmark <game>), most of it copying DataInfo reference sets,
+// so autosave takes it in place of emulating a frame
+FAnalysisSnapshot* CreateAnalysisSnapshot(FCodeAnalysisState& state, const uint8_t* const pMemoryPages[]);
+
+// Free items allocated on the calling thread while exporting from a snapshot
+void FreeSnapshotThreadItems();
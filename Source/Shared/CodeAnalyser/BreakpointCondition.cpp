@@ -0,0 +1,433 @@
+#include "BreakpointCondition.h"
+#include "CodeAnalyser.h"
+#include "Z80/CodeAnalyserZ80.h"
+#include "6502/CodeAnalyser6502.h"
+
+#include <cctype>
+#include <cstring>
+
+// Recursive descent parser which emits postfix ops, precedence follows C
+struct FConditionParser
+{
+	const char*				pCur = nullptr;
+	ECPUType				CPUType = ECPUType::Unknown;
+	FBreakpointCondition*	pCondition = nullptr;
+	int						StackDepth = 0;
+	std::string				Error;
+
+	bool	HasError() const { return Error.empty() == false; }
+
+	void	SetError(const char* pMessage)
+	{
+		if (HasError() == false)
+			Error = pMessage;
+	}
+
+	void	SkipWhitespace()
+	{
+		while (*pCur == ' ' || *pCur == '\t')
+			pCur++;
+	}
+
+	// match a token - single char tokens won't match the start of a longer one e.g. '&' in "&&"
+	bool	Match(const char* pToken)
+	{
+		SkipWhitespace();
+		const size_t len = strlen(pToken);
+		if (strncmp(pCur, pToken, len) != 0)
+			return false;
+		if (len == 1 && (pToken[0] == '&' || pToken[0] == '|' || pToken[0] == '<' || pToken[0] == '>' || pToken[0] == '=') && pCur[1] == pToken[0])
+			return false;
+		if (len == 1 && (pToken[0] == '<' || pToken[0] == '>' || pToken[0] == '!') && pCur[1] == '=')
+			return false;
+		pCur += len;
+		return true;
+	}
+
+	void	Emit(EBreakpointConditionOp op, int32_t value = 0)
+	{
+		if (pCondition->NoOps == FBreakpointCondition::kMaxOps)
+		{
+			SetError("Expression too long");
+			return;
+		}
+
+		// track stack usage so evaluation never overflows
+		if (op <= EBreakpointConditionOp::FrameNo)
+			StackDepth++;
+		else if (op >= EBreakpointConditionOp::Add)
+			StackDepth--;
+		if (StackDepth > FBreakpointCondition::kMaxStackDepth)
+			SetError("Expression too complex");
+
+		FBreakpointConditionOp& newOp = pCondition->Ops[pCondition->NoOps++];
+		newOp.Op = op;
+		newOp.Value = value;
+	}
+
+	int		GetRegisterId(const char* pName, bool* pIsPointer) const
+	{
+		if (CPUType == ECPUType::Z80)
+			return GetZ80RegisterId(pName, pIsPointer);
+		if (CPUType == ECPUType::M6502)
+			return Get6502RegisterId(pName, pIsPointer);
+		return -1;
+	}
+
+	bool	ReadIdentifier(char* pOutName, int maxLen)
+	{
+		SkipWhitespace();
+		if (isalpha(*pCur) == 0 && *pCur != '_')
+			return false;
+
+		int len = 0;
+		while (isalnum(*pCur) || *pCur == '_' || *pCur == '\'')
+		{
+			if (len < maxLen - 1)
+				pOutName[len++] = (char)toupper(*pCur);
+			pCur++;
+		}
+		pOutName[len] = 0;
+		return true;
+	}
+
+	bool	ReadNumber(int32_t& outValue)
+	{
+		SkipWhitespace();
+		int base = 10;
+		if (pCur[0] == '0' && (pCur[1] == 'x' || pCur[1] == 'X'))
+		{
+			base = 16;
+			pCur += 2;
+		}
+		else if (pCur[0] == '$' || pCur[0] == '#')
+		{
+			base = 16;
+			pCur++;
+		}
+		else if (isdigit(*pCur) == 0)
+		{
+			return false;
+		}
+
+		const char* pStart = pCur;
+		int64_t value = 0;
+		while (base == 16 ? isxdigit(*pCur) : isdigit(*pCur))
+		{
+			const int digit = isdigit(*pCur) ? *pCur - '0' : toupper(*pCur) - 'A' + 10;
+			value = value * base + digit;
+			if (value > INT32_MAX)
+			{
+				SetError("Number too big");
+				value = INT32_MAX;
+			}
+			pCur++;
+		}
+
+		if (pCur == pStart)
+			SetError("Bad number");
+		outValue = (int32_t)value;
+		return true;
+	}
+
+	// Z80 style memory reference e.g. (HL) or (IX+4) - a pointer register, an optional offset then the closing bracket
+	// anything else in the bracket e.g. (HL==0x4000) is just grouping
+	bool	IsZ80MemoryRef()
+	{
+		if (CPUType != ECPUType::Z80)
+			return false;
+
+		const char* pSaved = pCur;
+		const bool bHadError = HasError();
+		char name[16];
+		bool bPointer = false;
+		bool bResult = ReadIdentifier(name, sizeof(name)) && GetRegisterId(name, &bPointer) != -1 && bPointer;
+		if (bResult && (Match("+") || Match("-")))
+		{
+			int32_t offset = 0;
+			bResult = ReadNumber(offset) && HasError() == false;
+		}
+		bResult = bResult && Match(")");
+
+		// this is only a look ahead - the expression is parsed properly after
+		pCur = pSaved;
+		if (bHadError == false)
+			Error.clear();
+		return bResult;
+	}
+
+	void	ParsePrimary()
+	{
+		int32_t number = 0;
+		char name[16];
+
+		if (ReadNumber(number))
+		{
+			Emit(EBreakpointConditionOp::Const, number);
+		}
+		else if (Match("["))
+		{
+			ParseExpression();
+			if (Match("]") == false)
+				SetError("Expected ']'");
+			Emit(EBreakpointConditionOp::Peek);
+		}
+		else if (Match("("))
+		{
+			const bool bMemoryRef = IsZ80MemoryRef();
+			ParseExpression();
+			if (Match(")") == false)
+				SetError("Expected ')'");
+			if (bMemoryRef)
+				Emit(EBreakpointConditionOp::Peek);
+		}
+		else if (ReadIdentifier(name, sizeof(name)))
+		{
+			bool bPointer = false;
+			const int regId = GetRegisterId(name, &bPointer);
+
+			if (regId != -1)
+				Emit(EBreakpointConditionOp::Register, regId);
+			else if (strcmp(name, "ADDR") == 0)
+				Emit(EBreakpointConditionOp::Addr);
+			else if (strcmp(name, "VALUE") == 0)
+				Emit(EBreakpointConditionOp::DataValue);
+			else if (strcmp(name, "OLD") == 0)
+				Emit(EBreakpointConditionOp::OldValue);
+			else if (strcmp(name, "FRAME") == 0)
+				Emit(EBreakpointConditionOp::FrameNo);
+			else if (strcmp(name, "PEEK") == 0 || strcmp(name, "PEEKW") == 0)
+			{
+				if (Match("(") == false)
+					SetError("Expected '('");
+				ParseExpression();
+				if (Match(")") == false)
+					SetError("Expected ')'");
+				Emit(name[4] == 'W' ? EBreakpointConditionOp::PeekWord : EBreakpointConditionOp::Peek);
+			}
+			else
+			{
+				Error = std::string("Unknown name: ") + name;
+			}
+		}
+		else
+		{
+			SetError("Expected value");
+		}
+	}
+
+	void	ParseUnary()
+	{
+		if (Match("-"))
+		{
+			ParseUnary();
+			Emit(EBreakpointConditionOp::Neg);
+		}
+		else if (Match("!"))
+		{
+			ParseUnary();
+			Emit(EBreakpointConditionOp::LogicalNot);
+		}
+		else if (Match("~"))
+		{
+			ParseUnary();
+			Emit(EBreakpointConditionOp::BitNot);
+		}
+		else
+		{
+			ParsePrimary();
+		}
+	}
+
+	void	ParseAdditive()
+	{
+		ParseUnary();
+		while (HasError() == false)
+		{
+			if (Match("+")) { ParseUnary(); Emit(EBreakpointConditionOp::Add); }
+			else if (Match("-")) { ParseUnary(); Emit(EBreakpointConditionOp::Sub); }
+			else break;
+		}
+	}
+
+	void	ParseShift()
+	{
+		ParseAdditive();
+		while (HasError() == false)
+		{
+			if (Match("<<")) { ParseAdditive(); Emit(EBreakpointConditionOp::ShiftLeft); }
+			else if (Match(">>")) { ParseAdditive(); Emit(EBreakpointConditionOp::ShiftRight); }
+			else break;
+		}
+	}
+
+	void	ParseRelational()
+	{
+		ParseShift();
+		while (HasError() == false)
+		{
+			if (Match("<=")) { ParseShift(); Emit(EBreakpointConditionOp::LessEqual); }
+			else if (Match(">=")) { ParseShift(); Emit(EBreakpointConditionOp::GreaterEqual); }
+			else if (Match("<")) { ParseShift(); Emit(EBreakpointConditionOp::Less); }
+			else if (Match(">")) { ParseShift(); Emit(EBreakpointConditionOp::Greater); }
+			else break;
+		}
+	}
+
+	void	ParseEquality()
+	{
+		ParseRelational();
+		while (HasError() == false)
+		{
+			if (Match("==") || Match("=")) { ParseRelational(); Emit(EBreakpointConditionOp::Equal); }
+			else if (Match("!=")) { ParseRelational(); Emit(EBreakpointConditionOp::NotEqual); }
+			else break;
+		}
+	}
+
+	void	ParseBitAnd()
+	{
+		ParseEquality();
+		while (HasError() == false && Match("&"))
+		{
+			ParseEquality();
+			Emit(EBreakpointConditionOp::BitAnd);
+		}
+	}
+
+	void	ParseBitXor()
+	{
+		ParseBitAnd();
+		while (HasError() == false && Match("^"))
+		{
+			ParseBitAnd();
+			Emit(EBreakpointConditionOp::BitXor);
+		}
+	}
+
+	void	ParseBitOr()
+	{
+		ParseBitXor();
+		while (HasError() == false && Match("|"))
+		{
+			ParseBitXor();
+			Emit(EBreakpointConditionOp::BitOr);
+		}
+	}
+
+	void	ParseLogicalAnd()
+	{
+		ParseBitOr();
+		while (HasError() == false && Match("&&"))
+		{
+			ParseBitOr();
+			Emit(EBreakpointConditionOp::LogicalAnd);
+		}
+	}
+
+	void	ParseExpression()
+	{
+		ParseLogicalAnd();
+		while (HasError() == false && Match("||"))
+		{
+			ParseLogicalAnd();
+			Emit(EBreakpointConditionOp::LogicalOr);
+		}
+	}
+};
+
+bool CompileBreakpointCondition(const char* pText, ECPUType cpuType, FBreakpointCondition& outCondition, std::string& outError)
+{
+	outCondition.NoOps = 0;
+	outError.clear();
+
+	FConditionParser parser;
+	parser.pCur = pText;
+	parser.CPUType = cpuType;
+	parser.pCondition = &outCondition;
+
+	parser.SkipWhitespace();
+	if (*parser.pCur == 0)	// empty - no condition
+		return true;
+
+	parser.ParseExpression();
+	parser.SkipWhitespace();
+	if (parser.HasError() == false && *parser.pCur != 0)
+		parser.SetError("Unexpected characters at end");
+
+	if (parser.HasError())
+	{
+		outCondition.NoOps = 0;
+		outError = parser.Error;
+		return false;
+	}
+
+	return true;
+}
+
+static int32_t GetRegisterValue(const FBreakpointContext& context, int regId)
+{
+	ICPUInterface* pCPUInterface = context.pCPUInterface;
+	if (pCPUInterface->CPUType == ECPUType::Z80)
+		return GetZ80RegisterValue(pCPUInterface->GetCPUEmulator(), regId);
+	if (pCPUInterface->CPUType == ECPUType::M6502)
+		return Get6502RegisterValue(pCPUInterface->GetCPUEmulator(), regId);
+	return 0;
+}
+
+bool EvaluateBreakpointCondition(const FBreakpointCondition& condition, const FBreakpointContext& context)
+{
+	if (condition.NoOps == 0)
+		return true;
+
+	int32_t stack[FBreakpointCondition::kMaxStackDepth];
+	int sp = 0;
+
+	for (int i = 0; i < condition.NoOps; i++)
+	{
+		const FBreakpointConditionOp& op = condition.Ops[i];
+		switch (op.Op)
+		{
+		case EBreakpointConditionOp::Const:		stack[sp++] = op.Value; break;
+		case EBreakpointConditionOp::Register:	stack[sp++] = GetRegisterValue(context, op.Value); break;
+		case EBreakpointConditionOp::Addr:		stack[sp++] = context.Address; break;
+		case EBreakpointConditionOp::DataValue:	stack[sp++] = context.Value; break;
+		case EBreakpointConditionOp::OldValue:	stack[sp++] = context.OldValue; break;
+		case EBreakpointConditionOp::FrameNo:	stack[sp++] = context.FrameNo; break;
+
+		case EBreakpointConditionOp::Peek:		stack[sp - 1] = context.pCPUInterface->ReadByte((uint16_t)stack[sp - 1]); break;
+		case EBreakpointConditionOp::PeekWord:	stack[sp - 1] = context.pCPUInterface->ReadWord((uint16_t)stack[sp - 1]); break;
+		case EBreakpointConditionOp::Neg:		stack[sp - 1] = -stack[sp - 1]; break;
+		case EBreakpointConditionOp::LogicalNot:stack[sp - 1] = !stack[sp - 1]; break;
+		case EBreakpointConditionOp::BitNot:	stack[sp - 1] = ~stack[sp - 1]; break;
+
+		default:
+		{
+			const int32_t rhs = stack[--sp];
+			int32_t& lhs = stack[sp - 1];
+			switch (op.Op)
+			{
+			case EBreakpointConditionOp::Add:			lhs = lhs + rhs; break;
+			case EBreakpointConditionOp::Sub:			lhs = lhs - rhs; break;
+			case EBreakpointConditionOp::BitAnd:		lhs = lhs & rhs; break;
+			case EBreakpointConditionOp::BitOr:			lhs = lhs | rhs; break;
+			case EBreakpointConditionOp::BitXor:		lhs = lhs ^ rhs; break;
+			case EBreakpointConditionOp::ShiftLeft:		lhs = lhs << (rhs & 31); break;
+			case EBreakpointConditionOp::ShiftRight:	lhs = lhs >> (rhs & 31); break;
+			case EBreakpointConditionOp::Equal:			lhs = lhs == rhs; break;
+			case EBreakpointConditionOp::NotEqual:		lhs = lhs != rhs; break;
+			case EBreakpointConditionOp::Less:			lhs = lhs < rhs; break;
+			case EBreakpointConditionOp::Greater:		lhs = lhs > rhs; break;
+			case EBreakpointConditionOp::LessEqual:		lhs = lhs <= rhs; break;
+			case EBreakpointConditionOp::GreaterEqual:	lhs = lhs >= rhs; break;
+			case EBreakpointConditionOp::LogicalAnd:	lhs = lhs && rhs; break;
+			case EBreakpointConditionOp::LogicalOr:		lhs = lhs || rhs; break;
+			default: break;
+			}
+		}
+		break;
+		}
+	}
+
+	return stack[0] != 0;
+}
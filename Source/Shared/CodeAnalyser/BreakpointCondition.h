@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+class ICPUInterface;
+enum class ECPUType;
+
+// Breakpoint condition expressions e.g. "PC=0x8123 && A==3 && (HL)>0x40" or "VALUE!=OLD"
+// Conditions are parsed once into postfix bytecode which is evaluated on a fixed size stack - no allocation when the breakpoint is hit
+enum class EBreakpointConditionOp : uint8_t
+{
+	// operands
+	Const,		// push Value
+	Register,	// push CPU register Value
+	Addr,		// address of the data access (or PC for exec breakpoints)
+	DataValue,	// value being read or written
+	OldValue,	// value in memory before a write
+	FrameNo,
+
+	// unary
+	Peek,		// replace top with byte at address
+	PeekWord,	// replace top with word at address
+	Neg,
+	LogicalNot,
+	BitNot,
+
+	// binary
+	Add,
+	Sub,
+	BitAnd,
+	BitOr,
+	BitXor,
+	ShiftLeft,
+	ShiftRight,
+	Equal,
+	NotEqual,
+	Less,
+	Greater,
+	LessEqual,
+	GreaterEqual,
+	LogicalAnd,
+	LogicalOr,
+};
+
+struct FBreakpointConditionOp
+{
+	EBreakpointConditionOp	Op;
+	int32_t					Value;
+};
+
+struct FBreakpointCondition
+{
+	static const int kMaxOps = 64;
+	static const int kMaxStackDepth = 16;
+
+	FBreakpointConditionOp	Ops[kMaxOps];
+	int						NoOps = 0;	// 0 means no condition - always true
+};
+
+// Everything a condition can look at when a breakpoint hits
+struct FBreakpointContext
+{
+	ICPUInterface*	pCPUInterface = nullptr;
+	uint16_t		Address = 0;
+	uint8_t			Value = 0;
+	uint8_t			OldValue = 0;
+	int				FrameNo = 0;
+};
+
+bool	CompileBreakpointCondition(const char* pText, ECPUType cpuType, FBreakpointCondition& outCondition, std::string& outError);
+bool	EvaluateBreakpointCondition(const FBreakpointCondition& condition, const FBreakpointContext& context);
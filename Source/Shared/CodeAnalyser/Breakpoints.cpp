@@ -0,0 +1,183 @@
+#include "Breakpoints.h"
+#include "CodeAnalyser.h"
+
+#include <cstring>
+
+static void ResolveBreakpointPages(FCodeAnalysisState& state, FBreakpoint& bp)
+{
+	// clamp the range to the address space
+	if (bp.Size == 0)
+		bp.Size = 1;
+	if (bp.Address + bp.Size > FCodeAnalysisState::kAddressSize)
+		bp.Size = (uint16_t)(FCodeAnalysisState::kAddressSize - bp.Address);
+
+	bp.ReadPageIds.clear();
+	bp.WritePageIds.clear();
+
+	const int lastAddr = bp.Address + bp.Size - 1;
+	for (int pageNo = bp.Address >> FCodeAnalysisState::kPageShift; pageNo <= (lastAddr >> FCodeAnalysisState::kPageShift); pageNo++)
+	{
+		const uint16_t pageAddr = (uint16_t)(pageNo << FCodeAnalysisState::kPageShift);
+		bp.ReadPageIds.push_back(state.GetReadPage(pageAddr)->PageId);
+		bp.WritePageIds.push_back(state.GetWritePage(pageAddr)->PageId);
+	}
+}
+
+int AddBreakpoint(FCodeAnalysisState& state, uint8_t type, uint16_t address, uint16_t size)
+{
+	FBreakpoint bp;
+	bp.Type = type;
+	bp.Address = address;
+	bp.Size = size;
+	ResolveBreakpointPages(state, bp);
+	state.Breakpoints.push_back(bp);
+	UpdateBreakpointBitmaps(state);
+	return (int)state.Breakpoints.size() - 1;
+}
+
+void SetBreakpointRange(FCodeAnalysisState& state, int index, uint16_t address, uint16_t size)
+{
+	FBreakpoint& bp = state.Breakpoints[index];
+	bp.Address = address;
+	bp.Size = size;
+	ResolveBreakpointPages(state, bp);
+	UpdateBreakpointBitmaps(state);
+}
+
+void RemoveBreakpoint(FCodeAnalysisState& state, int index)
+{
+	if (index < 0 || index >= (int)state.Breakpoints.size())
+		return;
+
+	state.Breakpoints.erase(state.Breakpoints.begin() + index);
+	if (state.LastHitBreakpoint == index)
+		state.LastHitBreakpoint = -1;
+	else if (state.LastHitBreakpoint > index)
+		state.LastHitBreakpoint--;
+
+	UpdateBreakpointBitmaps(state);
+}
+
+void RemoveAllBreakpoints(FCodeAnalysisState& state)
+{
+	state.Breakpoints.clear();
+	state.LastHitBreakpoint = -1;
+	UpdateBreakpointBitmaps(state);
+}
+
+int FindBreakpoint(const FCodeAnalysisState& state, uint8_t type, uint16_t address)
+{
+	for (int i = 0; i < (int)state.Breakpoints.size(); i++)
+	{
+		const FBreakpoint& bp = state.Breakpoints[i];
+		if (bp.Type == type && bp.Address == address)
+			return i;
+	}
+
+	return -1;
+}
+
+bool SetBreakpointCondition(FCodeAnalysisState& state, int index, const char* pConditionText)
+{
+	FBreakpoint& bp = state.Breakpoints[index];
+	bp.ConditionText = pConditionText;
+	const bool bCompiled = CompileBreakpointCondition(pConditionText, state.CPUInterface->CPUType, bp.Condition, bp.ConditionError);
+	UpdateBreakpointBitmaps(state);
+	return bCompiled;
+}
+
+static inline void SetBreakpointBit(uint64_t* pBitmap, uint16_t addr)
+{
+	const int pageAddr = addr & FCodeAnalysisState::kPageMask;
+	pBitmap[pageAddr >> 6] |= 1ull << (pageAddr & 63);
+}
+
+void UpdateBreakpointBitmaps(FCodeAnalysisState& state)
+{
+	for (FCodeAnalysisPage* pPage : state.GetRegisteredPages())
+	{
+		memset(pPage->ExecBreakpoints, 0, sizeof(pPage->ExecBreakpoints));
+		memset(pPage->ReadBreakpoints, 0, sizeof(pPage->ReadBreakpoints));
+		memset(pPage->WriteBreakpoints, 0, sizeof(pPage->WriteBreakpoints));
+	}
+
+	state.bBreakpointConditions = false;
+	for (const FBreakpoint& bp : state.Breakpoints)
+	{
+		if (bp.bEnabled == false)
+			continue;
+
+		if (bp.Condition.NoOps != 0)
+			state.bBreakpointConditions = true;
+
+		const int firstPageNo = bp.Address >> FCodeAnalysisState::kPageShift;
+		for (int i = 0; i < bp.Size; i++)
+		{
+			const uint16_t addr = (uint16_t)(bp.Address + i);
+			const int pageIndex = (addr >> FCodeAnalysisState::kPageShift) - firstPageNo;
+			FCodeAnalysisPage* pReadPage = state.GetPage(bp.ReadPageIds[pageIndex]);
+			FCodeAnalysisPage* pWritePage = state.GetPage(bp.WritePageIds[pageIndex]);
+
+			if (bp.Type & BreakpointType_Exec)
+				SetBreakpointBit(pReadPage->ExecBreakpoints, addr);
+			if (bp.Type & BreakpointType_Read)
+				SetBreakpointBit(pReadPage->ReadBreakpoints, addr);
+			if (bp.Type & BreakpointType_Write)
+				SetBreakpointBit(pWritePage->WriteBreakpoints, addr);
+		}
+	}
+}
+
+bool HasBreakpointAtAddress(const FCodeAnalysisState& state, uint16_t address)
+{
+	return state.IsExecBreakpointed(address) || state.IsReadBreakpointed(address) || state.IsWriteBreakpointed(address);
+}
+
+// Only called when a bitmap test has hit so the search doesn't matter
+int RegisterBreakpointHit(FCodeAnalysisState& state, uint8_t type, const FBreakpointContext& context)
+{
+	const uint16_t address = context.Address;
+	const bool bWrite = type == BreakpointType_Write;
+	const int16_t pageId = bWrite ? state.GetWritePage(address)->PageId : state.GetReadPage(address)->PageId;
+
+	for (int i = 0; i < (int)state.Breakpoints.size(); i++)
+	{
+		FBreakpoint& bp = state.Breakpoints[i];
+		if (bp.bEnabled == false || (bp.Type & type) == 0)
+			continue;
+		if (address < bp.Address || address >= bp.Address + bp.Size)
+			continue;
+
+		const int pageIndex = (address >> FCodeAnalysisState::kPageShift) - (bp.Address >> FCodeAnalysisState::kPageShift);
+		if ((bWrite ? bp.WritePageIds[pageIndex] : bp.ReadPageIds[pageIndex]) != pageId)
+			continue;
+		if (EvaluateBreakpointCondition(bp.Condition, context) == false)
+			continue;
+
+		bp.HitCount++;
+		return i;
+	}
+
+	return -1;
+}
+
+int RegisterBreakpointAccessHits(FCodeAnalysisState& state, const FBreakpointAccess* pAccesses, int noAccesses)
+{
+	FBreakpointContext context;
+	context.pCPUInterface = state.CPUInterface;
+	context.FrameNo = state.CurrentFrameNo;
+
+	for (int i = 0; i < noAccesses; i++)
+	{
+		const FBreakpointAccess& access = pAccesses[i];
+		context.Address = access.Address;
+		context.Value = access.Value;
+		context.OldValue = access.OldValue;
+
+		const int hit = RegisterBreakpointHit(state, access.Type, context);
+		if (hit != -1)
+			return hit;
+	}
+
+	return -1;
+}
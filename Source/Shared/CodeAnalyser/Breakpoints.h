@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BreakpointCondition.h"
+
+struct FCodeAnalysisState;
+
+// Breakpoint type flags
+enum EBreakpointType : uint8_t
+{
+	BreakpointType_Exec		= 1 << 0,
+	BreakpointType_Read		= 1 << 1,
+	BreakpointType_Write	= 1 << 2,
+};
+
+// An exec breakpoint or a read/write watch over an address range
+// The range is tied to the physical pages that were mapped in when it was set so banked memory only breaks in its own bank
+struct FBreakpoint
+{
+	uint8_t		Type = BreakpointType_Exec;	// EBreakpointType flags
+	bool		bEnabled = true;
+	uint16_t	Address = 0;
+	uint16_t	Size = 1;
+	int			HitCount = 0;
+
+	std::string				ConditionText;	// optional condition - see BreakpointCondition.h
+	std::string				ConditionError;
+	FBreakpointCondition	Condition;
+
+	std::vector<int16_t>	ReadPageIds;	// page ids for each 1K of the range
+	std::vector<int16_t>	WritePageIds;
+};
+
+// A data access which hit a read/write bitmap - conditions are evaluated after the instruction when the registers are valid
+struct FBreakpointAccess
+{
+	uint8_t		Type = 0;
+	uint8_t		Value = 0;
+	uint8_t		OldValue = 0;
+	uint16_t	Address = 0;
+};
+
+// Breakpoints are compiled into bitmaps in the analysis pages, checking an access is a page lookup & a bit test
+inline bool TestBreakpointBit(const uint64_t* pBitmap, uint16_t addr)
+{
+	const int pageAddr = addr & 1023;
+	return (pBitmap[pageAddr >> 6] >> (pageAddr & 63)) & 1;
+}
+
+int		AddBreakpoint(FCodeAnalysisState& state, uint8_t type, uint16_t address, uint16_t size = 1);
+void	SetBreakpointRange(FCodeAnalysisState& state, int index, uint16_t address, uint16_t size);
+void	RemoveBreakpoint(FCodeAnalysisState& state, int index);
+void	RemoveAllBreakpoints(FCodeAnalysisState& state);
+int		FindBreakpoint(const FCodeAnalysisState& state, uint8_t type, uint16_t address);
+
+// compile condition text for a breakpoint, on failure the error is stored in the breakpoint & the condition is cleared
+bool	SetBreakpointCondition(FCodeAnalysisState& state, int index, const char* pConditionText);
+
+// call when breakpoints are enabled, disabled or have their type changed
+void	UpdateBreakpointBitmaps(FCodeAnalysisState& state);
+
+// is there an enabled breakpoint of any type at the address
+bool	HasBreakpointAtAddress(const FCodeAnalysisState& state, uint16_t address);
+
+// find which breakpoint caused a hit & passes its condition, updates its hit count & returns the breakpoint index or -1
+int		RegisterBreakpointHit(FCodeAnalysisState& state, uint8_t type, const FBreakpointContext& context);
+
+// evaluate recorded data accesses, returns the first breakpoint hit or -1
+int		RegisterBreakpointAccessHits(FCodeAnalysisState& state, const FBreakpointAccess* pAccesses, int noAccesses);
@@ -8,13 +8,11 @@
 
 #include <imgui.h>
 
-#include <util/z80dasm.h>
-#include <util/m6502dasm.h>
-
 #include "Util/Misc.h"
 #include "Util/GraphicsView.h"
 #include "UI/ImageViewer.h"
 
+#include "Disassembler.h"
 #include "Z80/CodeAnalyserZ80.h"
 #include "6502/CodeAnalyser6502.h"
 #include <Debug/DebugLog.h>
@@ -54,19 +52,24 @@ bool FCodeAnalysisState::RemoveLabelName(const std::string& labelName)
 }
 
 // Search memory space for a block of data
+// This only covers the CPU visible 64K - see Util/MemorySearch.h for searching all banks
 bool FCodeAnalysisState::FindMemoryPattern(uint8_t* pData, size_t dataSize, uint16_t offset, uint16_t& outAddr)
 {
-	uint16_t address = offset;
-	ICPUInterface* pCPUInterface = CPUInterface;
-	size_t dataOffset = 0;
+	if (dataSize == 0)
+		return false;
+
+	const ICPUInterface* pCPUInterface = CPUInterface;
+	const uint8_t firstByte = pData[0];
 
-	do
+	for (uint32_t address = offset; address + dataSize <= 0x10000; address++)
 	{
+		if (pCPUInterface->ReadByte((uint16_t)address) != firstByte)
+			continue;
+
 		bool bFound = true;
-		for (int byteNo = 0; byteNo < 8; byteNo++)
+		for (size_t byteNo = 1; byteNo < dataSize; byteNo++)
 		{
-			const uint8_t byte = pCPUInterface->ReadByte(address + byteNo);
-			if (byte != pData[byteNo])
+			if (pCPUInterface->ReadByte((uint16_t)(address + byteNo)) != pData[byteNo])
 			{
 				bFound = false;
 				break;
@@ -78,61 +81,11 @@ bool FCodeAnalysisState::FindMemoryPattern(uint8_t* pData, size_t dataSize, uint
 			outAddr = static_cast<uint16_t>(address);
 			return true;
 		}
-
-		address++;
-	} while (address != 0);	// 16 bit address overflow
+	}
 
 	return false;
 }
 
-bool IsAscii(uint8_t byte)
-{
-	return byte >= 32 && byte <= 126;
-}
-
-void FCodeAnalysisState::FindAsciiStrings(uint16_t startAddress)
-{
-	uint16_t address = startAddress;
-	ICPUInterface* pCPUInterface = CPUInterface;
-	const int kStringMinLength = 4;
-	int stringLength = 0;
-	uint16_t stringStart = 0;
-	std::string dbgString;
-
-	do
-	{
-		FCodeInfo* pCodeInfo = GetCodeInfoForAddress(address);
-		FDataInfo* pDataInfo = GetReadDataInfoForAddress(address);
-		const uint8_t byte = pCPUInterface->ReadByte(address++);
-
-		// determine if char is ascii
-		const bool bIsAscii = IsAscii(byte);
-		const bool bCode = pCodeInfo != nullptr && pCodeInfo->bDisabled;
-
-		if (bIsAscii && bCode == false)
-		{
-			if (stringLength == 0)
-				stringStart = address;
-
-			dbgString += byte;
-			stringLength++;
-		}
-		else
-		{
-			if (stringLength >= kStringMinLength) // end of valid string
-			{
-				LOGINFO("Found string at:0x%04X \"%s\"", stringStart, dbgString.c_str());
-			}
-			stringLength = 0;
-			dbgString.clear();
-		}
-
-	} while (address != 0);	// 16 bit address overflow
-
-}
-
-
-
 bool CheckPointerIndirectionInstruction(ICPUInterface* pCPUInterface, uint16_t pc, uint16_t* out_addr)
 {
 	if (pCPUInterface->CPUType == ECPUType::Z80)
@@ -188,6 +141,64 @@ bool CheckStopInstruction(ICPUInterface* pCPUInterface, uint16_t pc)
 		return false;
 }
 
+// Decoded instruction cache
+
+static const int kMaxInstructionSize = 4;
+
+static void DecodeInstruction(FCodeAnalysisState& state, uint16_t pc, FDecodedInstruction& decoded)
+{
+	ICPUInterface* pCPUInterface = state.CPUInterface;
+
+	decoded.Flags = 0;
+	decoded.Opcode = pCPUInterface->ReadByte(pc);
+	decoded.bJump = CheckJumpInstruction(pCPUInterface, pc, &decoded.JumpAddress);
+	decoded.bCall = decoded.bJump && CheckCallInstruction(pCPUInterface, pc);
+	decoded.bPointerRef = CheckPointerRefInstruction(pCPUInterface, pc, &decoded.PointerAddress);
+	decoded.bStop = CheckStopInstruction(pCPUInterface, pc);
+
+	FDasmInstruction instruction;
+	decoded.ByteSize = (uint8_t)DisassembleInstruction(pCPUInterface, pc, instruction);
+
+	// instructions that straddle a page boundary aren't cached as the next page could get banked out
+	decoded.bValid = (pc & FCodeAnalysisState::kPageMask) + decoded.ByteSize <= FCodeAnalysisPage::kPageSize;
+}
+
+const FDecodedInstruction& GetDecodedInstruction(FCodeAnalysisState& state, uint16_t pc)
+{
+	FDecodedInstruction& decoded = state.GetReadPage(pc)->DecodedInstructions[pc & FCodeAnalysisState::kPageMask];
+	if (decoded.bValid == false || state.bCacheDecodedInstructions == false)
+		DecodeInstruction(state, pc, decoded);
+
+	return decoded;
+}
+
+// Memory in a page has changed - invalidate any cached instructions in it that use the byte
+// cached instructions never straddle pages so only this page needs checking
+void InvalidateDecodedInstructions(FCodeAnalysisPage& page, uint16_t pageAddr)
+{
+	for (int offset = 0; offset < kMaxInstructionSize && offset <= pageAddr; offset++)
+	{
+		FDecodedInstruction& decoded = page.DecodedInstructions[pageAddr - offset];
+		if (decoded.bValid && decoded.ByteSize > offset)
+			decoded.bValid = false;
+	}
+}
+
+// Memory at addr has been written - this is the write page, which isn't the read page for e.g. RAM under ROM on the C64
+void InvalidateDecodedInstructions(FCodeAnalysisState& state, uint16_t addr)
+{
+	FCodeAnalysisPage* pPage = state.WritePageTable[addr >> FCodeAnalysisState::kPageShift];
+	if (pPage != nullptr)
+		InvalidateDecodedInstructions(*pPage, addr & FCodeAnalysisState::kPageMask);
+}
+
+// All of memory has changed e.g. a state has been restored
+void InvalidateAllDecodedInstructions(FCodeAnalysisState& state)
+{
+	for (FCodeAnalysisPage* pPage : state.GetRegisteredPages())
+		std::fill(std::begin(pPage->DecodedInstructions), std::end(pPage->DecodedInstructions), FDecodedInstruction());
+}
+
 std::string GetItemText(FCodeAnalysisState& state, uint16_t address)
 {
 	FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(address);
@@ -255,116 +266,43 @@ FLabelInfo* GenerateLabelForAddress(FCodeAnalysisState &state, uint16_t address,
 	}
 
 	pLabel->Name = label;
-	if (pLabel->Global)
-		GenerateGlobalInfo(state);
 	state.SetLabelForAddress(address, pLabel);
 	return pLabel;	
 }
 
 
-class FAnalysisDasmState : public FDasmStateBase
+// Disassembly text is generated on demand and cached by address, instruction bytes & number format
+const char* GetCodeInfoText(FCodeAnalysisState& state, const FCodeInfo* pCodeInfo)
 {
-public:
-	void OutputU8(uint8_t val, z80dasm_output_t outputCallback) override
-	{
-		if (outputCallback != nullptr)
-		{
-			ENumberDisplayMode dispMode = GetNumberDisplayMode();
-
-			if (pCodeInfoItem->OperandType == EOperandType::Decimal)
-				dispMode = ENumberDisplayMode::Decimal;
-			if (pCodeInfoItem->OperandType == EOperandType::Hex)
-				dispMode = ENumberDisplayMode::HexAitch;
-			if (pCodeInfoItem->OperandType == EOperandType::Binary)
-				dispMode = ENumberDisplayMode::Binary;
-
-			const char* outStr = NumStr(val, dispMode);
-			for (int i = 0; i < strlen(outStr); i++)
-				outputCallback(outStr[i], this);
-		}
-	}
-
-	void OutputU16(uint16_t val, z80dasm_output_t outputCallback) override
-	{
-		if (outputCallback)
-		{
-			ENumberDisplayMode dispMode = GetNumberDisplayMode();
-
-			if (pCodeInfoItem->OperandType == EOperandType::Decimal)
-				dispMode = ENumberDisplayMode::Decimal;
-			if (pCodeInfoItem->OperandType == EOperandType::Hex)
-				dispMode = ENumberDisplayMode::HexAitch;
-			if (pCodeInfoItem->OperandType == EOperandType::Binary)
-				dispMode = ENumberDisplayMode::Binary;
-
-			const char* outStr = NumStr(val, dispMode);
-			for (int i = 0; i < strlen(outStr); i++)
-				outputCallback(outStr[i], this);
-		}
-	}
-
-	void OutputD8(int8_t val, z80dasm_output_t outputCallback) override
-	{
-		if (outputCallback)
-		{
-			if (val < 0)
-			{
-				outputCallback('-', this);
-				val = -val;
-			}
-			else
-			{
-				outputCallback('+', this);
-			}
-			const char* outStr = NumStr((uint8_t)val);
-			for (int i = 0; i < strlen(outStr); i++)
-				outputCallback(outStr[i], this);
-		}
-	}
+	const uint16_t pc = pCodeInfo->Address;
+	uint64_t key = pc;
+	for (int i = 0; i < pCodeInfo->ByteSize && i < kMaxInstructionSize; i++)
+		key |= (uint64_t)state.CPUInterface->ReadByte(pc + i) << (16 + i * 8);
+	key |= (uint64_t)pCodeInfo->OperandType << 48;
+	key |= (uint64_t)(uint8_t)GetNumberDisplayMode() << 56;
 
-	FCodeInfo* pCodeInfoItem = nullptr;
-};
+	const char* pText = state.CodeTextCache.Find(key);
+	if (pText != nullptr)
+		return pText;
 
+	FDasmFormatOptions options;
+	options.NumberMode = GetNumberDisplayMode();
+	options.DisplacementMode = GetNumberDisplayMode();
+	if (pCodeInfo->OperandType == EOperandType::Decimal)
+		options.NumberMode = ENumberDisplayMode::Decimal;
+	if (pCodeInfo->OperandType == EOperandType::Hex)
+		options.NumberMode = ENumberDisplayMode::HexAitch;
+	if (pCodeInfo->OperandType == EOperandType::Binary)
+		options.NumberMode = ENumberDisplayMode::Binary;
 
-/* disassembler callback to fetch the next instruction byte */
-static uint8_t AnalysisDasmInputCB(void* pUserData)
-{
-	FAnalysisDasmState* pDasmState = (FAnalysisDasmState*)pUserData;
+	FDasmInstruction instruction;
+	DisassembleInstruction(state.CPUInterface, pc, instruction);
 
-	return pDasmState->CodeAnalysisState->CPUInterface->ReadByte( pDasmState->CurrentAddress++);
+	char* pCachedText = state.CodeTextCache.Add(key);
+	FormatDasmInstruction(instruction, options, pCachedText, FCodeTextCache::kMaxTextLength);
+	return pCachedText;
 }
 
-/* disassembler callback to output a character */
-static void AnalysisOutputCB(char c, void* pUserData)
-{
-	FAnalysisDasmState* pDasmState = (FAnalysisDasmState*)pUserData;
-
-	// add character to string
-	pDasmState->Text += c;
-}
-
-void UpdateCodeInfoForAddress(FCodeAnalysisState &state, uint16_t pc)
-{
-	FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(pc);
-	if (pCodeInfo == nullptr)	// code info could have been cleared
-		return;
-
-	FAnalysisDasmState dasmState;
-	dasmState.pCodeInfoItem = pCodeInfo;
-	dasmState.CodeAnalysisState = &state;
-	dasmState.CurrentAddress = pc;
-	SetNumberOutput(&dasmState);
-	if(state.CPUInterface->CPUType == ECPUType::Z80)
-		z80dasm_op(pc, AnalysisDasmInputCB, AnalysisOutputCB, &dasmState);
-	else if(state.CPUInterface->CPUType == ECPUType::M6502)
-		m6502dasm_op(pc, AnalysisDasmInputCB, AnalysisOutputCB, &dasmState);
-
-	assert(pCodeInfo != nullptr);
-	pCodeInfo->Text = dasmState.Text;
-	SetNumberOutput(nullptr);
-}
-
-
 uint16_t WriteCodeInfoForAddress(FCodeAnalysisState &state, uint16_t pc)
 {
 	FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(pc);
@@ -374,11 +312,6 @@ uint16_t WriteCodeInfoForAddress(FCodeAnalysisState &state, uint16_t pc)
 		state.SetCodeInfoForAddress(pc, pCodeInfo);
 	}
 
-	FAnalysisDasmState dasmState;
-	dasmState.pCodeInfoItem = pCodeInfo;
-	dasmState.CodeAnalysisState = &state;
-	dasmState.CurrentAddress = pc;	
-
 	// does this function branch?
 	uint16_t jumpAddr;
 	if (CheckJumpInstruction(state.CPUInterface, pc, &jumpAddr))
@@ -411,21 +344,12 @@ uint16_t WriteCodeInfoForAddress(FCodeAnalysisState &state, uint16_t pc)
 		}
 	}
 
-	// generate disassembly
-	SetNumberOutput(&dasmState);	// not particularly happy with this - pointer to stack held globally
-	uint16_t newPC = pc;
-
-	if (state.CPUInterface->CPUType == ECPUType::Z80)
-		newPC = z80dasm_op(pc, AnalysisDasmInputCB, AnalysisOutputCB, &dasmState);
-	else if (state.CPUInterface->CPUType == ECPUType::M6502)
-		newPC = m6502dasm_op(pc, AnalysisDasmInputCB, AnalysisOutputCB, &dasmState);
-
-	SetNumberOutput(nullptr);
+	// text isn't generated here - see GetCodeInfoText
+	const uint16_t newPC = pc + GetDecodedInstruction(state, pc).ByteSize;
 
 	pCodeInfo->Address = pc;
 	for (uint16_t codeAddr = pc; codeAddr < newPC; codeAddr++)
 		state.SetCodeInfoForAddress(codeAddr, pCodeInfo);	// make sure all addresses spanned by instruction are set
-	pCodeInfo->Text = dasmState.Text;
 	pCodeInfo->ByteSize = newPC - pc;
 
 	return newPC;
@@ -434,19 +358,19 @@ uint16_t WriteCodeInfoForAddress(FCodeAnalysisState &state, uint16_t pc)
 // return if we should continue
 bool AnalyseAtPC(FCodeAnalysisState &state, uint16_t& pc)
 {
+	const FDecodedInstruction& decoded = GetDecodedInstruction(state, pc);
+
 	// update branch reference counters
-	uint16_t jumpAddr;
-	if (CheckJumpInstruction(state.CPUInterface, pc, &jumpAddr))
+	if (decoded.bJump)
 	{
-		FLabelInfo* pLabel = state.GetLabelForAddress(jumpAddr);
+		FLabelInfo* pLabel = state.GetLabelForAddress(decoded.JumpAddress);
 		if (pLabel != nullptr)
 			pLabel->References[pc]++;	// add/increment reference
 	}
 
-	uint16_t ptr;
-	if (CheckPointerRefInstruction(state.CPUInterface, pc, &ptr))
+	if (decoded.bPointerRef)
 	{
-		FLabelInfo* pLabel = state.GetLabelForAddress(ptr);
+		FLabelInfo* pLabel = state.GetLabelForAddress(decoded.PointerAddress);
 		if (pLabel != nullptr)
 			pLabel->References[pc]++;	// add/increment reference
 	}
@@ -487,26 +411,17 @@ bool AnalyseAtPC(FCodeAnalysisState &state, uint16_t& pc)
 	if (pOldComment != nullptr)	// restore old comment
 		pCodeInfo->Comment = std::string(pOldComment);
 
-	if (CheckStopInstruction(state.CPUInterface, pc) || newPC < pc)
+	if (decoded.bStop || newPC < pc)
 		return false;
 	
 	pc = newPC;
-	state.SetCodeAnalysisDirty();
 	return true;
 }
 
-// Step through and analyse code from a location
-void AnalyseFromPC(FCodeAnalysisState &state, uint16_t pc)
-{
-	while(AnalyseAtPC(state,pc))
-		state.SetCodeAnalysisDirty();
-
-	return;
-}
-
 bool RegisterCodeExecuted(FCodeAnalysisState &state, uint16_t pc, uint16_t nextpc)
 {
-	AnalyseAtPC(state, pc);
+	uint16_t analysePC = pc;	// AnalyseAtPC moves this on to the next instruction
+	AnalyseAtPC(state, analysePC);
 
 	state.FrameTrace.push_back(pc);
 	
@@ -522,26 +437,33 @@ bool RegisterCodeExecuted(FCodeAnalysisState &state, uint16_t pc, uint16_t nextp
 	return false;
 }
 
+// Queue up a recursive descent analysis from an address
+// Some is done straight away, the rest is carried on by UpdateStaticAnalysis
 void RunStaticCodeAnalysis(FCodeAnalysisState &state, uint16_t pc)
 {
-	AnalyseFromPC(state, pc);
+	static const int kImmediateBudget = 16 * 1024;	// instructions
+
+	QueueStaticAnalysis(state, pc);
+	UpdateStaticAnalysis(state, kImmediateBudget);
 }
 
 void RegisterDataRead(FCodeAnalysisState& state, uint16_t pc, uint16_t dataAddr)
 {
-	if (state.GetCodeInfoForAddress(dataAddr) == nullptr)	// don't register instruction data reads
+	FCodeAnalysisPage* pPage = state.GetReadPage(dataAddr);
+	const uint16_t pageAddr = dataAddr & FCodeAnalysisState::kPageMask;
+	if (pPage->CodeInfo[pageAddr] == nullptr)	// don't register instruction data reads
 	{
-		FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(dataAddr);
-		pDataInfo->LastFrameRead = state.CurrentFrameNo;
-		pDataInfo->Reads[pc]++;
+		pPage->LastFrameRead[pageAddr] = state.CurrentFrameNo;
+		pPage->DataInfo[pageAddr].Reads.RegisterAccess(pc);
 	}
 }
 
 void RegisterDataWrite(FCodeAnalysisState &state, uint16_t pc,uint16_t dataAddr)
 {
-	FDataInfo* pDataInfo = state.GetWriteDataInfoForAddress(dataAddr);
-	pDataInfo->LastFrameWritten = state.CurrentFrameNo;
-	pDataInfo->Writes[pc]++;
+	FCodeAnalysisPage* pPage = state.GetWritePage(dataAddr);
+	const uint16_t pageAddr = dataAddr & FCodeAnalysisState::kPageMask;
+	pPage->LastFrameWritten[pageAddr] = state.CurrentFrameNo;
+	pPage->DataInfo[pageAddr].Writes.RegisterAccess(pc);
 }
 
 void ReAnalyseCode(FCodeAnalysisState &state)
@@ -591,24 +513,24 @@ void ReAnalyseCode(FCodeAnalysisState &state)
 // Do we want to do this with every page?
 void ResetReferenceInfo(FCodeAnalysisState &state)
 {
-	for (int i = 0; i < (1 << 16); i++)
+	// work a page at a time so we walk the dense arrays linearly
+	for (int pageBase = 0; pageBase < (1 << 16); pageBase += FCodeAnalysisPage::kPageSize)
 	{
-		FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(i);
-		if (pDataInfo != nullptr)
-		{
-			pDataInfo->LastFrameRead = -1;
-			pDataInfo->Reads.clear();
-			pDataInfo->LastFrameWritten = -1;
-			pDataInfo->Writes.clear();
-		}
+		FCodeAnalysisPage* pReadPage = state.GetReadPage(pageBase);
+		FCodeAnalysisPage* pWritePage = state.GetWritePage(pageBase);
 
-		FLabelInfo* pLabelInfo = state.GetLabelForAddress(i);
-		if (pLabelInfo != nullptr)
+		for (int pageAddr = 0; pageAddr < FCodeAnalysisPage::kPageSize; pageAddr++)
 		{
-			pLabelInfo->References.clear();
+			pReadPage->LastFrameRead[pageAddr] = -1;
+			pReadPage->DataInfo[pageAddr].Reads.clear();
+			pWritePage->LastFrameWritten[pageAddr] = -1;
+			pWritePage->DataInfo[pageAddr].Writes.clear();
+			pWritePage->LastWriter[pageAddr] = 0;
+
+			FLabelInfo* pLabelInfo = pReadPage->Labels[pageAddr];
+			if (pLabelInfo != nullptr)
+				pLabelInfo->References.clear();
 		}
-
-		state.SetLastWriterForAddress(i,  0);
 	}
 }
 
@@ -624,9 +546,6 @@ FLabelInfo* AddLabel(FCodeAnalysisState &state, uint16_t address,const char *nam
 	pLabel->Global = type == ELabelType::Function;
 	state.SetLabelForAddress(address, pLabel);
 
-	if (pLabel->Global)
-		GenerateGlobalInfo(state);
-
 	return pLabel;
 }
 
@@ -647,30 +566,70 @@ FCommentBlock* AddCommentBlock(FCodeAnalysisState& state, uint16_t address)
 	return pExistingBlock;
 }
 
-// Generate Global Info for items in address space
-void GenerateGlobalInfo(FCodeAnalysisState &state)
+// Rebuild global label lists for segments whose labels have changed
+// Label bursts just mark segments dirty so this only scans the changed segments once
+void UpdateGlobalInfo(FCodeAnalysisState &state)
 {
-	state.GlobalDataItems.clear();
-	state.GlobalFunctions.clear();
+	if (state.bGlobalLabelsDirty == false)
+		return;
 
-	for (int i = 0; i < (1 << 16); i++)
+	const int kNoSegments = FCodeAnalysisState::kAddressSize / FCodeAnalysisPage::kPageSize;
+	size_t noDataItems = 0;
+	size_t noFunctions = 0;
+	for (int segmentNo = 0; segmentNo < kNoSegments; segmentNo++)
 	{
-		FLabelInfo *pLabel = state.GetLabelForAddress(i);
-		
-		if (pLabel != nullptr)
+		FGlobalLabelSegment& segment = state.GlobalLabelSegments[segmentNo];
+		const FCodeAnalysisPage* pPage = state.ReadPageTable[segmentNo];
+		if (segment.bDirty && pPage != nullptr)
 		{
-			if (pLabel->LabelType == ELabelType::Data && pLabel->Global)
-				state.GlobalDataItems.push_back(pLabel);
-			if (pLabel->LabelType == ELabelType::Function)
-				state.GlobalFunctions.push_back(pLabel);
+			segment.DataItems.clear();
+			segment.Functions.clear();
+
+			FLabelInfo* const* pLabels = pPage->Labels;
+			for (int pageAddr = 0; pageAddr < FCodeAnalysisPage::kPageSize; pageAddr++)
+			{
+				FLabelInfo* pLabel = pLabels[pageAddr];
+
+				if (pLabel != nullptr)
+				{
+					if (pLabel->LabelType == ELabelType::Data && pLabel->Global)
+						segment.DataItems.push_back(pLabel);
+					if (pLabel->LabelType == ELabelType::Function)
+						segment.Functions.push_back(pLabel);
+				}
+			}
+			segment.bDirty = false;
 		}
-		
+		noDataItems += segment.DataItems.size();
+		noFunctions += segment.Functions.size();
 	}
 
+	// stitch segments together
+	state.GlobalDataItems.clear();
+	state.GlobalDataItems.reserve(noDataItems);
+	state.GlobalFunctions.clear();
+	state.GlobalFunctions.reserve(noFunctions);
+	for (const FGlobalLabelSegment& segment : state.GlobalLabelSegments)
+	{
+		state.GlobalDataItems.insert(state.GlobalDataItems.end(), segment.DataItems.begin(), segment.DataItems.end());
+		state.GlobalFunctions.insert(state.GlobalFunctions.end(), segment.Functions.begin(), segment.Functions.end());
+	}
+
+	state.bGlobalLabelsDirty = false;
 	state.bRebuildFilteredGlobalDataItems = true;
 	state.bRebuildFilteredGlobalFunctions = true;
 }
 
+// Generate Global Info for items in address space
+void GenerateGlobalInfo(FCodeAnalysisState &state)
+{
+	for (FGlobalLabelSegment& segment : state.GlobalLabelSegments)
+		segment.bDirty = true;
+	state.bGlobalLabelsDirty = true;
+
+	UpdateGlobalInfo(state);
+}
+
 void InitialiseCodeAnalysis(FCodeAnalysisState &state, ICPUInterface* pCPUInterface)
 {
 	InitImageViewers();
@@ -679,6 +638,13 @@ void InitialiseCodeAnalysis(FCodeAnalysisState &state, ICPUInterface* pCPUInterf
 	state.InitWatches();
 	state.ResetLabelNames();
 	state.ItemList.clear();
+	for (FItemListSegment& segment : state.ItemListSegments)
+	{
+		segment.Items.clear();
+		segment.CommentLines.clear();	// freed with the other items below
+		segment.FirstItemAddress = 0;
+	}
+	state.SetCodeAnalysisDirty();
 
 	// This won't work with banked memory
 	// we need to reset all the banks
@@ -708,14 +674,20 @@ void InitialiseCodeAnalysis(FCodeAnalysisState &state, ICPUInterface* pCPUInterf
 			pPage->CodeInfo[addr] = nullptr;
 			assert(pPage->DataInfo[addr].Address == pPage->BaseAddress + addr);
 			pPage->DataInfo[addr].Reset(pPage->BaseAddress + addr);
+			pPage->LastFrameRead[addr] = -1;
+			pPage->LastFrameWritten[addr] = -1;
 			pPage->MachineState[addr] = nullptr;
 		}
 	}
 
+	// memory may have been loaded without going through WriteByte e.g. quickloading a snapshot
+	InvalidateAllDecodedInstructions(state);
+
 	FreeMachineStates(state);
 	FLabelInfo::FreeAll();
 	FCodeInfo::FreeAll();
 	FCommentBlock::FreeAll();
+	FCommentLine::FreeAll();
 
 	for (int i = 0; i < FCodeAnalysisState::kNoViewStates; i++)
 	{
@@ -724,6 +696,7 @@ void InitialiseCodeAnalysis(FCodeAnalysisState &state, ICPUInterface* pCPUInterf
 	}
 
 	state.CPUInterface = pCPUInterface;
+	ResetStaticAnalysis(state);
 	uint16_t initialPC = pCPUInterface->GetPC();
 	RunStaticCodeAnalysis(state, initialPC);
 
@@ -796,7 +769,7 @@ void SetItemText(FCodeAnalysisState &state, FItem *pItem)
 			else
 			{
 				pDataItem->DataType = EDataType::Text;
-				state.SetCodeAnalysisDirty();
+				state.SetAddressRangeDirty(pDataItem->Address, pDataItem->ByteSize);
 			}
 		}
 	}
@@ -845,11 +818,7 @@ void RemoveLabelAtAddress(FCodeAnalysisState &state, uint16_t address)
 
 	if (pLabelInfo != nullptr)
 	{
-		state.SetLabelForAddress(address, nullptr);
-		// Remove from globals
-		if (pLabelInfo->Global || pLabelInfo->LabelType == ELabelType::Function)
-			GenerateGlobalInfo(state);
-
+		state.SetLabelForAddress(address, nullptr);	// also removes from globals
 		state.SetCodeAnalysisDirty();
 	}
 }
@@ -862,6 +831,10 @@ void SetLabelName(FCodeAnalysisState &state, FLabelInfo *pLabel, const char *pTe
 	state.RemoveLabelName(pLabel->Name);
 	pLabel->Name = pText;
 	state.EnsureUniqueLabelName(pLabel->Name);
+
+	// order is by address so only the name filters need updating
+	state.bRebuildFilteredGlobalDataItems = true;
+	state.bRebuildFilteredGlobalFunctions = true;
 }
 
 void SetItemCommentText(FCodeAnalysisState &state, FItem *pItem, const char *pText)
@@ -931,18 +904,6 @@ void FormatData(FCodeAnalysisState& state, const FDataFormattingOptions& options
 
 
 
-// number output abstraction
-IDasmNumberOutput* g_pNumberOutputObj = nullptr;
-IDasmNumberOutput* GetNumberOutput()
-{
-	return g_pNumberOutputObj;
-}
-
-void SetNumberOutput(IDasmNumberOutput* pNumberOutputObj)
-{
-	g_pNumberOutputObj = pNumberOutputObj;
-}
-
 // machine state
 FMachineState* AllocateMachineState(FCodeAnalysisState& state)
 {
@@ -7,6 +7,9 @@
 #include <algorithm>
 
 #include "CodeAnaysisPage.h"
+#include "Breakpoints.h"
+#include "StaticAnalysis.h"
+#include "CodeTextCache.h"
 
 #define USE_PAGING 1
 
@@ -31,6 +34,8 @@ typedef void (*FDasmOutput)(char c, void* user_data);
 class ICPUInterface
 {
 public:
+	virtual ~ICPUInterface() = default;
+
 	virtual uint8_t		ReadByte(uint16_t address) const = 0;
 	virtual uint16_t	ReadWord(uint16_t address) const = 0;
 	virtual const uint8_t*	GetMemPtr(uint16_t address) const = 0;
@@ -52,6 +57,11 @@ public:
 	virtual void	StepScreenWrite() = 0;
 	virtual void	GraphicsViewerSetView(uint16_t address, int charWidth) = 0;
 
+	// reverse stepping - optional
+	virtual bool	CanStepBack(void) const { return false; }
+	virtual void	StepBackInto() {}
+	virtual void	StepBackOver() {}
+
 	virtual bool	ShouldExecThisFrame(void) const = 0;
 	virtual bool	IsStopped(void) const = 0;
 
@@ -60,26 +70,6 @@ public:
 	ECPUType	CPUType = ECPUType::Unknown;
 };
 
-typedef void (*z80dasm_output_t)(char c, void* user_data);
-
-class IDasmNumberOutput
-{
-public:
-
-	virtual void OutputU8(uint8_t val, z80dasm_output_t out_cb) = 0;
-	virtual void OutputU16(uint16_t val, z80dasm_output_t out_cb) = 0;
-	virtual void OutputD8(int8_t val, z80dasm_output_t out_cb) = 0;
-};
-
-class FDasmStateBase : public IDasmNumberOutput
-{
-public:
-	FCodeAnalysisState*		CodeAnalysisState;
-	uint16_t				CurrentAddress;
-	std::string				Text;
-};
-
-
 struct FMemoryAccess
 {
 	uint16_t	Address;
@@ -184,6 +174,24 @@ private:
 	FItem* pCursorItem = nullptr;
 };
 
+// Items for a page sized slice of the address space
+// The item list is made from these so only slices that have changed need rebuilding
+struct FItemListSegment
+{
+	std::vector<FItem*>			Items;
+	std::vector<FCommentLine*>	CommentLines;	// comment lines created for this segment - reused on rebuild
+	int							FirstItemAddress = 0;	// items from the previous segment can overlap the start of this one
+	bool						bDirty = true;
+};
+
+// global labels for a page sized segment of the address space, rebuilt when labels in it change
+struct FGlobalLabelSegment
+{
+	std::vector<FLabelInfo*>	DataItems;
+	std::vector<FLabelInfo*>	Functions;
+	bool						bDirty = true;
+};
+
 struct FCodeAnalysisConfig
 {
 	bool bShowOpcodeValues = false;
@@ -213,9 +221,18 @@ struct FCodeAnalysisState
 	int16_t					GetAddressWritePageId(uint16_t addr) { return GetWritePage(addr)->PageId; }
 	const std::vector< FCodeAnalysisPage*>& GetRegisteredPages() const { return RegisteredPages; }
 
-	FCodeAnalysisPage*		ReadPageTable[kAddressSize / FCodeAnalysisPage::kPageSize];
-	FCodeAnalysisPage*		WritePageTable[kAddressSize / FCodeAnalysisPage::kPageSize];
-	void					SetCodeAnalysisReadPage(int pageNo, FCodeAnalysisPage* pPage) { ReadPageTable[pageNo] = pPage; pPage->bUsed = true; }
+	FCodeAnalysisPage*		ReadPageTable[kAddressSize / FCodeAnalysisPage::kPageSize] = { nullptr };
+	FCodeAnalysisPage*		WritePageTable[kAddressSize / FCodeAnalysisPage::kPageSize] = { nullptr };
+	void					SetCodeAnalysisReadPage(int pageNo, FCodeAnalysisPage* pPage) 
+	{ 
+		if (ReadPageTable[pageNo] != pPage)
+		{
+			ItemListSegments[pageNo].bDirty = true;
+			SetGlobalLabelsDirty((uint16_t)(pageNo << kPageShift));
+		}
+		ReadPageTable[pageNo] = pPage; 
+		pPage->bUsed = true; 
+	}
 	void					SetCodeAnalysisWritePage(int pageNo, FCodeAnalysisPage* pPage) { WritePageTable[pageNo] = pPage; pPage->bUsed = true;}
 	void					SetCodeAnalysisRWPage(int pageNo, FCodeAnalysisPage* pReadPage, FCodeAnalysisPage *pWritePage)
 	{
@@ -223,9 +240,24 @@ struct FCodeAnalysisState
 		SetCodeAnalysisWritePage(pageNo, pWritePage);
 	}
 
+	// marks the whole item list for rebuild
 	void	SetCodeAnalysisDirty(bool val = true) 
 	{ 
 		bCodeAnalysisDataDirty = val; 
+		if (val)
+		{
+			for (FItemListSegment& segment : ItemListSegments)
+				segment.bDirty = true;
+		}
+	}
+
+	// only rebuild the item list for an address range
+	void	SetAddressRangeDirty(uint16_t addr, int size = 1)
+	{
+		const int lastAddr = std::min(addr + size - 1, kAddressSize - 1);
+		for (int segmentNo = addr >> kPageShift; segmentNo <= (lastAddr >> kPageShift); segmentNo++)
+			ItemListSegments[segmentNo].bDirty = true;
+		bCodeAnalysisDataDirty = true;
 	}
 
 	bool IsCodeAnalysisDataDirty() const { return bCodeAnalysisDataDirty; }
@@ -262,15 +294,28 @@ private:
 public:
 
 	bool					bRegisterDataAccesses = true;
+	bool					bCacheDecodedInstructions = true;	// off decodes every executed instruction - for benchmarking
 
 	std::vector< FItem *>	ItemList;
+	FItemListSegment		ItemListSegments[kAddressSize / FCodeAnalysisPage::kPageSize];
 
+	// global lists are stitched together from segments by UpdateGlobalInfo
 	std::vector< FLabelInfo*>	GlobalDataItems;
 	bool						bRebuildFilteredGlobalDataItems = true;
 	
 	std::vector< FLabelInfo*>	GlobalFunctions;
 	bool						bRebuildFilteredGlobalFunctions = true;
 
+	FGlobalLabelSegment			GlobalLabelSegments[kAddressSize / FCodeAnalysisPage::kPageSize];
+	bool						bGlobalLabelsDirty = true;
+
+	// call when a label is added, removed or changes type
+	void	SetGlobalLabelsDirty(uint16_t addr)
+	{
+		GlobalLabelSegments[addr >> kPageShift].bDirty = true;
+		bGlobalLabelsDirty = true;
+	}
+
 	static const int kNoViewStates = 4;
 	FCodeAnalysisViewState	ViewState[kNoViewStates];	// new multiple view states
 	int						FocussedWindowId = 0;
@@ -278,12 +323,25 @@ public:
 	FCodeAnalysisViewState& GetAltViewState() { return ViewState[FocussedWindowId ^ 1]; }
 	
 	std::set<uint16_t>		Watches;	// addresses to use as watches
+
+	std::vector<FBreakpoint>	Breakpoints;
+	int							LastHitBreakpoint = -1;
+	bool						bBreakpointConditions = false;	// an enabled breakpoint has a condition - they need the registers in the trap
+
+	bool	IsExecBreakpointed(uint16_t addr) const { return TestBreakpointBit(GetReadPage(addr)->ExecBreakpoints, addr); }
+	bool	IsReadBreakpointed(uint16_t addr) const { return TestBreakpointBit(GetReadPage(addr)->ReadBreakpoints, addr); }
+	bool	IsWriteBreakpointed(uint16_t addr) const { return TestBreakpointBit(GetWritePage(addr)->WriteBreakpoints, addr); }
+
 	std::vector<FCPUFunctionCall>	CallStack;
 	uint16_t				StackMin;
 	uint16_t				StackMax;
 
 	std::vector<uint16_t>	FrameTrace;
 
+	FCodeTextCache			CodeTextCache;	// disassembly text, generated when drawn or exported
+
+	FStaticAnalysis			StaticAnalysis;
+
 	int						KeyConfig[(int)EKey::Count];
 
 	std::vector< class FCommand *>	CommandStack;
@@ -328,17 +386,24 @@ public:
 		if(pLabel != nullptr)	// ensure no name clashes
 			EnsureUniqueLabelName(pLabel->Name);
 		GetReadPage(addr)->Labels[addr & kPageMask] = pLabel; 
+		SetAddressRangeDirty(addr);
+		SetGlobalLabelsDirty(addr);
 	}
 
 	FCommentBlock* GetCommentBlockForAddress(uint16_t addr) const { return GetReadPage(addr)->CommentBlocks[addr & kPageMask]; }
 	void SetCommentBlockForAddress(uint16_t addr, FCommentBlock* pCommentBlock)
 	{
 		GetReadPage(addr)->CommentBlocks[addr & kPageMask] = pCommentBlock;
+		SetAddressRangeDirty(addr);
 	}
 
 	const FCodeInfo* GetCodeInfoForAddress(uint16_t addr) const { return GetReadPage(addr)->CodeInfo[addr & kPageMask]; }
 	FCodeInfo* GetCodeInfoForAddress(uint16_t addr) { return GetReadPage(addr)->CodeInfo[addr & kPageMask]; }
-	void SetCodeInfoForAddress(uint16_t addr, FCodeInfo* pCodeInfo) { GetReadPage(addr)->CodeInfo[addr & kPageMask] = pCodeInfo; }
+	void SetCodeInfoForAddress(uint16_t addr, FCodeInfo* pCodeInfo) 
+	{ 
+		GetReadPage(addr)->CodeInfo[addr & kPageMask] = pCodeInfo; 
+		SetAddressRangeDirty(addr);
+	}
 
 	const FDataInfo* GetReadDataInfoForAddress(uint16_t addr) const { return &GetReadPage(addr)->DataInfo[addr & kPageMask]; }
 	FDataInfo* GetReadDataInfoForAddress(uint16_t addr) { return &GetReadPage(addr)->DataInfo[addr & kPageMask]; }
@@ -346,6 +411,9 @@ public:
 	const FDataInfo* GetWriteDataInfoForAddress(uint16_t addr) const { return  &GetWritePage(addr)->DataInfo[addr & kPageMask]; }
 	FDataInfo* GetWriteDataInfoForAddress(uint16_t addr) { return &GetWritePage(addr)->DataInfo[addr & kPageMask]; }
 
+	int GetLastFrameReadForAddress(uint16_t addr) const { return GetReadPage(addr)->LastFrameRead[addr & kPageMask]; }
+	int GetLastFrameWrittenForAddress(uint16_t addr) const { return GetWritePage(addr)->LastFrameWritten[addr & kPageMask]; }
+
 	uint16_t GetLastWriterForAddress(uint16_t addr) const { return GetWritePage(addr)->LastWriter[addr & kPageMask]; }
 	void SetLastWriterForAddress(uint16_t addr, uint16_t lastWriter) { GetWritePage(addr)->LastWriter[addr & kPageMask] = lastWriter; }
 
@@ -353,8 +421,6 @@ public:
 	void SetMachineStateForAddress(uint16_t addr, FMachineState* pMachineState) { GetReadPage(addr)->MachineState[addr & kPageMask] = pMachineState; }
 
 	bool FindMemoryPattern(uint8_t* pData, size_t dataSize, uint16_t offset, uint16_t& outAddr);
-
-	void FindAsciiStrings(uint16_t startAddress);
 };
 
 // Analysis
@@ -365,10 +431,15 @@ bool RegisterCodeExecuted(FCodeAnalysisState &state, uint16_t pc, uint16_t nextp
 void ReAnalyseCode(FCodeAnalysisState &state);
 uint16_t WriteCodeInfoForAddress(FCodeAnalysisState& state, uint16_t pc);
 void GenerateGlobalInfo(FCodeAnalysisState &state);
+void UpdateGlobalInfo(FCodeAnalysisState &state);
 void RegisterDataRead(FCodeAnalysisState& state, uint16_t pc, uint16_t dataAddr);
 void RegisterDataWrite(FCodeAnalysisState &state, uint16_t pc, uint16_t dataAddr);
-void UpdateCodeInfoForAddress(FCodeAnalysisState &state, uint16_t pc);
+const char* GetCodeInfoText(FCodeAnalysisState& state, const FCodeInfo* pCodeInfo);
 void ResetReferenceInfo(FCodeAnalysisState &state);
+const FDecodedInstruction& GetDecodedInstruction(FCodeAnalysisState& state, uint16_t pc);
+void InvalidateDecodedInstructions(FCodeAnalysisPage& page, uint16_t pageAddr);
+void InvalidateDecodedInstructions(FCodeAnalysisState& state, uint16_t addr);
+void InvalidateAllDecodedInstructions(FCodeAnalysisState& state);
 
 std::string GetItemText(FCodeAnalysisState& state, uint16_t address);
 
@@ -389,10 +460,6 @@ void SetItemCommentText(FCodeAnalysisState &state, FItem *pItem, const char *pTe
 
 void FormatData(FCodeAnalysisState& state, const FDataFormattingOptions& options);
 
-// number output abstraction
-IDasmNumberOutput* GetNumberOutput();
-void SetNumberOutput(IDasmNumberOutput* pNumberOutputObj);
-
 // machine state
 FMachineState* AllocateMachineState(FCodeAnalysisState& state);
 void FreeMachineStates(FCodeAnalysisState& state);
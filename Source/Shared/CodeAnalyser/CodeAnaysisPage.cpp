@@ -3,16 +3,19 @@
 
 #include "Util/MemoryBuffer.h"
 #include "Util/GraphicsView.h"
+#include <algorithm>
 #include <cassert>
+#include <iterator>
 #include <string.h>
 
 //#include "json.hpp"
-std::vector<FCodeInfo*>		FCodeInfo::AllocatedList;
-std::vector<FLabelInfo*>	FLabelInfo::AllocatedList;
-std::vector<FCommentBlock*>	FCommentBlock::AllocatedList;
+// Allocation lists are per thread so independent analysers can run on worker threads
+thread_local std::vector<FCodeInfo*>		FCodeInfo::AllocatedList;
+thread_local std::vector<FLabelInfo*>		FLabelInfo::AllocatedList;
+thread_local std::vector<FCommentBlock*>	FCommentBlock::AllocatedList;
 
-std::vector<FCommentLine*>	FCommentLine::AllocatedList;
-std::vector<FCommentLine*>	FCommentLine::FreeList;
+thread_local std::vector<FCommentLine*>	FCommentLine::AllocatedList;
+thread_local std::vector<FCommentLine*>	FCommentLine::FreeList;
 
 FImageData::~FImageData() 
 { 
@@ -79,9 +82,12 @@ FCommentLine* FCommentLine::Allocate()
 void FCommentLine::FreeAll()
 {
 	for (auto it : AllocatedList)
-		FreeList.push_back(it);
+		delete it;
+	for (auto it : FreeList)
+		delete it;
 
 	AllocatedList.clear();
+	FreeList.clear();
 }
 
 
@@ -95,6 +101,11 @@ void FCodeAnalysisPage::Initialise(uint16_t address)
 	memset(CodeInfo, 0, sizeof(CodeInfo));
 	memset(CommentBlocks, 0, sizeof(CommentBlocks));
 	memset(LastWriter, 0, sizeof(LastWriter));
+	std::fill(std::begin(DecodedInstructions), std::end(DecodedInstructions), FDecodedInstruction());
+	memset(ExecBreakpoints, 0, sizeof(ExecBreakpoints));
+	memset(ReadBreakpoints, 0, sizeof(ReadBreakpoints));
+	memset(WriteBreakpoints, 0, sizeof(WriteBreakpoints));
+	memset(BasicBlockIndex, 0xff, sizeof(BasicBlockIndex));
 
 	for (int addr = 0; addr < FCodeAnalysisPage::kPageSize; addr++)
 	{
@@ -103,6 +114,9 @@ void FCodeAnalysisPage::Initialise(uint16_t address)
 		dataInfo.Address = BaseAddress + (uint16_t)addr;
 		dataInfo.ByteSize = 1;
 		dataInfo.DataType = EDataType::Byte;
+
+		LastFrameRead[addr] = -1;
+		LastFrameWritten[addr] = -1;
 	}
 }
 
@@ -128,6 +142,9 @@ void FCodeAnalysisPage::ChangeAddress(uint16_t newAddress)
 			CommentBlocks[addr]->Address = (CommentBlocks[addr]->Address - BaseAddress) + newAddress;
 	}
 
+	// decoded relative jump targets depend on the address
+	std::fill(std::begin(DecodedInstructions), std::end(DecodedInstructions), FDecodedInstruction());
+
 	BaseAddress = newAddress;
 }
 
@@ -186,7 +203,7 @@ void ReadItemFromBuffer( FItem& item, FMemoryBuffer& buffer)
 	buffer.Read(item.ByteSize);
 }
 
-void WriteReferencesToBuffer(const std::map<uint16_t, int>& references, FMemoryBuffer& buffer)
+void WriteReferencesToBuffer(const FCodeReferenceSet& references, FMemoryBuffer& buffer)
 {
 	buffer.Write((uint16_t)references.size());
 	for (const auto& ref : references)
@@ -195,7 +212,7 @@ void WriteReferencesToBuffer(const std::map<uint16_t, int>& references, FMemoryB
 	}
 }
 
-void ReadReferencesFromBuffer(std::map<uint16_t, int>& references, FMemoryBuffer& buffer)
+void ReadReferencesFromBuffer(FCodeReferenceSet& references, FMemoryBuffer& buffer)
 {
 	const uint16_t count = buffer.Read<uint16_t>();
 	for (int i = 0; i < count; i++)
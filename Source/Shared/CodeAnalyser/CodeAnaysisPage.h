@@ -6,6 +6,7 @@
 #include <vector>
 
 #include <Util/Misc.h>
+#include "CodeReferenceSet.h"
 
 class FMemoryBuffer;
 
@@ -63,12 +64,13 @@ struct FLabelInfo : FItem
 	std::string				Name;
 	bool					Global = false;
 	ELabelType				LabelType = ELabelType::Data;
-	std::map<uint16_t, int>	References;
+	FCodeReferenceSet		References;
 private:
+	friend struct FAnalysisSnapshot;	// deletes its copies
 	FLabelInfo() { Type = EItemType::Label; }
 	~FLabelInfo() = default;
 
-	static std::vector<FLabelInfo*>	AllocatedList;
+	static thread_local std::vector<FLabelInfo*>	AllocatedList;
 };
 
 struct FCodeInfo : FItem
@@ -77,7 +79,6 @@ struct FCodeInfo : FItem
 	static void FreeAll();
 
 	EOperandType	OperandType = EOperandType::Unknown;
-	std::string		Text;				// Disassembly text
 	uint16_t		JumpAddress = 0;	// optional jump address
 	uint16_t		PointerAddress = 0;	// optional pointer address
 	int				FrameLastExecuted = -1;
@@ -96,10 +97,11 @@ struct FCodeInfo : FItem
 	bool	bNOPped = false;
 	uint8_t	OpcodeBkp[4] = { 0 };
 private:
+	friend struct FAnalysisSnapshot;
 	FCodeInfo() :FItem(){Type = EItemType::Code;	}
 	~FCodeInfo() = default;
 
-	static std::vector<FCodeInfo*>	AllocatedList;
+	static thread_local std::vector<FCodeInfo*>	AllocatedList;
 };
 
 
@@ -151,9 +153,7 @@ struct FDataInfo : FItem
 		DataType = EDataType::Byte;
 		OperandType = EOperandType::Unknown;
 		Comment.clear();
-		LastFrameRead = -1;
 		Reads.clear();
-		LastFrameWritten = -1;
 		Writes.clear();
 	}
 
@@ -184,10 +184,8 @@ struct FDataInfo : FItem
 		};
 	};
 
-	int						LastFrameRead = -1;
-	std::map<uint16_t, int>	Reads;	// address and counts of data access instructions
-	int						LastFrameWritten = -1;
-	std::map<uint16_t, int>	Writes;	// address and counts of data access instructions
+	FCodeReferenceSet		Reads;	// address and counts of data access instructions
+	FCodeReferenceSet		Writes;	// address and counts of data access instructions
 };
 
 struct FCommentBlock : FItem
@@ -196,9 +194,10 @@ struct FCommentBlock : FItem
 	static void FreeAll();
 
 private:
+	friend struct FAnalysisSnapshot;
 	FCommentBlock() : FItem() { Type = EItemType::CommentBlock; }
 	~FCommentBlock() = default;
-	static std::vector<FCommentBlock*>	AllocatedList;
+	static thread_local std::vector<FCommentBlock*>	AllocatedList;
 };
 
 struct FCommentLine : FItem
@@ -210,8 +209,8 @@ private:
 	FCommentLine() : FItem() { Type = EItemType::CommentLine; }
 	~FCommentLine() = default;
 
-	static std::vector<FCommentLine*>	AllocatedList;
-	static std::vector<FCommentLine*>	FreeList;
+	static thread_local std::vector<FCommentLine*>	AllocatedList;
+	static thread_local std::vector<FCommentLine*>	FreeList;
 };
 
 // abstract machine state class - device specific
@@ -220,6 +219,29 @@ struct FMachineState
 
 };
 
+// Decoded instruction info cached per address so executed code doesn't need decoding every time
+// Invalidated when any of the instruction's bytes are written to
+struct FDecodedInstruction
+{
+	uint16_t	JumpAddress = 0;
+	uint16_t	PointerAddress = 0;
+	uint8_t		Opcode = 0;		// first instruction byte
+	uint8_t		ByteSize = 0;
+
+	union
+	{
+		struct
+		{
+			bool	bValid : 1;
+			bool	bJump : 1;
+			bool	bCall : 1;
+			bool	bPointerRef : 1;
+			bool	bStop : 1;
+		};
+		uint8_t	Flags = 0;
+	};
+};
+
 struct FCodeAnalysisPage
 {
 	void Initialise(uint16_t address);
@@ -238,7 +260,23 @@ struct FCodeAnalysisPage
 	FCodeInfo*		CodeInfo[kPageSize];
 	FDataInfo		DataInfo[kPageSize];
 	FCommentBlock*	CommentBlocks[kPageSize];
+
+	// Per address access info is kept in dense arrays so scans across memory don't have to touch DataInfo.
+	// Only these have been split out - type, size & flags, comments and Reads/Writes are still in FDataInfo
+	// as the UI, commands & serialisers all work through FDataInfo pointers.
+	int				LastFrameRead[kPageSize];
+	int				LastFrameWritten[kPageSize];
 	uint16_t		LastWriter[kPageSize];
 
 	FMachineState*	MachineState[kPageSize];
+
+	FDecodedInstruction	DecodedInstructions[kPageSize];
+
+	// breakpoint bitmaps - a bit per address, built by UpdateBreakpointBitmaps
+	uint64_t		ExecBreakpoints[kPageSize / 64];
+	uint64_t		ReadBreakpoints[kPageSize / 64];
+	uint64_t		WriteBreakpoints[kPageSize / 64];
+
+	// static analysis basic block for each address, -1 if none - see StaticAnalysis.h
+	int32_t			BasicBlockIndex[kPageSize];
 };
\ No newline at end of file
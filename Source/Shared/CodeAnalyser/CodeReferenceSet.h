@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// Compact set of code addresses that reference an item, with a count for each address.
+// Entries are kept sorted in one small heap block so an empty set costs no allocation and lookups don't chase tree nodes.
+// Iterates like the std::map<uint16_t,int> it replaces - 'first' is the address & 'second' the count.
+class FCodeReferenceSet
+{
+public:
+	struct FEntry
+	{
+		uint16_t	first;	// address
+		int			second;	// count
+	};
+
+	FCodeReferenceSet() = default;
+	~FCodeReferenceSet() { free(Entries); }
+
+	FCodeReferenceSet(const FCodeReferenceSet& other) { *this = other; }
+	FCodeReferenceSet(FCodeReferenceSet&& other) noexcept
+		: Entries(other.Entries), Count(other.Count), Capacity(other.Capacity), LastIndex(other.LastIndex)
+	{
+		other.Entries = nullptr;
+		other.Count = other.Capacity = other.LastIndex = 0;
+	}
+
+	FCodeReferenceSet& operator=(const FCodeReferenceSet& other)
+	{
+		if (this == &other)
+			return *this;
+		clear();
+		if (other.Count > 0)
+		{
+			Entries = (FEntry*)malloc(other.Count * sizeof(FEntry));
+			memcpy(Entries, other.Entries, other.Count * sizeof(FEntry));
+			Count = Capacity = other.Count;
+		}
+		return *this;
+	}
+
+	FCodeReferenceSet& operator=(FCodeReferenceSet&& other) noexcept
+	{
+		if (this != &other)
+		{
+			free(Entries);
+			Entries = other.Entries;
+			Count = other.Count;
+			Capacity = other.Capacity;
+			LastIndex = other.LastIndex;
+			other.Entries = nullptr;
+			other.Count = other.Capacity = other.LastIndex = 0;
+		}
+		return *this;
+	}
+
+	bool	empty() const { return Count == 0; }
+	size_t	size() const { return Count; }
+
+	void	clear()
+	{
+		free(Entries);
+		Entries = nullptr;
+		Count = Capacity = LastIndex = 0;
+	}
+
+	FEntry* begin() { return Entries; }
+	FEntry* end() { return Entries + Count; }
+	const FEntry* begin() const { return Entries; }
+	const FEntry* end() const { return Entries + Count; }
+
+	// Returns the count for an address, adding it if it's not in the set
+	int& operator[](uint16_t address)
+	{
+		// the same instruction usually accesses an item repeatedly
+		if (LastIndex < Count && Entries[LastIndex].first == address)
+			return Entries[LastIndex].second;
+
+		const int index = LowerBound(address);
+		if (index == Count || Entries[index].first != address)
+		{
+			if (Count == kMaxEntries)	// full - can't happen with real code
+			{
+				static thread_local int overflowCount;
+				return overflowCount;
+			}
+			Insert(index, address);
+		}
+
+		LastIndex = (uint16_t)index;
+		return Entries[index].second;
+	}
+
+	// Registers an access from an address
+	void	RegisterAccess(uint16_t address) { (*this)[address]++; }
+
+	bool	contains(uint16_t address) const
+	{
+		const int index = LowerBound(address);
+		return index < Count && Entries[index].first == address;
+	}
+
+private:
+	static const uint16_t kMaxEntries = 0xffff;
+
+	int		LowerBound(uint16_t address) const
+	{
+		int lo = 0, hi = Count;
+		while (lo < hi)
+		{
+			const int mid = (lo + hi) >> 1;
+			if (Entries[mid].first < address)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo;
+	}
+
+	void	Insert(int index, uint16_t address)
+	{
+		if (Count == Capacity)
+		{
+			// most items only have a few accessors so start small
+			Capacity = Capacity == 0 ? 2 : (Capacity >= kMaxEntries / 2 ? kMaxEntries : Capacity * 2);
+			Entries = (FEntry*)realloc(Entries, Capacity * sizeof(FEntry));
+		}
+		memmove(&Entries[index + 1], &Entries[index], (Count - index) * sizeof(FEntry));
+		Entries[index].first = address;
+		Entries[index].second = 0;
+		Count++;
+	}
+
+	FEntry*		Entries = nullptr;
+	uint16_t	Count = 0;
+	uint16_t	Capacity = 0;
+	uint16_t	LastIndex = 0;
+};
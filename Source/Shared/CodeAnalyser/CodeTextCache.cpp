@@ -0,0 +1,77 @@
+#include "CodeTextCache.h"
+
+void FCodeTextCache::Unlink(int index)
+{
+	FEntry& entry = Entries[index];
+	if (entry.Prev != -1)
+		Entries[entry.Prev].Next = entry.Next;
+	else
+		Head = entry.Next;
+	if (entry.Next != -1)
+		Entries[entry.Next].Prev = entry.Prev;
+	else
+		Tail = entry.Prev;
+	entry.Prev = entry.Next = -1;
+}
+
+void FCodeTextCache::LinkAtHead(int index)
+{
+	FEntry& entry = Entries[index];
+	entry.Prev = -1;
+	entry.Next = Head;
+	if (Head != -1)
+		Entries[Head].Prev = index;
+	Head = index;
+	if (Tail == -1)
+		Tail = index;
+}
+
+const char* FCodeTextCache::Find(uint64_t key)
+{
+	auto it = Lookup.find(key);
+	if (it == Lookup.end())
+		return nullptr;
+
+	if (it->second != Head)
+	{
+		Unlink(it->second);
+		LinkAtHead(it->second);
+	}
+	return Entries[it->second].Text;
+}
+
+char* FCodeTextCache::Add(uint64_t key)
+{
+	if (Entries.empty())
+	{
+		Entries.resize(kNoEntries);
+		Lookup.reserve(kNoEntries);
+	}
+
+	int index;
+	if (NoUsed < kNoEntries)
+	{
+		index = NoUsed++;
+	}
+	else
+	{
+		// reuse least recently used
+		index = Tail;
+		Lookup.erase(Entries[index].Key);
+		Unlink(index);
+	}
+
+	FEntry& entry = Entries[index];
+	entry.Key = key;
+	entry.Text[0] = 0;
+	Lookup[key] = index;
+	LinkAtHead(index);
+	return entry.Text;
+}
+
+void FCodeTextCache::Clear()
+{
+	Lookup.clear();
+	NoUsed = 0;
+	Head = Tail = -1;
+}
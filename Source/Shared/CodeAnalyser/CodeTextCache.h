@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Bounded LRU cache of instruction disassembly text
+// Keys include the instruction bytes & display settings so self modifying code & format changes just miss the cache
+class FCodeTextCache
+{
+public:
+	static const int	kNoEntries = 4096;
+	static const int	kMaxTextLength = 40;
+
+	const char*	Find(uint64_t key);	// nullptr if not cached
+	char*		Add(uint64_t key);	// returns buffer of kMaxTextLength to write the text to - evicts the least recently used
+	void		Clear();
+
+private:
+	struct FEntry
+	{
+		uint64_t	Key = 0;
+		int			Prev = -1;	// towards most recently used
+		int			Next = -1;	// towards least recently used
+		char		Text[kMaxTextLength];
+	};
+
+	void	Unlink(int index);
+	void	LinkAtHead(int index);
+
+	std::vector<FEntry>				Entries;	// allocated on first use so analysis snapshots that are only saved don't pay for it
+	std::unordered_map<uint64_t, int>	Lookup;
+	int		NoUsed = 0;
+	int		Head = -1;	// most recently used
+	int		Tail = -1;	// least recently used
+};
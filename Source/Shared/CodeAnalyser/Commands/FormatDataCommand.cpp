@@ -0,0 +1,51 @@
+#include "FormatDataCommand.h"
+
+void FFormatDataCommand::Do(FCodeAnalysisState& state)
+{
+	OldDataInfo.clear();
+	AddedLabels.clear();
+
+	for (const FDataFormattingOptions& format : Formats)
+	{
+		if (format.IsValid() == false)
+			continue;
+
+		for (int itemNo = 0; itemNo < format.NoItems; itemNo++)
+		{
+			const uint16_t itemAddress = (uint16_t)(format.StartAddress + itemNo * format.ItemSize);
+			const FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(itemAddress);
+			OldDataInfo.push_back({ itemAddress, pDataInfo->DataType, pDataInfo->ByteSize, pDataInfo->Flags });
+		}
+
+		if (format.AddLabelAtStart && state.GetLabelForAddress(format.StartAddress) == nullptr)
+			AddedLabels.push_back(format.StartAddress);
+
+		FormatData(state, format);
+
+		// pick up bit 7 terminated strings
+		if (format.DataType == EDataType::Text)
+		{
+			FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(format.StartAddress);
+			pDataInfo->bBit7Terminator = (state.CPUInterface->ReadByte(format.CalcEndAddress()) & 0x80) != 0;
+		}
+	}
+
+	state.SetCodeAnalysisDirty();
+}
+
+void FFormatDataCommand::Undo(FCodeAnalysisState& state)
+{
+	// reverse order so overlapping formats unwind correctly
+	for (auto it = OldDataInfo.rbegin(); it != OldDataInfo.rend(); ++it)
+	{
+		FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(it->Address);
+		pDataInfo->DataType = it->DataType;
+		pDataInfo->ByteSize = it->ByteSize;
+		pDataInfo->Flags = it->Flags;
+	}
+
+	for (uint16_t labelAddress : AddedLabels)
+		RemoveLabelAtAddress(state, labelAddress);
+
+	state.SetCodeAnalysisDirty();
+}
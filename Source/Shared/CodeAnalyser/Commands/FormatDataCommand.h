@@ -0,0 +1,30 @@
+#pragma once
+#include "CommandProcessor.h"
+#include "../CodeAnalyser.h"
+
+#include <vector>
+
+// Formats a batch of data ranges in one undoable step
+// Code info and labels cleared by the formatting options aren't restored on undo
+class FFormatDataCommand : public FCommand
+{
+public:
+	FFormatDataCommand(const std::vector<FDataFormattingOptions>& formats) :Formats(formats) {}
+
+	virtual void Do(FCodeAnalysisState& state) override;
+	virtual void Undo(FCodeAnalysisState& state) override;
+
+	std::vector<FDataFormattingOptions>	Formats;
+
+private:
+	struct FOldDataInfo
+	{
+		uint16_t	Address;
+		EDataType	DataType;
+		uint16_t	ByteSize;
+		uint32_t	Flags;
+	};
+
+	std::vector<FOldDataInfo>	OldDataInfo;
+	std::vector<uint16_t>		AddedLabels;
+};
@@ -34,23 +34,46 @@ void FSetItemDataCommand::Do(FCodeAnalysisState& state)
 	else if (pItem->Type == EItemType::Code)
 	{
 		FCodeInfo* pCodeItem = static_cast<FCodeInfo*>(pItem);
+		bDisabledCode = false;
 		if (pCodeItem->bDisabled == false)
 		{
 			pCodeItem->bDisabled = true;
+			bDisabledCode = true;
 			state.SetCodeAnalysisDirty();
 
 			FLabelInfo* pLabelInfo = state.GetLabelForAddress(pItem->Address);
 			if (pLabelInfo != nullptr)
+			{
+				oldLabelType = pLabelInfo->LabelType;
 				pLabelInfo->LabelType = ELabelType::Data;
+				state.SetGlobalLabelsDirty(pItem->Address);
+			}
 		}
 	}
 }
 
 void FSetItemDataCommand::Undo(FCodeAnalysisState& state)
 {
-	FDataInfo* pDataItem = static_cast<FDataInfo*>(pItem);
-	pDataItem->DataType = oldDataType;
-	pDataItem->ByteSize = oldDataSize;
+	if (pItem->Type == EItemType::Data)
+	{
+		FDataInfo* pDataItem = static_cast<FDataInfo*>(pItem);
+		pDataItem->DataType = oldDataType;
+		pDataItem->ByteSize = oldDataSize;
+		state.SetCodeAnalysisDirty();
+	}
+	else if (pItem->Type == EItemType::Code && bDisabledCode)
+	{
+		FCodeInfo* pCodeItem = static_cast<FCodeInfo*>(pItem);
+		pCodeItem->bDisabled = false;
+		state.SetCodeAnalysisDirty();
+
+		FLabelInfo* pLabelInfo = state.GetLabelForAddress(pItem->Address);
+		if (pLabelInfo != nullptr)
+		{
+			pLabelInfo->LabelType = oldLabelType;
+			state.SetGlobalLabelsDirty(pItem->Address);
+		}
+	}
 }
 
 // Set Item Code
@@ -66,7 +89,6 @@ void FSetItemCodeCommand::Do(FCodeAnalysisState& state)
 	else
 	{
 		RunStaticCodeAnalysis(state, Addr);
-		UpdateCodeInfoForAddress(state, Addr);
 	}
 	state.SetCodeAnalysisDirty();
 }
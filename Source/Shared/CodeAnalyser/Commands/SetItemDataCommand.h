@@ -17,6 +17,8 @@ public:
 
 	EDataType	oldDataType;
 	uint16_t	oldDataSize;
+	bool		bDisabledCode = false;	// code item was disabled by Do
+	ELabelType	oldLabelType = ELabelType::Data;
 };
 
 class FSetItemCodeCommand : public FCommand
@@ -0,0 +1,90 @@
+#include "Disassembler.h"
+
+#include "CodeAnalyser.h"
+
+int DisassembleInstruction(const ICPUInterface* pCPUInterface, uint16_t pc, FDasmInstruction& outInstruction)
+{
+	uint8_t bytes[kDasmMaxInstructionBytes];
+	for (int i = 0; i < kDasmMaxInstructionBytes; i++)
+		bytes[i] = pCPUInterface->ReadByte(pc + i);
+
+	if (pCPUInterface->CPUType == ECPUType::Z80)
+		return DisassembleZ80(bytes, pc, outInstruction);
+	else if (pCPUInterface->CPUType == ECPUType::M6502)
+		return Disassemble6502(bytes, pc, outInstruction);
+
+	outInstruction = FDasmInstruction();
+	outInstruction.ByteSize = 1;
+	return 1;
+}
+
+// Formatting
+
+struct FDasmTextWriter
+{
+	char*	pText;
+	int		Length;
+	int		MaxLength;
+
+	void	Add(const char* pString)
+	{
+		while (*pString != 0 && Length < MaxLength - 1)
+			pText[Length++] = *pString++;
+		pText[Length] = 0;
+	}
+};
+
+int FormatDasmInstruction(const FDasmInstruction& instruction, const FDasmFormatOptions& options, char* pOutText, int maxLength)
+{
+	if (maxLength <= 0)
+		return 0;
+
+	FDasmTextWriter writer = { pOutText, 0, maxLength };
+	pOutText[0] = 0;
+	writer.Add(instruction.pMnemonic);
+
+	for (int operandNo = 0; operandNo < instruction.NoOperands; operandNo++)
+	{
+		const FDasmOperand& operand = instruction.Operands[operandNo];
+		writer.Add(operandNo == 0 ? " " : ",");
+		writer.Add(operand.pPrefix);
+
+		switch (operand.Kind)
+		{
+		case EDasmOperandKind::Text:
+			break;
+		case EDasmOperandKind::Imm8:
+			writer.Add(NumStr((uint8_t)operand.Value, options.NumberMode));
+			break;
+		case EDasmOperandKind::Imm16:
+		case EDasmOperandKind::Address:
+		{
+			const FLabelInfo* pLabel = options.pLabelState != nullptr ? options.pLabelState->GetLabelForAddress(operand.Value) : nullptr;
+			if (pLabel != nullptr)
+				writer.Add(pLabel->Name.c_str());
+			else
+				writer.Add(NumStr(operand.Value, options.NumberMode));
+		}
+		break;
+		case EDasmOperandKind::Displacement:
+		{
+			int8_t displacement = (int8_t)operand.Value;
+			if (displacement < 0)
+			{
+				writer.Add("-");
+				displacement = -displacement;
+			}
+			else
+			{
+				writer.Add("+");
+			}
+			writer.Add(NumStr((uint8_t)displacement, options.DisplacementMode));
+		}
+		break;
+		}
+
+		writer.Add(operand.pSuffix);
+	}
+
+	return writer.Length;
+}
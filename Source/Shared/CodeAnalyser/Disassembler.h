@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Util/Misc.h"
+
+class ICPUInterface;
+struct FCodeAnalysisState;
+
+// Table driven disassembler
+// Decoding produces tokens with no callbacks or allocation, formatting them into text is a separate pass
+
+enum class EDasmOperandKind : uint8_t
+{
+	Text,			// register, condition or other fixed text - held in the prefix
+	Imm8,			// 8 bit immediate value
+	Imm16,			// 16 bit immediate value
+	Address,		// 16 bit address - memory operand or branch target
+	Displacement,	// signed index register offset
+};
+
+struct FDasmOperand
+{
+	EDasmOperandKind	Kind = EDasmOperandKind::Text;
+	const char*			pPrefix = "";	// text before the value e.g. "(" or "(IX"
+	const char*			pSuffix = "";	// text after the value e.g. ")" or ",X"
+	uint16_t			Value = 0;
+};
+
+struct FDasmInstruction
+{
+	static const int	kMaxOperands = 3;
+
+	const char*		pMnemonic = "";
+	uint8_t			ByteSize = 0;
+	uint8_t			NoOperands = 0;
+	FDasmOperand	Operands[kMaxOperands];
+};
+
+struct FDasmFormatOptions
+{
+	ENumberDisplayMode			NumberMode = ENumberDisplayMode::HexDollar;			// immediates & addresses
+	ENumberDisplayMode			DisplacementMode = ENumberDisplayMode::HexDollar;	// index register offsets
+	const FCodeAnalysisState*	pLabelState = nullptr;	// if set, addresses with labels are output as the label name
+};
+
+static const int kDasmMaxInstructionBytes = 5;	// a DD/FD prefix before an ED instruction makes it 5
+
+// pBytes must hold kDasmMaxInstructionBytes - returns instruction size
+int	DisassembleZ80(const uint8_t* pBytes, uint16_t pc, FDasmInstruction& outInstruction);
+int	Disassemble6502(const uint8_t* pBytes, uint16_t pc, FDasmInstruction& outInstruction);
+
+// read the instruction from memory & decode it for the interface's CPU
+int	DisassembleInstruction(const ICPUInterface* pCPUInterface, uint16_t pc, FDasmInstruction& outInstruction);
+
+// returns the length of the text written
+int	FormatDasmInstruction(const FDasmInstruction& instruction, const FDasmFormatOptions& options, char* pOutText, int maxLength);
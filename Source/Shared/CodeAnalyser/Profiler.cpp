@@ -0,0 +1,235 @@
+#include "Profiler.h"
+
+#include "Debug/DebugLog.h"
+
+void FProfiler::Reset()
+{
+	Functions.clear();
+	Functions.emplace_back();	// root
+	FunctionLookup.assign(2 * 0x10000, -1);
+	CallNodes.clear();
+	CallNodes.emplace_back();	// root
+	Stack.clear();
+	StackChanges.resize(kNoStackChanges);
+	ResetStackChangeNo = StackChangeNo;
+
+	CurrentFunction = 0;
+	CurrentNode = 0;
+	InterruptDepth = 0;
+	LastTicks = 0;
+	Clock = 0;
+	FrameStartClock = 0;
+	FrameMainTicks = 0;
+	FrameInterruptTicks = 0;
+
+	SelectedFunction = -1;
+	HistoryPos = 0;
+	NoHistoryFrames = 0;
+	FrameNo = 0;
+}
+
+int FProfiler::GetFunctionIndex(uint16_t address, bool bInterrupt)
+{
+	const int lookupIndex = address | (bInterrupt ? 0x10000 : 0);
+	int functionIndex = FunctionLookup[lookupIndex];
+	if (functionIndex == -1)
+	{
+		functionIndex = (int)Functions.size();
+		FunctionLookup[lookupIndex] = functionIndex;
+
+		FProfileFunction newFunction;
+		newFunction.Address = address;
+		newFunction.bInterrupt = bInterrupt;
+		Functions.push_back(newFunction);
+	}
+
+	return functionIndex;
+}
+
+int FProfiler::GetChildNode(int parentNode, int functionIndex)
+{
+	for (int childNode = CallNodes[parentNode].FirstChild; childNode != -1; childNode = CallNodes[childNode].NextSibling)
+	{
+		if (CallNodes[childNode].FunctionIndex == functionIndex)
+			return childNode;
+	}
+
+	// stop growing the tree if it gets too big - time goes to the parent
+	if (CallNodes.size() >= kMaxCallNodes)
+		return parentNode;
+
+	FProfileCallNode newNode;
+	newNode.FunctionIndex = functionIndex;
+	newNode.NextSibling = CallNodes[parentNode].FirstChild;
+	CallNodes.push_back(newNode);
+	CallNodes[parentNode].FirstChild = (int)CallNodes.size() - 1;
+	return CallNodes[parentNode].FirstChild;
+}
+
+// add time spent in a call during this frame
+void FProfiler::AddInclusiveTicks(const FStackEntry& entry)
+{
+	FProfileFunction& function = Functions[entry.FunctionIndex];
+	const uint64_t startClock = entry.EntryClock > FrameStartClock ? entry.EntryClock : FrameStartClock;
+	const uint32_t ticks = (uint32_t)(Clock - startClock);
+	function.InclusiveTicks += ticks;
+	function.FrameInclusiveTicks += ticks;
+}
+
+void FProfiler::PushFunction(uint16_t address, bool bInterruptEntry)
+{
+	const int functionIndex = GetFunctionIndex(address, bInterruptEntry || InterruptDepth > 0);
+	FProfileFunction& function = Functions[functionIndex];
+	function.CallCount++;
+	function.FrameCallCount++;
+	function.ActiveDepth++;
+
+	// interrupts start from the root so they group together in the call tree
+	const int nodeIndex = GetChildNode(bInterruptEntry ? 0 : CurrentNode, functionIndex);
+
+	Stack.push_back({ functionIndex, nodeIndex, Clock, bInterruptEntry });
+	StackChanges[StackChangeNo++ & (kNoStackChanges - 1)] = { Stack.back(), true };
+	if (bInterruptEntry)
+		InterruptDepth++;
+
+	CurrentFunction = functionIndex;
+	CurrentNode = nodeIndex;
+}
+
+void FProfiler::PopFunction()
+{
+	const FStackEntry entry = Stack.back();
+	Stack.pop_back();
+	StackChanges[StackChangeNo++ & (kNoStackChanges - 1)] = { entry, false };
+
+	if (--Functions[entry.FunctionIndex].ActiveDepth == 0)
+		AddInclusiveTicks(entry);
+	if (entry.bInterrupt)
+		InterruptDepth--;
+
+	CurrentFunction = Stack.empty() ? 0 : Stack.back().FunctionIndex;
+	CurrentNode = Stack.empty() ? 0 : Stack.back().NodeIndex;
+}
+
+void FProfiler::UpdateStack(const FCodeAnalysisState& state, bool bInterrupt, uint16_t interruptHandlerAddress)
+{
+	while (Stack.size() > state.CallStack.size())
+		PopFunction();
+
+	// if an interrupt was taken the first new entry is the interrupt
+	const size_t interruptEntry = Stack.size();
+	while (Stack.size() < state.CallStack.size())
+	{
+		const bool bInterruptEntry = bInterrupt && Stack.size() == interruptEntry;
+		PushFunction(bInterruptEntry ? interruptHandlerAddress : state.CallStack[Stack.size()].FunctionAddr, bInterruptEntry);
+	}
+}
+
+// Undo stack changes back to changeNo - time already counted stays counted
+void FProfiler::RewindStack(uint64_t changeNo)
+{
+	while (StackChangeNo > changeNo && StackChangeNo > ResetStackChangeNo)
+	{
+		const FStackChange& change = StackChanges[--StackChangeNo & (kNoStackChanges - 1)];
+		const FStackEntry& entry = change.Entry;
+		const int depthChange = change.bPush ? -1 : 1;
+
+		if (change.bPush)
+			Stack.pop_back();
+		else
+			Stack.push_back(entry);
+
+		Functions[entry.FunctionIndex].ActiveDepth += depthChange;
+		if (entry.bInterrupt)
+			InterruptDepth += depthChange;
+	}
+
+	CurrentFunction = Stack.empty() ? 0 : Stack.back().FunctionIndex;
+	CurrentNode = Stack.empty() ? 0 : Stack.back().NodeIndex;
+}
+
+void FProfiler::EndFrame()
+{
+	// count this frame's time for calls still in progress - outermost call of each function only
+	for (size_t i = 0; i < Stack.size(); i++)
+	{
+		bool bOutermost = true;
+		for (size_t j = 0; j < i; j++)
+		{
+			if (Stack[j].FunctionIndex == Stack[i].FunctionIndex)
+				bOutermost = false;
+		}
+		if (bOutermost)
+			AddInclusiveTicks(Stack[i]);
+	}
+
+	FProfileFunction& root = Functions[0];
+	root.InclusiveTicks += Clock - FrameStartClock;
+	root.FrameInclusiveTicks += (uint32_t)(Clock - FrameStartClock);
+
+	for (FProfileFunction& function : Functions)
+	{
+		function.LastFrameCallCount = function.FrameCallCount;
+		function.LastFrameInclusiveTicks = function.FrameInclusiveTicks;
+		function.LastFrameExclusiveTicks = function.FrameExclusiveTicks;
+		function.FrameCallCount = 0;
+		function.FrameInclusiveTicks = 0;
+		function.FrameExclusiveTicks = 0;
+	}
+
+	FProfileFrameInfo& frameInfo = History[HistoryPos];
+	frameInfo.MainTicks = FrameMainTicks;
+	frameInfo.InterruptTicks = FrameInterruptTicks;
+	frameInfo.SelectedFunctionTicks = SelectedFunction != -1 ? Functions[SelectedFunction].LastFrameInclusiveTicks : 0;
+	HistoryPos = (HistoryPos + 1) % kNoHistoryFrames;
+	if (NoHistoryFrames < kNoHistoryFrames)
+		NoHistoryFrames++;
+
+	FrameStartClock = Clock;
+	FrameMainTicks = 0;
+	FrameInterruptTicks = 0;
+	FrameNo++;
+}
+
+std::string FProfiler::GetFunctionName(const FCodeAnalysisState& state, int functionIndex) const
+{
+	if (functionIndex == 0)
+		return "root";
+
+	const FProfileFunction& function = Functions[functionIndex];
+	const FLabelInfo* pLabel = state.GetLabelForAddress(function.Address);
+	char name[64];
+	if (pLabel != nullptr)
+		snprintf(name, sizeof(name), "%s%s", function.bInterrupt ? "IRQ:" : "", pLabel->Name.c_str());
+	else
+		snprintf(name, sizeof(name), "%s$%04X", function.bInterrupt ? "IRQ:" : "", function.Address);
+	return name;
+}
+
+void FProfiler::WriteCollapsedStacks(const FCodeAnalysisState& state, FILE* fp, int nodeIndex, const std::string& path) const
+{
+	const FProfileCallNode& node = CallNodes[nodeIndex];
+	const std::string nodePath = nodeIndex == 0 ? GetFunctionName(state, 0) : path + ";" + GetFunctionName(state, node.FunctionIndex);
+
+	if (node.ExclusiveTicks != 0)
+		fprintf(fp, "%s %llu\n", nodePath.c_str(), (unsigned long long)node.ExclusiveTicks);
+
+	for (int childNode = node.FirstChild; childNode != -1; childNode = CallNodes[childNode].NextSibling)
+		WriteCollapsedStacks(state, fp, childNode, nodePath);
+}
+
+// Export in the collapsed stack format used by flame graph tools - one line per call stack with its exclusive ticks
+bool FProfiler::ExportCollapsedStacks(const FCodeAnalysisState& state, const char* pFilename) const
+{
+	FILE* fp = fopen(pFilename, "wt");
+	if (fp == nullptr)
+	{
+		LOGERROR("Could not open %s for writing", pFilename);
+		return false;
+	}
+
+	WriteCollapsedStacks(state, fp, 0, "");
+	fclose(fp);
+	LOGINFO("Exported profile to %s", pFilename);
+	return true;
+}
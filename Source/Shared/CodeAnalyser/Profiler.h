@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "CodeAnalyser.h"
+
+// Cycle counts for a function - functions called from an interrupt handler are counted separately
+struct FProfileFunction
+{
+	uint16_t	Address = 0;
+	bool		bInterrupt = false;
+
+	// cumulative
+	uint32_t	CallCount = 0;
+	uint64_t	InclusiveTicks = 0;
+	uint64_t	ExclusiveTicks = 0;
+
+	// current frame - moved to LastFrame at the end of each frame
+	uint32_t	FrameCallCount = 0;
+	uint32_t	FrameInclusiveTicks = 0;
+	uint32_t	FrameExclusiveTicks = 0;
+	uint32_t	LastFrameCallCount = 0;
+	uint32_t	LastFrameInclusiveTicks = 0;
+	uint32_t	LastFrameExclusiveTicks = 0;
+
+	int			ActiveDepth = 0;	// no of times on the stack - inclusive time is only counted for the outermost call
+};
+
+// Node in the call tree - used for collapsed stack export
+struct FProfileCallNode
+{
+	int			FunctionIndex = -1;	// -1 for root
+	int			FirstChild = -1;
+	int			NextSibling = -1;
+	uint64_t	ExclusiveTicks = 0;
+};
+
+// Ticks per frame for the timeline
+struct FProfileFrameInfo
+{
+	uint32_t	MainTicks = 0;
+	uint32_t	InterruptTicks = 0;
+	uint32_t	SelectedFunctionTicks = 0;	// inclusive ticks for the selected function
+};
+
+// Function level cycle profiler
+// Follows the analyser's call stack so it only does real work when the stack changes
+class FProfiler
+{
+public:
+	static const int	kNoHistoryFrames = 256;
+	static const int	kMaxCallNodes = 64 * 1024;
+	static const int	kNoStackChanges = 16 * 1024;	// must be a power of 2
+
+	void	Reset();
+
+	// call before each exec - ticks passed to the trap restart from 0
+	void	BeginExec() { LastTicks = 0; }
+
+	// call from the trap after each instruction, after the analyser has updated its call stack
+	void	RegisterInstruction(const FCodeAnalysisState& state, int ticks, bool bInterrupt, uint16_t interruptHandlerAddress)
+	{
+		const uint32_t instructionTicks = ticks >= LastTicks ? ticks - LastTicks : ticks;
+		LastTicks = ticks;
+		Clock += instructionTicks;
+
+		// charge the instruction to the function that executed it, before the stack changes
+		Functions[CurrentFunction].ExclusiveTicks += instructionTicks;
+		Functions[CurrentFunction].FrameExclusiveTicks += instructionTicks;
+		CallNodes[CurrentNode].ExclusiveTicks += instructionTicks;
+		if (InterruptDepth > 0)
+			FrameInterruptTicks += instructionTicks;
+		else
+			FrameMainTicks += instructionTicks;
+
+		if (state.CallStack.size() != Stack.size())
+			UpdateStack(state, bInterrupt, interruptHandlerAddress);
+	}
+
+	void	EndFrame();
+
+	// stack changes are kept in a ring so the stack can be rewound when stepping back
+	uint64_t	GetStackChangeNo() const { return StackChangeNo; }
+	bool		CanRewindStack(uint64_t changeNo) const { return changeNo + kNoStackChanges >= StackChangeNo; }
+	void		RewindStack(uint64_t changeNo);
+
+	bool	ExportCollapsedStacks(const FCodeAnalysisState& state, const char* pFilename) const;
+	std::string	GetFunctionName(const FCodeAnalysisState& state, int functionIndex) const;
+
+	bool	bEnabled = false;	// enabled from the profiler viewer
+	int		SelectedFunction = -1;
+
+	std::vector<FProfileFunction>	Functions;	// 0 is the root - code not in a function
+	FProfileFrameInfo	History[kNoHistoryFrames];
+	int					HistoryPos = 0;	// next to write
+	int					NoHistoryFrames = 0;
+	int					FrameNo = 0;
+
+private:
+	struct FStackEntry
+	{
+		int			FunctionIndex;
+		int			NodeIndex;
+		uint64_t	EntryClock;
+		bool		bInterrupt;
+	};
+
+	struct FStackChange
+	{
+		FStackEntry	Entry;
+		bool		bPush;
+	};
+
+	void	UpdateStack(const FCodeAnalysisState& state, bool bInterrupt, uint16_t interruptHandlerAddress);
+	void	PushFunction(uint16_t address, bool bInterrupt);
+	void	PopFunction();
+	int		GetFunctionIndex(uint16_t address, bool bInterrupt);
+	int		GetChildNode(int parentNode, int functionIndex);
+	void	AddInclusiveTicks(const FStackEntry& entry);
+	void	WriteCollapsedStacks(const FCodeAnalysisState& state, FILE* fp, int nodeIndex, const std::string& path) const;
+
+	std::vector<FStackEntry>		Stack;
+	std::vector<int>				FunctionLookup;	// address + interrupt flag -> function index
+	std::vector<FProfileCallNode>	CallNodes;		// 0 is the root
+	std::vector<FStackChange>		StackChanges;	// ring of kNoStackChanges
+	uint64_t						StackChangeNo = 0;	// not reset so write journal snapshots stay in order
+	uint64_t						ResetStackChangeNo = 0;	// changes before a reset aren't on the stack to rewind
+
+	int			CurrentFunction = 0;
+	int			CurrentNode = 0;
+	int			InterruptDepth = 0;
+	int			LastTicks = 0;
+	uint64_t	Clock = 0;
+	uint64_t	FrameStartClock = 0;
+	uint32_t	FrameMainTicks = 0;
+	uint32_t	FrameInterruptTicks = 0;
+};
@@ -0,0 +1,226 @@
+#include "StaticAnalysis.h"
+
+#include <string.h>
+
+#include "CodeAnalyser.h"
+#include "Z80/CodeAnalyserZ80.h"
+#include "6502/CodeAnalyser6502.h"
+#include <Debug/DebugLog.h>
+
+static bool CheckFallThroughInstruction(ICPUInterface* pCPUInterface, uint16_t pc)
+{
+	if (pCPUInterface->CPUType == ECPUType::Z80)
+		return CheckFallThroughInstructionZ80(pCPUInterface, pc);
+	else if (pCPUInterface->CPUType == ECPUType::M6502)
+		return CheckFallThroughInstruction6502(pCPUInterface, pc);
+	else
+		return false;
+}
+
+// block index for an address - ignored if the code it was built from has since been removed
+static int32_t GetBasicBlockIndex(FCodeAnalysisState& state, uint16_t address)
+{
+	if (state.GetCodeInfoForAddress(address) == nullptr)
+		return -1;
+	return state.GetReadPage(address)->BasicBlockIndex[address & FCodeAnalysisState::kPageMask];
+}
+
+static void SetBasicBlockIndex(FCodeAnalysisState& state, uint16_t address, int byteSize, int32_t blockIndex)
+{
+	for (int i = 0; i < byteSize; i++)
+	{
+		const uint16_t addr = address + i;
+		state.GetReadPage(addr)->BasicBlockIndex[addr & FCodeAnalysisState::kPageMask] = blockIndex;
+	}
+}
+
+static bool IsFunctionEntry(FCodeAnalysisState& state, uint16_t address)
+{
+	const FLabelInfo* pLabel = state.GetLabelForAddress(address);
+	return pLabel != nullptr && pLabel->LabelType == ELabelType::Function;
+}
+
+static void AddSuccessor(FCodeAnalysisState& state, FBasicBlock& block, uint16_t address)
+{
+	if (block.NoSuccessors < 2)
+		block.Successors[block.NoSuccessors++] = address;
+	QueueStaticAnalysis(state, address);
+}
+
+void ResetStaticAnalysis(FCodeAnalysisState& state)
+{
+	FStaticAnalysis& analysis = state.StaticAnalysis;
+	analysis.Worklist.clear();
+	analysis.Blocks.clear();
+	analysis.NoInstructionsAnalysed = 0;
+
+	for (FCodeAnalysisPage* pPage : state.GetRegisteredPages())
+		memset(pPage->BasicBlockIndex, 0xff, sizeof(pPage->BasicBlockIndex));
+}
+
+void QueueStaticAnalysis(FCodeAnalysisState& state, uint16_t address)
+{
+	state.StaticAnalysis.Worklist.push_back(address);
+}
+
+void CancelStaticAnalysis(FCodeAnalysisState& state)
+{
+	FStaticAnalysis& analysis = state.StaticAnalysis;
+	if (analysis.Worklist.empty() == false)
+		LOGINFO("Static analysis cancelled with %d addresses left to analyse", (int)analysis.Worklist.size());
+	analysis.Worklist.clear();
+}
+
+// Split a block when a branch lands in the middle of it
+static void SplitBasicBlock(FCodeAnalysisState& state, int32_t blockIndex, uint16_t address)
+{
+	FStaticAnalysis& analysis = state.StaticAnalysis;
+
+	const FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(address);
+	if (pCodeInfo == nullptr || pCodeInfo->Address != address)	// branch into the middle of an instruction
+		return;
+
+	// find the instruction before the split
+	uint16_t pc = analysis.Blocks[blockIndex].StartAddress;
+	uint16_t prevPC = pc;
+	while (pc < address)
+	{
+		const FCodeInfo* pInstruction = state.GetCodeInfoForAddress(pc);
+		if (pInstruction == nullptr || pInstruction->ByteSize == 0)
+			return;
+		prevPC = pc;
+		pc += pInstruction->ByteSize;
+	}
+	if (pc != address)
+		return;
+
+	// the new block takes over the end of the old one
+	FBasicBlock newBlock = analysis.Blocks[blockIndex];
+	newBlock.StartAddress = address;
+	newBlock.PageId = state.GetReadPage(address)->PageId;
+	newBlock.bFunctionEntry = IsFunctionEntry(state, address);
+
+	FBasicBlock& oldBlock = analysis.Blocks[blockIndex];
+	oldBlock.EndAddress = prevPC;
+	oldBlock.bHasCall = false;
+	oldBlock.NoSuccessors = 1;
+	oldBlock.Successors[0] = address;
+
+	const int32_t newBlockIndex = (int32_t)analysis.Blocks.size();
+	analysis.Blocks.push_back(newBlock);
+
+	const FCodeInfo* pLastInstruction = state.GetCodeInfoForAddress(newBlock.EndAddress);
+	const int lastInstructionSize = pLastInstruction != nullptr ? pLastInstruction->ByteSize : 1;
+	SetBasicBlockIndex(state, address, (uint16_t)(newBlock.EndAddress - address) + lastInstructionSize, newBlockIndex);
+}
+
+// Build the block starting at an address, queueing up any addresses it can branch to
+static void AnalyseBasicBlock(FCodeAnalysisState& state, uint16_t address, int& instructionBudget)
+{
+	FStaticAnalysis& analysis = state.StaticAnalysis;
+
+	const int32_t existingBlockIndex = GetBasicBlockIndex(state, address);
+	if (existingBlockIndex != -1)
+	{
+		if (analysis.Blocks[existingBlockIndex].StartAddress != address)
+			SplitBasicBlock(state, existingBlockIndex, address);
+		return;
+	}
+
+	const FCodeInfo* pStartCodeInfo = state.GetCodeInfoForAddress(address);
+	if (pStartCodeInfo != nullptr && pStartCodeInfo->Address != address)	// overlaps an existing instruction
+		return;
+
+	const int32_t blockIndex = (int32_t)analysis.Blocks.size();
+	FBasicBlock block;
+	block.StartAddress = address;
+	block.EndAddress = address;
+	block.PageId = state.GetReadPage(address)->PageId;
+
+	uint16_t pc = address;
+	while (true)
+	{
+		// ran into another block - link to it
+		if (pc != address && GetBasicBlockIndex(state, pc) != -1)
+		{
+			AddSuccessor(state, block, pc);
+			break;
+		}
+
+		const FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(pc);
+		if (pCodeInfo != nullptr && pCodeInfo->Address != pc)	// overlapping instructions
+			break;
+
+		const uint16_t nextPC = pCodeInfo != nullptr ? pc + pCodeInfo->ByteSize : WriteCodeInfoForAddress(state, pc);
+
+		SetBasicBlockIndex(state, pc, (uint16_t)(nextPC - pc), blockIndex);
+		block.EndAddress = pc;
+		analysis.NoInstructionsAnalysed++;
+		instructionBudget--;
+
+		const FDecodedInstruction& decoded = GetDecodedInstruction(state, pc);
+		const bool bFallThrough = nextPC > pc && CheckFallThroughInstruction(state.CPUInterface, pc);
+
+		if (decoded.bJump)
+		{
+			if (decoded.bCall)
+			{
+				block.bHasCall = true;
+				block.CallTarget = decoded.JumpAddress;
+				QueueStaticAnalysis(state, decoded.JumpAddress);
+			}
+			else
+			{
+				AddSuccessor(state, block, decoded.JumpAddress);
+			}
+		}
+
+		// block ends at any change of flow
+		if (decoded.bJump || decoded.bStop || bFallThrough == false)
+		{
+			if (bFallThrough)
+				AddSuccessor(state, block, nextPC);
+			break;
+		}
+
+		pc = nextPC;
+	}
+
+	block.bFunctionEntry = IsFunctionEntry(state, address);
+	analysis.Blocks.push_back(block);
+}
+
+bool UpdateStaticAnalysis(FCodeAnalysisState& state, int instructionBudget)
+{
+	FStaticAnalysis& analysis = state.StaticAnalysis;
+	if (analysis.Worklist.empty())
+		return true;
+
+	while (instructionBudget > 0 && analysis.Worklist.empty() == false)
+	{
+		const uint16_t address = analysis.Worklist.back();
+		analysis.Worklist.pop_back();
+		AnalyseBasicBlock(state, address, instructionBudget);
+	}
+
+	if (analysis.Worklist.empty())
+	{
+		LOGINFO("Static analysis complete: %d blocks, %d instructions", (int)analysis.Blocks.size(), analysis.NoInstructionsAnalysed);
+		return true;
+	}
+
+	return false;
+}
+
+const FBasicBlock* GetBasicBlockForAddress(const FCodeAnalysisState& state, uint16_t address)
+{
+	const FCodeAnalysisPage* pPage = state.GetReadPage(address);
+	if (pPage->CodeInfo[address & FCodeAnalysisState::kPageMask] == nullptr)
+		return nullptr;
+
+	const int32_t blockIndex = pPage->BasicBlockIndex[address & FCodeAnalysisState::kPageMask];
+	if (blockIndex < 0 || blockIndex >= (int32_t)state.StaticAnalysis.Blocks.size())
+		return nullptr;
+
+	return &state.StaticAnalysis.Blocks[blockIndex];
+}
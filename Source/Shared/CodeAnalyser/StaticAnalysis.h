@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct FCodeAnalysisState;
+
+// A run of instructions that is only entered at the start and only left at the end
+// Edges are stored as addresses so splitting a block doesn't have to fix up its predecessors
+struct FBasicBlock
+{
+	uint16_t	StartAddress = 0;
+	uint16_t	EndAddress = 0;		// address of the last instruction
+	int16_t		PageId = -1;		// page the block started in
+	bool		bFunctionEntry = false;	// target of a call
+
+	bool		bHasCall = false;
+	uint16_t	CallTarget = 0;
+
+	int			NoSuccessors = 0;
+	uint16_t	Successors[2];		// branch target and/or fall through address
+};
+
+// Worklist driven recursive descent analysis
+// Follows every static branch & call target rather than a single linear path, building a control flow graph as it goes
+// Work is done in budgeted steps so large analyses can be spread over frames and cancelled
+struct FStaticAnalysis
+{
+	std::vector<uint16_t>		Worklist;	// addresses still to analyse
+	std::vector<FBasicBlock>	Blocks;		// indexed by FCodeAnalysisPage::BasicBlockIndex
+	int							NoInstructionsAnalysed = 0;
+
+	bool	IsActive() const { return Worklist.empty() == false; }
+};
+
+static const int kStaticAnalysisFrameBudget = 2000;	// instructions per frame when analysing in the background
+
+void ResetStaticAnalysis(FCodeAnalysisState& state);
+void QueueStaticAnalysis(FCodeAnalysisState& state, uint16_t address);
+bool UpdateStaticAnalysis(FCodeAnalysisState& state, int instructionBudget);	// returns true when there is nothing left to do
+void CancelStaticAnalysis(FCodeAnalysisState& state);
+
+// control flow graph access
+const FBasicBlock* GetBasicBlockForAddress(const FCodeAnalysisState& state, uint16_t address);
@@ -1,6 +1,7 @@
 #include "CodeToolTips6502.h"
 #include "../../CodeAnalyser.h"
 #include "../CodeToolTips.h"
+#include "../../6502/OpcodeTable6502.h"
 
 #include <imgui.h>
 
@@ -11,13 +12,14 @@ static InstructionInfoMap g_InstructionInfo =
 void ShowCodeToolTip6502(FCodeAnalysisState& state, const FCodeInfo* pCodeInfo)
 {
 	const uint8_t instrByte = state.CPUInterface->ReadByte(pCodeInfo->Address);
+	const F6502OpcodeInfo& opcodeInfo = GetOpcodeInfo6502(instrByte);
 	InstructionInfoMap::const_iterator it = g_InstructionInfo.find(instrByte);
-	if (it == g_InstructionInfo.end())
-		return;
-
-	const FInstructionInfo& info = it->second;
 
 	ImGui::BeginTooltip();
-	ImGui::Text(info.Description);
+	if (it != g_InstructionInfo.end())
+		ImGui::Text(it->second.Description);
+	else
+		ImGui::Text("%s", opcodeInfo.pMnemonic);
+	ImGui::Text("Cycles: %d", opcodeInfo.Cycles);
 	ImGui::EndTooltip();
-}
\ No newline at end of file
+}
@@ -223,9 +223,10 @@ void DrawCharacterMap(FCharacterMapViewerUIState& uiState, FCodeAnalysisState& s
 		for (int x = 0; x < params.Width; x++)
 		{
 			const uint8_t val = state.CPUInterface->ReadByte(params.Address + byte);
-			FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(params.Address + byte);
-			const int framesSinceWritten = pDataInfo->LastFrameWritten == -1 ? 255 : state.CurrentFrameNo - pDataInfo->LastFrameWritten;
-			const int framesSinceRead = pDataInfo->LastFrameRead == -1 ? 255 : state.CurrentFrameNo - pDataInfo->LastFrameRead;
+			const int lastFrameWritten = state.GetLastFrameWrittenForAddress(params.Address + byte);
+			const int lastFrameRead = state.GetLastFrameReadForAddress(params.Address + byte);
+			const int framesSinceWritten = lastFrameWritten == -1 ? 255 : state.CurrentFrameNo - lastFrameWritten;
+			const int framesSinceRead = lastFrameRead == -1 ? 255 : state.CurrentFrameNo - lastFrameRead;
 			const int wBrightVal = (255 - std::min(framesSinceWritten << 3, 255)) & 0xff;
 			const int rBrightVal = (255 - std::min(framesSinceRead << 3, 255)) & 0xff;
 
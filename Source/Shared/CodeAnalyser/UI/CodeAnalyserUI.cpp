@@ -12,7 +12,6 @@
 #include "imgui_internal.h"
 #include "misc/cpp/imgui_stdlib.h"
 #include <algorithm>
-#include <sstream>
 #include "chips/z80.h"
 #include "CodeToolTips.h"
 
@@ -45,17 +44,12 @@ bool GoToPreviousAddress(FCodeAnalysisViewState&state)
 	return true;
 }
 
+// item list is in address order so we can binary search it
 int GetItemIndexForAddress(const FCodeAnalysisState &state, uint16_t addr)
 {
-	int index = -1;
-	for(int i=0;i<(int)state.ItemList.size();i++)
-	{
-		if (state.ItemList[i] != nullptr && state.ItemList[i]->Address > addr)
-			return index;
-
-		index = i;
-	}
-	return -1;
+	const auto it = std::upper_bound(state.ItemList.begin(), state.ItemList.end(), addr,
+		[](uint16_t address, const FItem* pItem) { return address < pItem->Address; });
+	return (int)(it - state.ItemList.begin()) - 1;
 }
 
 
@@ -406,7 +400,7 @@ void DrawLabelDetails(FCodeAnalysisState &state, FCodeAnalysisViewState& viewSta
 			pLabelInfo->LabelType = ELabelType::Function;
 		if (pLabelInfo->LabelType == ELabelType::Function && pLabelInfo->Global == false)
 			pLabelInfo->LabelType = ELabelType::Code;
-		GenerateGlobalInfo(state);
+		state.SetGlobalLabelsDirty(pLabelInfo->Address);
 	}
 
 	ImGui::Text("References:");
@@ -537,11 +531,8 @@ void DrawCodeInfo(FCodeAnalysisState &state, FCodeAnalysisViewState& viewState,
 		dl->AddRectFilled(ImVec2(pos.x-12, pos.y), ImVec2(pos.x - 8, pos.y + line_height), 0xFFFF0000);
 	}
 
-	if(pCodeInfo->bSelfModifyingCode == true || pCodeInfo->Text.empty())
-	{
-		//UpdateCodeInfoForAddress(state, pCodeInfo->Address);
-		WriteCodeInfoForAddress(state, pCodeInfo->Address);
-	}
+	if(pCodeInfo->bSelfModifyingCode == true)
+		WriteCodeInfoForAddress(state, pCodeInfo->Address);	// operands may have changed
 
 	ImGui::Text("\t%s", NumStr(pCodeInfo->Address));
 	const float line_start_x = ImGui::GetCursorPosX();
@@ -588,7 +579,7 @@ void DrawCodeInfo(FCodeAnalysisState &state, FCodeAnalysisViewState& viewState,
 		}
 	}
 
-	ImGui::Text("%s", pCodeInfo->Text.c_str());
+	ImGui::Text("%s", GetCodeInfoText(state, pCodeInfo));
 
 	if (pCodeInfo->bNOPped)
 		ImGui::PopStyleColor();
@@ -614,8 +605,7 @@ void DrawCodeInfo(FCodeAnalysisState &state, FCodeAnalysisViewState& viewState,
 
 void DrawCodeDetails(FCodeAnalysisState &state, FCodeAnalysisViewState& viewState, FCodeInfo *pCodeInfo)
 {
-	if (DrawOperandTypeCombo("Operand Type", pCodeInfo->OperandType))
-		pCodeInfo->Text.clear();	// clear for a rewrite
+	DrawOperandTypeCombo("Operand Type", pCodeInfo->OperandType);	// text cache is keyed on operand type
 
 	if (ImGui::Checkbox("NOP out instruction", &pCodeInfo->bNOPped))
 	{
@@ -661,6 +651,30 @@ void DrawCodeDetails(FCodeAnalysisState &state, FCodeAnalysisViewState& viewStat
 			}
 		}
 	}
+
+	// control flow from static analysis
+	const FBasicBlock* pBlock = GetBasicBlockForAddress(state, pCodeInfo->Address);
+	if (pBlock != nullptr)
+	{
+		ImGui::Separator();
+		ImGui::Text("Basic Block: %s - %s%s", NumStr(pBlock->StartAddress), NumStr(pBlock->EndAddress), pBlock->bFunctionEntry ? " (function entry)" : "");
+		if (pBlock->StartAddress != pCodeInfo->Address)
+		{
+			ImGui::Text("Block Start:");
+			DrawCodeAddress(state, viewState, pBlock->StartAddress);
+		}
+		if (pBlock->bHasCall)
+		{
+			ImGui::Text("Calls:");
+			DrawCodeAddress(state, viewState, pBlock->CallTarget);
+		}
+		if (pBlock->NoSuccessors > 0)
+		{
+			ImGui::Text("Successors:");
+			for (int i = 0; i < pBlock->NoSuccessors; i++)
+				DrawCodeAddress(state, viewState, pBlock->Successors[i]);
+		}
+	}
 }
 
 
@@ -678,7 +692,7 @@ void DrawCommentBlockDetails(FCodeAnalysisState& state, FCommentBlock* pCommentB
 	{
 		if (pCommentBlock->Comment.empty() == true)
 			state.SetCommentBlockForAddress(pCommentBlock->Address, nullptr);
-		state.SetCodeAnalysisDirty();
+		state.SetAddressRangeDirty(pCommentBlock->Address);
 	}
 
 }
@@ -823,7 +837,7 @@ void UpdatePopups(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState)
 		ImGui::SetKeyboardFocusHere();
 		if(ImGui::InputTextMultiline("##comment", &pCursorItem->Comment,ImVec2(), ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_CtrlEnterForNewLine))
 		{
-			state.SetCodeAnalysisDirty();
+			state.SetAddressRangeDirty(pCursorItem->Address);
 			ImGui::CloseCurrentPopup();
 		}
 		ImGui::SetItemDefaultFocus();
@@ -847,113 +861,174 @@ void UpdatePopups(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState)
 	}
 }
 
-void UpdateItemList(FCodeAnalysisState &state)
+// Rebuild the items for one segment of the address space
+// returns the address of the first item after the segment
+static int BuildItemListSegment(FCodeAnalysisState& state, int segmentNo, FCommentBlock* viewStateCommentBlocks[])
 {
-	// build item list - not every frame please!
-	if (state.IsCodeAnalysisDataDirty() || state.HasMemoryBeenRemapped())
-	{
-		const float line_height = ImGui::GetTextLineHeight();
-		
-		state.ItemList.clear();
-		FCommentLine::FreeAll();	// recycle comment lines
+	FItemListSegment& segment = state.ItemListSegments[segmentNo];
+	const int startAddress = segmentNo * FCodeAnalysisPage::kPageSize;
+	const int endAddress = startAddress + FCodeAnalysisPage::kPageSize;
+	int nextItemAddress = segment.FirstItemAddress;
+	size_t noCommentLines = 0;
 
-		int nextItemAddress = 0;
+	segment.Items.clear();
 
-		// special case for expanded lines
-		// TODO: there should be a more general case
-		FCommentBlock* viewStateCommentBlocks[FCodeAnalysisState::kNoViewStates] = { nullptr };
-		for (int i = 0; i < FCodeAnalysisState::kNoViewStates; i++)
+	for (int addr = startAddress; addr < endAddress; addr++)
+	{
+		// convert comment block into multiple comment lines
+		FCommentBlock* pCommentBlock = state.GetCommentBlockForAddress(addr);
+		if (pCommentBlock != nullptr)
 		{
-			const FItem* const pCursorItem = state.ViewState[i].GetCursorItem();
-			if (pCursorItem != nullptr && pCursorItem->Type == EItemType::CommentLine)
-			{
-				FCommentBlock* pBlock = state.GetCommentBlockForAddress(pCursorItem->Address);
-				viewStateCommentBlocks[i] = pBlock;
-			}
-		}
+			// split comment into lines
+			const std::string& comment = pCommentBlock->Comment;
+			FCommentLine* pFirstLine = nullptr;
+			size_t lineStart = 0;
 
-		// loop across address range
-		for (int addr = 0; addr < (1 << 16); addr++)
-		{
-			// convert comment block into multiple comment lines
-			FCommentBlock* pCommentBlock = state.GetCommentBlockForAddress(addr);
-			if (pCommentBlock != nullptr)
+			while (lineStart < comment.size())
 			{
-				// split comment into lines
-				std::stringstream stringStream(pCommentBlock->Comment);
-				std::string line;
-				FCommentLine* pFirstLine = nullptr;
+				size_t lineEnd = comment.find('\n', lineStart);
+				if (lineEnd == std::string::npos)
+					lineEnd = comment.size();
 
-				while (std::getline(stringStream, line, '\n'))
+				// skip lines starting with @ - we might want to create items from them in future
+				if (lineEnd > lineStart && comment[lineStart] != '@')
 				{
-					if (line.empty() || line[0] == '@')	// skip lines starting with @ - we might want to create items from them in future
-						continue;
+					if (noCommentLines == segment.CommentLines.size())
+						segment.CommentLines.push_back(FCommentLine::Allocate());
 
-					FCommentLine* pLine = FCommentLine::Allocate();
-					pLine->Comment = line;
+					FCommentLine* pLine = segment.CommentLines[noCommentLines++];
+					pLine->Comment.assign(comment, lineStart, lineEnd - lineStart);
 					pLine->Address = addr;
-					state.ItemList.push_back(pLine);	
+					segment.Items.push_back(pLine);
 					if (pFirstLine == nullptr)
 						pFirstLine = pLine;
 				}
 
-				// fix up having comment blocks as cursor items
-				for (int i = 0; i < FCodeAnalysisState::kNoViewStates; i++)
-				{
-					if (viewStateCommentBlocks[i] == pCommentBlock)
-						state.ViewState[i].SetCursorItem(pFirstLine);
-				}
+				lineStart = lineEnd + 1;
 			}
-			
-			FLabelInfo* pLabelInfo = state.GetLabelForAddress(addr);
-			if (pLabelInfo != nullptr)
+
+			// fix up having comment blocks as cursor items
+			for (int i = 0; i < FCodeAnalysisState::kNoViewStates; i++)
 			{
-				state.ItemList.push_back(pLabelInfo);
+				if (viewStateCommentBlocks[i] == pCommentBlock)
+					state.ViewState[i].SetCursorItem(pFirstLine);
 			}
+		}
+
+		FLabelInfo* pLabelInfo = state.GetLabelForAddress(addr);
+		if (pLabelInfo != nullptr)
+		{
+			segment.Items.push_back(pLabelInfo);
+		}
 
-			// check if we have gone past this item
-			if (addr >= nextItemAddress)
+		// check if we have gone past this item
+		if (addr >= nextItemAddress)
+		{
+			FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(addr);
+			if (pCodeInfo != nullptr && pCodeInfo->bDisabled == false)
 			{
-				FCodeInfo *pCodeInfo = state.GetCodeInfoForAddress(addr);
-				if (pCodeInfo != nullptr && pCodeInfo->bDisabled == false)
-				{
-					nextItemAddress = addr + pCodeInfo->ByteSize;
-					state.ItemList.push_back(pCodeInfo);
-				}
-				else // code and data are mutually exclusive
+				nextItemAddress = addr + pCodeInfo->ByteSize;
+				segment.Items.push_back(pCodeInfo);
+			}
+			else // code and data are mutually exclusive
+			{
+				FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(addr);
+				if (pDataInfo != nullptr)
 				{
-					FDataInfo *pDataInfo = state.GetReadDataInfoForAddress(addr);
-					if (pDataInfo != nullptr)
-					{
-						if (pDataInfo->DataType != EDataType::Blob && pDataInfo->DataType != EDataType::ScreenPixels)	// not sure why we want this
-							nextItemAddress = addr + pDataInfo->ByteSize;
-						else
-							nextItemAddress = addr + 1;
+					if (pDataInfo->DataType != EDataType::Blob && pDataInfo->DataType != EDataType::ScreenPixels)	// not sure why we want this
+						nextItemAddress = addr + pDataInfo->ByteSize;
+					else
+						nextItemAddress = addr + 1;
 
-						state.ItemList.push_back(pDataInfo);
-					}
+					segment.Items.push_back(pDataInfo);
 				}
 			}
+		}
+	}
 
-			// update cursor item index
-			for (int i = 0; i < FCodeAnalysisState::kNoViewStates; i++)
+	segment.bDirty = false;
+	return std::max(nextItemAddress, endAddress);
+}
+
+// Rebuild the dirty segments & stitch the item list together
+// doesn't touch the UI so it can be used on states that aren't being drawn e.g. snapshots
+void BuildItemList(FCodeAnalysisState& state)
+{
+	const int kNoSegments = FCodeAnalysisState::kAddressSize / FCodeAnalysisPage::kPageSize;
+
+	// special case for expanded lines
+	// TODO: there should be a more general case
+	FCommentBlock* viewStateCommentBlocks[FCodeAnalysisState::kNoViewStates] = { nullptr };
+	for (int i = 0; i < FCodeAnalysisState::kNoViewStates; i++)
+	{
+		const FItem* const pCursorItem = state.ViewState[i].GetCursorItem();
+		if (pCursorItem != nullptr && pCursorItem->Type == EItemType::CommentLine)
+		{
+			FCommentBlock* pBlock = state.GetCommentBlockForAddress(pCursorItem->Address);
+			viewStateCommentBlocks[i] = pBlock;
+		}
+	}
+
+	// rebuild dirty segments - an item running off the end of a segment affects the next one
+	size_t noItems = 0;
+	for (int segmentNo = 0; segmentNo < kNoSegments; segmentNo++)
+	{
+		FItemListSegment& segment = state.ItemListSegments[segmentNo];
+		if (segment.bDirty)
+		{
+			const int nextItemAddress = BuildItemListSegment(state, segmentNo, viewStateCommentBlocks);
+			if (segmentNo + 1 < kNoSegments)
 			{
-				if (state.ViewState[i].GetCursorItem() == state.ItemList.back())
-					state.ViewState[i].CursorItemIndex = (int)state.ItemList.size() - 1;
+				FItemListSegment& nextSegment = state.ItemListSegments[segmentNo + 1];
+				if (nextSegment.FirstItemAddress != nextItemAddress)
+				{
+					nextSegment.FirstItemAddress = nextItemAddress;
+					nextSegment.bDirty = true;
+				}
 			}
 		}
+		noItems += segment.Items.size();
+	}
 
-		// Maybe this needs to follow the same algorithm as the main view?
-		ImGui::SetScrollY(state.GetFocussedViewState().CursorItemIndex * line_height);
-		state.SetCodeAnalysisDirty(false);
+	// stitch segments together
+	state.ItemList.clear();
+	state.ItemList.reserve(noItems);
+	for (const FItemListSegment& segment : state.ItemListSegments)
+		state.ItemList.insert(state.ItemList.end(), segment.Items.begin(), segment.Items.end());
+
+	// update cursor item index
+	for (int i = 0; i < FCodeAnalysisState::kNoViewStates; i++)
+	{
+		FCodeAnalysisViewState& viewState = state.ViewState[i];
+		const FItem* pCursorItem = viewState.GetCursorItem();
+		if (pCursorItem == nullptr)
+			continue;
 
-		if (state.HasMemoryBeenRemapped())
+		// several items can share an address
+		for (int index = GetItemIndexForAddress(state, pCursorItem->Address); index >= 0 && state.ItemList[index]->Address == pCursorItem->Address; index--)
 		{
-			GenerateGlobalInfo(state);
-			state.SetMemoryRemapped(false);
+			if (state.ItemList[index] == pCursorItem)
+			{
+				viewState.CursorItemIndex = index;
+				break;
+			}
 		}
 	}
 
+	state.SetCodeAnalysisDirty(false);
+	state.SetMemoryRemapped(false);	// remapped segments have marked their global labels dirty
+}
+
+void UpdateItemList(FCodeAnalysisState &state)
+{
+	// build item list - not every frame please!
+	if (state.IsCodeAnalysisDataDirty() || state.HasMemoryBeenRemapped())
+	{
+		BuildItemList(state);
+
+		// Maybe this needs to follow the same algorithm as the main view?
+		ImGui::SetScrollY(state.GetFocussedViewState().CursorItemIndex * ImGui::GetTextLineHeight());
+	}
 }
 
 void DoItemContextMenu(FCodeAnalysisState& state, FItem *pItem)
@@ -1237,6 +1312,21 @@ void DrawDebuggerButtons(FCodeAnalysisState &state, FCodeAnalysisViewState& view
 		state.CPUInterface->StepInto();
 		viewState.TrackPCFrame = true;
 	}
+	if (state.CPUInterface->CanStepBack())
+	{
+		ImGui::SameLine();
+		if (ImGui::Button("Step Back Over"))
+		{
+			state.CPUInterface->StepBackOver();
+			viewState.TrackPCFrame = true;
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Step Back Into"))
+		{
+			state.CPUInterface->StepBackInto();
+			viewState.TrackPCFrame = true;
+		}
+	}
 	ImGui::SameLine();
 	if (ImGui::Button("Step Frame (F6)"))
 	{
@@ -1307,6 +1397,16 @@ void DrawCodeAnalysisData(FCodeAnalysisState &state, int windowId)
 	ImGui::SameLine();
 	DrawAddressLabel(state, viewState, state.StackMax);
 
+	// background static analysis progress
+	if (state.StaticAnalysis.IsActive())
+	{
+		ImGui::SameLine();
+		ImGui::Text("Analysing: %d blocks, %d queued", (int)state.StaticAnalysis.Blocks.size(), (int)state.StaticAnalysis.Worklist.size());
+		ImGui::SameLine();
+		if (ImGui::Button("Cancel Analysis"))
+			CancelStaticAnalysis(state);
+	}
+
 	if(ImGui::BeginChild("##analysis", ImVec2(ImGui::GetWindowContentRegionWidth() * 0.75f, 0), true))
 	{
 		//int scrollToItem = -1;
@@ -1618,6 +1718,8 @@ void GenerateFilteredLabelList(const FLabelListFilter&filter,const std::vector<F
 
 void DrawGlobals(FCodeAnalysisState &state, FCodeAnalysisViewState& viewState)
 {
+	UpdateGlobalInfo(state);
+
 	if(ImGui::BeginTabBar("GlobalsTabBar"))
 	{
 		if(ImGui::BeginTabItem("Functions"))
@@ -34,6 +34,7 @@ void ShowCodeAccessorActivity(FCodeAnalysisState& state, const uint16_t accessor
 void DrawCodeAddress(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState, uint16_t addr, bool bFunctionRel = false);
 void DrawAddressLabel(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState, uint16_t addr, bool bFunctionRel = false);
 int GetItemIndexForAddress(const FCodeAnalysisState& state, uint16_t addr);
+void BuildItemList(FCodeAnalysisState& state);
 void DrawCodeAnalysisItemAtIndex(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState, int i);
 bool DrawNumberTypeCombo(const char* pLabel, ENumberDisplayMode& numberMode);
 bool DrawOperandTypeCombo(const char* pLabel, EOperandType& operandType);
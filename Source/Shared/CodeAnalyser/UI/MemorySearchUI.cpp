@@ -0,0 +1,119 @@
+#include "MemorySearchUI.h"
+#include "../CodeAnalyser.h"
+#include "CodeAnalyserUI.h"
+#include "Util/Misc.h"
+
+#include <imgui.h>
+#include <chrono>
+#include <sstream>
+
+static bool ParsePatternList(FMemorySearchUIState& searchState)
+{
+	searchState.Patterns.clear();
+	searchState.ErrorText.clear();
+
+	std::istringstream textStream(searchState.PatternText);
+	std::string line;
+	int lineNo = 0;
+	while (std::getline(textStream, line))
+	{
+		lineNo++;
+		if (line.find_first_not_of(" \t\r") == std::string::npos)
+			continue;
+
+		FMemorySearchPattern pattern;
+		if (ParseMemorySearchPattern(line.c_str(), pattern) == false)
+		{
+			searchState.ErrorText = "Line " + std::to_string(lineNo) + ": can't parse '" + line + "'";
+			return false;
+		}
+		searchState.Patterns.push_back(pattern);
+	}
+
+	if (searchState.Patterns.empty())
+	{
+		searchState.ErrorText = "No patterns";
+		return false;
+	}
+
+	return true;
+}
+
+void DrawMemorySearchUI(FCodeAnalysisState& state, FMemorySearchUIState& searchState, const std::vector<FMemorySearchBank>& banks)
+{
+	FCodeAnalysisViewState& viewState = state.GetFocussedViewState();
+
+	ImGui::Text("Patterns - one per line. Hex bytes, ?? or ? nibble wildcards, \"text\"");
+	ImGui::InputTextMultiline("##SearchPatterns", searchState.PatternText, sizeof(searchState.PatternText), ImVec2(-1, ImGui::GetTextLineHeight() * 5));
+
+	if (ImGui::Button("Search") && ParsePatternList(searchState))
+	{
+		const auto startTime = std::chrono::steady_clock::now();
+		SearchMemory(banks.data(), (int)banks.size(), searchState.Patterns, searchState.Hits);
+		const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+		searchState.SearchTimeMS = elapsed.count();
+		searchState.SelectedHit = -1;
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Clear"))
+	{
+		searchState.Hits.clear();
+		searchState.SelectedHit = -1;
+	}
+
+	if (searchState.ErrorText.empty() == false)
+	{
+		ImGui::TextColored(ImVec4(1.0f, 0.25f, 0.25f, 1.0f), "%s", searchState.ErrorText.c_str());
+		return;
+	}
+
+	ImGui::Text("%d hits in %d banks (%.2fms)", (int)searchState.Hits.size(), (int)banks.size(), searchState.SearchTimeMS);
+
+	if (ImGui::BeginChild("MemorySearchHits", ImVec2(0, 0), true, ImGuiWindowFlags_HorizontalScrollbar))
+	{
+		const float lineHeight = ImGui::GetTextLineHeight();
+		ImGuiListClipper clipper((int)searchState.Hits.size(), lineHeight);
+
+		while (clipper.Step())
+		{
+			for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+			{
+				const FMemorySearchHit& hit = searchState.Hits[i];
+				if (hit.Bank >= (int)banks.size() || hit.Pattern >= (int)searchState.Patterns.size())
+					continue;
+
+				// use current paging - it may have changed since the search
+				const FMemorySearchBank& bank = banks[hit.Bank];
+				const int bankCPUAddress = bank.GetCPUAddress(hit.Offset);
+				const bool bPagedIn = bankCPUAddress != -1;
+				const uint16_t cpuAddress = (uint16_t)bankCPUAddress;
+
+				ImGui::PushID(i);
+				if (ImGui::Selectable("##searchhit", searchState.SelectedHit == i))
+				{
+					searchState.SelectedHit = i;
+					if (bPagedIn)
+						CodeAnalyserGoToAddress(viewState, cpuAddress);
+				}
+				ImGui::SetItemAllowOverlap();	// allow buttons
+				ImGui::SameLine();
+				ImGui::Text("%s:%04X", bank.Name.c_str(), hit.Offset);
+				ImGui::SameLine(120);
+				if (bPagedIn)
+				{
+					ImGui::Text("%s", NumStr(cpuAddress));
+					ImGui::SameLine();
+					DrawAddressLabel(state, viewState, cpuAddress);
+				}
+				else
+				{
+					ImGui::TextDisabled("not paged in");
+				}
+				ImGui::SameLine(360);
+				ImGui::Text("%s", searchState.Patterns[hit.Pattern].Text.c_str());
+				ImGui::PopID();
+			}
+		}
+	}
+	ImGui::EndChild();
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "../../Util/MemorySearch.h"
+
+struct FCodeAnalysisState;
+
+struct FMemorySearchUIState
+{
+	char								PatternText[1024] = { 0 };	// one pattern per line
+	std::vector<FMemorySearchPattern>	Patterns;
+	std::vector<FMemorySearchHit>		Hits;
+	std::string							ErrorText;
+	int									SelectedHit = -1;
+	double								SearchTimeMS = 0.0;
+};
+
+// banks are supplied by the machine - all RAM & ROM banks with their current CPU mapping
+void DrawMemorySearchUI(FCodeAnalysisState& state, FMemorySearchUIState& searchState, const std::vector<FMemorySearchBank>& banks);
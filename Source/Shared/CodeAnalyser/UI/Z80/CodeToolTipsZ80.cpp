@@ -7,7 +7,7 @@
 
 #include "imgui.h"
 
-#include <map>
+#include "../../Z80/OpcodeTableZ80.h"
 
 struct FToolTipReg
 {
@@ -24,54 +24,40 @@ struct FToolTipReg
 
 struct FToolTipInstructionInfo
 {
-	uint32_t RegFlags = 0;
+	static const int kMaxRegInfos = 4;
+
+	const FToolTipReg* FindRegInfo(uint32_t reg) const
+	{
+		for (int i = 0; i < NoRegInfos; i++)
+		{
+			if (RegInfoRegs[i] == reg)
+				return &RegInfos[i];
+		}
+		return nullptr;
+	}
+
+	void SetRegInfo(uint32_t reg, const FToolTipReg& regInfo)
+	{
+		int i = 0;
+		while (i < NoRegInfos && RegInfoRegs[i] != reg)
+			i++;
+		if (i == kMaxRegInfos)
+			return;
+		if (i == NoRegInfos)
+			NoRegInfos++;
+		RegInfoRegs[i] = reg;
+		RegInfos[i] = regInfo;
+	}
+
+	uint32_t RegFlags = 0;	// registers used - from the opcode table
 	std::string Title;
 	std::string Description;
-	std::map<uint32_t, FToolTipReg> RegInfoMap;
-};
 
-// register bits
-namespace Z80Reg
-{
-	const uint32_t	A = 0x00000001;
-	const uint32_t	F = 0x00000002;
-	const uint32_t	B = 0x00000004;
-	const uint32_t	C = 0x00000008;
-	const uint32_t	D = 0x00000010;
-	const uint32_t	E = 0x00000020;
-	const uint32_t	H = 0x00000040;
-	const uint32_t	L = 0x00000080;
-	const uint32_t	I = 0x00000100;
-	const uint32_t	R = 0x00000200;
-	const uint32_t	IXL = 0x00000400;
-	const uint32_t	IXH = 0x00000800;
-	const uint32_t	IYL = 0x00001000;
-	const uint32_t	IYH = 0x00002000;
-
-	const uint32_t	SP = 0x00004000;
-	const uint32_t	AF = 0x00008000;
-	const uint32_t	BC = 0x00010000;
-	const uint32_t	DE = 0x00020000;
-	const uint32_t	HL = 0x00040000;
-	const uint32_t	IX = 0x00080000;
-	const uint32_t	IY = 0x00100000;
-
-	const uint32_t	IX_Indirect_D = 0x00200000;
-	const uint32_t	IY_Indirect_D = 0x00400000;
-
-	const uint32_t	AF_ALT = 0x00800000;
-	const uint32_t	SPARE_BIT_2 = 0x01000000;
-	const uint32_t	SPARE_BIT_3 = 0x02000000;
-
-	const uint32_t	BC_Indirect = 0x04000000;
-	const uint32_t	DE_Indirect = 0x08000000;
-	const uint32_t	HL_Indirect = 0x10000000;
-	const uint32_t	IX_Indirect = 0x20000000;
-	const uint32_t	IY_Indirect = 0x40000000;
-	const uint32_t	SP_Indirect = 0x80000000;
-
-	// todo: add PC?
-}
+	// display info for specific registers
+	int			NoRegInfos = 0;
+	uint32_t	RegInfoRegs[kMaxRegInfos];
+	FToolTipReg	RegInfos[kMaxRegInfos];
+};
 
 static uint32_t g_TTZ80Reg[8] = { Z80Reg::B, Z80Reg::C, Z80Reg::D, Z80Reg::E, Z80Reg::H,   Z80Reg::L,   Z80Reg::HL_Indirect, Z80Reg::A };
 static uint32_t g_TTZ80RegIX[8] = { Z80Reg::B, Z80Reg::C, Z80Reg::D, Z80Reg::E, Z80Reg::IXH, Z80Reg::IXL, Z80Reg::IX_Indirect_D, Z80Reg::A };
@@ -169,16 +155,16 @@ void GetTooltipRegStr(uint32_t regFlag, uint32_t regFlag2, uint16_t value, bool
 
 	if (inst.RegFlags & regFlag || inst.RegFlags & regFlag2)
 	{
-		std::map<uint32_t, FToolTipReg>::iterator it = inst.RegInfoMap.find(regFlag);
+		const FToolTipReg* pRegInfo = inst.FindRegInfo(regFlag);
 		const char* numStr = isByte ? NumStr((uint8_t)value) : NumStr(value);
 		std::string numStrAlt;
-		if (it != inst.RegInfoMap.end())
+		if (pRegInfo != nullptr)
 		{
-			if (it->second.DisplayMode != GetNumberDisplayMode())
+			if (pRegInfo->DisplayMode != GetNumberDisplayMode())
 			{
 				//numStrAlt += " (";
 				numStrAlt += ' ';
-				numStrAlt += isByte ? NumStr((uint8_t)value, it->second.DisplayMode) : NumStr(value, it->second.DisplayMode);
+				numStrAlt += isByte ? NumStr((uint8_t)value, pRegInfo->DisplayMode) : NumStr(value, pRegInfo->DisplayMode);
 				//numStrAlt += ')';
 			}
 		}
@@ -203,8 +189,8 @@ void GetTooltipRegStrIndirect(uint32_t regFlag, uint16_t addr, bool isByte, FToo
 
 	if (inst.RegFlags & regFlag)
 	{
-		std::map<uint32_t, FToolTipReg>::iterator it = inst.RegInfoMap.find(regFlag);
-		const uint8_t d = it == inst.RegInfoMap.end() ? 0 : it->second.Displacement;
+		const FToolTipReg* pRegInfo = inst.FindRegInfo(regFlag);
+		const uint8_t d = pRegInfo == nullptr ? 0 : pRegInfo->Displacement;
 		uint16_t value = 0;
 		const char* numStr = 0;
 		if (isByte)
@@ -218,13 +204,13 @@ void GetTooltipRegStrIndirect(uint32_t regFlag, uint16_t addr, bool isByte, FToo
 			numStr = NumStr(value);
 		}
 		std::string numStrAlt;
-		if (it != inst.RegInfoMap.end())
+		if (pRegInfo != nullptr)
 		{
-			if (it->second.DisplayMode != GetNumberDisplayMode())
+			if (pRegInfo->DisplayMode != GetNumberDisplayMode())
 			{
 				//numStrAlt += " (";
 				numStrAlt += ' ';
-				numStrAlt += isByte ? NumStr((uint8_t)value, it->second.DisplayMode) : NumStr(value, it->second.DisplayMode);
+				numStrAlt += isByte ? NumStr((uint8_t)value, pRegInfo->DisplayMode) : NumStr(value, pRegInfo->DisplayMode);
 				//numStrAlt += ')';
 			}
 		}
@@ -307,7 +293,7 @@ void Do8BitLoadBlock(uint8_t y, uint8_t z, uint8_t prefix, uint32_t* r, uint16_t
 	if (prefix)
 	{
 		d = CPUIF->ReadByte(pc);
-		inst.RegInfoMap[r[6]] = FToolTipReg(d);
+		inst.SetRegInfo(r[6], FToolTipReg(d));
 	}
 
 	if (y == 6)
@@ -325,12 +311,10 @@ void Do8BitLoadBlock(uint8_t y, uint8_t z, uint8_t prefix, uint32_t* r, uint16_t
 			{
 				/* special case LD (IX+d),L/H (don't use IXL/IXH) */
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Load %s from %s.", GetRegName(r[6], d).c_str(), GetRegName(g_TTZ80Reg[z]).c_str());
-				inst.RegFlags = g_TTZ80Reg[z] | r[6];
 			}
 			else
 			{
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Load %s from %s.", GetRegName(r[6], d).c_str(), GetRegName(r[z]).c_str());
-				inst.RegFlags = r[z] | r[6];
 			}
 		}
 	}
@@ -341,19 +325,16 @@ void Do8BitLoadBlock(uint8_t y, uint8_t z, uint8_t prefix, uint32_t* r, uint16_t
 		{
 			/* special case LD H/L,(IX+d) (don't use IXL/IXH) */
 			snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Load %s from %s.", GetRegName(g_TTZ80Reg[y]).c_str(), GetRegName(r[6], d).c_str());
-			inst.RegFlags = g_TTZ80Reg[y] | r[6];
 		}
 		else
 		{
 			snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Load %s from %s.", GetRegName(r[y]).c_str(), GetRegName(r[6], d).c_str());
-			inst.RegFlags = r[y] | r[6];
 		}
 	}
 	else
 	{
 		/* regular LD r,s */
 		snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Load %s from %s.", GetRegName(r[y]).c_str(), GetRegName(r[z]).c_str());
-		inst.RegFlags = g_TTZ80Reg[y] | g_TTZ80Reg[z];
 	}
 }
 
@@ -375,14 +356,12 @@ void Do8BitALUBlock(uint8_t y, uint8_t z, uint8_t prefix, uint32_t* r, uint16_t
 		break;
 	case 1: // ADC A, s 
 		snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Add %s and C flag to A. Result stored in A.", regName.c_str());
-		inst.RegFlags |= Z80Reg::F;
 		break;
 	case 2: // SUB s
 		snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Subtract %s from A. Result stored in A.", regName.c_str());
 		break;
 	case 3: // SBC A, s
 		snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Subtract %s and C flag from A. Result stored in A.", regName.c_str());
-		inst.RegFlags |= Z80Reg::F;
 		break;
 	case 4: // AND s
 		snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Logical AND A with %s. Result stored in A.", regName.c_str());
@@ -404,17 +383,14 @@ void Do8BitALUBlock(uint8_t y, uint8_t z, uint8_t prefix, uint32_t* r, uint16_t
 			"A < %s:  S and P/V are different.\nA >= %s: S and P/V are the same.\n",
 			regName.c_str(), regName.c_str(), regName.c_str(), regName.c_str(), regName.c_str(), regName.c_str(), regName.c_str(), regName.c_str(), regName.c_str());
 		snprintf(g_TTZ80TitleBuf, kTTZ80TitleLen, "Compare A with %s", regName.c_str());
-		inst.RegFlags |= Z80Reg::F;
 		break;
 	}
 
-	inst.RegFlags |= r[z] | Z80Reg::A;
-
 	if (prefix || bBinary)
 	{
 		ENumberDisplayMode numMode = bBinary ? ENumberDisplayMode::Binary : GetNumberDisplayMode();
-		inst.RegInfoMap[r[z]] = FToolTipReg(d, numMode);
-		inst.RegInfoMap[Z80Reg::A] = FToolTipReg(d, numMode);
+		inst.SetRegInfo(r[z], FToolTipReg(d, numMode));
+		inst.SetRegInfo(Z80Reg::A, FToolTipReg(d, numMode));
 	}
 }
 
@@ -471,8 +447,6 @@ void DoCBPrefix(uint8_t prefix, uint32_t* r, uint16_t pc, ICPUInterface* CPUIF,
 			snprintf(g_TTZ80TitleBuf, kTTZ80TitleLen, "Logical shift right %s", regName.c_str());
 			break;
 		}
-
-		inst.RegFlags = r[z];
 	}
 	else if (x == 1) /* BIT b, r */
 	{
@@ -488,8 +462,7 @@ void DoCBPrefix(uint8_t prefix, uint32_t* r, uint16_t pc, ICPUInterface* CPUIF,
 	{
 		snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Set bit %d of %s.", y, regName.c_str());
 	}
-	inst.RegFlags = r[z];
-	inst.RegInfoMap[r[z]] = FToolTipReg(d, ENumberDisplayMode::Binary);
+	inst.SetRegInfo(r[z], FToolTipReg(d, ENumberDisplayMode::Binary));
 }
 
 void DoEDPrefix(uint8_t prefix, uint32_t* r, uint32_t* rp, uint16_t pc, ICPUInterface* CPUIF, FToolTipInstructionInfo& inst)
@@ -534,7 +507,6 @@ void DoEDPrefix(uint8_t prefix, uint32_t* r, uint32_t* rp, uint16_t pc, ICPUInte
 					snprintf(g_TTZ80TitleBuf, kTTZ80TitleLen, "Repeating block load with decrement");
 					break;
 				}
-				inst.RegFlags = Z80Reg::BC | Z80Reg::HL | Z80Reg::DE | Z80Reg::DE_Indirect | Z80Reg::HL_Indirect;
 			}
 			else if (z == 1) /* Second column. CPI, CPD, CPIR, CPDR*/
 			{
@@ -561,7 +533,6 @@ void DoEDPrefix(uint8_t prefix, uint32_t* r, uint32_t* rp, uint16_t pc, ICPUInte
 					snprintf(g_TTZ80TitleBuf, kTTZ80TitleLen, "Block compare with decrement");
 					break;
 				}
-				inst.RegFlags = Z80Reg::A | Z80Reg::BC | Z80Reg::HL | Z80Reg::HL_Indirect;
 			}
 			else if (z == 2) /* Third column. INI, IND, INIR, INDR */
 			{
@@ -588,7 +559,6 @@ void DoEDPrefix(uint8_t prefix, uint32_t* r, uint32_t* rp, uint16_t pc, ICPUInte
 					snprintf(g_TTZ80TitleBuf, kTTZ80TitleLen, "Block input with decrement");
 					break;
 				}
-				inst.RegFlags = Z80Reg::B | Z80Reg::C | Z80Reg::HL | Z80Reg::HL_Indirect;
 			}
 			else /* Fourth column. OUTI, OUTD, OTIR, OTDR */
 			{
@@ -611,8 +581,6 @@ void DoEDPrefix(uint8_t prefix, uint32_t* r, uint32_t* rp, uint16_t pc, ICPUInte
 					snprintf(g_TTZ80TitleBuf, kTTZ80TitleLen, "Block output with decrement");
 					break;
 				}
-
-				inst.RegFlags = Z80Reg::B | Z80Reg::C | Z80Reg::HL | Z80Reg::HL_Indirect;
 			}
 		}
 		else
@@ -630,7 +598,6 @@ void DoEDPrefix(uint8_t prefix, uint32_t* r, uint32_t* rp, uint16_t pc, ICPUInte
 				const std::string strReg = GetRegName(r[y]);
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Port (C) is read and the result is loaded into %s.", strReg.c_str());
 				snprintf(g_TTZ80TitleBuf, kTTZ80TitleLen, "Load %s from port (C)", strReg.c_str());
-				inst.RegFlags = r[y] | Z80Reg::C;
 			}
 			break;
 		case 1: /* OUT (C), r*/
@@ -639,12 +606,10 @@ void DoEDPrefix(uint8_t prefix, uint32_t* r, uint32_t* rp, uint16_t pc, ICPUInte
 				const std::string strReg = GetRegName(r[y]);
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "The contents of %s is written to port (C).", strReg.c_str());
 				snprintf(g_TTZ80TitleBuf, kTTZ80TitleLen, "Output %s to port (C)", strReg.c_str());
-				inst.RegFlags = r[y] | Z80Reg::C;
 			}
 			else // OUT (C), 0 [Undocumented]
 			{
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "0 is written to port (C).");
-				inst.RegFlags = Z80Reg::C;
 			}
 			break;
 		case 2: /* SBC HL, ss. ADC HL, ss. Where ss is BC/DE/HL/SP*/
@@ -656,7 +621,6 @@ void DoEDPrefix(uint8_t prefix, uint32_t* r, uint32_t* rp, uint16_t pc, ICPUInte
 			{
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "%s and C flag are added to HL. Result stored in HL.", GetRegName(rp[p]).c_str());
 			}
-			inst.RegFlags = Z80Reg::HL | rp[p] | Z80Reg::F;
 			break;
 		case 3: /* LD (nn), dd. LD dd, (nn). */
 		{
@@ -669,13 +633,11 @@ void DoEDPrefix(uint8_t prefix, uint32_t* r, uint32_t* rp, uint16_t pc, ICPUInte
 			{
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Load %s from memory locations (%s) and (%s).", GetRegName(rp[p]).c_str(), NumStr(nn), NumStr(uint16_t(nn + 1)));
 			}
-			inst.RegFlags = rp[p];
 			break;
 		}
 		case 4: /* NEG */
 			snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Negate A (two's complement). Same result as subtracting A from 0.");
-			inst.RegFlags = Z80Reg::A;
-			inst.RegInfoMap[Z80Reg::A] = FToolTipReg(0, ENumberDisplayMode::Binary);
+			inst.SetRegInfo(Z80Reg::A, FToolTipReg(0, ENumberDisplayMode::Binary));
 			break;
 		case 5: /* RETI/RETN*/
 		{
@@ -691,7 +653,6 @@ void DoEDPrefix(uint8_t prefix, uint32_t* r, uint32_t* rp, uint16_t pc, ICPUInte
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "PC is popped off the stack.");
 				snprintf(g_TTZ80TitleBuf, kTTZ80TitleLen, "Return from interrupt");
 			}
-			inst.RegFlags = Z80Reg::SP_Indirect;
 			break;
 		}
 		case 6: /* IM 0/1/2*/
@@ -744,13 +705,6 @@ void DoEDPrefix(uint8_t prefix, uint32_t* r, uint32_t* rp, uint16_t pc, ICPUInte
 				// NOP (ED)
 				break;
 			}
-			if (y == 0 || y == 2)
-				inst.RegFlags = Z80Reg::A | Z80Reg::I;
-			else
-				if (y == 1 || y == 3)
-					inst.RegFlags = Z80Reg::A | Z80Reg::R;
-				else
-					inst.RegFlags = Z80Reg::A | Z80Reg::HL_Indirect;
 			break;
 		}
 	}
@@ -829,14 +783,12 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 				break;
 			case 1: /* EX AF,AF'*/
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Swap AF and AF'.");
-				inst.RegFlags = Z80Reg::AF | Z80Reg::AF_ALT;
 				break;
 			case 2: /* DJNZ*/
 			{
 				const int8_t offset = CPUIF->ReadByte(pc);
 				const uint16_t addr = pc + offset + 1;
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Decrement B and jump %s to %s on no zero.", offset < 0 ? "back" : "forward", NumStr(addr));
-				inst.RegFlags = Z80Reg::B | Z80Reg::F;
 				break;
 			}
 			case 3: /* JR e*/
@@ -866,7 +818,6 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 					snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Jump %s to %s if the C flag is set.", offset < 0 ? "back" : "forward", NumStr(addr));
 					break;
 				}
-				inst.RegFlags = Z80Reg::F;
 				break;
 			}
 			}
@@ -875,12 +826,10 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 			if (q == 0) /* LD dd,nn*/
 			{
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Load %s with immediate data %s.", GetRegName(rp[p]).c_str(), NumStr(CPUIF->ReadWord(pc)));
-				inst.RegFlags = rp[p];
 			}
 			else /* ADD HL, ss. ADD IX, pp. ADD IY, rr. */
 			{
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "ADD %s to %s and store result in %s.", GetRegName(rp[2]).c_str(), GetRegName(rp[p]).c_str(), GetRegName(rp[2]).c_str());
-				inst.RegFlags = rp[2] | rp[p];
 			}
 			break;
 		case 2:
@@ -889,46 +838,38 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 			{
 			case 0: /* LD (BC),A */
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Load (BC) with A.");
-				inst.RegFlags = Z80Reg::A | Z80Reg::BC_Indirect;
 				break;
 			case 1: /* LD A,(BC) */
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Load A with (BC).");
-				inst.RegFlags = Z80Reg::A | Z80Reg::BC_Indirect;
 				break;
 			case 2: /* LD (DE),A*/
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Load (DE) with A.");
-				inst.RegFlags = Z80Reg::A | Z80Reg::DE_Indirect;
 				break;
 			case 3: /* LD A,(DE)*/
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Load A with (DE).");
-				inst.RegFlags = Z80Reg::A | Z80Reg::DE_Indirect;
 				break;
 			case 4: /* LD (nn), HL/IX/IY*/
 			{
 				const uint16_t nn = CPUIF->ReadWord(pc);
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Load the memory locations %s and %s from %s.", NumStr(nn), NumStr(uint16_t(nn + 1)), GetRegName(rp[p]).c_str());
-				inst.RegFlags = rp[p];
 				break;
 			}
 			case 5: /* LD HL/IX/IY,(nn)*/
 			{
 				const uint16_t nn = CPUIF->ReadWord(pc);
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Load %s from memory locations %s and %s.", GetRegName(rp[p]).c_str(), NumStr(nn), NumStr(uint16_t(nn + 1)));
-				inst.RegFlags = rp[p];
 				break;
 			}
 			case 6: /* LD (nn), A*/
 			{
 				const uint16_t nn = CPUIF->ReadWord(pc);
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Load (%s) from A", NumStr(nn));
-				inst.RegFlags = Z80Reg::A;
 				break;
 			}
 			case 7: /* LD A, (nn)*/
 			{
 				const uint16_t nn = CPUIF->ReadWord(pc);
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Load A from (%s)", NumStr(nn));
-				inst.RegFlags = Z80Reg::A;
 				break;
 			}
 			}
@@ -936,7 +877,6 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 		break;
 		case 3: /* INC/DEC ss (register pair)*/
 			snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "%s register pair %s", q == 0 ? "Increment" : "Decrement", GetRegName(rp[p]).c_str());
-			inst.RegFlags = rp[p];
 			break;
 		case 4: /* INC (HL)/(IX+d)/(IY+d) or r */
 		{
@@ -945,7 +885,7 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 				if (prefix) // INC (IX+d)/(IY+d)
 				{
 					int8_t d = CPUIF->ReadByte(pc++);
-					inst.RegInfoMap[r[y]] = FToolTipReg(d);
+					inst.SetRegInfo(r[y], FToolTipReg(d));
 					snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Increment %s.", GetRegName(r[y], d).c_str());
 				}
 				else // INC (HL)
@@ -957,7 +897,6 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 			{
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Increment %s.", GetRegName(r[y]).c_str());
 			}
-			inst.RegFlags = r[y];
 			break;
 		}
 		case 5: /* DEC (HL)/(IX+d)/(IY+d) or r */
@@ -967,7 +906,7 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 				if (prefix) // DEC (IX+d)/(IY+d)
 				{
 					int8_t d = CPUIF->ReadByte(pc++);
-					inst.RegInfoMap[r[y]] = FToolTipReg(d);
+					inst.SetRegInfo(r[y], FToolTipReg(d));
 					snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Decrement %s.", GetRegName(r[y], d).c_str());
 				}
 				else // DEC (HL)
@@ -980,7 +919,6 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 			{
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Decrement %s.", GetRegName(r[y]).c_str());
 			}
-			inst.RegFlags |= r[y];
 			break;
 		}
 		case 6: /* LD s, n. Where s is (HL)/(IX+d)/(IY+d) or r*/
@@ -989,7 +927,7 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 				if (prefix) // LD (IX+d)/(IY+d), n
 				{
 					int8_t d = CPUIF->ReadByte(pc++);
-					inst.RegInfoMap[r[y]] = FToolTipReg(d);
+					inst.SetRegInfo(r[y], FToolTipReg(d));
 					snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Load %s with immediate data %s.", GetRegName(r[y], d).c_str(), NumStr(CPUIF->ReadByte(pc + 1)));
 				}
 				else // LD (HL), n
@@ -1001,7 +939,6 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 			{
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Load %s with immediate data %s.", GetRegName(r[y]).c_str(), NumStr(CPUIF->ReadByte(pc)));
 			}
-			inst.RegFlags |= r[y];
 			break;
 		case 7:
 			if (y < 6) /* RLCA, RRCA, RLA, RRA, DAA, CPL, */
@@ -1034,8 +971,7 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 					snprintf(g_TTZ80TitleBuf, kTTZ80TitleLen, "Complement accumulator");
 					break;
 				}
-				inst.RegFlags = Z80Reg::A;
-				inst.RegInfoMap[Z80Reg::A] = FToolTipReg(0, ENumberDisplayMode::Binary);
+				inst.SetRegInfo(Z80Reg::A, FToolTipReg(0, ENumberDisplayMode::Binary));
 			}
 			else /* SCF, CCF*/
 			{
@@ -1047,7 +983,6 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 				{
 					snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Flip C flag. C = !C");
 				}
-				inst.RegFlags = Z80Reg::F;
 			}
 			break;
 		}
@@ -1084,8 +1019,6 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Return from subroutine if S flag is not set (sign negative).");
 				break;
 			}
-
-			inst.RegFlags = Z80Reg::F | Z80Reg::SP_Indirect;
 			break;
 		case 1:
 			if (q == 0) /* POP qq (register pair)*/
@@ -1093,7 +1026,6 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 				std::string strReg = GetRegName(rp2[p]);
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "(SP) is loaded into the low byte of %s. SP is incremented and (SP) is loaded into the high byte of %s and then SP is incremented again.", GetRegName(rp2[p]).c_str(), GetRegName(rp2[p]).c_str());
 				snprintf(g_TTZ80TitleBuf, kTTZ80TitleLen, "Pop %s from stack.", strReg.c_str());
-				inst.RegFlags = rp2[p] | Z80Reg::SP_Indirect;
 			}
 			else
 			{
@@ -1103,7 +1035,6 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 				{
 					snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "PC is popped from the stack. Normally used to return from a subroutine entered by a CALL instruction.");
 					snprintf(g_TTZ80TitleBuf, kTTZ80TitleLen, "Return from subroutine");
-					inst.RegFlags = Z80Reg::SP_Indirect;
 					break;
 				}
 				case 1: /* EXX */
@@ -1111,11 +1042,9 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 					break;
 				case 2: /* JP (HL)/(IX)/(IY)*/
 					snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Jump to (%s)", GetRegName(rp[2]).c_str());
-					inst.RegFlags = rp[2];
 					break;
 				case 3: /* LD SP, HL/IX/IY*/
 					snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Load SP from %s", GetRegName(rp[2]).c_str());
-					inst.RegFlags = rp[p];
 					break;
 				}
 			}
@@ -1150,8 +1079,6 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Jump to %s if S flag is not set (sign negative).", pchnn);
 				break;
 			}
-
-			inst.RegFlags = Z80Reg::F;
 			break;
 		}
 		case 3:
@@ -1163,20 +1090,16 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 			case 2: /* OUT (n), A*/
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Contents of A is written to port (%s).", NumStr(CPUIF->ReadByte(pc)));
 				snprintf(g_TTZ80TitleBuf, kTTZ80TitleLen, "Output A to port number specified in immediate data");
-				inst.RegFlags = Z80Reg::A;
 				break;
 			case 3: /* IN A, (n)*/
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Port (%s) is read and the result is loaded into A.", NumStr(CPUIF->ReadByte(pc)));
 				snprintf(g_TTZ80TitleBuf, kTTZ80TitleLen, "Load A from port number specified in immediate data");
-				inst.RegFlags = Z80Reg::A;
 				break;
 			case 4: /* EX (SP), HL/IX/IY*/
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Exchange %s with top of stack.", GetRegName(rp[2]).c_str());
-				inst.RegFlags = rp[2] | Z80Reg::SP_Indirect;
 				break;
 			case 5: /* EX DE,HL*/
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Exchange the HL and DE registers");
-				inst.RegFlags = Z80Reg::DE | Z80Reg::HL;
 				break;
 			case 6: /* DI*/
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Disable maskable interrupts.");
@@ -1219,8 +1142,6 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Call subroutine at %s if S flag is not set (sign negative).", pchnn);
 				break;
 			}
-
-			inst.RegFlags = Z80Reg::F;
 			break;
 		}
 		case 5:
@@ -1230,7 +1151,6 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 				std::string strReg = GetRegName(rp2[p]);
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "SP is decremented and the high byte of %s is loaded into (SP). SP is decremented again and the low byte of %s is loaded into (SP).", strReg.c_str(), strReg.c_str());
 				snprintf(g_TTZ80TitleBuf, kTTZ80TitleLen, "Push %s onto stack.", strReg.c_str());
-				inst.RegFlags = rp2[p] | Z80Reg::SP_Indirect;
 			}
 			else
 			{
@@ -1263,14 +1183,12 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 				break;
 			case 1: // ADC A, n
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Add immediate data %s and C flag to A. Result stored in A.", pchn);
-				inst.RegFlags |= Z80Reg::F;
 				break;
 			case 2: // SUB A, n
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Subtract immediate data %s from A. Result stored in A.", pchn);
 				break;
 			case 3: // SBC A, n
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Subtract immediate data %s and C flag from A. Result stored in A.", pchn);
-				inst.RegFlags |= Z80Reg::F;
 				break;
 			case 4: // AND n
 				snprintf(g_TTZ80DescBuf, kTTZ80DescLen, "Logical AND A with immediate data %s (%s). Result stored in A.", pchn, NumStr(n, ENumberDisplayMode::Binary));
@@ -1290,14 +1208,12 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 					"A < %s:  S and P/V are different.\nA >= %s: S and P/V are the same.\n",
 					pchn, pchn, pchn, pchn, pchn, pchn, pchn, pchn, pchn);
 				snprintf(g_TTZ80TitleBuf, kTTZ80TitleLen, "Compare A with immediate data %s", pchn);
-				inst.RegFlags |= Z80Reg::F;
 				break;
 			}
 			}
-			inst.RegFlags |= Z80Reg::A;
 			if (y >= 4 && y <= 6)
 			{
-				inst.RegInfoMap[Z80Reg::A] = FToolTipReg(0, ENumberDisplayMode::Binary);
+				inst.SetRegInfo(Z80Reg::A, FToolTipReg(0, ENumberDisplayMode::Binary));
 			}
 			break;
 		}
@@ -1313,10 +1229,21 @@ void GetToolTipInfoFromOpcode(uint16_t pc, ICPUInterface* CPUIF, FToolTipInstruc
 
 void ShowCodeToolTipZ80(FCodeAnalysisState& state, const FCodeInfo* pCodeInfo)
 {
-	// Get flags for register usage and try to auto generate a description for the instruction.
+	// Get register usage from the opcode table and try to auto generate a description for the instruction.
+	const FZ80OpcodeInfo& opcodeInfo = GetOpcodeInfoZ80(state.CPUInterface, pCodeInfo->Address);
 	FToolTipInstructionInfo instrInfo;
 	GetToolTipInfoFromOpcode(pCodeInfo->Address, state.CPUInterface, instrInfo);
 
+	// flags are only shown when the instruction depends on them
+	instrInfo.RegFlags = opcodeInfo.RegsRead | (opcodeInfo.RegsWritten & ~Z80Reg::F);
+
+	if (opcodeInfo.MemOperand == EZ80MemOperand::Indexed)
+	{
+		const uint32_t indexReg = (opcodeInfo.RegsRead | opcodeInfo.RegsWritten) & (Z80Reg::IX_Indirect_D | Z80Reg::IY_Indirect_D);
+		if (instrInfo.FindRegInfo(indexReg) == nullptr)
+			instrInfo.SetRegInfo(indexReg, FToolTipReg((int8_t)state.CPUInterface->ReadByte(pCodeInfo->Address + opcodeInfo.OperandOffset)));
+	}
+
 	std::vector<std::string> regStrs;
 	GenerateRegisterValueStrings(instrInfo, state.CPUInterface, regStrs);
 
@@ -1346,6 +1273,12 @@ void ShowCodeToolTipZ80(FCodeAnalysisState& state, const FCodeInfo* pCodeInfo)
 		ImGui::TextUnformatted(instrInfo.Description.c_str());
 	}
 
+	// Draw timing - conditional instructions show taken/not taken
+	if (opcodeInfo.TStates != opcodeInfo.TStatesNotTaken)
+		ImGui::Text("T-states: %d/%d", opcodeInfo.TStates, opcodeInfo.TStatesNotTaken);
+	else
+		ImGui::Text("T-states: %d", opcodeInfo.TStates);
+
 	// Draw register values (if there are any)
 	if (!regStrs.empty())
 	{
@@ -1,59 +1,21 @@
 #include "CodeAnalyserZ80.h"
+#include "OpcodeTableZ80.h"
 #include "../CodeAnalyser.h"
 #include <cassert>
+#include <cstring>
 
 #include "chips/z80.h"
 
 
 bool CheckPointerIndirectionInstructionZ80(ICPUInterface* pCPUInterface, uint16_t pc, uint16_t* out_addr)
 {
-	const uint8_t instrByte = pCPUInterface->ReadByte(pc);
+	const FZ80OpcodeInfo& opcodeInfo = GetOpcodeInfoZ80(pCPUInterface, pc);
 
-	switch (instrByte)
+	// LD (nnnn),x & LD x,(nnnn)
+	if (opcodeInfo.MemOperand == EZ80MemOperand::Absolute)
 	{
-		// LD (nnnn),x
-	case 0x22:
-	case 0x32:
-		// LD x,(nnnn)
-	case 0x2A:
-	case 0x3A:
-		*out_addr = (pCPUInterface->ReadByte(pc + 2) << 8) | pCPUInterface->ReadByte(pc + 1);
+		*out_addr = pCPUInterface->ReadWord(pc + opcodeInfo.OperandOffset);
 		return true;
-	
-		// extended instructions
-	case 0xED:
-	{
-		const uint8_t exInstrByte = pCPUInterface->ReadByte(pc + 1);
-		switch (exInstrByte)
-		{
-		case 0x43://ld (**),bc
-		case 0x4B://ld bc,(**)
-		case 0x53://ld (**),de
-		case 0x5B://ld de,(**)
-		case 0x63://ld (**),hl
-		case 0x6B://ld hl,(**)
-		case 0x73://ld (**),sp
-		case 0x7B://ld sp,(**)
-			*out_addr = (pCPUInterface->ReadByte(pc + 3) << 8) | pCPUInterface->ReadByte(pc + 2);
-			return true;
-		}
-
-	}
-	return false;
-
-	// IX/IY instructions
-	case 0xDD:
-	case 0xFD:
-	{
-		const uint8_t exInstrByte = pCPUInterface->ReadByte(pc + 1);
-		switch (exInstrByte)
-		{
-		case 0x22://ld (**),ix/iy
-		case 0x2A://ld ix/iy,(**)
-			*out_addr = (pCPUInterface->ReadByte(pc + 3) << 8) | pCPUInterface->ReadByte(pc + 2);
-			return true;
-		}
-	}
 	}
 
 	return false;
@@ -62,266 +24,117 @@ bool CheckPointerIndirectionInstructionZ80(ICPUInterface* pCPUInterface, uint16_
 
 bool CheckPointerRefInstructionZ80(ICPUInterface* pCPUInterface, uint16_t pc, uint16_t* out_addr)
 {
-	if (CheckPointerIndirectionInstructionZ80(pCPUInterface, pc, out_addr))
-		return true;
+	const FZ80OpcodeInfo& opcodeInfo = GetOpcodeInfoZ80(pCPUInterface, pc);
 
-	const uint8_t instrByte = pCPUInterface->ReadByte(pc);
-
-	switch (instrByte)
+	// LD (nnnn),x, LD x,(nnnn) & LD x,nnnn
+	if (opcodeInfo.MemOperand == EZ80MemOperand::Absolute || opcodeInfo.MemOperand == EZ80MemOperand::ImmediateAddress)
 	{
-		// LD x,nnnn
-	case 0x01:
-	case 0x11:
-	case 0x21:
-	case 0x31:
-		*out_addr = (pCPUInterface->ReadByte(pc + 2) << 8) | pCPUInterface->ReadByte(pc + 1);
+		*out_addr = pCPUInterface->ReadWord(pc + opcodeInfo.OperandOffset);
 		return true;
-
-		// IX/IY instructions
-	case 0xDD:
-	case 0xFD:
-	{
-		const uint8_t exInstrByte = pCPUInterface->ReadByte(pc + 1);
-		switch (exInstrByte)
-		{
-		case 0x21://ld ix/iy,**
-			*out_addr = (pCPUInterface->ReadByte(pc + 3) << 8) | pCPUInterface->ReadByte(pc + 2);
-			return true;
-		}
-	}
 	}
+
 	return false;
 }
 
 bool CheckJumpInstructionZ80(ICPUInterface* pCPUInterface, uint16_t pc, uint16_t* out_addr)
 {
-	const uint8_t instrByte = pCPUInterface->ReadByte(pc);
+	const FZ80OpcodeInfo& opcodeInfo = GetOpcodeInfoZ80(pCPUInterface, pc);
 
-	switch (instrByte)
+	switch (opcodeInfo.Flow)
 	{
-		/* CALL nnnn */
-	case 0xCD:
-		/* CALL cc,nnnn */
-	case 0xDC: case 0xFC: case 0xD4: case 0xC4:
-	case 0xF4: case 0xEC: case 0xE4: case 0xCC:
-		/* JP nnnn */
-	case 0xC3:
-		/* JP cc,nnnn */
-	case 0xDA: case 0xFA: case 0xD2: case 0xC2:
-	case 0xF2: case 0xEA: case 0xE2: case 0xCA:
-		*out_addr = pCPUInterface->ReadWord(pc + 1);
+	case EZ80Flow::Jump:
+	case EZ80Flow::JumpCC:
+	case EZ80Flow::Call:
+	case EZ80Flow::CallCC:
+		*out_addr = pCPUInterface->ReadWord(pc + opcodeInfo.OperandOffset);
 		return true;
 
-		/* DJNZ d */
-	case 0x10:
-		/* JR d */
-	case 0x18:
-		/* JR cc,d */
-	case 0x38: case 0x30: case 0x20: case 0x28:
+	case EZ80Flow::JumpRelative:
+	case EZ80Flow::JumpRelativeCC:
 	{
-		const int8_t relJump = (int8_t)pCPUInterface->ReadByte(pc + 1);
-		*out_addr = pc + 2 + relJump;	// +2 because it's relative to the next instruction
+		const int8_t relJump = (int8_t)pCPUInterface->ReadByte(pc + opcodeInfo.OperandOffset);
+		*out_addr = pc + opcodeInfo.Length + relJump;	// relative to the next instruction
 	}
 	return true;
-	/* RST */
-	case 0xC7:  *out_addr = 0x00; return true;
-	case 0xCF:  *out_addr = 0x08; return true;
-	case 0xD7:  *out_addr = 0x10; return true;
-	case 0xDF:  *out_addr = 0x18; return true;
-	case 0xE7:  *out_addr = 0x20; return true;
-	case 0xEF:  *out_addr = 0x28; return true;
-	case 0xF7:  *out_addr = 0x30; return true;
-	case 0xFF:  *out_addr = 0x38; return true;
-	}
 
-	return false;
+	case EZ80Flow::Rst:
+		*out_addr = pCPUInterface->ReadByte(pc + opcodeInfo.Length - 1) & 0x38;
+		return true;
+
+	default:
+		return false;
+	}
 }
 
 bool CheckCallInstructionZ80(ICPUInterface* pCPUInterface, uint16_t pc)
 {
-	const uint8_t instrByte = pCPUInterface->ReadByte(pc);
+	const EZ80Flow flow = GetOpcodeInfoZ80(pCPUInterface, pc).Flow;
 
-	switch (instrByte)
-	{
-		/* CALL nnnn */
-	case 0xCD:
-		/* CALL cc,nnnn */
-	case 0xDC: case 0xFC: case 0xD4: case 0xC4:
-	case 0xF4: case 0xEC: case 0xE4: case 0xCC:
-		/* RST */
-	case 0xC7:
-	case 0xCF:
-	case 0xD7:
-	case 0xDF:
-	case 0xE7:
-	case 0xEF:
-	case 0xF7:
-	case 0xFF:
-		return true;
-	}
-	return false;
+	return flow == EZ80Flow::Call || flow == EZ80Flow::CallCC || flow == EZ80Flow::Rst;
 }
 
 bool CheckStopInstructionZ80(ICPUInterface* pCPUInterface, uint16_t pc)
 {
-	const uint8_t instrByte = pCPUInterface->ReadByte(pc);
-
-	switch (instrByte)
+	switch (GetOpcodeInfoZ80(pCPUInterface, pc).Flow)
 	{
-		/* CALL nnnn */
-	case 0xCD:
-		/* CALL cc,nnnn */
-	case 0xDC: case 0xFC: case 0xD4: case 0xC4:
-	case 0xF4: case 0xEC: case 0xE4: case 0xCC:
-		/* RST */
-	case 0xC7:
-	case 0xCF:
-	case 0xD7:
-	case 0xDF:
-	case 0xE7:
-	case 0xEF:
-	case 0xF7:
-	case 0xFF:
-		// ret
-	case 0xC8:
-	case 0xC9:
-	case 0xD8:
-	case 0xE8:
-	case 0xF8:
-
-
-	case 0xc3:// jp
-	case 0xe9:// jp(hl)
-	case 0x18://jr
+	case EZ80Flow::Call:
+	case EZ80Flow::CallCC:
+	case EZ80Flow::Rst:
+	case EZ80Flow::Return:
+	case EZ80Flow::ReturnCC:
+	case EZ80Flow::Jump:
+	case EZ80Flow::JumpRelative:
+	case EZ80Flow::JumpIndirect:
 		return true;
-	case 0xED:	// extended instructions
-	{
-		const uint8_t extInstrByte = pCPUInterface->ReadByte(pc + 1);
-		switch (extInstrByte)
-		{
-		case 0x4D:	// more RET functions
-		case 0x5D:
-		case 0x6D:
-		case 0x7D:
-		case 0x45:
-		case 0x55:
-		case 0x65:
-		case 0x75:
-			return true;
-		}
+	default:
+		return false;
 	}
-	return false;
-	// index register instructions
-	case 0xDD:	// IX
-	case 0xFD:	// IY
+}
+
+// can execution carry on to the next instruction?
+// RSTs are treated as not returning as they are often followed by inline data (e.g. the Spectrum calculator)
+bool CheckFallThroughInstructionZ80(ICPUInterface* pCPUInterface, uint16_t pc)
+{
+	switch (GetOpcodeInfoZ80(pCPUInterface, pc).Flow)
 	{
-		const uint8_t extInstrByte = pCPUInterface->ReadByte(pc + 1);
-		switch (extInstrByte)
-		{
-		case 0xE9:	// JP(IX)
-			return true;
-		}
+	case EZ80Flow::Jump:
+	case EZ80Flow::JumpRelative:
+	case EZ80Flow::JumpIndirect:
+	case EZ80Flow::Return:
+	case EZ80Flow::Rst:
 		return false;
-	}
 	default:
-		return false;
+		return true;
 	}
 }
 
 bool RegisterCodeExecutedZ80(FCodeAnalysisState& state, uint16_t pc, uint16_t nextpc)
 {
-	const ICPUInterface* pCPUInterface = state.CPUInterface;
-	const uint8_t opcode = pCPUInterface->ReadByte(pc);
+	const FZ80OpcodeInfo& opcodeInfo = GetOpcodeInfoZ80(state.CPUInterface, pc);
 	const z80_t* pCPU = static_cast<z80_t*>(state.CPUInterface->GetCPUEmulator());
 	const FZ80InternalState& cpuState = pCPU->internal_state;
+	const bool bBranched = nextpc != pc + opcodeInfo.Length;
 
-	bool bPushInstruction = false;
-	
-	switch (opcode)
+	// Call functions
+	if ((opcodeInfo.Flow == EZ80Flow::Call || opcodeInfo.Flow == EZ80Flow::CallCC) && bBranched)
 	{
-		// Stack
-		case 0xc5:	// PUSH BC
-		case 0xd5:	// PUSH DE
-		case 0xe5:	// PUSH HL
-		case 0xf5:	// PUSH AF
-			bPushInstruction = true;
-		break;
-
-		// index register opcodes
-		case 0xdd:
-		case 0xfd:
-			{
-				const uint8_t indexOpcode = pCPUInterface->ReadByte(pc + 1);
-				switch(indexOpcode)
-				{
-				case 0xe5:
-					bPushInstruction = true;
-					break;
-				default:
-					break;
-				}
-			}
-		break;
-		
-		// Call functions
-		/* CALL nnnn */
-		case 0xCD:
-			/* CALL cc,nnnn */
-		case 0xDC: case 0xFC: case 0xD4: case 0xC4:
-		case 0xF4: case 0xEC: case 0xE4: case 0xCC:
-
-			bPushInstruction = true;
-
-			//if(nextpc == 0xc544)
-				//fprintf(stderr, "PC: $%04x, NextPC $%04x\n", pc, nextpc);
+		FCPUFunctionCall callInfo;
+		callInfo.CallAddr = pc;
+		callInfo.FunctionAddr = nextpc;
+		callInfo.ReturnAddr = pc + opcodeInfo.Length;
+		state.CallStack.push_back(callInfo);
+	}
 
-			if (nextpc != pc + 3)	// call instructions are 3 bytes
-			{
-				FCPUFunctionCall callInfo;
-				callInfo.CallAddr = pc;
-				callInfo.FunctionAddr = nextpc;
-				callInfo.ReturnAddr = pc + 3;
-				state.CallStack.push_back(callInfo);
-			}
-			
-			break;
-
-
-			// ret
-		case 0xC0:
-		case 0xC8:
-		case 0xC9:
-		case 0xD0:
-		case 0xD8:
-		case 0xE0:
-		case 0xE8:
-		case 0xF0:
-		case 0xF8:
-			if (nextpc != pc + 1)	// ret instructions are 1 byte
-			{
-				if (state.CallStack.empty() == false)
-				{
-					FCPUFunctionCall& callInfo = state.CallStack.back();
-					//assert(callInfo.ReturnAddr == nextpc);
-					
-					state.CallStack.pop_back();
-
-					/*if (callInfo.ReturnAddr != nextpc)
-					{
-						fprintf(stderr, "PC: $%04x, NextPC $%04x, Return Address $%04x\n", pc, nextpc, callInfo.ReturnAddr);
-						return true;
-					}*/
-
-				}
-			}
-			break;
-	default:
-		break;
+	// ret
+	if ((opcodeInfo.Flow == EZ80Flow::Return || opcodeInfo.Flow == EZ80Flow::ReturnCC) && bBranched)
+	{
+		if (state.CallStack.empty() == false)
+			state.CallStack.pop_back();
 	}
 
 	// Handle push instruction
 	// store the comment from the code line that did the push at the location in the stack as a comment
-	if(bPushInstruction)
+	if(opcodeInfo.MemOperand == EZ80MemOperand::StackPush)
 	{
 		const uint16_t stackPointer = cpuState.SP - 2;
 
@@ -340,7 +153,7 @@ bool RegisterCodeExecutedZ80(FCodeAnalysisState& state, uint16_t pc, uint16_t ne
 			{
 				pStackItem->DataType = EDataType::Word;
 				pStackItem->ByteSize = 2;
-				state.SetCodeAnalysisDirty();
+				state.SetAddressRangeDirty(pStackItem->Address, 2);
 			}
 		}
 	}
@@ -348,8 +161,8 @@ bool RegisterCodeExecutedZ80(FCodeAnalysisState& state, uint16_t pc, uint16_t ne
 	return false;
 }
 
-std::vector<FMachineStateZ80*> g_FreeMachineStates;
-std::vector<FMachineStateZ80*> g_AllocatedMachineStates;
+static thread_local std::vector<FMachineStateZ80*> g_FreeMachineStates;
+static thread_local std::vector<FMachineStateZ80*> g_AllocatedMachineStates;
 
 // Machine state & capture
 FMachineStateZ80* AllocateMachineStateZ80()
@@ -402,4 +215,67 @@ void CaptureMachineStateZ80(FMachineState* pMachineState, ICPUInterface* pCPUInt
 
 	for (int stackVal = 0; stackVal < FMachineStateZ80::kNoStackEntries; stackVal++)
 		pMachineStateZ80->Stack[stackVal] = pCPUInterface->ReadWord(pMachineStateZ80->SP - (stackVal * 2));
-}
\ No newline at end of file
+}
+// Register names for breakpoint conditions
+enum class EZ80Register
+{
+	A, F, B, C, D, E, H, L, I, R,
+	AF, BC, DE, HL, IX, IY, SP, PC,
+	AF_, BC_, DE_, HL_,
+
+	Count
+};
+
+static const char* g_Z80RegisterNames[(int)EZ80Register::Count] =
+{
+	"A", "F", "B", "C", "D", "E", "H", "L", "I", "R",
+	"AF", "BC", "DE", "HL", "IX", "IY", "SP", "PC",
+	"AF'", "BC'", "DE'", "HL'",
+};
+
+int GetZ80RegisterId(const char* pName, bool* pIsPointer)
+{
+	for (int i = 0; i < (int)EZ80Register::Count; i++)
+	{
+		if (strcmp(pName, g_Z80RegisterNames[i]) == 0)
+		{
+			if (pIsPointer != nullptr)
+				*pIsPointer = i >= (int)EZ80Register::BC && i <= (int)EZ80Register::SP;
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+uint16_t GetZ80RegisterValue(void* pCPUEmu, int regId)
+{
+	z80_t* pCPU = (z80_t*)pCPUEmu;
+
+	switch ((EZ80Register)regId)
+	{
+	case EZ80Register::A:	return z80_a(pCPU);
+	case EZ80Register::F:	return z80_f(pCPU);
+	case EZ80Register::B:	return z80_b(pCPU);
+	case EZ80Register::C:	return z80_c(pCPU);
+	case EZ80Register::D:	return z80_d(pCPU);
+	case EZ80Register::E:	return z80_e(pCPU);
+	case EZ80Register::H:	return z80_h(pCPU);
+	case EZ80Register::L:	return z80_l(pCPU);
+	case EZ80Register::I:	return z80_i(pCPU);
+	case EZ80Register::R:	return z80_r(pCPU);
+	case EZ80Register::AF:	return z80_af(pCPU);
+	case EZ80Register::BC:	return z80_bc(pCPU);
+	case EZ80Register::DE:	return z80_de(pCPU);
+	case EZ80Register::HL:	return z80_hl(pCPU);
+	case EZ80Register::IX:	return z80_ix(pCPU);
+	case EZ80Register::IY:	return z80_iy(pCPU);
+	case EZ80Register::SP:	return z80_sp(pCPU);
+	case EZ80Register::PC:	return z80_pc(pCPU);
+	case EZ80Register::AF_:	return z80_af_(pCPU);
+	case EZ80Register::BC_:	return z80_bc_(pCPU);
+	case EZ80Register::DE_:	return z80_de_(pCPU);
+	case EZ80Register::HL_:	return z80_hl_(pCPU);
+	default:				return 0;
+	}
+}
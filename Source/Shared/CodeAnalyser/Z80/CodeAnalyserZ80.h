@@ -32,8 +32,13 @@ bool CheckPointerRefInstructionZ80(ICPUInterface* pCPUInterface, uint16_t pc, ui
 bool CheckJumpInstructionZ80(ICPUInterface* pCPUInterface, uint16_t pc, uint16_t* out_addr);
 bool CheckCallInstructionZ80(ICPUInterface* pCPUInterface, uint16_t pc);
 bool CheckStopInstructionZ80(ICPUInterface* pCPUInterface, uint16_t pc);
+bool CheckFallThroughInstructionZ80(ICPUInterface* pCPUInterface, uint16_t pc);
 bool RegisterCodeExecutedZ80(FCodeAnalysisState& state, uint16_t pc, uint16_t nextpc);
 
 FMachineStateZ80* AllocateMachineStateZ80();
 void FreeMachineStatesZ80();
 void CaptureMachineStateZ80(FMachineState* pMachineState, ICPUInterface* pCPUInterface);
+
+// Register lookup for breakpoint conditions
+int			GetZ80RegisterId(const char* pName, bool* pIsPointer = nullptr);	// returns -1 if not a register
+uint16_t	GetZ80RegisterValue(void* pCPU, int regId);
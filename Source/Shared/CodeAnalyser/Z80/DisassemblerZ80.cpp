@@ -0,0 +1,330 @@
+#include "../Disassembler.h"
+
+// Z80 decode tables - opcodes are split into x/y/z/p/q fields as described in 'Decoding Z80 Opcodes'
+// Output matches the chips z80dasm disassembler
+
+static const char* g_Reg8[8] = { "B", "C", "D", "E", "H", "L", "(HL)", "A" };
+static const char* g_Reg8IX[8] = { "B", "C", "D", "E", "IXH", "IXL", "(IX", "A" };
+static const char* g_Reg8IY[8] = { "B", "C", "D", "E", "IYH", "IYL", "(IY", "A" };
+static const char* g_RegPair[4] = { "BC", "DE", "HL", "SP" };
+static const char* g_RegPairIX[4] = { "BC", "DE", "IX", "SP" };
+static const char* g_RegPairIY[4] = { "BC", "DE", "IY", "SP" };
+static const char* g_RegPair2[4] = { "BC", "DE", "HL", "AF" };
+static const char* g_RegPair2IX[4] = { "BC", "DE", "IX", "AF" };
+static const char* g_RegPair2IY[4] = { "BC", "DE", "IY", "AF" };
+static const char* g_Conditions[8] = { "NZ", "Z", "NC", "C", "PO", "PE", "P", "M" };
+static const char* g_AluOps[8] = { "ADD", "ADC", "SUB", "SBC", "AND", "XOR", "OR", "CP" };
+static const bool g_AluOpHasA[8] = { true, true, false, true, false, false, false, false };
+static const char* g_RotOps[8] = { "RLC", "RRC", "RL", "RR", "SLA", "SRA", "SLL", "SRL" };
+static const char* g_X0Z7Ops[8] = { "RLCA", "RRCA", "RLA", "RRA", "DAA", "CPL", "SCF", "CCF" };
+static const char* g_EDX1Z7Ops[8] = { "LD I,A", "LD R,A", "LD A,I", "LD A,R", "RRD", "RLD", "NOP (ED)", "NOP (ED)" };
+static const char* g_InterruptModes[8] = { "0", "0", "1", "2", "0", "0", "1", "2" };
+static const char* g_BitNumbers[8] = { "0", "1", "2", "3", "4", "5", "6", "7" };
+static const char* g_BlockOps[4][4] = {
+	{ "LDI", "CPI", "INI", "OUTI" },
+	{ "LDD", "CPD", "IND", "OUTD" },
+	{ "LDIR", "CPIR", "INIR", "OTIR" },
+	{ "LDDR", "CPDR", "INDR", "OTDR" }
+};
+
+struct FZ80Decoder
+{
+	const uint8_t*		pBytes;
+	uint16_t			PC;
+	int					Pos = 0;
+	uint8_t				Prefix = 0;
+	const char**		Reg8 = g_Reg8;
+	const char**		RegPair = g_RegPair;
+	const char**		RegPair2 = g_RegPair2;
+	FDasmInstruction&	Instruction;
+
+	FZ80Decoder(const uint8_t* pInBytes, uint16_t pc, FDasmInstruction& outInstruction) : pBytes(pInBytes), PC(pc), Instruction(outInstruction) {}
+
+	uint8_t		FetchU8() { return pBytes[Pos++]; }
+	int8_t		FetchI8() { return (int8_t)pBytes[Pos++]; }
+	uint16_t	FetchU16() { const uint16_t val = pBytes[Pos] | (pBytes[Pos + 1] << 8); Pos += 2; return val; }
+
+	void	Mnemonic(const char* pMnemonic) { Instruction.pMnemonic = pMnemonic; }
+
+	FDasmOperand&	AddOperand(EDasmOperandKind kind, const char* pPrefix, uint16_t value = 0, const char* pSuffix = "")
+	{
+		FDasmOperand& operand = Instruction.Operands[Instruction.NoOperands++];
+		operand.Kind = kind;
+		operand.pPrefix = pPrefix;
+		operand.pSuffix = pSuffix;
+		operand.Value = value;
+		return operand;
+	}
+
+	void	Text(const char* pText) { AddOperand(EDasmOperandKind::Text, pText); }
+	void	Imm8(const char* pPrefix = "", const char* pSuffix = "") { const uint8_t val = FetchU8(); AddOperand(EDasmOperandKind::Imm8, pPrefix, val, pSuffix); }
+	void	Imm16() { const uint16_t val = FetchU16(); AddOperand(EDasmOperandKind::Imm16, "", val); }
+	void	Address(const char* pPrefix = "", const char* pSuffix = "") { const uint16_t val = FetchU16(); AddOperand(EDasmOperandKind::Address, pPrefix, val, pSuffix); }
+	void	Relative() { const int8_t d = FetchI8(); AddOperand(EDasmOperandKind::Address, "", (uint16_t)(PC + Pos + d)); }
+
+	// (HL)/(IX+d)/(IY+d)
+	void	Mem() { if (Prefix) { const int8_t d = FetchI8(); MemD(d); } else { Text(Reg8[6]); } }
+	void	MemD(int8_t d) { AddOperand(EDasmOperandKind::Displacement, Reg8[6], (uint16_t)(uint8_t)d, ")"); }
+	// (HL)/(IX+d)/(IY+d) or r
+	void	MemOrReg(int i) { if (i == 6) Mem(); else Text(Reg8[i]); }
+	void	MemOrRegD(int i, int8_t d) { if (i == 6 && Prefix) MemD(d); else Text(Reg8[i]); }
+
+	void	Decode();
+	void	DecodeCB();
+	void	DecodeED();
+};
+
+void FZ80Decoder::Decode()
+{
+	uint8_t op = FetchU8();
+
+	// prefixed op? - use register tables that replace HL with IX/IY
+	if (op == 0xDD || op == 0xFD)
+	{
+		Prefix = op;
+		op = FetchU8();
+		if (op == 0xED)
+			Prefix = 0;	// an ED following a prefix cancels the prefix
+
+		if (Prefix == 0xDD)
+		{
+			Reg8 = g_Reg8IX;
+			RegPair = g_RegPairIX;
+			RegPair2 = g_RegPair2IX;
+		}
+		else if (Prefix == 0xFD)
+		{
+			Reg8 = g_Reg8IY;
+			RegPair = g_RegPairIY;
+			RegPair2 = g_RegPair2IY;
+		}
+	}
+
+	const int x = (op >> 6) & 3;
+	const int y = (op >> 3) & 7;
+	const int z = op & 7;
+	const int p = y >> 1;
+	const int q = y & 1;
+
+	if (x == 1)	// 8-bit load block
+	{
+		if (y == 6 && z == 6)
+		{
+			Mnemonic("HALT");	// special case LD (HL),(HL)
+		}
+		else if (y == 6)
+		{
+			Mnemonic("LD");
+			Mem();
+			Text(Prefix && (z == 4 || z == 5) ? g_Reg8[z] : Reg8[z]);	// LD (IX+d),H/L doesn't use IXH/IXL
+		}
+		else if (z == 6)
+		{
+			Mnemonic("LD");
+			Text(Prefix && (y == 4 || y == 5) ? g_Reg8[y] : Reg8[y]);
+			Mem();
+		}
+		else
+		{
+			Mnemonic("LD");
+			Text(Reg8[y]);
+			Text(Reg8[z]);
+		}
+	}
+	else if (x == 2)	// 8-bit ALU block
+	{
+		Mnemonic(g_AluOps[y]);
+		if (g_AluOpHasA[y])
+			Text("A");
+		MemOrReg(z);
+	}
+	else if (x == 0)
+	{
+		switch (z)
+		{
+		case 0:
+			switch (y)
+			{
+			case 0: Mnemonic("NOP"); break;
+			case 1: Mnemonic("EX"); Text("AF"); Text("AF'"); break;
+			case 2: Mnemonic("DJNZ"); Relative(); break;
+			case 3: Mnemonic("JR"); Relative(); break;
+			default: Mnemonic("JR"); Text(g_Conditions[y - 4]); Relative(); break;
+			}
+			break;
+		case 1:
+			if (q == 0)
+			{
+				Mnemonic("LD"); Text(RegPair[p]); Imm16();
+			}
+			else
+			{
+				Mnemonic("ADD"); Text(RegPair[2]); Text(RegPair[p]);
+			}
+			break;
+		case 2:
+			Mnemonic("LD");
+			switch (y)
+			{
+			case 0: Text("(BC)"); Text("A"); break;
+			case 1: Text("A"); Text("(BC)"); break;
+			case 2: Text("(DE)"); Text("A"); break;
+			case 3: Text("A"); Text("(DE)"); break;
+			case 4: Address("(", ")"); Text(RegPair[2]); break;
+			case 5: Text(RegPair[2]); Address("(", ")"); break;
+			case 6: Address("(", ")"); Text("A"); break;
+			case 7: Text("A"); Address("(", ")"); break;
+			}
+			break;
+		case 3: Mnemonic(q == 0 ? "INC" : "DEC"); Text(RegPair[p]); break;
+		case 4: Mnemonic("INC"); MemOrReg(y); break;
+		case 5: Mnemonic("DEC"); MemOrReg(y); break;
+		case 6: Mnemonic("LD"); MemOrReg(y); Imm8(); break;
+		case 7: Mnemonic(g_X0Z7Ops[y]); break;
+		}
+	}
+	else
+	{
+		switch (z)
+		{
+		case 0: Mnemonic("RET"); Text(g_Conditions[y]); break;
+		case 1:
+			if (q == 0)
+			{
+				Mnemonic("POP"); Text(RegPair2[p]);
+			}
+			else
+			{
+				switch (p)
+				{
+				case 0: Mnemonic("RET"); break;
+				case 1: Mnemonic("EXX"); break;
+				case 2: Mnemonic("JP"); Text(Prefix == 0xDD ? "(IX)" : Prefix == 0xFD ? "(IY)" : "(HL)"); break;
+				case 3: Mnemonic("LD"); Text("SP"); Text(RegPair[2]); break;
+				}
+			}
+			break;
+		case 2: Mnemonic("JP"); Text(g_Conditions[y]); Address(); break;
+		case 3:
+			switch (y)
+			{
+			case 0: Mnemonic("JP"); Address(); break;
+			case 1: DecodeCB(); break;
+			case 2: Mnemonic("OUT"); Imm8("(", ")"); Text("A"); break;
+			case 3: Mnemonic("IN"); Text("A"); Imm8("(", ")"); break;
+			case 4: Mnemonic("EX"); Text("(SP)"); Text(RegPair[2]); break;
+			case 5: Mnemonic("EX"); Text("DE"); Text("HL"); break;
+			case 6: Mnemonic("DI"); break;
+			case 7: Mnemonic("EI"); break;
+			}
+			break;
+		case 4: Mnemonic("CALL"); Text(g_Conditions[y]); Address(); break;
+		case 5:
+			if (q == 0)
+			{
+				Mnemonic("PUSH"); Text(RegPair2[p]);
+			}
+			else
+			{
+				switch (p)
+				{
+				case 0: Mnemonic("CALL"); Address(); break;
+				case 1: Mnemonic("DBL PREFIX"); break;
+				case 2: DecodeED(); break;
+				case 3: Mnemonic("DBL PREFIX"); break;
+				}
+			}
+			break;
+		case 6:
+			Mnemonic(g_AluOps[y]);
+			if (g_AluOpHasA[y])
+				Text("A");
+			Imm8();
+			break;
+		case 7: Mnemonic("RST"); AddOperand(EDasmOperandKind::Imm8, "", y * 8); break;
+		}
+	}
+}
+
+void FZ80Decoder::DecodeCB()
+{
+	int8_t d = 0;
+	if (Prefix)
+		d = FetchI8();	// displacement comes before the opcode
+	const uint8_t op = FetchU8();
+	const int x = (op >> 6) & 3;
+	const int y = (op >> 3) & 7;
+	const int z = op & 7;
+
+	if (x == 0)	// rotates & shifts
+	{
+		Mnemonic(g_RotOps[y]);
+		MemOrRegD(z, d);
+	}
+	else	// bit instructions
+	{
+		Mnemonic(x == 1 ? "BIT" : x == 2 ? "RES" : "SET");
+		Text(g_BitNumbers[y]);
+		if (Prefix)
+			MemD(d);
+		if (!Prefix || z != 6)
+			Text(Reg8[z]);
+	}
+}
+
+void FZ80Decoder::DecodeED()
+{
+	const uint8_t op = FetchU8();
+	const int x = (op >> 6) & 3;
+	const int y = (op >> 3) & 7;
+	const int z = op & 7;
+	const int p = y >> 1;
+	const int q = y & 1;
+
+	if (x == 0 || x == 3)
+	{
+		Mnemonic("NOP (ED)");
+	}
+	else if (x == 2)
+	{
+		Mnemonic(y >= 4 && z <= 3 ? g_BlockOps[y - 4][z] : "NOP (ED)");
+	}
+	else
+	{
+		switch (z)
+		{
+		case 0:
+			Mnemonic("IN");
+			if (y != 6)
+				Text(Reg8[y]);
+			Text("(C)");
+			break;
+		case 1: Mnemonic("OUT"); Text("(C)"); Text(y == 6 ? "0" : Reg8[y]); break;
+		case 2: Mnemonic(q == 0 ? "SBC" : "ADC"); Text("HL"); Text(RegPair[p]); break;
+		case 3:
+			Mnemonic("LD");
+			if (q == 0)
+			{
+				Address("(", ")"); Text(RegPair[p]);
+			}
+			else
+			{
+				Text(RegPair[p]); Address("(", ")");
+			}
+			break;
+		case 4: Mnemonic("NEG"); break;
+		case 5: Mnemonic(y == 1 ? "RETI" : "RETN"); break;
+		case 6: Mnemonic("IM"); Text(g_InterruptModes[y]); break;
+		case 7: Mnemonic(g_EDX1Z7Ops[y]); break;
+		}
+	}
+}
+
+int DisassembleZ80(const uint8_t* pBytes, uint16_t pc, FDasmInstruction& outInstruction)
+{
+	outInstruction = FDasmInstruction();
+	FZ80Decoder decoder(pBytes, pc, outInstruction);
+	decoder.Decode();
+	outInstruction.ByteSize = (uint8_t)decoder.Pos;
+	return decoder.Pos;
+}
@@ -0,0 +1,576 @@
+#include "OpcodeTableZ80.h"
+#include "../CodeAnalyser.h"
+
+#include <array>
+
+// Z80 opcode metadata tables, generated at compile time
+// opcodes are split into x/y/z/p/q fields as described in 'Decoding Z80 Opcodes'
+
+typedef std::array<FZ80OpcodeInfo, 256> FZ80OpcodePage;
+
+// register tables - HL is replaced by IX/IY on the DD/FD pages
+struct FZ80RegTables
+{
+	uint32_t	Reg8[8];
+	uint32_t	RegPair[4];
+	uint32_t	RegPair2[4];
+};
+
+static constexpr FZ80RegTables g_RegTables[3] =
+{
+	{
+		{ Z80Reg::B, Z80Reg::C, Z80Reg::D, Z80Reg::E, Z80Reg::H, Z80Reg::L, Z80Reg::HL_Indirect, Z80Reg::A },
+		{ Z80Reg::BC, Z80Reg::DE, Z80Reg::HL, Z80Reg::SP },
+		{ Z80Reg::BC, Z80Reg::DE, Z80Reg::HL, Z80Reg::AF },
+	},
+	{
+		{ Z80Reg::B, Z80Reg::C, Z80Reg::D, Z80Reg::E, Z80Reg::IXH, Z80Reg::IXL, Z80Reg::IX_Indirect_D, Z80Reg::A },
+		{ Z80Reg::BC, Z80Reg::DE, Z80Reg::IX, Z80Reg::SP },
+		{ Z80Reg::BC, Z80Reg::DE, Z80Reg::IX, Z80Reg::AF },
+	},
+	{
+		{ Z80Reg::B, Z80Reg::C, Z80Reg::D, Z80Reg::E, Z80Reg::IYH, Z80Reg::IYL, Z80Reg::IY_Indirect_D, Z80Reg::A },
+		{ Z80Reg::BC, Z80Reg::DE, Z80Reg::IY, Z80Reg::SP },
+		{ Z80Reg::BC, Z80Reg::DE, Z80Reg::IY, Z80Reg::AF },
+	},
+};
+
+// T-states for unprefixed instructions - conditional instructions are the taken time
+static constexpr uint8_t g_MainTStates[256] =
+{
+	//0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F
+	 4,10, 7, 6, 4, 4, 7, 4, 4,11, 7, 6, 4, 4, 7, 4,	// 0x00
+	13,10, 7, 6, 4, 4, 7, 4,12,11, 7, 6, 4, 4, 7, 4,	// 0x10
+	12,10,16, 6, 4, 4, 7, 4,12,11,16, 6, 4, 4, 7, 4,	// 0x20
+	12,10,13, 6,11,11,10, 4,12,11,13, 6, 4, 4, 7, 4,	// 0x30
+	 4, 4, 4, 4, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 7, 4,	// 0x40
+	 4, 4, 4, 4, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 7, 4,	// 0x50
+	 4, 4, 4, 4, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 7, 4,	// 0x60
+	 7, 7, 7, 7, 7, 7, 4, 7, 4, 4, 4, 4, 4, 4, 7, 4,	// 0x70
+	 4, 4, 4, 4, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 7, 4,	// 0x80
+	 4, 4, 4, 4, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 7, 4,	// 0x90
+	 4, 4, 4, 4, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 7, 4,	// 0xA0
+	 4, 4, 4, 4, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 7, 4,	// 0xB0
+	11,10,10,10,17,11, 7,11,11,10,10, 4,17,17, 7,11,	// 0xC0
+	11,10,10,11,17,11, 7,11,11, 4,10,11,17, 4, 7,11,	// 0xD0
+	11,10,10,19,17,11, 7,11,11, 4,10, 4,17, 4, 7,11,	// 0xE0
+	11,10,10, 4,17,11, 7,11,11, 6,10, 4,17, 4, 7,11,	// 0xF0
+};
+
+// registers used by the 8 bit ALU ops: ADD, ADC, SUB, SBC, AND, XOR, OR, CP
+constexpr void SetALURegs(FZ80OpcodeInfo& info, int y, uint32_t operand)
+{
+	info.RegsRead = Z80Reg::A | operand;
+	if (y == 1 || y == 3)	// ADC & SBC use the carry
+		info.RegsRead |= Z80Reg::F;
+	info.RegsWritten = y == 7 ? Z80Reg::F : Z80Reg::A | Z80Reg::F;
+}
+
+// unprefixed & DD/FD prefixed instructions
+// index: 0 = HL, 1 = IX, 2 = IY
+constexpr FZ80OpcodeInfo MakeMainOpcodeInfo(int op, int index)
+{
+	const FZ80RegTables& regs = g_RegTables[index];
+	const FZ80RegTables& mainRegs = g_RegTables[0];
+	const int prefixSize = index != 0 ? 1 : 0;
+	const int x = (op >> 6) & 3;
+	const int y = (op >> 3) & 7;
+	const int z = op & 7;
+	const int p = y >> 1;
+	const int q = y & 1;
+
+	FZ80OpcodeInfo info;
+	info.Length = 1 + prefixSize;
+	info.OperandOffset = 1 + prefixSize;
+	info.TStates = g_MainTStates[op];
+	bool bUsesHLIndirect = false;	// (HL) becomes (IX+d) on the DD/FD pages
+
+	if (x == 0)
+	{
+		switch (z)
+		{
+		case 0:
+			if (y == 1)			// EX AF,AF'
+			{
+				info.RegsRead = info.RegsWritten = Z80Reg::AF | Z80Reg::AF_ALT;
+			}
+			else if (y == 2)	// DJNZ d
+			{
+				info.Flow = EZ80Flow::JumpRelativeCC;
+				info.RegsRead = info.RegsWritten = Z80Reg::B;
+				info.Length += 1;
+			}
+			else if (y == 3)	// JR d
+			{
+				info.Flow = EZ80Flow::JumpRelative;
+				info.Length += 1;
+			}
+			else if (y >= 4)	// JR cc,d
+			{
+				info.Flow = EZ80Flow::JumpRelativeCC;
+				info.RegsRead = Z80Reg::F;
+				info.Length += 1;
+			}
+			break;
+		case 1:
+			if (q == 0)	// LD rr,nn
+			{
+				info.MemOperand = EZ80MemOperand::ImmediateAddress;
+				info.RegsWritten = regs.RegPair[p];
+				info.Length += 2;
+			}
+			else		// ADD HL,rr
+			{
+				info.RegsRead = regs.RegPair[2] | regs.RegPair[p];
+				info.RegsWritten = regs.RegPair[2] | Z80Reg::F;
+			}
+			break;
+		case 2:
+			switch (y)
+			{
+			case 0: info.RegsRead = Z80Reg::A; info.RegsWritten = Z80Reg::BC_Indirect; break;	// LD (BC),A
+			case 1: info.RegsRead = Z80Reg::BC_Indirect; info.RegsWritten = Z80Reg::A; break;	// LD A,(BC)
+			case 2: info.RegsRead = Z80Reg::A; info.RegsWritten = Z80Reg::DE_Indirect; break;	// LD (DE),A
+			case 3: info.RegsRead = Z80Reg::DE_Indirect; info.RegsWritten = Z80Reg::A; break;	// LD A,(DE)
+			case 4: info.RegsRead = regs.RegPair[2]; break;		// LD (nn),HL
+			case 5: info.RegsWritten = regs.RegPair[2]; break;	// LD HL,(nn)
+			case 6: info.RegsRead = Z80Reg::A; break;			// LD (nn),A
+			case 7: info.RegsWritten = Z80Reg::A; break;		// LD A,(nn)
+			}
+			if (y < 4)
+			{
+				info.MemOperand = EZ80MemOperand::RegIndirect;
+			}
+			else
+			{
+				info.MemOperand = EZ80MemOperand::Absolute;
+				info.Length += 2;
+			}
+			break;
+		case 3:	// INC/DEC rr
+			info.RegsRead = info.RegsWritten = regs.RegPair[p];
+			break;
+		case 4:	// INC/DEC r
+		case 5:
+			info.RegsRead = regs.Reg8[y];
+			info.RegsWritten = regs.Reg8[y] | Z80Reg::F;
+			bUsesHLIndirect = y == 6;
+			break;
+		case 6:	// LD r,n
+			info.RegsWritten = regs.Reg8[y];
+			info.Length += 1;
+			bUsesHLIndirect = y == 6;
+			break;
+		case 7:	// RLCA, RRCA, RLA, RRA, DAA, CPL, SCF, CCF
+			info.RegsRead = (y == 6) ? 0 : (y == 7) ? Z80Reg::F : Z80Reg::A;
+			if (y == 2 || y == 3 || y == 4)
+				info.RegsRead |= Z80Reg::F;
+			info.RegsWritten = (y >= 6) ? Z80Reg::F : Z80Reg::A | Z80Reg::F;
+			break;
+		}
+	}
+	else if (x == 1)	// 8-bit load block
+	{
+		if (y == 6 && z == 6)
+		{
+			info.Flow = EZ80Flow::Halt;
+		}
+		else if (y == 6)	// LD (HL),r - LD (IX+d),H/L doesn't use IXH/IXL
+		{
+			info.RegsRead = mainRegs.Reg8[z];
+			info.RegsWritten = regs.Reg8[6];
+			bUsesHLIndirect = true;
+		}
+		else if (z == 6)	// LD r,(HL)
+		{
+			info.RegsRead = regs.Reg8[6];
+			info.RegsWritten = mainRegs.Reg8[y];
+			bUsesHLIndirect = true;
+		}
+		else
+		{
+			info.RegsRead = regs.Reg8[z];
+			info.RegsWritten = regs.Reg8[y];
+		}
+	}
+	else if (x == 2)	// 8-bit ALU block
+	{
+		SetALURegs(info, y, regs.Reg8[z]);
+		bUsesHLIndirect = z == 6;
+	}
+	else
+	{
+		switch (z)
+		{
+		case 0:	// RET cc
+			info.Flow = EZ80Flow::ReturnCC;
+			info.MemOperand = EZ80MemOperand::StackPop;
+			info.RegsRead = Z80Reg::F | Z80Reg::SP | Z80Reg::SP_Indirect;
+			info.RegsWritten = Z80Reg::SP;
+			info.TStatesNotTaken = 5;
+			break;
+		case 1:
+			if (q == 0)	// POP rr
+			{
+				info.MemOperand = EZ80MemOperand::StackPop;
+				info.RegsRead = Z80Reg::SP | Z80Reg::SP_Indirect;
+				info.RegsWritten = Z80Reg::SP | regs.RegPair2[p];
+			}
+			else
+			{
+				switch (p)
+				{
+				case 0:	// RET
+					info.Flow = EZ80Flow::Return;
+					info.MemOperand = EZ80MemOperand::StackPop;
+					info.RegsRead = Z80Reg::SP | Z80Reg::SP_Indirect;
+					info.RegsWritten = Z80Reg::SP;
+					break;
+				case 1:	// EXX
+					info.RegsRead = info.RegsWritten = Z80Reg::BC | Z80Reg::DE | Z80Reg::HL;
+					break;
+				case 2:	// JP (HL)
+					info.Flow = EZ80Flow::JumpIndirect;
+					info.RegsRead = regs.RegPair[2];
+					break;
+				case 3:	// LD SP,HL
+					info.RegsRead = regs.RegPair[2];
+					info.RegsWritten = Z80Reg::SP;
+					break;
+				}
+			}
+			break;
+		case 2:	// JP cc,nn
+			info.Flow = EZ80Flow::JumpCC;
+			info.RegsRead = Z80Reg::F;
+			info.Length += 2;
+			break;
+		case 3:
+			switch (y)
+			{
+			case 0:	// JP nn
+				info.Flow = EZ80Flow::Jump;
+				info.Length += 2;
+				break;
+			case 2:	// OUT (n),A
+				info.MemOperand = EZ80MemOperand::Port;
+				info.RegsRead = Z80Reg::A;
+				info.Length += 1;
+				break;
+			case 3:	// IN A,(n)
+				info.MemOperand = EZ80MemOperand::Port;
+				info.RegsRead = info.RegsWritten = Z80Reg::A;
+				info.Length += 1;
+				break;
+			case 4:	// EX (SP),HL
+				info.MemOperand = EZ80MemOperand::RegIndirect;
+				info.RegsRead = info.RegsWritten = regs.RegPair[2] | Z80Reg::SP_Indirect;
+				break;
+			case 5:	// EX DE,HL - not affected by the prefix
+				info.RegsRead = info.RegsWritten = Z80Reg::DE | Z80Reg::HL;
+				break;
+			}
+			break;
+		case 4:	// CALL cc,nn
+			info.Flow = EZ80Flow::CallCC;
+			info.MemOperand = EZ80MemOperand::StackPush;
+			info.RegsRead = Z80Reg::F | Z80Reg::SP;
+			info.RegsWritten = Z80Reg::SP | Z80Reg::SP_Indirect;
+			info.Length += 2;
+			info.TStatesNotTaken = 10;
+			break;
+		case 5:
+			if (q == 0)	// PUSH rr
+			{
+				info.MemOperand = EZ80MemOperand::StackPush;
+				info.RegsRead = Z80Reg::SP | regs.RegPair2[p];
+				info.RegsWritten = Z80Reg::SP | Z80Reg::SP_Indirect;
+			}
+			else if (p == 0)	// CALL nn
+			{
+				info.Flow = EZ80Flow::Call;
+				info.MemOperand = EZ80MemOperand::StackPush;
+				info.RegsRead = Z80Reg::SP;
+				info.RegsWritten = Z80Reg::SP | Z80Reg::SP_Indirect;
+				info.Length += 2;
+			}
+			break;
+		case 6:	// ALU n
+			SetALURegs(info, y, 0);
+			info.Length += 1;
+			break;
+		case 7:	// RST p
+			info.Flow = EZ80Flow::Rst;
+			info.MemOperand = EZ80MemOperand::StackPush;
+			info.RegsRead = Z80Reg::SP;
+			info.RegsWritten = Z80Reg::SP | Z80Reg::SP_Indirect;
+			break;
+		}
+	}
+
+	if (info.Flow == EZ80Flow::JumpRelativeCC)
+		info.TStatesNotTaken = info.TStates - 5;
+	else if (info.Flow != EZ80Flow::ReturnCC && info.Flow != EZ80Flow::CallCC)
+		info.TStatesNotTaken = info.TStates;
+
+	if (bUsesHLIndirect)
+	{
+		info.MemOperand = index != 0 ? EZ80MemOperand::Indexed : EZ80MemOperand::RegIndirect;
+		if (index != 0)
+		{
+			// displacement byte & address calculation
+			info.Length += 1;
+			info.TStates += (x == 0 && z == 6) ? 5 : 8;
+			info.TStatesNotTaken = info.TStates;
+		}
+	}
+
+	// the prefix takes 4 T-states
+	if (index != 0)
+	{
+		info.TStates += 4;
+		info.TStatesNotTaken += 4;
+	}
+
+	return info;
+}
+
+// CB page & DDCB/FDCB pages
+// DDCB/FDCB instructions are DD CB d op
+constexpr FZ80OpcodeInfo MakeCBOpcodeInfo(int op, int index)
+{
+	const int x = (op >> 6) & 3;
+	const int y = (op >> 3) & 7;
+	const int z = op & 7;
+
+	FZ80OpcodeInfo info;
+	uint32_t operand = g_RegTables[0].Reg8[z];
+
+	if (index == 0)
+	{
+		info.Length = 2;
+		info.OperandOffset = 2;
+		if (z == 6)
+		{
+			info.MemOperand = EZ80MemOperand::RegIndirect;
+			info.TStates = x == 1 ? 12 : 15;
+		}
+		else
+		{
+			info.TStates = 8;
+		}
+	}
+	else
+	{
+		info.Length = 4;
+		info.OperandOffset = 2;	// displacement
+		info.MemOperand = EZ80MemOperand::Indexed;
+		info.TStates = x == 1 ? 20 : 23;
+		operand = g_RegTables[index].Reg8[6];
+	}
+	info.TStatesNotTaken = info.TStates;
+
+	switch (x)
+	{
+	case 0:	// RLC, RRC, RL, RR, SLA, SRA, SLL, SRL
+		info.RegsRead = operand;
+		if (y == 2 || y == 3)	// RL & RR rotate through the carry
+			info.RegsRead |= Z80Reg::F;
+		info.RegsWritten = operand | Z80Reg::F;
+		break;
+	case 1:	// BIT
+		info.RegsRead = operand;
+		info.RegsWritten = Z80Reg::F;
+		break;
+	default:	// RES & SET
+		info.RegsRead = operand;
+		info.RegsWritten = operand;
+		break;
+	}
+
+	// undocumented DDCB/FDCB instructions also copy the result to a register
+	if (index != 0 && x != 1 && z != 6)
+		info.RegsWritten |= g_RegTables[0].Reg8[z];
+
+	return info;
+}
+
+// ED page - bPrefixed is for an ED instruction with a redundant DD/FD prefix
+constexpr FZ80OpcodeInfo MakeEDOpcodeInfo(int op, bool bPrefixed)
+{
+	const FZ80RegTables& regs = g_RegTables[0];
+	const int x = (op >> 6) & 3;
+	const int y = (op >> 3) & 7;
+	const int z = op & 7;
+	const int p = y >> 1;
+	const int q = y & 1;
+
+	FZ80OpcodeInfo info;
+	info.Length = 2;
+	info.OperandOffset = 2;
+	info.TStates = 8;
+
+	if (x == 1)
+	{
+		switch (z)
+		{
+		case 0:	// IN r,(C)
+			info.MemOperand = EZ80MemOperand::Port;
+			info.RegsRead = Z80Reg::BC;
+			info.RegsWritten = (y == 6 ? 0 : regs.Reg8[y]) | Z80Reg::F;
+			info.TStates = 12;
+			break;
+		case 1:	// OUT (C),r
+			info.MemOperand = EZ80MemOperand::Port;
+			info.RegsRead = Z80Reg::BC | (y == 6 ? 0 : regs.Reg8[y]);
+			info.TStates = 12;
+			break;
+		case 2:	// SBC/ADC HL,rr
+			info.RegsRead = Z80Reg::HL | regs.RegPair[p] | Z80Reg::F;
+			info.RegsWritten = Z80Reg::HL | Z80Reg::F;
+			info.TStates = 15;
+			break;
+		case 3:	// LD (nn),rr & LD rr,(nn)
+			info.MemOperand = EZ80MemOperand::Absolute;
+			if (q == 0)
+				info.RegsRead = regs.RegPair[p];
+			else
+				info.RegsWritten = regs.RegPair[p];
+			info.Length += 2;
+			info.TStates = 20;
+			break;
+		case 4:	// NEG
+			info.RegsRead = Z80Reg::A;
+			info.RegsWritten = Z80Reg::A | Z80Reg::F;
+			break;
+		case 5:	// RETN & RETI
+			info.Flow = EZ80Flow::Return;
+			info.MemOperand = EZ80MemOperand::StackPop;
+			info.RegsRead = Z80Reg::SP | Z80Reg::SP_Indirect;
+			info.RegsWritten = Z80Reg::SP;
+			info.TStates = 14;
+			break;
+		case 6:	// IM
+			break;
+		case 7:
+			switch (y)
+			{
+			case 0: info.RegsRead = Z80Reg::A; info.RegsWritten = Z80Reg::I; info.TStates = 9; break;	// LD I,A
+			case 1: info.RegsRead = Z80Reg::A; info.RegsWritten = Z80Reg::R; info.TStates = 9; break;	// LD R,A
+			case 2: info.RegsRead = Z80Reg::I; info.RegsWritten = Z80Reg::A | Z80Reg::F; info.TStates = 9; break;	// LD A,I
+			case 3: info.RegsRead = Z80Reg::R; info.RegsWritten = Z80Reg::A | Z80Reg::F; info.TStates = 9; break;	// LD A,R
+			case 4:	// RRD
+			case 5:	// RLD
+				info.MemOperand = EZ80MemOperand::RegIndirect;
+				info.RegsRead = Z80Reg::A | Z80Reg::HL_Indirect;
+				info.RegsWritten = Z80Reg::A | Z80Reg::F | Z80Reg::HL_Indirect;
+				info.TStates = 18;
+				break;
+			}
+			break;
+		}
+	}
+	else if (x == 2 && y >= 4 && z <= 3)	// block instructions
+	{
+		switch (z)
+		{
+		case 0:	// LDI, LDD, LDIR, LDDR
+			info.MemOperand = EZ80MemOperand::RegIndirect;
+			info.RegsRead = Z80Reg::BC | Z80Reg::DE | Z80Reg::HL | Z80Reg::HL_Indirect;
+			info.RegsWritten = Z80Reg::BC | Z80Reg::DE | Z80Reg::HL | Z80Reg::DE_Indirect | Z80Reg::F;
+			break;
+		case 1:	// CPI, CPD, CPIR, CPDR
+			info.MemOperand = EZ80MemOperand::RegIndirect;
+			info.RegsRead = Z80Reg::A | Z80Reg::BC | Z80Reg::HL | Z80Reg::HL_Indirect;
+			info.RegsWritten = Z80Reg::BC | Z80Reg::HL | Z80Reg::F;
+			break;
+		case 2:	// INI, IND, INIR, INDR
+			info.MemOperand = EZ80MemOperand::Port;
+			info.RegsRead = Z80Reg::BC | Z80Reg::HL;
+			info.RegsWritten = Z80Reg::B | Z80Reg::HL | Z80Reg::HL_Indirect | Z80Reg::F;
+			break;
+		case 3:	// OUTI, OUTD, OTIR, OTDR
+			info.MemOperand = EZ80MemOperand::Port;
+			info.RegsRead = Z80Reg::BC | Z80Reg::HL | Z80Reg::HL_Indirect;
+			info.RegsWritten = Z80Reg::B | Z80Reg::HL | Z80Reg::F;
+			break;
+		}
+		info.TStates = y >= 6 ? 21 : 16;	// repeating versions
+		info.TStatesNotTaken = 16;
+	}
+
+	if (x != 2 || y < 4 || z > 3)
+		info.TStatesNotTaken = info.TStates;
+
+	if (bPrefixed)
+	{
+		info.Length += 1;
+		info.OperandOffset += 1;
+		info.TStates += 4;
+		info.TStatesNotTaken += 4;
+	}
+
+	return info;
+}
+
+constexpr FZ80OpcodePage MakeMainPage(int index)
+{
+	FZ80OpcodePage page = {};
+	for (int op = 0; op < 256; op++)
+		page[op] = MakeMainOpcodeInfo(op, index);
+	return page;
+}
+
+constexpr FZ80OpcodePage MakeCBPage(int index)
+{
+	FZ80OpcodePage page = {};
+	for (int op = 0; op < 256; op++)
+		page[op] = MakeCBOpcodeInfo(op, index);
+	return page;
+}
+
+constexpr FZ80OpcodePage MakeEDPage(bool bPrefixed)
+{
+	FZ80OpcodePage page = {};
+	for (int op = 0; op < 256; op++)
+		page[op] = MakeEDOpcodeInfo(op, bPrefixed);
+	return page;
+}
+
+static constexpr FZ80OpcodePage g_MainPage = MakeMainPage(0);
+static constexpr FZ80OpcodePage g_IndexPages[2] = { MakeMainPage(1), MakeMainPage(2) };
+static constexpr FZ80OpcodePage g_CBPage = MakeCBPage(0);
+static constexpr FZ80OpcodePage g_IndexCBPages[2] = { MakeCBPage(1), MakeCBPage(2) };
+static constexpr FZ80OpcodePage g_EDPage = MakeEDPage(false);
+static constexpr FZ80OpcodePage g_PrefixedEDPage = MakeEDPage(true);
+
+static_assert(g_MainPage[0xCD].Length == 3 && g_MainPage[0xCD].Flow == EZ80Flow::Call, "CALL nn");
+static_assert(g_IndexPages[0][0x36].Length == 4 && g_IndexPages[0][0x36].TStates == 19, "LD (IX+d),n");
+static_assert(g_IndexCBPages[1][0x46].Length == 4 && g_IndexCBPages[1][0x46].TStates == 20, "BIT 0,(IY+d)");
+static_assert(g_EDPage[0xB0].TStates == 21 && g_EDPage[0xB0].TStatesNotTaken == 16, "LDIR");
+
+const FZ80OpcodeInfo& GetOpcodeInfoZ80(const ICPUInterface* pCPUInterface, uint16_t pc)
+{
+	const uint8_t op = pCPUInterface->ReadByte(pc);
+
+	switch (op)
+	{
+	case 0xCB:
+		return g_CBPage[pCPUInterface->ReadByte(pc + 1)];
+	case 0xED:
+		return g_EDPage[pCPUInterface->ReadByte(pc + 1)];
+	case 0xDD:
+	case 0xFD:
+	{
+		const int index = op == 0xDD ? 0 : 1;
+		const uint8_t indexOp = pCPUInterface->ReadByte(pc + 1);
+		if (indexOp == 0xCB)
+			return g_IndexCBPages[index][pCPUInterface->ReadByte(pc + 3)];	// DD CB d op
+		if (indexOp == 0xED)
+			return g_PrefixedEDPage[pCPUInterface->ReadByte(pc + 2)];	// an ED following a prefix cancels the prefix
+		return g_IndexPages[index][indexOp];
+	}
+	default:
+		return g_MainPage[op];
+	}
+}
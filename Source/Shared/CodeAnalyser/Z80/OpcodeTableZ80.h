@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+
+class ICPUInterface;
+
+// register bits
+namespace Z80Reg
+{
+	const uint32_t	A = 0x00000001;
+	const uint32_t	F = 0x00000002;
+	const uint32_t	B = 0x00000004;
+	const uint32_t	C = 0x00000008;
+	const uint32_t	D = 0x00000010;
+	const uint32_t	E = 0x00000020;
+	const uint32_t	H = 0x00000040;
+	const uint32_t	L = 0x00000080;
+	const uint32_t	I = 0x00000100;
+	const uint32_t	R = 0x00000200;
+	const uint32_t	IXL = 0x00000400;
+	const uint32_t	IXH = 0x00000800;
+	const uint32_t	IYL = 0x00001000;
+	const uint32_t	IYH = 0x00002000;
+
+	const uint32_t	SP = 0x00004000;
+	const uint32_t	AF = 0x00008000;
+	const uint32_t	BC = 0x00010000;
+	const uint32_t	DE = 0x00020000;
+	const uint32_t	HL = 0x00040000;
+	const uint32_t	IX = 0x00080000;
+	const uint32_t	IY = 0x00100000;
+
+	const uint32_t	IX_Indirect_D = 0x00200000;
+	const uint32_t	IY_Indirect_D = 0x00400000;
+
+	const uint32_t	AF_ALT = 0x00800000;
+	const uint32_t	SPARE_BIT_2 = 0x01000000;
+	const uint32_t	SPARE_BIT_3 = 0x02000000;
+
+	const uint32_t	BC_Indirect = 0x04000000;
+	const uint32_t	DE_Indirect = 0x08000000;
+	const uint32_t	HL_Indirect = 0x10000000;
+	const uint32_t	IX_Indirect = 0x20000000;
+	const uint32_t	IY_Indirect = 0x40000000;
+	const uint32_t	SP_Indirect = 0x80000000;
+
+	// todo: add PC?
+}
+
+// how an instruction affects the flow of execution
+enum class EZ80Flow : uint8_t
+{
+	None,				// carries on to the next instruction
+	Jump,				// JP nn
+	JumpCC,				// JP cc,nn
+	JumpRelative,		// JR d
+	JumpRelativeCC,		// JR cc,d & DJNZ d
+	JumpIndirect,		// JP (HL)/(IX)/(IY)
+	Call,				// CALL nn
+	CallCC,				// CALL cc,nn
+	Rst,				// RST p
+	Return,				// RET, RETI & RETN
+	ReturnCC,			// RET cc
+	Halt,
+};
+
+// memory accessed by an instruction
+enum class EZ80MemOperand : uint8_t
+{
+	None,
+	ImmediateAddress,	// LD rr,nn - the value could be a pointer
+	Absolute,			// (nn)
+	RegIndirect,		// (BC)/(DE)/(HL)/(SP)
+	Indexed,			// (IX+d)/(IY+d)
+	StackPush,			// PUSH, CALL & RST
+	StackPop,			// POP & RET
+	Port,				// IN & OUT
+};
+
+struct FZ80OpcodeInfo
+{
+	uint8_t			Length = 1;
+	uint8_t			OperandOffset = 1;		// offset of the immediate, address or displacement byte(s)
+	EZ80Flow		Flow = EZ80Flow::None;
+	EZ80MemOperand	MemOperand = EZ80MemOperand::None;
+	uint8_t			TStates = 4;			// when a branch is taken or a block instruction repeats
+	uint8_t			TStatesNotTaken = 4;
+	uint32_t		RegsRead = 0;			// Z80Reg bits
+	uint32_t		RegsWritten = 0;
+};
+
+// Look up the instruction at pc - covers the CB, ED, DD, FD, DDCB & FDCB pages
+const FZ80OpcodeInfo&	GetOpcodeInfoZ80(const ICPUInterface* pCPUInterface, uint16_t pc);
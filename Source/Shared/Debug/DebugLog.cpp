@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <mutex>
 #ifdef _WIN32
 #include <Windows.h>
 #endif
@@ -44,8 +45,12 @@
 	fn(buf); 
 #endif
 
+// log can be written to from analysis worker threads
+static std::mutex g_LogMutex;
+
 void LogFatal(const char* str)
 {
+	std::lock_guard<std::mutex> lock(g_LogMutex);
 #ifdef WIN32
 	OutputDebugStringA(str);
 #endif
@@ -54,6 +59,7 @@ void LogFatal(const char* str)
 
 void LogError(const char* str)
 {
+	std::lock_guard<std::mutex> lock(g_LogMutex);
 #ifdef WIN32
 	OutputDebugStringA(str);
 #endif
@@ -62,6 +68,7 @@ void LogError(const char* str)
 
 void LogWarning(const char* str)
 {
+	std::lock_guard<std::mutex> lock(g_LogMutex);
 #ifdef WIN32
 	OutputDebugStringA(str);
 #endif
@@ -70,6 +77,7 @@ void LogWarning(const char* str)
 
 void LogInfo(const char* str)
 {
+	std::lock_guard<std::mutex> lock(g_LogMutex);
 #ifdef WIN32
 	OutputDebugStringA(str);
 #endif
@@ -78,6 +86,7 @@ void LogInfo(const char* str)
 
 void LogDebug(const char* str)
 {
+	std::lock_guard<std::mutex> lock(g_LogMutex);
 #ifdef WIN32
 	OutputDebugStringA(str);
 #endif
@@ -0,0 +1,20 @@
+#include "../ImGuiTexture.h"
+
+// Texture functions for headless builds - there's no renderer so these do nothing
+
+ImTextureID ImGui_CreateTextureRGBA(unsigned char* pixels, int width, int height)
+{
+	return nullptr;
+}
+
+void ImGui_FreeTexture(ImTextureID texture)
+{
+}
+
+void ImGui_UpdateTextureRGBA(ImTextureID texture, unsigned char* pixels)
+{
+}
+
+void ImGui_UpdateTextureRGBA(ImTextureID texture, unsigned char* pixels, int srcWidth, int srcHeight)
+{
+}
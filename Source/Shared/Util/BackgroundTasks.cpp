@@ -0,0 +1,96 @@
+#include "BackgroundTasks.h"
+
+#include <Debug/DebugLog.h>
+
+FBackgroundTaskQueue::FBackgroundTaskQueue()
+{
+	Worker = std::thread(&FBackgroundTaskQueue::WorkerThread, this);
+}
+
+FBackgroundTaskQueue::~FBackgroundTaskQueue()
+{
+	WaitForIdle();
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		bQuit = true;
+	}
+	TaskAdded.notify_one();
+	Worker.join();
+}
+
+void FBackgroundTaskQueue::AddTask(FBackgroundTask&& task)
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Tasks.push_back(std::move(task));
+		Status.NoQueued = (int)Tasks.size();
+	}
+	TaskAdded.notify_one();
+}
+
+void FBackgroundTaskQueue::WaitForIdle()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	TaskDone.wait(lock, [this] { return Tasks.empty() && Status.bBusy == false; });
+}
+
+bool FBackgroundTaskQueue::IsBusy() const
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	return Status.bBusy || Tasks.empty() == false;
+}
+
+FBackgroundTaskStatus FBackgroundTaskQueue::GetStatus() const
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	return Status;
+}
+
+void FBackgroundTaskQueue::WorkerThread()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	while (true)
+	{
+		TaskAdded.wait(lock, [this] { return bQuit || Tasks.empty() == false; });
+		if (Tasks.empty())	// quitting
+			break;
+
+		FBackgroundTask task = std::move(Tasks.front());
+		Tasks.pop_front();
+		Status.bBusy = true;
+		Status.TaskName = task.Name;
+		Status.NoSteps = (int)task.Steps.size();
+		Status.NoQueued = (int)Tasks.size();
+
+		bool bSuccess = true;
+		for (int stepNo = 0; stepNo < (int)task.Steps.size(); stepNo++)
+		{
+			FBackgroundTaskStep& step = task.Steps[stepNo];
+			Status.StepNo = stepNo;
+			Status.StepName = step.Name;
+
+			lock.unlock();
+			bSuccess = step.Function();
+			lock.lock();
+
+			if (bSuccess == false)
+			{
+				LOGERROR("%s: '%s' failed", task.Name.c_str(), step.Name.c_str());
+				Status.LastResult = task.Name + " failed: " + step.Name;
+				break;
+			}
+		}
+
+		if (bSuccess)
+			Status.LastResult = task.Name + " done";
+		Status.bLastFailed = !bSuccess;
+
+		// release anything the steps captured before saying we're idle
+		lock.unlock();
+		task.Steps.clear();
+		lock.lock();
+
+		Status.bBusy = false;
+		TaskDone.notify_all();
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Single worker thread that runs queued tasks in order - for saving & exporting without stalling the emulator
+// A task is a list of named steps so the UI can show progress, a step returns false to fail the task
+
+struct FBackgroundTaskStep
+{
+	std::string				Name;
+	std::function<bool()>	Function;
+};
+
+struct FBackgroundTask
+{
+	std::string						Name;
+	std::vector<FBackgroundTaskStep>	Steps;
+};
+
+struct FBackgroundTaskStatus
+{
+	bool			bBusy = false;
+	std::string		TaskName;		// task being run
+	std::string		StepName;		// step being run
+	int				StepNo = 0;
+	int				NoSteps = 0;
+	int				NoQueued = 0;	// tasks waiting to run, not including the current one
+	std::string		LastResult;		// message for the last task that finished
+	bool			bLastFailed = false;
+};
+
+class FBackgroundTaskQueue
+{
+public:
+	FBackgroundTaskQueue();
+	~FBackgroundTaskQueue();
+
+	void	AddTask(FBackgroundTask&& task);
+	void	WaitForIdle();
+	bool	IsBusy() const;
+	FBackgroundTaskStatus	GetStatus() const;
+
+private:
+	void	WorkerThread();
+
+	std::thread					Worker;
+	mutable std::mutex			Mutex;
+	std::condition_variable		TaskAdded;
+	std::condition_variable		TaskDone;
+	std::deque<FBackgroundTask>	Tasks;
+	FBackgroundTaskStatus		Status;
+	bool						bQuit = false;
+};
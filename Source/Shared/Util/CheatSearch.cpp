@@ -0,0 +1,259 @@
+#include "CheatSearch.h"
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CHEAT_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHEAT_SSE2 1
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+static inline int CountTrailingZeros64(uint64_t val)
+{
+	unsigned long index;
+	_BitScanForward64(&index, val);
+	return (int)index;
+}
+static inline int CountBits64(uint64_t val) { return (int)__popcnt64(val); }
+#else
+static inline int CountTrailingZeros64(uint64_t val) { return __builtin_ctzll(val); }
+static inline int CountBits64(uint64_t val) { return __builtin_popcountll(val); }
+#endif
+
+static const char* g_CompareNames[(int)ECheatSearchCompare::Count] =
+{
+	"Unchanged",
+	"Changed",
+	"Decreased",
+	"Increased",
+	"Decreased by",
+	"Increased by",
+	"Equal to",
+};
+
+const char* GetCheatSearchCompareName(ECheatSearchCompare compare)
+{
+	return g_CompareNames[(int)compare];
+}
+
+void ResetCheatSearch(FCheatSearch& search)
+{
+	search = FCheatSearch();
+}
+
+// Copy the searched banks into one buffer, returns false if the layout has changed
+static bool GatherBanks(FCheatSearch& search, const FMemorySearchBank* pBanks, int noBanks, std::vector<uint8_t>& outMemory)
+{
+	if (noBanks != (int)search.BankOffsets.size())
+		return false;
+
+	for (int bankNo = 0; bankNo < noBanks; bankNo++)
+	{
+		const uint32_t size = pBanks[bankNo].bROM ? 0 : pBanks[bankNo].Size;
+		if (size != search.BankSizes[bankNo])
+			return false;
+		if (size != 0)
+			memcpy(&outMemory[search.BankOffsets[bankNo]], pBanks[bankNo].pData, size);
+	}
+	return true;
+}
+
+void StartCheatSearch(FCheatSearch& search, const FMemorySearchBank* pBanks, int noBanks)
+{
+	ResetCheatSearch(search);
+
+	uint32_t totalSize = 0;
+	for (int bankNo = 0; bankNo < noBanks; bankNo++)
+	{
+		const uint32_t size = pBanks[bankNo].bROM ? 0 : pBanks[bankNo].Size;
+		search.BankOffsets.push_back(totalSize);
+		search.BankSizes.push_back(size);
+		totalSize += size;
+	}
+
+	if (totalSize == 0)
+		return;
+
+	search.Snapshot.resize(totalSize);
+	search.CurrentMemory.resize(totalSize);
+	GatherBanks(search, pBanks, noBanks, search.Snapshot);
+
+	// all bits set apart from those past the end
+	search.Candidates.assign((totalSize + 63) / 64, ~0ull);
+	if (totalSize & 63)
+		search.Candidates.back() = (1ull << (totalSize & 63)) - 1;
+	search.NoCandidates = totalSize;
+}
+
+static inline bool CompareByte(uint8_t current, uint8_t old, ECheatSearchCompare compare, uint8_t value)
+{
+	switch (compare)
+	{
+	case ECheatSearchCompare::Unchanged:	return current == old;
+	case ECheatSearchCompare::Changed:		return current != old;
+	case ECheatSearchCompare::Decreased:	return current < old;
+	case ECheatSearchCompare::Increased:	return current > old;
+	case ECheatSearchCompare::DecreasedBy:	return current == (uint8_t)(old - value);
+	case ECheatSearchCompare::IncreasedBy:	return current == (uint8_t)(old + value);
+	case ECheatSearchCompare::EqualTo:		return current == value;
+	default:								return false;
+	}
+}
+
+static inline uint64_t CompareWordScalar(const uint8_t* pCurrent, const uint8_t* pOld, int count, ECheatSearchCompare compare, uint8_t value)
+{
+	uint64_t mask = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (CompareByte(pCurrent[i], pOld[i], compare, value))
+			mask |= 1ull << i;
+	}
+	return mask;
+}
+
+// Compare a 64 byte word, returns a bit per byte that passes
+#if CHEAT_AVX2
+static inline uint64_t CompareWord(const uint8_t* pCurrent, const uint8_t* pOld, ECheatSearchCompare compare, uint8_t value)
+{
+	const __m256i valueVec = _mm256_set1_epi8((char)value);
+	uint64_t mask = 0;
+	for (int block = 0; block < 2; block++)
+	{
+		const __m256i cur = _mm256_loadu_si256((const __m256i*)(pCurrent + block * 32));
+		const __m256i old = _mm256_loadu_si256((const __m256i*)(pOld + block * 32));
+		__m256i result;
+		bool bInvert = false;
+		switch (compare)
+		{
+		case ECheatSearchCompare::Unchanged:	result = _mm256_cmpeq_epi8(cur, old); break;
+		case ECheatSearchCompare::Changed:		result = _mm256_cmpeq_epi8(cur, old); bInvert = true; break;
+		case ECheatSearchCompare::Decreased:	result = _mm256_cmpeq_epi8(_mm256_max_epu8(cur, old), cur); bInvert = true; break;
+		case ECheatSearchCompare::Increased:	result = _mm256_cmpeq_epi8(_mm256_min_epu8(cur, old), cur); bInvert = true; break;
+		case ECheatSearchCompare::DecreasedBy:	result = _mm256_cmpeq_epi8(cur, _mm256_sub_epi8(old, valueVec)); break;
+		case ECheatSearchCompare::IncreasedBy:	result = _mm256_cmpeq_epi8(cur, _mm256_add_epi8(old, valueVec)); break;
+		default:								result = _mm256_cmpeq_epi8(cur, valueVec); break;
+		}
+		uint32_t blockMask = (uint32_t)_mm256_movemask_epi8(result);
+		if (bInvert)
+			blockMask = ~blockMask;
+		mask |= (uint64_t)blockMask << (block * 32);
+	}
+	return mask;
+}
+#elif CHEAT_SSE2
+static inline uint64_t CompareWord(const uint8_t* pCurrent, const uint8_t* pOld, ECheatSearchCompare compare, uint8_t value)
+{
+	const __m128i valueVec = _mm_set1_epi8((char)value);
+	uint64_t mask = 0;
+	for (int block = 0; block < 4; block++)
+	{
+		const __m128i cur = _mm_loadu_si128((const __m128i*)(pCurrent + block * 16));
+		const __m128i old = _mm_loadu_si128((const __m128i*)(pOld + block * 16));
+		__m128i result;
+		bool bInvert = false;
+		switch (compare)
+		{
+		case ECheatSearchCompare::Unchanged:	result = _mm_cmpeq_epi8(cur, old); break;
+		case ECheatSearchCompare::Changed:		result = _mm_cmpeq_epi8(cur, old); bInvert = true; break;
+		case ECheatSearchCompare::Decreased:	result = _mm_cmpeq_epi8(_mm_max_epu8(cur, old), cur); bInvert = true; break;
+		case ECheatSearchCompare::Increased:	result = _mm_cmpeq_epi8(_mm_min_epu8(cur, old), cur); bInvert = true; break;
+		case ECheatSearchCompare::DecreasedBy:	result = _mm_cmpeq_epi8(cur, _mm_sub_epi8(old, valueVec)); break;
+		case ECheatSearchCompare::IncreasedBy:	result = _mm_cmpeq_epi8(cur, _mm_add_epi8(old, valueVec)); break;
+		default:								result = _mm_cmpeq_epi8(cur, valueVec); break;
+		}
+		uint32_t blockMask = (uint32_t)_mm_movemask_epi8(result);
+		if (bInvert)
+			blockMask = ~blockMask & 0xffff;
+		mask |= (uint64_t)blockMask << (block * 16);
+	}
+	return mask;
+}
+#else
+static inline uint64_t CompareWord(const uint8_t* pCurrent, const uint8_t* pOld, ECheatSearchCompare compare, uint8_t value)
+{
+	return CompareWordScalar(pCurrent, pOld, 64, compare, value);
+}
+#endif
+
+bool FilterCheatSearch(FCheatSearch& search, const FMemorySearchBank* pBanks, int noBanks, ECheatSearchCompare compare, uint8_t value)
+{
+	if (search.IsActive() == false || GatherBanks(search, pBanks, noBanks, search.CurrentMemory) == false)
+		return false;
+
+	const uint8_t* pCurrent = search.CurrentMemory.data();
+	const uint8_t* pOld = search.Snapshot.data();
+	const uint32_t size = (uint32_t)search.Snapshot.size();
+	const uint32_t noFullWords = size / 64;
+	uint32_t noCandidates = 0;
+
+	for (uint32_t wordNo = 0; wordNo < (uint32_t)search.Candidates.size(); wordNo++)
+	{
+		uint64_t& candidates = search.Candidates[wordNo];
+		if (candidates == 0)
+			continue;
+
+		const uint32_t offset = wordNo * 64;
+		if (wordNo < noFullWords)
+			candidates &= CompareWord(pCurrent + offset, pOld + offset, compare, value);
+		else
+			candidates &= CompareWordScalar(pCurrent + offset, pOld + offset, size - offset, compare, value);
+		noCandidates += CountBits64(candidates);
+	}
+
+	search.NoCandidates = noCandidates;
+	search.NoFilters++;
+	search.Snapshot.swap(search.CurrentMemory);
+	return true;
+}
+
+bool FilterCheatSearchScalar(FCheatSearch& search, const FMemorySearchBank* pBanks, int noBanks, ECheatSearchCompare compare, uint8_t value)
+{
+	if (search.IsActive() == false || GatherBanks(search, pBanks, noBanks, search.CurrentMemory) == false)
+		return false;
+
+	uint32_t noCandidates = 0;
+	for (uint32_t i = 0; i < (uint32_t)search.Snapshot.size(); i++)
+	{
+		uint64_t& candidates = search.Candidates[i / 64];
+		const uint64_t bit = 1ull << (i & 63);
+		if ((candidates & bit) == 0)
+			continue;
+		if (CompareByte(search.CurrentMemory[i], search.Snapshot[i], compare, value))
+			noCandidates++;
+		else
+			candidates &= ~bit;
+	}
+
+	search.NoCandidates = noCandidates;
+	search.NoFilters++;
+	search.Snapshot.swap(search.CurrentMemory);
+	return true;
+}
+
+void GetCheatSearchCandidates(const FCheatSearch& search, std::vector<FCheatSearchCandidate>& outCandidates, size_t maxCandidates)
+{
+	outCandidates.clear();
+
+	int bankNo = 0;
+	for (uint32_t wordNo = 0; wordNo < (uint32_t)search.Candidates.size(); wordNo++)
+	{
+		uint64_t candidates = search.Candidates[wordNo];
+		while (candidates != 0)
+		{
+			const uint32_t offset = wordNo * 64 + CountTrailingZeros64(candidates);
+			candidates &= candidates - 1;
+
+			// banks are in offset order
+			while (bankNo + 1 < (int)search.BankOffsets.size() && offset >= search.BankOffsets[bankNo] + search.BankSizes[bankNo])
+				bankNo++;
+
+			outCandidates.push_back({ bankNo, offset - search.BankOffsets[bankNo], search.Snapshot[offset] });
+			if (outCandidates.size() == maxCandidates)
+				return;
+		}
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "MemorySearch.h"
+
+// Snapshot differencing value search - for finding lives, energy, timers etc.
+// Each filter compares the banks against the previous snapshot and then takes a new one
+
+enum class ECheatSearchCompare
+{
+	Unchanged,
+	Changed,
+	Decreased,
+	Increased,
+	DecreasedBy,	// by Value
+	IncreasedBy,	// by Value
+	EqualTo,		// current value equals Value
+
+	Count
+};
+
+struct FCheatSearchCandidate
+{
+	int			Bank;	// index into the searched bank list
+	uint32_t	Offset;	// offset into the bank
+	uint8_t		Value;	// value at the last snapshot
+};
+
+struct FCheatSearch
+{
+	bool	IsActive() const { return Snapshot.empty() == false; }
+
+	std::vector<uint32_t>	BankOffsets;	// start of each bank in the snapshot
+	std::vector<uint32_t>	BankSizes;		// 0 for ROM banks - they're not searched
+	std::vector<uint8_t>	Snapshot;		// searched banks at the last filter
+	std::vector<uint8_t>	CurrentMemory;
+	std::vector<uint64_t>	Candidates;		// bit per snapshot byte
+	uint32_t				NoCandidates = 0;
+	int						NoFilters = 0;
+};
+
+// Take the initial snapshot, every RAM byte is a candidate
+void StartCheatSearch(FCheatSearch& search, const FMemorySearchBank* pBanks, int noBanks);
+void ResetCheatSearch(FCheatSearch& search);
+
+// Remove candidates that fail the comparison against the previous snapshot
+// Uses SSE2/AVX2 where available, words with no candidates left are skipped
+// returns false if the bank layout has changed since the search started
+bool FilterCheatSearch(FCheatSearch& search, const FMemorySearchBank* pBanks, int noBanks, ECheatSearchCompare compare, uint8_t value = 0);
+
+// Plain byte loop version - for reference & benchmarking
+bool FilterCheatSearchScalar(FCheatSearch& search, const FMemorySearchBank* pBanks, int noBanks, ECheatSearchCompare compare, uint8_t value = 0);
+
+void GetCheatSearchCandidates(const FCheatSearch& search, std::vector<FCheatSearchCandidate>& outCandidates, size_t maxCandidates);
+
+const char* GetCheatSearchCompareName(ECheatSearchCompare compare);
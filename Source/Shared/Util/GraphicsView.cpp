@@ -183,8 +183,9 @@ void DrawGraphicsView(const FGraphicsView& graphicsView, bool bMagnifier)
 
 // Character sets
 
-std::vector<FCharacterSet*>	g_CharacterSets;
-std::vector<FCharacterMap*>	g_CharacterMaps;
+// per thread - each analyser thread has its own character sets & maps
+static thread_local std::vector<FCharacterSet*>	g_CharacterSets;
+static thread_local std::vector<FCharacterMap*>	g_CharacterMaps;
 
 void UpdateCharacterSetImage(FCodeAnalysisState& state, FCharacterSet& characterSet);
 
@@ -320,6 +321,13 @@ bool CreateCharacterSetAt(FCodeAnalysisState& state, const FCharSetCreateParams&
 	return true;
 }
 
+void GetCharacterSetParams(std::vector<FCharSetCreateParams>& outParams)
+{
+	outParams.clear();
+	for (const FCharacterSet* pCharSet : g_CharacterSets)
+		outParams.push_back(pCharSet->Params);
+}
+
 
 // Character Maps
 
@@ -368,4 +376,11 @@ bool CreateCharacterMap(FCodeAnalysisState& state, const FCharMapCreateParams& p
 
 	g_CharacterMaps.push_back(pNewCharMap);
 	return true;
+}
+
+void GetCharacterMapParams(std::vector<FCharMapCreateParams>& outParams)
+{
+	outParams.clear();
+	for (const FCharacterMap* pCharMap : g_CharacterMaps)
+		outParams.push_back(pCharMap->Params);
 }
\ No newline at end of file
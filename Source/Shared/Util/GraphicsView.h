@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 struct FCodeAnalysisState;
 
@@ -121,6 +122,7 @@ FCharacterSet* GetCharacterSetFromIndex(int index);
 FCharacterSet* GetCharacterSetFromAddress(uint16_t address);
 void UpdateCharacterSet(FCodeAnalysisState& state, FCharacterSet& characterSet, const FCharSetCreateParams& params);
 bool CreateCharacterSetAt(FCodeAnalysisState& state, const FCharSetCreateParams& params);
+void GetCharacterSetParams(std::vector<FCharSetCreateParams>& outParams);	// for saving off the UI thread
 
 // Character Maps
 int GetNoCharacterMaps();
@@ -128,4 +130,5 @@ void DeleteCharacterMap(int index);
 FCharacterMap* GetCharacterMapFromIndex(int index);
 FCharacterMap* GetCharacterMapFromAddress(uint16_t address);
 bool CreateCharacterMap(FCodeAnalysisState& state, const FCharMapCreateParams& params);
+void GetCharacterMapParams(std::vector<FCharMapCreateParams>& outParams);
 
@@ -11,25 +11,37 @@ void FMemoryBuffer::Init(size_t initialSize)
 	if (BasePtr != nullptr)	// free old buffer
 		free(BasePtr);
 
+	if (initialSize == 0)
+		initialSize = 1;
+
 	BasePtr = malloc(initialSize);
 	AllocationSize = initialSize;
 	CurrentSize = 0;
+	ReadPosition = 0;
 }
 
-void FMemoryBuffer::Init(void *pData, size_t dataSize)
+void FMemoryBuffer::Init(const void *pData, size_t dataSize)
 {
 	Init(dataSize);
 	CurrentSize = dataSize;
 	memcpy(BasePtr,pData, dataSize);
 }
 
+void* FMemoryBuffer::InitForData(size_t dataSize)
+{
+	Init(dataSize);
+	CurrentSize = dataSize;
+	return BasePtr;
+}
+
 void	FMemoryBuffer::WriteBytes(const void* pData, size_t noBytes)
 {
 	assert(AllocationSize != 0);
 
 	if (CurrentSize + noBytes > AllocationSize)
 	{
-		AllocationSize = AllocationSize * 2;	// double allocation
+		while (CurrentSize + noBytes > AllocationSize)
+			AllocationSize = AllocationSize * 2;	// double allocation
 		BasePtr = realloc(BasePtr, AllocationSize);
 	}
 
@@ -39,7 +51,16 @@ void	FMemoryBuffer::WriteBytes(const void* pData, size_t noBytes)
 
 void FMemoryBuffer::ReadBytes(void* Dest, size_t noBytes)
 {
-	assert(ReadPosition + noBytes <= CurrentSize);
+	// reading past the end gives zeros - truncated files shouldn't crash
+	if (ReadPosition + noBytes > CurrentSize)
+	{
+		const size_t noAvailable = CurrentSize - ReadPosition;
+		memcpy(Dest, (uint8_t*)BasePtr + ReadPosition, noAvailable);
+		memset((uint8_t*)Dest + noAvailable, 0, noBytes - noAvailable);
+		ReadPosition = CurrentSize;
+		return;
+	}
+
 	memcpy(Dest, (uint8_t*)BasePtr + ReadPosition, noBytes);
 	ReadPosition += noBytes;
 }
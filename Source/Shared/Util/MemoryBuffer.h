@@ -1,12 +1,20 @@
 #pragma once 
 
+#include <cstdint>
+#include <cstdlib>
 #include <string>
 
 class FMemoryBuffer
 {
 public:
+	FMemoryBuffer() = default;
+	FMemoryBuffer(const FMemoryBuffer&) = delete;
+	FMemoryBuffer& operator=(const FMemoryBuffer&) = delete;
+	~FMemoryBuffer() { free(BasePtr); }
+
 	void	Init(size_t initialSize = 1024);
-	void	Init(void* pData, size_t dataSize);
+	void	Init(const void* pData, size_t dataSize);
+	void*	InitForData(size_t dataSize);	// dataSize bytes for the caller to fill in e.g. decompressing straight into the buffer
 	void	WriteBytes(const void* pData, size_t noBytes);
 	void	ReadBytes(void* Dest, size_t noBytes);
 
@@ -32,6 +40,12 @@ public:
 		return str;
 	}
 
+	const void*	GetData() const { return BasePtr; }
+	size_t	GetSize() const { return CurrentSize; }
+	size_t	GetReadPosition() const { return ReadPosition; }
+	void	SetReadPosition(size_t pos) { ReadPosition = pos < CurrentSize ? pos : CurrentSize; }
+	bool	Finished() const { return ReadPosition >= CurrentSize; }
+
 	bool LoadFromFile(const char* pFileName);
 	bool SaveToFile(const char* pFileName) const;
 private:
@@ -39,4 +53,4 @@ private:
 	size_t	CurrentSize = 0;
 	size_t	ReadPosition = 0;
 	void* BasePtr = nullptr;
-};
\ No newline at end of file
+};
@@ -0,0 +1,152 @@
+#include "MemoryDiff.h"
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define DIFF_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DIFF_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define DIFF_NEON 1
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+static inline int CountTrailingZeros(uint32_t val)
+{
+	unsigned long index;
+	_BitScanForward(&index, val);
+	return (int)index;
+}
+#else
+static inline int CountTrailingZeros(uint32_t val) { return __builtin_ctz(val); }
+#endif
+
+// Turn a mask of changed bytes into runs
+// runStart is -1 when we're not in a run, runs can carry across blocks
+static inline void AddMaskRuns(uint32_t mask, int width, uint32_t baseOffset, int64_t& runStart, std::vector<FMemoryDiffRun>& outRuns)
+{
+	const uint32_t unchangedMask = ~mask & (width == 32 ? 0xffffffff : ((1u << width) - 1));
+	int pos = 0;
+
+	while (pos < width)
+	{
+		if (runStart == -1)
+		{
+			const uint32_t bits = mask >> pos;
+			if (bits == 0)
+				return;
+			pos += CountTrailingZeros(bits);
+			runStart = baseOffset + pos;
+		}
+		else
+		{
+			const uint32_t bits = unchangedMask >> pos;
+			if (bits == 0)
+				return;
+			pos += CountTrailingZeros(bits);
+			outRuns.push_back({ (uint32_t)runStart, (uint32_t)(baseOffset + pos - runStart) });
+			runStart = -1;
+		}
+	}
+}
+
+static inline uint32_t GetScalarMask(const uint8_t* pNew, const uint8_t* pOld, int count)
+{
+	uint32_t mask = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (pNew[i] != pOld[i])
+			mask |= 1u << i;
+	}
+	return mask;
+}
+
+void DiffMemory(const uint8_t* pNew, const uint8_t* pOld, uint32_t size, std::vector<FMemoryDiffRun>& outRuns)
+{
+	outRuns.clear();
+
+	int64_t runStart = -1;
+	uint32_t offset = 0;
+
+#if DIFF_AVX2
+	const int kBlockSize = 32;
+	for (; offset + kBlockSize <= size; offset += kBlockSize)
+	{
+		const __m256i a = _mm256_loadu_si256((const __m256i*)(pNew + offset));
+		const __m256i b = _mm256_loadu_si256((const __m256i*)(pOld + offset));
+		const uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+		if (mask == 0 && runStart == -1)
+			continue;
+		AddMaskRuns(mask, kBlockSize, offset, runStart, outRuns);
+	}
+#elif DIFF_SSE2
+	const int kBlockSize = 16;
+	for (; offset + kBlockSize <= size; offset += kBlockSize)
+	{
+		const __m128i a = _mm_loadu_si128((const __m128i*)(pNew + offset));
+		const __m128i b = _mm_loadu_si128((const __m128i*)(pOld + offset));
+		const uint32_t mask = ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) & 0xffff;
+		if (mask == 0 && runStart == -1)
+			continue;
+		AddMaskRuns(mask, kBlockSize, offset, runStart, outRuns);
+	}
+#elif DIFF_NEON
+	const int kBlockSize = 16;
+	for (; offset + kBlockSize <= size; offset += kBlockSize)
+	{
+		const uint8x16_t ne = vmvnq_u8(vceqq_u8(vld1q_u8(pNew + offset), vld1q_u8(pOld + offset)));
+		// quick reject - no changed bytes in block
+		if (vmaxvq_u8(ne) == 0 && runStart == -1)
+			continue;
+		AddMaskRuns(GetScalarMask(pNew + offset, pOld + offset, kBlockSize), kBlockSize, offset, runStart, outRuns);
+	}
+#else
+	const int kBlockSize = 8;
+	for (; offset + kBlockSize <= size; offset += kBlockSize)
+	{
+		uint64_t a, b;
+		memcpy(&a, pNew + offset, sizeof(a));
+		memcpy(&b, pOld + offset, sizeof(b));
+		if (a == b && runStart == -1)
+			continue;
+		AddMaskRuns(a == b ? 0 : GetScalarMask(pNew + offset, pOld + offset, kBlockSize), kBlockSize, offset, runStart, outRuns);
+	}
+#endif
+
+	// tail
+	if (offset < size)
+	{
+		const int count = (int)(size - offset);
+		AddMaskRuns(GetScalarMask(pNew + offset, pOld + offset, count), count, offset, runStart, outRuns);
+	}
+
+	if (runStart != -1)
+		outRuns.push_back({ (uint32_t)runStart, (uint32_t)(size - runStart) });
+}
+
+void DiffMemoryScalar(const uint8_t* pNew, const uint8_t* pOld, uint32_t size, std::vector<FMemoryDiffRun>& outRuns)
+{
+	outRuns.clear();
+
+	int64_t runStart = -1;
+	for (uint32_t i = 0; i < size; i++)
+	{
+		if (pNew[i] != pOld[i])
+		{
+			if (runStart == -1)
+				runStart = i;
+		}
+		else if (runStart != -1)
+		{
+			outRuns.push_back({ (uint32_t)runStart, (uint32_t)(i - runStart) });
+			runStart = -1;
+		}
+	}
+
+	if (runStart != -1)
+		outRuns.push_back({ (uint32_t)runStart, (uint32_t)(size - runStart) });
+}
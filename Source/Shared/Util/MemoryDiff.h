@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// A run of bytes that differ between two memory buffers
+struct FMemoryDiffRun
+{
+	uint32_t	Offset;	// offset of first changed byte
+	uint32_t	Size;	// number of changed bytes
+};
+
+// Compare two buffers and output the runs of bytes that differ
+// Uses SSE2/AVX2/NEON where available with a scalar fallback
+void DiffMemory(const uint8_t* pNew, const uint8_t* pOld, uint32_t size, std::vector<FMemoryDiffRun>& outRuns);
+
+// Plain byte loop version - for reference & benchmarking
+void DiffMemoryScalar(const uint8_t* pNew, const uint8_t* pOld, uint32_t size, std::vector<FMemoryDiffRun>& outRuns);
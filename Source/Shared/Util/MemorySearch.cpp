@@ -0,0 +1,287 @@
+#include "MemorySearch.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SEARCH_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SEARCH_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define SEARCH_NEON 1
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+static inline int CountTrailingZeros(uint32_t val)
+{
+	unsigned long index;
+	_BitScanForward(&index, val);
+	return (int)index;
+}
+#else
+static inline int CountTrailingZeros(uint32_t val) { return __builtin_ctz(val); }
+#endif
+
+static int HexDigitValue(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+bool ParseMemorySearchPattern(const char* pText, FMemorySearchPattern& outPattern)
+{
+	outPattern = FMemorySearchPattern();
+	outPattern.Text = pText;
+
+	const char* pChar = pText;
+	while (*pChar != 0)
+	{
+		if (isspace((unsigned char)*pChar) || *pChar == ',')
+		{
+			pChar++;
+		}
+		else if (*pChar == '"')	// ASCII string
+		{
+			pChar++;
+			while (*pChar != 0 && *pChar != '"')
+			{
+				outPattern.Bytes.push_back((uint8_t)*pChar++);
+				outPattern.Mask.push_back(0xff);
+			}
+			if (*pChar != '"')
+				return false;	// unterminated
+			pChar++;
+		}
+		else	// hex byte with optional wildcard nibbles
+		{
+			uint8_t value = 0;
+			uint8_t mask = 0;
+			for (int nibble = 0; nibble < 2; nibble++)
+			{
+				const char c = pChar[nibble];
+				value <<= 4;
+				mask <<= 4;
+				if (c == '?')
+					continue;
+				const int digit = HexDigitValue(c);
+				if (digit == -1)
+					return false;
+				value |= digit;
+				mask |= 0xf;
+			}
+			pChar += 2;
+			outPattern.Bytes.push_back(value);
+			outPattern.Mask.push_back(mask);
+		}
+	}
+
+	if (outPattern.Bytes.empty())
+		return false;
+
+	SetMemorySearchPatternAnchor(outPattern);
+	return true;
+}
+
+// Prefer bytes that aren't common fill values so fewer candidates need checking
+void SetMemorySearchPatternAnchor(FMemorySearchPattern& pattern)
+{
+	pattern.AnchorOffset = -1;
+	for (int i = 0; i < (int)pattern.Bytes.size(); i++)
+	{
+		if (pattern.Mask[i] != 0xff)
+			continue;
+
+		const uint8_t byte = pattern.Bytes[i];
+		if (byte != 0x00 && byte != 0xff)
+		{
+			pattern.AnchorOffset = i;
+			return;
+		}
+
+		if (pattern.AnchorOffset == -1)
+			pattern.AnchorOffset = i;
+	}
+}
+
+static inline bool MatchPattern(const uint8_t* pData, uint32_t size, uint32_t offset, const FMemorySearchPattern& pattern)
+{
+	const uint32_t patternSize = (uint32_t)pattern.Bytes.size();
+	if (patternSize > size || offset > size - patternSize)
+		return false;
+
+	const uint8_t* pBytes = pattern.Bytes.data();
+	const uint8_t* pMask = pattern.Mask.data();
+	for (uint32_t i = 0; i < patternSize; i++)
+	{
+		if ((pData[offset + i] & pMask[i]) != pBytes[i])
+			return false;
+	}
+	return true;
+}
+
+static inline uint32_t GetScalarMatchMask(const uint8_t* pData, uint8_t value, int count)
+{
+	uint32_t mask = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (pData[i] == value)
+			mask |= 1u << i;
+	}
+	return mask;
+}
+
+// Get a bit mask of the bytes in a block that match the value
+#if SEARCH_AVX2
+static const int kBlockSize = 32;
+static inline uint32_t GetBlockMatchMask(const uint8_t* pBlock, uint8_t value)
+{
+	const __m256i block = _mm256_loadu_si256((const __m256i*)pBlock);
+	return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8((char)value)));
+}
+#elif SEARCH_SSE2
+static const int kBlockSize = 16;
+static inline uint32_t GetBlockMatchMask(const uint8_t* pBlock, uint8_t value)
+{
+	const __m128i block = _mm_loadu_si128((const __m128i*)pBlock);
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8((char)value)));
+}
+#elif SEARCH_NEON
+static const int kBlockSize = 16;
+static inline uint32_t GetBlockMatchMask(const uint8_t* pBlock, uint8_t value)
+{
+	// quick reject - no matching bytes in block
+	if (vmaxvq_u8(vceqq_u8(vld1q_u8(pBlock), vdupq_n_u8(value))) == 0)
+		return 0;
+	return GetScalarMatchMask(pBlock, value, kBlockSize);
+}
+#else
+static const int kBlockSize = 8;
+static inline uint32_t GetBlockMatchMask(const uint8_t* pBlock, uint8_t value)
+{
+	return GetScalarMatchMask(pBlock, value, kBlockSize);
+}
+#endif
+
+static void SortHits(std::vector<FMemorySearchHit>& hits)
+{
+	std::sort(hits.begin(), hits.end(), [](const FMemorySearchHit& a, const FMemorySearchHit& b)
+	{
+		if (a.Bank != b.Bank)
+			return a.Bank < b.Bank;
+		if (a.Offset != b.Offset)
+			return a.Offset < b.Offset;
+		return a.Pattern < b.Pattern;
+	});
+}
+
+// Search a single bank, returns false if we've hit the limit
+static bool SearchBank(const FMemorySearchBank& bank, int bankNo, const std::vector<FMemorySearchPattern>& patterns, std::vector<FMemorySearchHit>& outHits, size_t maxHits)
+{
+	const uint8_t* pData = bank.pData;
+	const uint32_t size = bank.Size;
+
+	// patterns with no fully specified byte have to check every position
+	uint32_t maxAnchor = 0;
+	for (int patternNo = 0; patternNo < (int)patterns.size(); patternNo++)
+	{
+		const FMemorySearchPattern& pattern = patterns[patternNo];
+		if (pattern.AnchorOffset == -1)
+		{
+			for (uint32_t offset = 0; offset < size && outHits.size() < maxHits; offset++)
+			{
+				if (MatchPattern(pData, size, offset, pattern))
+					outHits.push_back({ bankNo, offset, patternNo });
+			}
+		}
+		else
+		{
+			maxAnchor = std::max(maxAnchor, (uint32_t)pattern.AnchorOffset);
+		}
+	}
+
+	// test the anchor byte of every pattern a block at a time, then check the candidates
+	uint32_t offset = 0;
+	for (; (uint64_t)offset + maxAnchor + kBlockSize <= size && outHits.size() < maxHits; offset += kBlockSize)
+	{
+		for (int patternNo = 0; patternNo < (int)patterns.size(); patternNo++)
+		{
+			const FMemorySearchPattern& pattern = patterns[patternNo];
+			if (pattern.AnchorOffset == -1)
+				continue;
+
+			uint32_t mask = GetBlockMatchMask(pData + offset + pattern.AnchorOffset, pattern.Bytes[pattern.AnchorOffset]);
+			while (mask != 0)
+			{
+				const uint32_t candidate = offset + CountTrailingZeros(mask);
+				if (MatchPattern(pData, size, candidate, pattern))
+					outHits.push_back({ bankNo, candidate, patternNo });
+				mask &= mask - 1;
+			}
+		}
+	}
+
+	// tail
+	for (; offset < size && outHits.size() < maxHits; offset++)
+	{
+		for (int patternNo = 0; patternNo < (int)patterns.size(); patternNo++)
+		{
+			if (patterns[patternNo].AnchorOffset != -1 && MatchPattern(pData, size, offset, patterns[patternNo]))
+				outHits.push_back({ bankNo, offset, patternNo });
+		}
+	}
+
+	if (outHits.size() > maxHits)
+		outHits.resize(maxHits);
+
+	return outHits.size() < maxHits;
+}
+
+void SearchMemory(const FMemorySearchBank* pBanks, int noBanks, const std::vector<FMemorySearchPattern>& patterns, std::vector<FMemorySearchHit>& outHits, size_t maxHits)
+{
+	outHits.clear();
+
+	for (int bankNo = 0; bankNo < noBanks; bankNo++)
+	{
+		if (pBanks[bankNo].pData == nullptr)
+			continue;
+		if (SearchBank(pBanks[bankNo], bankNo, patterns, outHits, maxHits) == false)
+			break;
+	}
+
+	SortHits(outHits);
+}
+
+void SearchMemoryScalar(const FMemorySearchBank* pBanks, int noBanks, const std::vector<FMemorySearchPattern>& patterns, std::vector<FMemorySearchHit>& outHits, size_t maxHits)
+{
+	outHits.clear();
+
+	for (int bankNo = 0; bankNo < noBanks; bankNo++)
+	{
+		const FMemorySearchBank& bank = pBanks[bankNo];
+		if (bank.pData == nullptr)
+			continue;
+
+		for (uint32_t offset = 0; offset < bank.Size; offset++)
+		{
+			for (int patternNo = 0; patternNo < (int)patterns.size(); patternNo++)
+			{
+				if (MatchPattern(bank.pData, bank.Size, offset, patterns[patternNo]))
+				{
+					outHits.push_back({ bankNo, offset, patternNo });
+					if (outHits.size() == maxHits)
+						return;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+static const uint32_t kMemorySearchPageSize = 0x1000;	// granularity of PagedInPages - the C64 pages ROM & IO over RAM in 4K blocks
+
+// A physical RAM or ROM bank to search
+// Machines return every bank in the same order whatever the paging so bank indices in results stay valid,
+// only the CPU mapping changes - resolve CPU addresses when displaying rather than at search time
+struct FMemorySearchBank
+{
+	std::string		Name;
+	const uint8_t*	pData = nullptr;
+	uint32_t		Size = 0;
+	int				CPUAddress = -1;	// address the start of the bank is paged in at, -1 if not visible to the CPU
+	bool			bROM = false;
+	uint16_t		PagedInPages = 0xffff;	// bit per 4K page of the bank, clear where something else is paged over it
+	int				BankId = 0;		// machine's number for the bank e.g. 128K RAM bank 0-7, RAM & ROM are numbered separately
+
+	// CPU address of a bank offset with the current paging, -1 if not visible to the CPU
+	int	GetCPUAddress(uint32_t offset) const
+	{
+		if (CPUAddress == -1 || offset >= Size || (PagedInPages & (1 << (offset / kMemorySearchPageSize))) == 0)
+			return -1;
+		return CPUAddress + offset;
+	}
+};
+
+// Byte pattern with a per-byte mask - mask bits set must match, 0x00 is a wildcard
+struct FMemorySearchPattern
+{
+	std::string				Text;	// source text, for display
+	std::vector<uint8_t>	Bytes;
+	std::vector<uint8_t>	Mask;
+	int						AnchorOffset = -1;	// fully masked byte used to filter candidates, -1 if none
+};
+
+struct FMemorySearchHit
+{
+	int			Bank;		// index into the searched bank list
+	uint32_t	Offset;		// offset into the bank
+	int			Pattern;	// index into the pattern list
+};
+
+// Parse pattern text: hex bytes separated by spaces, '?' for wildcard nibbles (e.g. "3E ?? C9", "F?")
+// and quoted ASCII strings (e.g. "\"SCORE\" 00")
+bool ParseMemorySearchPattern(const char* pText, FMemorySearchPattern& outPattern);
+
+// Pick the byte used to filter candidate positions - done by the parser, call if the bytes are set up by hand
+void SetMemorySearchPatternAnchor(FMemorySearchPattern& pattern);
+
+// Search the banks for all the patterns in a single pass
+// Uses SSE2/AVX2/NEON to find candidates from each pattern's anchor byte where available
+// Hits are sorted by bank then offset, the search stops once maxHits have been found
+void SearchMemory(const FMemorySearchBank* pBanks, int noBanks, const std::vector<FMemorySearchPattern>& patterns, std::vector<FMemorySearchHit>& outHits, size_t maxHits = 10000);
+
+// Plain byte loop version - for reference & benchmarking
+void SearchMemoryScalar(const FMemorySearchBank* pBanks, int noBanks, const std::vector<FMemorySearchPattern>& patterns, std::vector<FMemorySearchHit>& outHits, size_t maxHits = 10000);
@@ -4,11 +4,12 @@
 #include <sstream>
 #include <vector>
 
-static ENumberDisplayMode g_NumDispMode = ENumberDisplayMode::HexAitch;
+// per thread so analysers on worker threads don't stomp on each other's strings
+static thread_local ENumberDisplayMode g_NumDispMode = ENumberDisplayMode::HexAitch;
 static const int kTextLength = 24;
 static const int kNoStrings = 8;
-int g_StringIndex = 0;
-static char g_TextWorkspace[kNoStrings][kTextLength];
+static thread_local int g_StringIndex = 0;
+static thread_local char g_TextWorkspace[kNoStrings][kTextLength];
 
 char* GetStrPtr()
 {
@@ -20,3 +20,10 @@ const char* NumStr(uint8_t);
 const char* NumStr(uint16_t num, ENumberDisplayMode numDispMode);
 const char* NumStr(uint16_t);
 void Tokenize(const std::string& stringToSplit, const char token, std::vector<std::string>& splitStrings);
+
+// 32 bit tag from a four character code e.g. MakeFourCC("SNAP")
+// gives the same value as the multi-character literal did on MSVC & GCC so existing files still load
+constexpr uint32_t MakeFourCC(const char (&code)[5])
+{
+	return ((uint32_t)(uint8_t)code[0] << 24) | ((uint32_t)(uint8_t)code[1] << 16) | ((uint32_t)(uint8_t)code[2] << 8) | (uint32_t)(uint8_t)code[3];
+}
@@ -0,0 +1,316 @@
+#include "TextDiscovery.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+static const uint32_t kChunkSize = 4096;	// bytes scanned per job
+static const uint32_t kMaxRunLength = 0xffff;
+
+static const char* g_EncodingNames[(int)ETextEncoding::Count] =
+{
+	"ASCII",
+	"Bit 7 terminated",
+	"Spectrum tokens",
+	"Character map",
+};
+
+const char* GetTextEncodingName(ETextEncoding encoding)
+{
+	return g_EncodingNames[(int)encoding];
+}
+
+static const uint8_t kFirstSpectrumToken = 0xA5;
+
+static const char* g_SpectrumTokens[0x100 - kFirstSpectrumToken] =
+{
+	"RND", "INKEY$", "PI", "FN", "POINT", "SCREEN$", "ATTR", "AT", "TAB", "VAL$", "CODE",
+	"VAL", "LEN", "SIN", "COS", "TAN", "ASN", "ACS", "ATN", "LN", "EXP", "INT", "SQR", "SGN",
+	"ABS", "PEEK", "IN", "USR", "STR$", "CHR$", "NOT", "BIN", "OR", "AND", "<=", ">=", "<>",
+	"LINE", "THEN", "TO", "STEP", "DEF FN", "CAT", "FORMAT", "MOVE", "ERASE", "OPEN #",
+	"CLOSE #", "MERGE", "VERIFY", "BEEP", "CIRCLE", "INK", "PAPER", "FLASH", "BRIGHT",
+	"INVERSE", "OVER", "OUT", "LPRINT", "LLIST", "STOP", "READ", "DATA", "RESTORE", "NEW",
+	"BORDER", "CONTINUE", "DIM", "REM", "FOR", "GO TO", "GO SUB", "INPUT", "LOAD", "LIST",
+	"LET", "PAUSE", "NEXT", "POKE", "PRINT", "PLOT", "RUN", "SAVE", "RANDOMIZE", "IF", "CLS",
+	"DRAW", "CLEAR", "RETURN", "COPY",
+};
+
+static inline bool IsPrintable(uint8_t byte)
+{
+	return byte >= 32 && byte <= 126;
+}
+
+// returns 0 if the byte isn't in the map
+static inline char MapCharacter(uint8_t byte, const FTextCharacterMap& charMap)
+{
+	if (charMap.LetterA != -1 && byte >= charMap.LetterA && byte < charMap.LetterA + 26)
+		return (char)('A' + byte - charMap.LetterA);
+	if (charMap.Digit0 != -1 && byte >= charMap.Digit0 && byte < charMap.Digit0 + 10)
+		return (char)('0' + byte - charMap.Digit0);
+	if (byte == charMap.Space)
+		return ' ';
+	return 0;
+}
+
+static inline bool IsRunByte(ETextEncoding encoding, uint8_t byte, const FTextCharacterMap& charMap)
+{
+	switch (encoding)
+	{
+	case ETextEncoding::SpectrumTokens:	return IsPrintable(byte) || byte >= kFirstSpectrumToken;
+	case ETextEncoding::CharacterMap:	return MapCharacter(byte, charMap) != 0;
+	default:							return IsPrintable(byte);
+	}
+}
+
+static inline bool IsVowel(char ch)
+{
+	switch (ch | 0x20)
+	{
+	case 'a': case 'e': case 'i': case 'o': case 'u': case 'y':
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Score text on how much it looks like words, 0 if it doesn't
+// random bytes give short runs of mixed case letters & punctuation with few vowels
+static int ScoreText(const std::string& text, bool bTerminated)
+{
+	int noLetters = 0, noVowels = 0, noOthers = 0, noDistinct = 0;
+	int consonantRun = 0, repeatLength = 1, longestRepeat = 1;
+	bool bSeen[128] = { false };
+	char lastCh = 0;
+	int score = 0;
+
+	for (const char ch : text)
+	{
+		const bool bLower = ch >= 'a' && ch <= 'z';
+		const bool bUpper = ch >= 'A' && ch <= 'Z';
+		if (bLower || bUpper)
+		{
+			noLetters++;
+			score += 2;
+			if (IsVowel(ch))
+			{
+				noVowels++;
+				consonantRun = 0;
+			}
+			else if (++consonantRun > 3)
+			{
+				score -= 3;
+			}
+			if (bUpper && lastCh >= 'a' && lastCh <= 'z')	// e.g. "hEllO" is unlikely to be text
+				score -= 4;
+		}
+		else
+		{
+			consonantRun = 0;
+			if (ch == ' ')
+				score += 1;
+			else if (ch >= '0' && ch <= '9')
+				score += 1;
+			else
+			{
+				noOthers++;
+				score -= 3;
+			}
+		}
+
+		// long runs of the same character are usually graphics or tables - spaces are often padding
+		repeatLength = (ch == lastCh && ch != ' ') ? repeatLength + 1 : 1;
+		longestRepeat = std::max(longestRepeat, repeatLength);
+
+		if (bSeen[ch & 0x7f] == false)
+		{
+			bSeen[ch & 0x7f] = true;
+			noDistinct++;
+		}
+		lastCh = ch;
+	}
+
+	if (noLetters * 2 < (int)text.size() || noVowels * 5 < noLetters || noDistinct < 3)
+		return 0;
+
+	if (longestRepeat > 3)
+		score -= longestRepeat * 4;
+	if (bTerminated)
+		score += 4;
+	return std::max(score, 0);
+}
+
+// Scan the runs starting in [start,end) - runs can carry on past the end of the chunk
+// a run that started in the previous chunk is left to that chunk's job
+static void ScanChunk(const FMemorySearchBank& bank, int bankNo, uint32_t start, uint32_t end, ETextEncoding encoding, const FTextDiscoveryOptions& options, std::vector<FTextCandidate>& outCandidates)
+{
+	const uint8_t* pData = bank.pData;
+	const FTextCharacterMap& charMap = options.CharacterMap;
+	uint32_t pos = start;
+
+	if (pos > 0 && IsRunByte(encoding, pData[pos - 1], charMap))
+	{
+		while (pos < end && IsRunByte(encoding, pData[pos], charMap))
+			pos++;
+	}
+
+	std::string text;
+	std::string scoreText;	// tokens are scored as a whole, not on their letters
+	while (pos < end)
+	{
+		if (IsRunByte(encoding, pData[pos], charMap) == false)
+		{
+			pos++;
+			continue;
+		}
+
+		text.clear();
+		scoreText.clear();
+		int noTokens = 0;
+		uint32_t runEnd = pos;
+		while (runEnd < bank.Size && runEnd - pos < kMaxRunLength - 1 && IsRunByte(encoding, pData[runEnd], charMap))
+		{
+			const uint8_t byte = pData[runEnd++];
+			if (encoding == ETextEncoding::CharacterMap)
+			{
+				text += MapCharacter(byte, charMap);
+				scoreText += text.back();
+			}
+			else if (byte >= kFirstSpectrumToken)
+			{
+				if (text.empty() == false && text.back() != ' ')
+					text += ' ';
+				text += g_SpectrumTokens[byte - kFirstSpectrumToken];
+				text += ' ';
+				scoreText += ' ';
+				noTokens++;
+			}
+			else
+			{
+				text += (char)byte;
+				scoreText += (char)byte;
+			}
+		}
+
+		uint32_t length = runEnd - pos;
+		bool bTerminated = false;
+		bool bValid = true;
+		if (encoding == ETextEncoding::Bit7Terminated)
+		{
+			// only a candidate if there's a terminator - otherwise it's plain ASCII
+			bValid = runEnd < bank.Size && (pData[runEnd] & 0x80) && IsPrintable(pData[runEnd] & 0x7f);
+			if (bValid)
+			{
+				text += (char)(pData[runEnd] & 0x7f);
+				scoreText += text.back();
+				length++;
+				bTerminated = true;
+			}
+		}
+		else
+		{
+			bTerminated = runEnd < bank.Size && (pData[runEnd] == 0 || pData[runEnd] == 0xff);
+			if (encoding == ETextEncoding::SpectrumTokens && runEnd < bank.Size && pData[runEnd] == 0x0d)	// end of BASIC line
+				bTerminated = true;
+		}
+
+		// tokens need to be mixed in with plain text, random data is a third tokens
+		if (encoding == ETextEncoding::SpectrumTokens)
+			bValid = noTokens > 0 && noTokens * 4 <= (int)length;
+
+		if (bValid && (int)length >= options.MinLength)
+		{
+			const int score = ScoreText(scoreText, bTerminated) + noTokens * 2;
+			if (score >= options.MinScore && score > noTokens * 2)
+				outCandidates.push_back({ bankNo, pos, (uint16_t)length, encoding, score, text });
+		}
+
+		pos = runEnd;
+	}
+}
+
+struct FTextDiscoveryJob
+{
+	int			Bank;
+	uint32_t	Start;
+	uint32_t	End;
+};
+
+void DiscoverText(const FMemorySearchBank* pBanks, int noBanks, const FTextDiscoveryOptions& options, std::vector<FTextCandidate>& outCandidates)
+{
+	outCandidates.clear();
+
+	std::vector<ETextEncoding> encodings;
+	for (int i = 0; i < (int)ETextEncoding::Count; i++)
+	{
+		if (options.bEncodings[i] == false)
+			continue;
+		if ((ETextEncoding)i == ETextEncoding::CharacterMap && options.CharacterMap.LetterA == -1)
+			continue;
+		encodings.push_back((ETextEncoding)i);
+	}
+
+	std::vector<FTextDiscoveryJob> jobs;
+	for (int bankNo = 0; bankNo < noBanks; bankNo++)
+	{
+		const FMemorySearchBank& bank = pBanks[bankNo];
+		if (bank.bROM && options.bIncludeROM == false)
+			continue;
+		for (uint32_t start = 0; start < bank.Size; start += kChunkSize)
+			jobs.push_back({ bankNo, start, std::min(start + kChunkSize, bank.Size) });
+	}
+
+	if (jobs.empty() || encodings.empty())
+		return;
+
+	// each job writes to its own list so the results come out in order
+	std::vector<std::vector<FTextCandidate>> jobCandidates(jobs.size());
+	std::atomic<int> nextJob(0);
+	auto worker = [&]()
+	{
+		for (int jobNo = nextJob++; jobNo < (int)jobs.size(); jobNo = nextJob++)
+		{
+			const FTextDiscoveryJob& job = jobs[jobNo];
+			for (ETextEncoding encoding : encodings)
+				ScanChunk(pBanks[job.Bank], job.Bank, job.Start, job.End, encoding, options, jobCandidates[jobNo]);
+		}
+	};
+
+	int noThreads = options.NoThreads > 0 ? options.NoThreads : (int)std::thread::hardware_concurrency();
+	noThreads = std::max(1, std::min(noThreads, (int)jobs.size()));
+
+	std::vector<std::thread> workers;
+	for (int threadNo = 1; threadNo < noThreads; threadNo++)
+		workers.emplace_back(worker);
+	worker();	// this thread does its share too
+	for (std::thread& thread : workers)
+		thread.join();
+
+	std::vector<FTextCandidate> candidates;
+	for (std::vector<FTextCandidate>& jobList : jobCandidates)
+		candidates.insert(candidates.end(), std::make_move_iterator(jobList.begin()), std::make_move_iterator(jobList.end()));
+
+	std::sort(candidates.begin(), candidates.end(), [](const FTextCandidate& a, const FTextCandidate& b)
+	{
+		if (a.Bank != b.Bank)
+			return a.Bank < b.Bank;
+		if (a.Offset != b.Offset)
+			return a.Offset < b.Offset;
+		return a.Score > b.Score;
+	});
+
+	// resolve overlapping runs from different encodings
+	for (FTextCandidate& candidate : candidates)
+	{
+		if (outCandidates.empty() == false)
+		{
+			FTextCandidate& last = outCandidates.back();
+			if (last.Bank == candidate.Bank && candidate.Offset < last.Offset + last.Length)
+			{
+				if (candidate.Score > last.Score)
+					last = std::move(candidate);
+				continue;
+			}
+		}
+		outCandidates.push_back(std::move(candidate));
+	}
+}
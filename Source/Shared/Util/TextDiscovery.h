@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+#include "MemorySearch.h"
+
+// Finds likely strings in memory banks
+// Banks are split into chunks that are scanned on worker threads, candidate runs are scored on how word-like they are
+
+enum class ETextEncoding
+{
+	Ascii,				// printable ASCII
+	Bit7Terminated,		// printable ASCII, last character has bit 7 set
+	SpectrumTokens,		// ASCII with ZX Spectrum BASIC keyword tokens (0xA5-0xFF)
+	CharacterMap,		// game specific character codes
+
+	Count
+};
+
+// Custom character map - codes of the first character in each contiguous range, -1 if not used
+struct FTextCharacterMap
+{
+	int		LetterA = -1;	// 'A' to 'Z'
+	int		Digit0 = -1;	// '0' to '9'
+	int		Space = -1;
+};
+
+struct FTextDiscoveryOptions
+{
+	bool				bEncodings[(int)ETextEncoding::Count] = { true, true, false, false };
+	FTextCharacterMap	CharacterMap;
+	int					MinLength = 4;		// in bytes
+	int					MinScore = 16;
+	bool				bIncludeROM = false;
+	int					NoThreads = 0;		// 0 to use all hardware threads
+};
+
+struct FTextCandidate
+{
+	int				Bank;		// index into the searched bank list
+	uint32_t		Offset;		// offset into the bank
+	uint16_t		Length;		// in bytes, including any terminator
+	ETextEncoding	Encoding;
+	int				Score;
+	std::string		Text;		// decoded text
+};
+
+// Scan the banks for text, candidates are sorted by bank then offset
+// where runs with different encodings overlap the highest scoring one is kept
+void DiscoverText(const FMemorySearchBank* pBanks, int noBanks, const FTextDiscoveryOptions& options, std::vector<FTextCandidate>& outCandidates);
+
+const char* GetTextEncodingName(ETextEncoding encoding);
@@ -405,6 +405,7 @@ typedef struct {
     int trap_id;                /* != 0 if a trap has been hit */
 
     FZ80InternalState   internal_state;  // MarkC - to provide info for the tick function
+    bool trap_flush_regs;       // MarkC - write the registers back before calling the trap so it can read them
 } z80_t;
 
 /* initialize a new z80 instance */
@@ -1380,12 +1381,18 @@ uint32_t z80_exec(z80_t* cpu, uint32_t num_ticks) {
             }
         }
         /* call track evaluation callback if set */
+        int trap_id = 0;
         if (trap) {
-            int trap_id = trap(pc,ticks,pins,cpu->trap_user_data);
-            if (trap_id) {
-                cpu->trap_id=trap_id;
-                break;
+            //MarkC - flush registers so the trap callback can read them (for breakpoint conditions), only when asked as it costs
+            if (cpu->trap_flush_regs) {
+                uint64_t tr2 = r2 & ~_BITS_USE_IXIY;    // the prefix only applied to the instruction just executed
+                _S16(tr2,_PC,pc);
+                cpu->bc_de_hl_fa = _z80_flush_r0(ws, r0, r2);
+                cpu->wz_ix_iy_sp = _z80_flush_r1(ws, r1, r2);
+                cpu->im_ir_pc_bits = tr2;
+                cpu->bc_de_hl_fa_ = r3;
             }
+            trap_id = trap(pc,ticks,pins,cpu->trap_user_data);
         }
         /* clear state bits for next instruction */
         map_bits &= ~_BITS_USE_IXIY;
@@ -1396,6 +1403,11 @@ uint32_t z80_exec(z80_t* cpu, uint32_t num_ticks) {
             r2 |= (_BIT_IFF1 | _BIT_IFF2);
         }
         pre_pins = pins;
+        //MarkC - break after clearing the state bits so the next exec carries on as if it hadn't stopped
+        if (trap_id) {
+            cpu->trap_id=trap_id;
+            break;
+        }
     } while (ticks < num_ticks);
     /* flush local state back to persistent CPU state before leaving */
     _S_PC(pc);
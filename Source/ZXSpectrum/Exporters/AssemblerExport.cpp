@@ -1,118 +1,36 @@
 #include "CodeAnalyser/CodeAnalyser.h"
 #include "../SpectrumConstants.h"
 #include "Util/Misc.h"
-#include <util/z80dasm.h>
+#include "CodeAnalyser/Disassembler.h"
 #include "Debug/DebugLog.h"
 
 #include <string.h>
 
 
-class FExportDasmState : public FDasmStateBase
-{
-public:
-	void OutputU8(uint8_t val, z80dasm_output_t outputCallback) override
-	{
-		if (outputCallback != nullptr)
-		{
-			ENumberDisplayMode dispMode = GetNumberDisplayMode();
-
-			if (pCodeInfoItem->OperandType == EOperandType::Decimal)
-				dispMode = ENumberDisplayMode::Decimal;
-			if (pCodeInfoItem->OperandType == EOperandType::Hex)
-				dispMode = HexDisplayMode;
-			if (pCodeInfoItem->OperandType == EOperandType::Binary)
-				dispMode = ENumberDisplayMode::Binary;
-
-			const char* outStr = NumStr(val, dispMode);
-			for (int i = 0; i < strlen(outStr); i++)
-				outputCallback(outStr[i], this);
-		}
-	}
-
-	void OutputU16(uint16_t val, z80dasm_output_t outputCallback) override
-	{
-		if (outputCallback)
-		{
-			const bool bOperandIsAddress = (pCodeInfoItem->OperandType == EOperandType::JumpAddress || pCodeInfoItem->OperandType == EOperandType::Pointer);
-			const FLabelInfo* pLabel = bOperandIsAddress ? CodeAnalysisState->GetLabelForAddress(val) : nullptr;
-			if (pLabel != nullptr)
-			{
-				for (int i = 0; i < pLabel->Name.size(); i++)
-				{
-					outputCallback(pLabel->Name[i], this);
-				}
-			}
-			else
-			{
-				ENumberDisplayMode dispMode = GetNumberDisplayMode();
-
-				if (pCodeInfoItem->OperandType == EOperandType::Decimal)
-					dispMode = ENumberDisplayMode::Decimal;
-				if (pCodeInfoItem->OperandType == EOperandType::Hex)
-					dispMode = HexDisplayMode;
-				if (pCodeInfoItem->OperandType == EOperandType::Binary)
-					dispMode = ENumberDisplayMode::Binary;
-
-				const char* outStr = NumStr(val, dispMode);
-				for (int i = 0; i < strlen(outStr); i++)
-					outputCallback(outStr[i], this);
-			}
-		}
-	}
-
-	void OutputD8(int8_t val, z80dasm_output_t outputCallback) override
-	{
-		if (outputCallback)
-		{
-			if (val < 0)
-			{
-				outputCallback('-', this);
-				val = -val;
-			}
-			else
-			{
-				outputCallback('+', this);
-			}
-			const char* outStr = NumStr((uint8_t)val);
-			for (int i = 0; i < strlen(outStr); i++)
-				outputCallback(outStr[i], this);
-		}
-	}
-
-	FCodeInfo* pCodeInfoItem = nullptr;
-	ENumberDisplayMode	HexDisplayMode = ENumberDisplayMode::HexDollar;
-};
-
-
-/* disassembler callback to fetch the next instruction byte */
-static uint8_t ExportDasmInputCB(void* pUserData)
-{
-	FExportDasmState* pDasmState = (FExportDasmState*)pUserData;
-
-	return pDasmState->CodeAnalysisState->CPUInterface->ReadByte(pDasmState->CurrentAddress++);
-}
-
-/* disassembler callback to output a character */
-static void ExportOutputCB(char c, void* pUserData)
-{
-	FExportDasmState* pDasmState = (FExportDasmState*)pUserData;
-
-	// add character to string
-	pDasmState->Text += c;
-}
-
 std::string GenerateDasmStringForAddress(FCodeAnalysisState& state, uint16_t pc, ENumberDisplayMode hexMode)
 {
-	FExportDasmState dasmState;
-	dasmState.CodeAnalysisState = &state;
-	dasmState.CurrentAddress = pc;
-	dasmState.HexDisplayMode = hexMode;
-	dasmState.pCodeInfoItem = state.GetCodeInfoForAddress(pc);
-	SetNumberOutput(&dasmState);
-	z80dasm_op(pc, ExportDasmInputCB, ExportOutputCB, &dasmState);
-	SetNumberOutput(nullptr);
-
-	return dasmState.Text;
+	const FCodeInfo* pCodeInfoItem = state.GetCodeInfoForAddress(pc);
+
+	FDasmFormatOptions options;
+	options.NumberMode = GetNumberDisplayMode();
+	options.DisplacementMode = GetNumberDisplayMode();
+	if (pCodeInfoItem->OperandType == EOperandType::Decimal)
+		options.NumberMode = ENumberDisplayMode::Decimal;
+	if (pCodeInfoItem->OperandType == EOperandType::Hex)
+		options.NumberMode = hexMode;
+	if (pCodeInfoItem->OperandType == EOperandType::Binary)
+		options.NumberMode = ENumberDisplayMode::Binary;
+
+	// address operands are output as labels
+	if (pCodeInfoItem->OperandType == EOperandType::JumpAddress || pCodeInfoItem->OperandType == EOperandType::Pointer)
+		options.pLabelState = &state;
+
+	FDasmInstruction instruction;
+	DisassembleInstruction(state.CPUInterface, pc, instruction);
+
+	char text[128];
+	FormatDasmInstruction(instruction, options, text, sizeof(text));
+	return text;
 }
 
 
@@ -1,529 +1,868 @@
 #include "JsonExport.h"
 #include "CodeAnalyser/CodeAnalyser.h"
+#include "CodeAnalyser/AnalysisSnapshot.h"
 #include "../SpectrumConstants.h"
 #include "../SpectrumEmu.h"
 
-#include <json.hpp>
-#include <iomanip>
-#include <fstream>
-#include <sstream>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/reader.h>
+#include <rapidjson/filewritestream.h>
+#include <rapidjson/filereadstream.h>
+#include <rapidjson/error/en.h>
+#include <cstring>
 #include <Util/GraphicsView.h>
 #include <Debug/DebugLog.h>
 
-using json = nlohmann::json;
+// Analysis json is streamed - items are written as they're visited and read back one at a time with a SAX handler
+// so there's never a document for the whole address range in memory
 
-// We want to eventually move to using Json as it will allow merging 
-void WriteAddressRangeToJson(FCodeAnalysisState& state, int startAddress, int endAddress, json& jsonDoc);
-void WriteBankToJson(const FSpectrumEmu* pSpectrumEmu, int bankNo, json& jsonDoc);
-void ReadBankFromJson(FSpectrumEmu* pSpectrumEmu, int bankNo, const json& jsonDoc);
+typedef rapidjson::PrettyWriter<rapidjson::FileWriteStream>	FJsonWriter;
 
-bool ExportROMJson(FCodeAnalysisState& state, const char* pJsonFileName)
+static const size_t kJsonStreamBufferSize = 64 * 1024;
+
+// We want to eventually move to using Json as it will allow merging
+void WriteAddressRangeToJson(FCodeAnalysisState& state, int startAddress, int endAddress, FJsonWriter& writer);
+void WriteBankToJson(const FSpectrumEmu* pSpectrumEmu, int bankNo, FJsonWriter& writer);
+bool ReadBankFromJson(FSpectrumEmu* pSpectrumEmu, int bankNo, const char* pJsonFileName);
+
+// writeContents writes the top level value
+template <typename WriteFunc>
+static bool WriteJsonFile(const char* pJsonFileName, WriteFunc writeContents)
 {
-	json jsonROMData;
+	FILE* fp = fopen(pJsonFileName, "wb");
+	if (fp == nullptr)
+		return false;
 
-	WriteAddressRangeToJson(state, 0, 0x3fff, jsonROMData);
+	std::vector<char> buffer(kJsonStreamBufferSize);
+	rapidjson::FileWriteStream stream(fp, buffer.data(), buffer.size());
+	FJsonWriter writer(stream);
+	writer.SetIndent(' ', 4);
 
-	std::ofstream outFileStream(pJsonFileName);
-	if (outFileStream.is_open())
-	{
-		outFileStream << std::setw(4) << jsonROMData << std::endl;
-		return true;
-	}
+	writeContents(writer);
+	stream.Put('\n');
+	stream.Flush();
 
-	return false;
+	const bool bSuccess = writer.IsComplete() && ferror(fp) == 0;
+	fclose(fp);
+	return bSuccess;
 }
 
-#define WRITE_BANKS 0
-
-bool ExportGameJson(FSpectrumEmu* pSpectrumEmu, const char* pJsonFileName)
+static void WriteString(FJsonWriter& writer, const std::string& str)
 {
-	FCodeAnalysisState& state = pSpectrumEmu->CodeAnalysis;
-	json jsonGameData;
-
-	// write out RAM
-	const int startAddress = 0x4000;
-	const int endAddress = 0xffff;
-
-	WriteAddressRangeToJson(state, startAddress, endAddress, jsonGameData);
+	writer.String(str.c_str(), (rapidjson::SizeType)str.size());
+}
 
-	// Write watches
-	for (const auto& watch : state.GetWatches())
+bool ExportROMJson(FCodeAnalysisState& state, const char* pJsonFileName)
+{
+	return WriteJsonFile(pJsonFileName, [&state](FJsonWriter& writer)
 	{
-		jsonGameData["Watches"].push_back(watch);
-	}
+		writer.StartObject();
+		WriteAddressRangeToJson(state, 0, 0x3fff, writer);
+		writer.EndObject();
+	});
+}
 
-	// Write character sets
-	for (int i = 0; i < GetNoCharacterSets(); i++)
+#define WRITE_BANKS 0
+
+// pSpectrumEmu is null when writing from a snapshot
+static bool WriteGameJson(const FSpectrumEmu* pSpectrumEmu, FCodeAnalysisState& state, const std::vector<FCharSetCreateParams>& charSets, const std::vector<FCharMapCreateParams>& charMaps, const char* pJsonFileName)
+{
+	return WriteJsonFile(pJsonFileName, [&](FJsonWriter& writer)
 	{
-		const FCharacterSet* pCharSet = GetCharacterSetFromIndex(i);
-		json jsonCharacterSet;
+		writer.StartObject();
 
-		jsonCharacterSet["Address"] = pCharSet->Params.Address;
-		jsonCharacterSet["AttribsAddress"] = pCharSet->Params.AttribsAddress;
-		jsonCharacterSet["MaskInfo"] = pCharSet->Params.MaskInfo;
-		jsonCharacterSet["ColourInfo"] = pCharSet->Params.ColourInfo;
-		jsonCharacterSet["Dynamic"] = pCharSet->Params.bDynamic;
+		// write out RAM
+		const int startAddress = 0x4000;
+		const int endAddress = 0xffff;
 
-		jsonGameData["CharacterSets"].push_back(jsonCharacterSet);
-	}
+		WriteAddressRangeToJson(state, startAddress, endAddress, writer);
 
-	// Write character maps
-	for (int i = 0; i < GetNoCharacterMaps(); i++)
-	{
-		const FCharacterMap* pCharMap = GetCharacterMapFromIndex(i);
-		json jsonCharacterMap;
+		// Write watches
+		if (state.GetWatches().empty() == false)
+		{
+			writer.Key("Watches");
+			writer.StartArray();
+			for (const auto& watch : state.GetWatches())
+				writer.Uint(watch);
+			writer.EndArray();
+		}
 
-		jsonCharacterMap["Address"] = pCharMap->Params.Address;
-		jsonCharacterMap["Width"] = pCharMap->Params.Width;
-		jsonCharacterMap["Height"] = pCharMap->Params.Height;
-		jsonCharacterMap["CharacterSet"] = pCharMap->Params.CharacterSet;
-		jsonCharacterMap["IgnoreCharacter"] = pCharMap->Params.IgnoreCharacter;
+		// Write character sets
+		if (charSets.empty() == false)
+		{
+			writer.Key("CharacterSets");
+			writer.StartArray();
+			for (const FCharSetCreateParams& params : charSets)
+			{
+				writer.StartObject();
+				writer.Key("Address");			writer.Uint(params.Address);
+				writer.Key("AttribsAddress");	writer.Uint(params.AttribsAddress);
+				writer.Key("MaskInfo");			writer.Int((int)params.MaskInfo);
+				writer.Key("ColourInfo");		writer.Int((int)params.ColourInfo);
+				writer.Key("Dynamic");			writer.Bool(params.bDynamic);
+				writer.EndObject();
+			}
+			writer.EndArray();
+		}
 
-		jsonGameData["CharacterMaps"].push_back(jsonCharacterMap);
-	}
+		// Write character maps
+		if (charMaps.empty() == false)
+		{
+			writer.Key("CharacterMaps");
+			writer.StartArray();
+			for (const FCharMapCreateParams& params : charMaps)
+			{
+				writer.StartObject();
+				writer.Key("Address");			writer.Uint(params.Address);
+				writer.Key("Width");			writer.Int(params.Width);
+				writer.Key("Height");			writer.Int(params.Height);
+				writer.Key("CharacterSet");		writer.Uint(params.CharacterSet);
+				writer.Key("IgnoreCharacter");	writer.Uint(params.IgnoreCharacter);
+				writer.EndObject();
+			}
+			writer.EndArray();
+		}
 
-	// Write banks
+		// Write banks
 #if WRITE_BANKS
-	for (int bankNo = 0; bankNo < 8; bankNo++)
-	{
-		json bankData;
-		if (pSpectrumEmu->RAMPages[bankNo * FSpectrumEmu::kNoBankPages].bUsed)
+		if (pSpectrumEmu != nullptr)
 		{
-			LOGINFO("Bank %d has been used", bankNo);
+			writer.Key("Banks");
+			writer.StartArray();
+			for (int bankNo = 0; bankNo < 8; bankNo++)
+			{
+				if (pSpectrumEmu->RAMPages[bankNo * FSpectrumEmu::kNoBankPages].bUsed)
+				{
+					LOGINFO("Bank %d has been used", bankNo);
+					WriteBankToJson(pSpectrumEmu, bankNo, writer);
+				}
+				else
+				{
+					writer.Null();
+				}
+			}
+			writer.EndArray();
 		}
-
-		jsonGameData["Banks"].push_back(bankData);
-	}
 #endif
 
-	// Write file out
-	std::ofstream outFileStream(pJsonFileName);
-	if (outFileStream.is_open())
-	{
-		outFileStream << std::setw(4) << jsonGameData << std::endl;
-		return true;
-	}
+		writer.EndObject();
+	});
+}
+
+bool ExportGameJson(FSpectrumEmu* pSpectrumEmu, const char* pJsonFileName)
+{
+	std::vector<FCharSetCreateParams> charSets;
+	std::vector<FCharMapCreateParams> charMaps;
+	GetCharacterSetParams(charSets);
+	GetCharacterMapParams(charMaps);
+
+	return WriteGameJson(pSpectrumEmu, pSpectrumEmu->CodeAnalysis, charSets, charMaps, pJsonFileName);
+}
 
-	return false;
+bool ExportGameJson(FAnalysisSnapshot& snapshot, const char* pJsonFileName)
+{
+	return WriteGameJson(nullptr, snapshot.State, snapshot.CharacterSets, snapshot.CharacterMaps, pJsonFileName);
 }
 
-bool WriteDataInfoToJson(const FDataInfo* pDataInfo, json& jsonDoc, int addressOverride = -1)
+// only data that deviates from the normal is written
+static bool ShouldWriteDataInfo(const FDataInfo* pDataInfo)
 {
-	json dataInfoJson;
+	return pDataInfo->DataType != EDataType::Byte || pDataInfo->OperandType != EOperandType::Unknown || pDataInfo->ByteSize != 1 ||
+		pDataInfo->Flags != 0 || pDataInfo->Comment.empty() == false || pDataInfo->Reads.empty() == false || pDataInfo->Writes.empty() == false;
+}
 
+void WriteDataInfoToJson(const FDataInfo* pDataInfo, FJsonWriter& writer, int addressOverride = -1)
+{
 	assert(pDataInfo != nullptr);
+	writer.StartObject();
+	writer.Key("Address");
+	writer.Uint(addressOverride == -1 ? pDataInfo->Address : addressOverride);
 	if (pDataInfo->DataType != EDataType::Byte)
-		dataInfoJson["DataType"] = (int)pDataInfo->DataType;
+	{
+		writer.Key("DataType");
+		writer.Int((int)pDataInfo->DataType);
+	}
 	if (pDataInfo->OperandType != EOperandType::Unknown)
-		dataInfoJson["OperandType"] = pDataInfo->OperandType;
+	{
+		writer.Key("OperandType");
+		writer.Int((int)pDataInfo->OperandType);
+	}
 	if (pDataInfo->ByteSize != 1)
-		dataInfoJson["ByteSize"] = pDataInfo->ByteSize;
+	{
+		writer.Key("ByteSize");
+		writer.Uint(pDataInfo->ByteSize);
+	}
 	if (pDataInfo->Flags != 0)
-		dataInfoJson["Flags"] = pDataInfo->Flags;
+	{
+		writer.Key("Flags");
+		writer.Uint(pDataInfo->Flags);
+	}
 	if (pDataInfo->Comment.empty() == false)
-		dataInfoJson["Comment"] = pDataInfo->Comment;
-
-	for (const auto& read : pDataInfo->Reads)
-		dataInfoJson["Reads"].push_back(read.first);
-
-	for (const auto& write : pDataInfo->Writes)
-		dataInfoJson["Writes"].push_back(write.first);
+	{
+		writer.Key("Comment");
+		WriteString(writer, pDataInfo->Comment);
+	}
 
-	// Charmap specific
-	if (pDataInfo->DataType == EDataType::CharacterMap)
+	if (pDataInfo->Reads.empty() == false)
 	{
-		dataInfoJson["CharSetAddress"] = pDataInfo->CharSetAddress;
-		dataInfoJson["EmptyCharNo"] = pDataInfo->EmptyCharNo;
+		writer.Key("Reads");
+		writer.StartArray();
+		for (const auto& read : pDataInfo->Reads)
+			writer.Uint(read.first);
+		writer.EndArray();
 	}
 
-	if (dataInfoJson.size() != 0)	// only write it if it deviates from the normal
+	if (pDataInfo->Writes.empty() == false)
 	{
-		dataInfoJson["Address"] = addressOverride == -1 ? pDataInfo->Address : addressOverride;
-		jsonDoc["DataInfo"].push_back(dataInfoJson);
-		return true;
+		writer.Key("Writes");
+		writer.StartArray();
+		for (const auto& write : pDataInfo->Writes)
+			writer.Uint(write.first);
+		writer.EndArray();
 	}
 
-	return false;
+	// Charmap specific
+	if (pDataInfo->DataType == EDataType::CharacterMap)
+	{
+		writer.Key("CharSetAddress");
+		writer.Uint(pDataInfo->CharSetAddress);
+		writer.Key("EmptyCharNo");
+		writer.Uint(pDataInfo->EmptyCharNo);
+	}
+	writer.EndObject();
 }
 
-void WriteCodeInfoToJson(const FCodeInfo* pCodeInfoItem, json& jsonDoc, int addressOverride = -1)
+void WriteCodeInfoToJson(const FCodeInfo* pCodeInfoItem, FJsonWriter& writer, int addressOverride = -1)
 {
-	json codeInfoJson;
-	codeInfoJson["Address"] = addressOverride == -1 ? pCodeInfoItem->Address : addressOverride;
-	codeInfoJson["ByteSize"] = pCodeInfoItem->ByteSize;
+	writer.StartObject();
+	writer.Key("Address");
+	writer.Uint(addressOverride == -1 ? pCodeInfoItem->Address : addressOverride);
+	writer.Key("ByteSize");
+	writer.Uint(pCodeInfoItem->ByteSize);
 	if (pCodeInfoItem->bSelfModifyingCode)
-		codeInfoJson["SMC"] = true;
+	{
+		writer.Key("SMC");
+		writer.Bool(true);
+	}
 	if (pCodeInfoItem->OperandType != EOperandType::Unknown)
-		codeInfoJson["OperandType"] = (int)pCodeInfoItem->OperandType;
+	{
+		writer.Key("OperandType");
+		writer.Int((int)pCodeInfoItem->OperandType);
+	}
 	if (pCodeInfoItem->Flags != 0)
-		codeInfoJson["Flags"] = pCodeInfoItem->Flags;
+	{
+		writer.Key("Flags");
+		writer.Uint(pCodeInfoItem->Flags);
+	}
 	if (pCodeInfoItem->Comment.empty() == false)
-		codeInfoJson["Comment"] = pCodeInfoItem->Comment;
-
-	jsonDoc["CodeInfo"].push_back(codeInfoJson);
+	{
+		writer.Key("Comment");
+		WriteString(writer, pCodeInfoItem->Comment);
+	}
+	writer.EndObject();
 }
 
-void WriteLabelInfoToJson(const FLabelInfo* pLabelInfo, json& jsonDoc, int addressOverride = -1)
+void WriteLabelInfoToJson(const FLabelInfo* pLabelInfo, FJsonWriter& writer, int addressOverride = -1)
 {
-	json labelInfoJson;
-	labelInfoJson["Address"] = addressOverride == -1 ? pLabelInfo->Address : addressOverride;
-	labelInfoJson["Name"] = pLabelInfo->Name;
+	writer.StartObject();
+	writer.Key("Address");
+	writer.Uint(addressOverride == -1 ? pLabelInfo->Address : addressOverride);
+	writer.Key("Name");
+	WriteString(writer, pLabelInfo->Name);
 	if (pLabelInfo->Global)
-		labelInfoJson["Global"] = pLabelInfo->Global;
-	labelInfoJson["LabelType"] = pLabelInfo->LabelType;
+	{
+		writer.Key("Global");
+		writer.Bool(true);
+	}
+	writer.Key("LabelType");
+	writer.Int((int)pLabelInfo->LabelType);
 	if (pLabelInfo->Comment.empty() == false)
-		labelInfoJson["Comment"] = pLabelInfo->Comment;
-
-	for (const auto& reference : pLabelInfo->References)
-		labelInfoJson["References"].push_back(reference.first);
+	{
+		writer.Key("Comment");
+		WriteString(writer, pLabelInfo->Comment);
+	}
 
-	jsonDoc["LabelInfo"].push_back(labelInfoJson);
+	if (pLabelInfo->References.empty() == false)
+	{
+		writer.Key("References");
+		writer.StartArray();
+		for (const auto& reference : pLabelInfo->References)
+			writer.Uint(reference.first);
+		writer.EndArray();
+	}
+	writer.EndObject();
 }
 
-void WriteCommentBlockToJson(const FCommentBlock* pCommentBlock, json& jsonDoc, int addressOverride = -1)
+void WriteCommentBlockToJson(const FCommentBlock* pCommentBlock, FJsonWriter& writer, int addressOverride = -1)
 {
-	if (pCommentBlock->Comment.empty())
-		return;
+	writer.StartObject();
+	writer.Key("Address");
+	writer.Uint(addressOverride == -1 ? pCommentBlock->Address : addressOverride);
+	writer.Key("Comment");
+	WriteString(writer, pCommentBlock->Comment);
+	writer.EndObject();
+}
 
-	json commentBlockJson;
-	commentBlockJson["Address"] = addressOverride == -1 ? pCommentBlock->Address : addressOverride;
-	commentBlockJson["Comment"] = pCommentBlock->Comment;
+// Item arrays, each is written in its own pass over the address range
+enum class EJsonItemArray
+{
+	CommentBlocks,
+	LabelInfo,
+	CodeInfo,
+	DataInfo,
 
-	jsonDoc["CommentBlocks"].push_back(commentBlockJson);
-}
+	Count
+};
 
-void WriteAddressRangeToJson(FCodeAnalysisState& state, int startAddress,int endAddress, json& jsonDoc)
+static const char* g_JsonItemArrayNames[(int)EJsonItemArray::Count] =
+{
+	"CommentBlocks",
+	"LabelInfo",
+	"CodeInfo",
+	"DataInfo",
+};
+
+// Visit addresses the way items are laid out - instructions are stepped over unless they're self modifying
+// so data info is visited for the first byte of each data item & SMC instruction
+template <typename GetPageFunc, typename VisitFunc>
+static void ForEachItemAddress(int startAddress, int endAddress, GetPageFunc getPage, VisitFunc visit)
 {
 	int address = startAddress;
-
-	// info on last writer
-	jsonDoc["LastWriterStart"] = startAddress;
-	for (int addr = startAddress; addr <= endAddress; addr++)
-		jsonDoc["LastWriter"].push_back(state.GetLastWriterForAddress(addr));
-	
-	while(address <= endAddress)
+	while (address <= endAddress)
 	{
-		FCommentBlock* pCommentBlock = state.GetCommentBlockForAddress(address);
-		if (pCommentBlock != nullptr)
-			WriteCommentBlockToJson(pCommentBlock, jsonDoc);
-
-		FLabelInfo* pLabelInfo = state.GetLabelForAddress(address);
-		if (pLabelInfo)
-			WriteLabelInfoToJson(pLabelInfo, jsonDoc);
-
-		FCodeInfo* pCodeInfoItem = state.GetCodeInfoForAddress(address);
-		if (pCodeInfoItem && pCodeInfoItem->Address == address)	// only write code items for first byte of the instruction
-		{
-			WriteCodeInfoToJson(pCodeInfoItem, jsonDoc);
-			
-			if (pCodeInfoItem->bSelfModifyingCode == false)	// this is so that we can write info on SMC accesses
-				address += pCodeInfoItem->ByteSize;
-		}
-		
-		if(pCodeInfoItem == nullptr || pCodeInfoItem->bSelfModifyingCode)
-		{
-			FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(address);
-			WriteDataInfoToJson(pDataInfo, jsonDoc);
-			address += pDataInfo->ByteSize;
-		}
+		const FCodeAnalysisPage& page = *getPage(address);
+		const int pageAddr = address & FCodeAnalysisState::kPageMask;
+		const FCodeInfo* pCodeInfo = page.CodeInfo[pageAddr];
+		const bool bCodeStart = pCodeInfo != nullptr && pCodeInfo->Address == page.BaseAddress + pageAddr;	// only write code items for first byte of the instruction
+		const bool bData = pCodeInfo == nullptr || pCodeInfo->bSelfModifyingCode;	// this is so that we can write info on SMC accesses
+
+		visit(address, page, pageAddr, bCodeStart, bData);
+
+		int step = 0;
+		if (bCodeStart && pCodeInfo->bSelfModifyingCode == false)
+			step += pCodeInfo->ByteSize;
+		if (bData)
+			step += page.DataInfo[pageAddr].ByteSize;
+		address += std::max(step, 1);
 	}
 }
 
-
-FCommentBlock* CreateCommentBlockFromJson(const json& commentBlockJson)
+// addresses are written relative to the start of the range for banks
+template <typename GetPageFunc>
+static void WriteItemArraysToJson(int startAddress, int endAddress, GetPageFunc getPage, bool bRelativeAddresses, FJsonWriter& writer)
 {
-	FCommentBlock* pCommentBlock = FCommentBlock::Allocate();
-	pCommentBlock->Address = commentBlockJson["Address"];
-	pCommentBlock->Comment = commentBlockJson["Comment"];
-	return pCommentBlock;
+	for (int arrayNo = 0; arrayNo < (int)EJsonItemArray::Count; arrayNo++)
+	{
+		const EJsonItemArray itemArray = (EJsonItemArray)arrayNo;
+		bool bArrayStarted = false;	// empty arrays aren't written
+
+		ForEachItemAddress(startAddress, endAddress, getPage, [&](int address, const FCodeAnalysisPage& page, int pageAddr, bool bCodeStart, bool bData)
+		{
+			const FCommentBlock* pCommentBlock = page.CommentBlocks[pageAddr];
+			const FLabelInfo* pLabelInfo = page.Labels[pageAddr];
+			const FDataInfo* pDataInfo = &page.DataInfo[pageAddr];
+			const bool bWrite = (itemArray == EJsonItemArray::CommentBlocks && pCommentBlock != nullptr && pCommentBlock->Comment.empty() == false) ||
+				(itemArray == EJsonItemArray::LabelInfo && pLabelInfo != nullptr) ||
+				(itemArray == EJsonItemArray::CodeInfo && bCodeStart) ||
+				(itemArray == EJsonItemArray::DataInfo && bData && ShouldWriteDataInfo(pDataInfo));
+			if (bWrite == false)
+				return;
+
+			if (bArrayStarted == false)
+			{
+				writer.Key(g_JsonItemArrayNames[arrayNo]);
+				writer.StartArray();
+				bArrayStarted = true;
+			}
+
+			const int addressOverride = bRelativeAddresses ? address - startAddress : -1;
+			switch (itemArray)
+			{
+			case EJsonItemArray::CommentBlocks:	WriteCommentBlockToJson(pCommentBlock, writer, addressOverride); break;
+			case EJsonItemArray::LabelInfo:		WriteLabelInfoToJson(pLabelInfo, writer, addressOverride); break;
+			case EJsonItemArray::CodeInfo:		WriteCodeInfoToJson(page.CodeInfo[pageAddr], writer, addressOverride); break;
+			case EJsonItemArray::DataInfo:		WriteDataInfoToJson(pDataInfo, writer, addressOverride); break;
+			default: break;
+			}
+		});
+
+		if (bArrayStarted)
+			writer.EndArray();
+	}
 }
 
-FCodeInfo* CreateCodeInfoFromJson(const json& codeInfoJson)
+void WriteAddressRangeToJson(FCodeAnalysisState& state, int startAddress,int endAddress, FJsonWriter& writer)
 {
-	FCodeInfo* pCodeInfo = FCodeInfo::Allocate();
-	pCodeInfo->Address = codeInfoJson["Address"];
-	pCodeInfo->ByteSize = codeInfoJson["ByteSize"];
-
-	if (codeInfoJson.contains("SMC"))
-		pCodeInfo->bSelfModifyingCode = codeInfoJson["SMC"];
-
-	if (codeInfoJson.contains("OperandType"))
-		pCodeInfo->OperandType = codeInfoJson["OperandType"];
+	// info on last writer
+	writer.Key("LastWriterStart");
+	writer.Int(startAddress);
+	writer.Key("LastWriter");
+	writer.StartArray();
+	for (int addr = startAddress; addr <= endAddress; addr++)
+		writer.Uint(state.GetLastWriterForAddress(addr));
+	writer.EndArray();
 
-	if (codeInfoJson.contains("Flags"))
-		pCodeInfo->Flags = codeInfoJson["Flags"];
+	WriteItemArraysToJson(startAddress, endAddress, [&state](int address) { return state.GetReadPage(address); }, false, writer);
+}
 
-	if (codeInfoJson.contains("Comment"))
-		pCodeInfo->Comment = codeInfoJson["Comment"];
+// Reading
 
-	return pCodeInfo;
+// Top level keys
+enum class EJsonSection
+{
+	Unknown,
+	LastWriterStart,
+	LastWriter,
+	CommentBlocks,
+	LabelInfo,
+	CodeInfo,
+	DataInfo,
+	Watches,
+	CharacterSets,
+	CharacterMaps,
+
+	Count
+};
+
+static const char* g_JsonSectionNames[(int)EJsonSection::Count] =
+{
+	"",
+	"LastWriterStart",
+	"LastWriter",
+	"CommentBlocks",
+	"LabelInfo",
+	"CodeInfo",
+	"DataInfo",
+	"Watches",
+	"CharacterSets",
+	"CharacterMaps",
+};
+
+// Keys in item objects
+enum class EJsonField
+{
+	Unknown,
+	Address,
+	ByteSize,
+	SMC,
+	OperandType,
+	Flags,
+	Comment,
+	Name,
+	Global,
+	LabelType,
+	References,
+	DataType,
+	Reads,
+	Writes,
+	CharSetAddress,
+	EmptyCharNo,
+	AttribsAddress,
+	MaskInfo,
+	ColourInfo,
+	Dynamic,
+	Width,
+	Height,
+	CharacterSet,
+	IgnoreCharacter,
+
+	Count
+};
+
+static const char* g_JsonFieldNames[(int)EJsonField::Count] =
+{
+	"",
+	"Address",
+	"ByteSize",
+	"SMC",
+	"OperandType",
+	"Flags",
+	"Comment",
+	"Name",
+	"Global",
+	"LabelType",
+	"References",
+	"DataType",
+	"Reads",
+	"Writes",
+	"CharSetAddress",
+	"EmptyCharNo",
+	"AttribsAddress",
+	"MaskInfo",
+	"ColourInfo",
+	"Dynamic",
+	"Width",
+	"Height",
+	"CharacterSet",
+	"IgnoreCharacter",
+};
+
+template <typename EnumType, int kCount>
+static EnumType FindJsonName(const char* (&names)[kCount], const char* pStr, rapidjson::SizeType length)
+{
+	for (int i = 1; i < kCount; i++)
+	{
+		if (strncmp(names[i], pStr, length) == 0 && names[i][length] == 0)
+			return (EnumType)i;
+	}
+	return EnumType::Unknown;
 }
 
-FLabelInfo* CreateLabelInfoFromJson(const json& labelInfoJson)
+// Item object being read - fields are applied once the whole object has been read as keys can come in any order
+struct FJsonItem
 {
-	FLabelInfo* pLabelInfo = FLabelInfo::Allocate();
+	void	Reset()
+	{
+		FieldMask = 0;
+		memset(Values, 0, sizeof(Values));
+		Name.clear();
+		Comment.clear();
+		References.clear();
+		Reads.clear();
+		Writes.clear();
+	}
 
-	pLabelInfo->Address = labelInfoJson["Address"];
-	pLabelInfo->Name = labelInfoJson["Name"];
-	if (labelInfoJson.contains("Global"))
-		pLabelInfo->Global = true;
+	bool	Has(EJsonField field) const { return (FieldMask & (1 << (int)field)) != 0; }
+	int64_t	Get(EJsonField field) const { return Values[(int)field]; }
 
-	if (labelInfoJson.contains("LabelType"))
-		pLabelInfo->LabelType = (ELabelType)(int)labelInfoJson["LabelType"];
-	if (labelInfoJson.contains("Comment"))
-		pLabelInfo->Comment = labelInfoJson["Comment"];
+	void	SetValue(EJsonField field, int64_t value)
+	{
+		FieldMask |= 1 << (int)field;
+		Values[(int)field] = value;
+	}
 
-	if (labelInfoJson.contains("References"))
+	std::vector<uint16_t>* GetAddressList(EJsonField field)
 	{
-		for (const auto& reference : labelInfoJson["References"])
+		switch (field)
 		{
-			pLabelInfo->References[reference] = 1;
+		case EJsonField::References:	return &References;
+		case EJsonField::Reads:			return &Reads;
+		case EJsonField::Writes:		return &Writes;
+		default:						return nullptr;
 		}
 	}
 
-	return pLabelInfo;
-}
-
-void LoadDataInfoFromJson(FDataInfo* pDataInfo, const json & dataInfoJson)
+	uint32_t				FieldMask = 0;
+	int64_t					Values[(int)EJsonField::Count] = { 0 };
+	std::string				Name;
+	std::string				Comment;
+	std::vector<uint16_t>	References;
+	std::vector<uint16_t>	Reads;
+	std::vector<uint16_t>	Writes;
+};
+
+// SAX handler for analysis json
+// Depth 1 is the top level object, 2 the section arrays, 3 the item objects & 4 arrays in items
+// Items are buffered and only applied with Apply() once the whole file has parsed, so a broken file leaves the analysis untouched
+// If pBankPages is set the items are read into a bank's pages with bank relative addresses
+class FAnalysisJsonReader : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, FAnalysisJsonReader>
 {
-	pDataInfo->Address = dataInfoJson["Address"];
-
-	if (dataInfoJson.contains("DataType"))
-		pDataInfo->DataType = (EDataType)(int)dataInfoJson["DataType"];
-	if (dataInfoJson.contains("OperandType"))
-		pDataInfo->OperandType = (EOperandType)(int)dataInfoJson["OperandType"];
-	if (dataInfoJson.contains("ByteSize"))
-		pDataInfo->ByteSize = dataInfoJson["ByteSize"];
-	if (dataInfoJson.contains("Flags"))
-		pDataInfo->Flags = dataInfoJson["Flags"];
-	if (dataInfoJson.contains("Comment"))
-		pDataInfo->Comment = dataInfoJson["Comment"];
-	if (dataInfoJson.contains("Reads"))
-	{
-		for (const auto& read : dataInfoJson["Reads"])
-		{
-			pDataInfo->Reads[read] = 1;
-		}
-	}
-	if (dataInfoJson.contains("Writes"))
+public:
+	FAnalysisJsonReader(FCodeAnalysisState& state, FCodeAnalysisPage* pBankPages = nullptr) : State(state), pBankPages(pBankPages) {}
+
+	bool	StartObject()
 	{
-		for (const auto& read : dataInfoJson["Writes"])
-		{
-			pDataInfo->Writes[read] = 1;
-		}
+		if (++Depth == 3)
+			Item.Reset();
+		return true;
 	}
 
-	// Charmap specific
-	if (pDataInfo->DataType == EDataType::CharacterMap)
+	bool	EndObject(rapidjson::SizeType)
 	{
-		if(dataInfoJson.contains("CharSetAddress"))
-			pDataInfo->CharSetAddress = dataInfoJson["CharSetAddress"];
-		if (dataInfoJson.contains("EmptyCharNo"))
-			pDataInfo->EmptyCharNo = dataInfoJson["EmptyCharNo"];
+		if (Depth == 3)
+			Items.push_back({ Section, std::move(Item) });
+		Depth--;
+		return true;
 	}
-}
 
+	bool	StartArray() { Depth++; return true; }
+	bool	EndArray(rapidjson::SizeType) { Depth--; return true; }
 
-bool ImportAnalysisJson(FCodeAnalysisState& state, const char* pJsonFileName)
-{
-	std::ifstream inFileStream(pJsonFileName);
-	if (inFileStream.is_open() == false)
-		return false;
-
-	json jsonGameData;
-
-	inFileStream >> jsonGameData;
-	inFileStream.close();
-
-	// info on last writer
-	if (jsonGameData.contains("LastWriterStart"))
+	bool	Key(const char* pStr, rapidjson::SizeType length, bool)
 	{
-		const int lwStart = jsonGameData["LastWriterStart"];
-
-		const json& lastWriterArray = jsonGameData["LastWriter"];
-		const int noWriters = (int)lastWriterArray.size();
-		for (int i = 0;i<noWriters;i++)
-			state.SetLastWriterForAddress(lwStart + i, lastWriterArray[i]);
+		if (Depth == 1)
+			Section = FindJsonName<EJsonSection>(g_JsonSectionNames, pStr, length);
+		else if (Depth == 3)
+			Field = FindJsonName<EJsonField>(g_JsonFieldNames, pStr, length);
+		return true;
 	}
 
-	if (jsonGameData.contains("CommentBlocks"))
+	bool	Number(int64_t value)
 	{
-		for (const auto commentBlockJson : jsonGameData["CommentBlocks"])
+		if (Depth == 1 && Section == EJsonSection::LastWriterStart)
 		{
-			FCommentBlock* pCommentBlock = CreateCommentBlockFromJson(commentBlockJson);
-			state.SetCommentBlockForAddress(pCommentBlock->Address, pCommentBlock);
+			LastWriterStart = (int)value;
 		}
-	}
-
-	if (jsonGameData.contains("CodeInfo"))
-	{
-		for (const auto codeInfoJson : jsonGameData["CodeInfo"])
+		else if (Depth == 2)
 		{
-			FCodeInfo* pCodeInfo = CreateCodeInfoFromJson(codeInfoJson);
-
-			for (int codeByte = 0; codeByte < pCodeInfo->ByteSize; codeByte++)	// set for whole instruction address range
-				state.SetCodeInfoForAddress(pCodeInfo->Address + codeByte, pCodeInfo);
+			if (Section == EJsonSection::LastWriter)
+				LastWriters.push_back((uint16_t)value);
+			else if (Section == EJsonSection::Watches)
+				Watches.push_back((uint16_t)value);
 		}
-	}
-
-	if (jsonGameData.contains("LabelInfo"))
-	{
-		for (const auto labelInfoJson : jsonGameData["LabelInfo"])
+		else if (Depth == 3)
 		{
-			FLabelInfo* pLabelInfo = CreateLabelInfoFromJson(labelInfoJson);
-
-			state.SetLabelForAddress(pLabelInfo->Address,pLabelInfo);
+			Item.SetValue(Field, value);
 		}
-	}
-
-	if (jsonGameData.contains("DataInfo"))
-	{
-		for (const auto dataInfoJson : jsonGameData["DataInfo"])
+		else if (Depth == 4)
 		{
-			const int address = dataInfoJson["Address"];
-			FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(address);
-			LoadDataInfoFromJson(pDataInfo, dataInfoJson);
+			std::vector<uint16_t>* pAddressList = Item.GetAddressList(Field);
+			if (pAddressList != nullptr)
+				pAddressList->push_back((uint16_t)value);
 		}
+		return true;
 	}
 
-	if (jsonGameData.contains("Watches"))
+	bool	Bool(bool b) { return Number(b ? 1 : 0); }
+	bool	Int(int i) { return Number(i); }
+	bool	Uint(unsigned u) { return Number(u); }
+	bool	Int64(int64_t i) { return Number(i); }
+	bool	Uint64(uint64_t u) { return Number((int64_t)u); }
+	bool	Double(double d) { return Number((int64_t)d); }
+
+	bool	String(const char* pStr, rapidjson::SizeType length, bool)
 	{
-		for (const auto& watch : jsonGameData["Watches"])
+		if (Depth == 3)
 		{
-			state.AddWatch(watch);
+			if (Field == EJsonField::Comment)
+				Item.Comment.assign(pStr, length);
+			else if (Field == EJsonField::Name)
+				Item.Name.assign(pStr, length);
+			Item.SetValue(Field, 0);	// mark as read
 		}
+		return true;
 	}
 
-	if (jsonGameData.contains("CharacterSets"))
+	// the last writer array can come before its start address & character maps add labels, so these are done at the end
+	void	Apply()
 	{
-		for (const auto& charSet : jsonGameData["CharacterSets"])
+		for (const FBufferedItem& bufferedItem : Items)
+			ApplyItem(bufferedItem.Section, bufferedItem.Item);
+		for (uint16_t watch : Watches)
+			State.AddWatch(watch);
+
+		if (pBankPages != nullptr)
 		{
-			FCharSetCreateParams params;
-			params.Address = charSet["Address"];
-			params.AttribsAddress = charSet["AttribsAddress"];
-			params.MaskInfo = charSet["MaskInfo"];
-			params.ColourInfo = charSet["ColourInfo"];
-			params.bDynamic = charSet["Dynamic"];
-			CreateCharacterSetAt(state, params);
+			for (int bankAddr = 0; bankAddr < (int)LastWriters.size(); bankAddr++)
+				GetBankPage(bankAddr).LastWriter[bankAddr & FCodeAnalysisState::kPageMask] = LastWriters[bankAddr];
 		}
-	}
-
-	if (jsonGameData.contains("CharacterMaps"))
-	{
-		for (const auto& charMap : jsonGameData["CharacterMaps"])
+		else if (LastWriterStart != -1)
 		{
-			FCharMapCreateParams params;
-			params.Address = charMap["Address"];
-			params.Width = charMap["Width"];
-			params.Height = charMap["Height"];
-			params.CharacterSet = charMap["CharacterSet"];
-			params.IgnoreCharacter = charMap["IgnoreCharacter"];
-			CreateCharacterMap(state, params);
+			for (int i = 0; i < (int)LastWriters.size(); i++)
+				State.SetLastWriterForAddress(LastWriterStart + i, LastWriters[i]);
 		}
-	}
-
-	return true;
-}
 
-// write a 16K bank to Json
-// the plan is to move to this so we can support 128K games
-void WriteBankToJson(const FSpectrumEmu* pSpectrumEmu, int bankNo, json& jsonDoc)
-{
-	const int bankPage = bankNo * 16;
-	uint16_t bankAddr = 0;
+		for (const FCharSetCreateParams& params : CharacterSets)
+			CreateCharacterSetAt(State, params);
+		for (const FCharMapCreateParams& params : CharacterMaps)
+			CreateCharacterMap(State, params);
+	}
 
-	while (bankAddr <= 0x4000)
+private:
+	struct FBufferedItem
 	{
-		const uint16_t curPageNo = bankPage + (bankAddr / 1024);
-		const FCodeAnalysisPage& curPage = pSpectrumEmu->RAMPages[curPageNo];
-		const uint16_t pageAddr = bankAddr & 1023;
+		EJsonSection	Section;
+		FJsonItem		Item;
+	};
 
-		const FCommentBlock* pCommentBlock = curPage.CommentBlocks[pageAddr];
-		if (pCommentBlock != nullptr)
-			WriteCommentBlockToJson(pCommentBlock, jsonDoc, bankAddr);
+	FCodeAnalysisPage& GetBankPage(int bankAddr) { return pBankPages[(bankAddr >> FCodeAnalysisState::kPageShift) & (FSpectrumEmu::kNoBankPages - 1)]; }
 
-		const FLabelInfo* pLabelInfo = curPage.Labels[pageAddr];
-		if (pLabelInfo)
-			WriteLabelInfoToJson(pLabelInfo, jsonDoc, bankAddr);
+	void	ApplyItem(EJsonSection section, const FJsonItem& item)
+	{
+		if (item.Has(EJsonField::Address) == false)
+			return;
 
-		const FCodeInfo* pCodeInfoItem = curPage.CodeInfo[pageAddr];
-		if (pCodeInfoItem && pCodeInfoItem->Address == curPage.BaseAddress + pageAddr)	// only write code items for first byte of the instruction
+		const uint16_t address = (uint16_t)item.Get(EJsonField::Address);
+		const int pageAddr = address & FCodeAnalysisState::kPageMask;
+		switch (section)
 		{
-			WriteCodeInfoToJson(pCodeInfoItem, jsonDoc, bankAddr);
-
-			if (pCodeInfoItem->bSelfModifyingCode == false)	// this is so that we can write info on SMC accesses
-				bankAddr += pCodeInfoItem->ByteSize;
+		case EJsonSection::CommentBlocks:
+		{
+			FCommentBlock* pCommentBlock = FCommentBlock::Allocate();
+			pCommentBlock->Address = address;
+			pCommentBlock->Comment = item.Comment;
+			if (pBankPages != nullptr)
+			{
+				FCodeAnalysisPage& page = GetBankPage(address);
+				pCommentBlock->Address = page.BaseAddress + pageAddr;
+				page.CommentBlocks[pageAddr] = pCommentBlock;
+			}
+			else
+			{
+				State.SetCommentBlockForAddress(address, pCommentBlock);
+			}
 		}
+		break;
+		case EJsonSection::CodeInfo:
+		{
+			if (pBankPages != nullptr)	// not supported for banks yet
+				break;
+
+			FCodeInfo* pCodeInfo = FCodeInfo::Allocate();
+			pCodeInfo->Address = address;
+			pCodeInfo->ByteSize = (uint16_t)item.Get(EJsonField::ByteSize);
+			if (item.Has(EJsonField::SMC))
+				pCodeInfo->bSelfModifyingCode = item.Get(EJsonField::SMC) != 0;
+			if (item.Has(EJsonField::OperandType))
+				pCodeInfo->OperandType = (EOperandType)item.Get(EJsonField::OperandType);
+			if (item.Has(EJsonField::Flags))
+				pCodeInfo->Flags = (uint32_t)item.Get(EJsonField::Flags);
+			pCodeInfo->Comment = item.Comment;
 
-		if (pCodeInfoItem == nullptr || pCodeInfoItem->bSelfModifyingCode)
+			for (int codeByte = 0; codeByte < pCodeInfo->ByteSize; codeByte++)	// set for whole instruction address range
+				State.SetCodeInfoForAddress(pCodeInfo->Address + codeByte, pCodeInfo);
+		}
+		break;
+		case EJsonSection::LabelInfo:
 		{
-			const FDataInfo* pDataInfo = &curPage.DataInfo[pageAddr];
-			WriteDataInfoToJson(pDataInfo, jsonDoc, bankAddr);
-			bankAddr += pDataInfo->ByteSize;
+			FLabelInfo* pLabelInfo = FLabelInfo::Allocate();
+			pLabelInfo->Address = address;
+			pLabelInfo->Name = item.Name;
+			if (item.Has(EJsonField::Global))
+				pLabelInfo->Global = true;
+			if (item.Has(EJsonField::LabelType))
+				pLabelInfo->LabelType = (ELabelType)item.Get(EJsonField::LabelType);
+			pLabelInfo->Comment = item.Comment;
+			for (uint16_t reference : item.References)
+				pLabelInfo->References[reference] = 1;
+
+			if (pBankPages != nullptr)
+			{
+				FCodeAnalysisPage& page = GetBankPage(address);
+				pLabelInfo->Address = page.BaseAddress + pageAddr;
+				page.Labels[pageAddr] = pLabelInfo;
+			}
+			else
+			{
+				State.SetLabelForAddress(pLabelInfo->Address, pLabelInfo);
+			}
 		}
+		break;
+		case EJsonSection::DataInfo:
+		{
+			FDataInfo* pDataInfo = pBankPages != nullptr ? &GetBankPage(address).DataInfo[pageAddr] : State.GetReadDataInfoForAddress(address);
+			if (pBankPages == nullptr)
+				pDataInfo->Address = address;
+
+			if (item.Has(EJsonField::DataType))
+				pDataInfo->DataType = (EDataType)item.Get(EJsonField::DataType);
+			if (item.Has(EJsonField::OperandType))
+				pDataInfo->OperandType = (EOperandType)item.Get(EJsonField::OperandType);
+			if (item.Has(EJsonField::ByteSize))
+				pDataInfo->ByteSize = (uint16_t)item.Get(EJsonField::ByteSize);
+			if (item.Has(EJsonField::Flags))
+				pDataInfo->Flags = (uint32_t)item.Get(EJsonField::Flags);
+			if (item.Has(EJsonField::Comment))
+				pDataInfo->Comment = item.Comment;
+			for (uint16_t read : item.Reads)
+				pDataInfo->Reads[read] = 1;
+			for (uint16_t write : item.Writes)
+				pDataInfo->Writes[write] = 1;
+
+			// Charmap specific
+			if (pDataInfo->DataType == EDataType::CharacterMap)
+			{
+				if (item.Has(EJsonField::CharSetAddress))
+					pDataInfo->CharSetAddress = (uint16_t)item.Get(EJsonField::CharSetAddress);
+				if (item.Has(EJsonField::EmptyCharNo))
+					pDataInfo->EmptyCharNo = (uint8_t)item.Get(EJsonField::EmptyCharNo);
+			}
+		}
+		break;
+		case EJsonSection::CharacterSets:
+		{
+			FCharSetCreateParams params;
+			params.Address = address;
+			params.AttribsAddress = (uint16_t)item.Get(EJsonField::AttribsAddress);
+			params.MaskInfo = (EMaskInfo)item.Get(EJsonField::MaskInfo);
+			params.ColourInfo = (EColourInfo)item.Get(EJsonField::ColourInfo);
+			params.bDynamic = item.Get(EJsonField::Dynamic) != 0;
+			CharacterSets.push_back(params);
+		}
+		break;
+		case EJsonSection::CharacterMaps:
+		{
+			FCharMapCreateParams params;
+			params.Address = address;
+			params.Width = (int)item.Get(EJsonField::Width);
+			params.Height = (int)item.Get(EJsonField::Height);
+			params.CharacterSet = (uint16_t)item.Get(EJsonField::CharacterSet);
+			params.IgnoreCharacter = (uint8_t)item.Get(EJsonField::IgnoreCharacter);
+			CharacterMaps.push_back(params);
+		}
+		break;
+		default:
+			break;
+		}
+	}
 
-		// one entry for each address in bank
-		jsonDoc["LastWriter"].push_back(curPage.LastWriter[pageAddr]);
+	FCodeAnalysisState&		State;
+	FCodeAnalysisPage*		pBankPages = nullptr;
 
-	}
-}
+	int						Depth = 0;
+	EJsonSection			Section = EJsonSection::Unknown;
+	EJsonField				Field = EJsonField::Unknown;
+	FJsonItem				Item;
 
+	std::vector<FBufferedItem>	Items;
+	std::vector<uint16_t>	Watches;
+	int						LastWriterStart = -1;
+	std::vector<uint16_t>	LastWriters;
+	std::vector<FCharSetCreateParams>	CharacterSets;
+	std::vector<FCharMapCreateParams>	CharacterMaps;
+};
 
-void ReadBankFromJson(FSpectrumEmu* pSpectrumEmu, int bankNo, const json& jsonDoc)
+static bool ReadJsonFile(const char* pJsonFileName, FAnalysisJsonReader& handler)
 {
-	const int bankPage = bankNo * 16;
+	FILE* fp = fopen(pJsonFileName, "rb");
+	if (fp == nullptr)
+		return false;
 
-	if (jsonDoc.contains("LastWriter"))
-	{
-		const json& lastWriterArray = jsonDoc["LastWriter"];
-		const int noWriters = (int)lastWriterArray.size();
-		for (int i = 0; i < noWriters; i++)
-		{
-			const uint16_t bankAddr = i;
-			const uint16_t pageNo = bankPage + (bankAddr / 1024);
-			const uint16_t pageAddr = bankAddr & 1023;
+	std::vector<char> buffer(kJsonStreamBufferSize);
+	rapidjson::FileReadStream stream(fp, buffer.data(), buffer.size());
+	rapidjson::Reader reader;
+	const rapidjson::ParseResult result = reader.Parse(stream, handler);
+	fclose(fp);
 
-			pSpectrumEmu->RAMPages[pageNo].LastWriter[pageAddr] = lastWriterArray[i];
-		}
+	if (result.IsError())
+	{
+		LOGERROR("Error parsing %s at offset %u: %s - nothing loaded", pJsonFileName, (unsigned)result.Offset(), rapidjson::GetParseError_En(result.Code()));
+		return false;
 	}
 
-	if (jsonDoc.contains("CommentBlocks"))
-	{
-		for (const auto commentBlockJson : jsonDoc["CommentBlocks"])
-		{
-			FCommentBlock* pCommentBlock = CreateCommentBlockFromJson(commentBlockJson);
+	handler.Apply();
+	return true;
+}
 
-			const uint16_t bankAddr = pCommentBlock->Address;
-			const uint16_t pageNo = bankPage + (bankAddr / 1024);
-			const uint16_t pageAddr = bankAddr & 1023;
+bool ImportAnalysisJson(FCodeAnalysisState& state, const char* pJsonFileName)
+{
+	FAnalysisJsonReader handler(state);
+	return ReadJsonFile(pJsonFileName, handler);
+}
 
-			pSpectrumEmu->RAMPages[pageNo].CommentBlocks[pageAddr] = pCommentBlock;
-		}
-	}
+// write a 16K bank to Json
+// the plan is to move to this so we can support 128K games
+void WriteBankToJson(const FSpectrumEmu* pSpectrumEmu, int bankNo, FJsonWriter& writer)
+{
+	const FCodeAnalysisPage* pBankPages = &pSpectrumEmu->RAMPages[bankNo * FSpectrumEmu::kNoBankPages];
+	auto getPage = [pBankPages](int bankAddr) { return &pBankPages[bankAddr >> FCodeAnalysisState::kPageShift]; };
 
-	if (jsonDoc.contains("LabelInfo"))
-	{
-		for (const auto labelInfoJson : jsonDoc["LabelInfo"])
-		{
-			FLabelInfo* pLabelInfo = CreateLabelInfoFromJson(labelInfoJson);
-			const uint16_t bankAddr = pLabelInfo->Address;
-			const uint16_t pageNo = bankPage + (bankAddr / 1024);
-			const uint16_t pageAddr = bankAddr & 1023;
+	writer.StartObject();
 
-			pSpectrumEmu->RAMPages[pageNo].Labels[pageAddr] = pLabelInfo;
-		}
-	}
+	// one entry for each address in bank
+	writer.Key("LastWriter");
+	writer.StartArray();
+	for (int bankAddr = 0; bankAddr < 0x4000; bankAddr++)
+		writer.Uint(getPage(bankAddr)->LastWriter[bankAddr & FCodeAnalysisState::kPageMask]);
+	writer.EndArray();
 
-	if (jsonDoc.contains("DataInfo"))
-	{
-		for (const auto dataInfoJson : jsonDoc["DataInfo"])
-		{
-			const uint16_t bankAddr = dataInfoJson["Address"];
-			const uint16_t pageNo = bankPage + (bankAddr / 1024);
-			const uint16_t pageAddr = bankAddr & 1023;
+	WriteItemArraysToJson(0, 0x3fff, getPage, true, writer);
 
-			FDataInfo* pDataInfo = &pSpectrumEmu->RAMPages[pageNo].DataInfo[pageAddr];
-			LoadDataInfoFromJson(pDataInfo, dataInfoJson);
-		}
-	}
-}
\ No newline at end of file
+	writer.EndObject();
+}
+
+bool ReadBankFromJson(FSpectrumEmu* pSpectrumEmu, int bankNo, const char* pJsonFileName)
+{
+	FAnalysisJsonReader handler(pSpectrumEmu->CodeAnalysis, &pSpectrumEmu->RAMPages[bankNo * FSpectrumEmu::kNoBankPages]);
+	return ReadJsonFile(pJsonFileName, handler);
+}
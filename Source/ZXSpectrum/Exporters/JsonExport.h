@@ -1,8 +1,10 @@
 #pragma once
 
 struct FCodeAnalysisState;
+struct FAnalysisSnapshot;
 class FSpectrumEmu;
 
 bool ExportROMJson(FCodeAnalysisState& state, const char* pJsonFileName);
 bool ExportGameJson(FSpectrumEmu* pSpectrumEmu, const char* pJsonFileName);
+bool ExportGameJson(FAnalysisSnapshot& snapshot, const char* pJsonFileName);	// can be called on a worker thread
 bool ImportAnalysisJson(FCodeAnalysisState& state, const char* pJsonFileName);
\ No newline at end of file
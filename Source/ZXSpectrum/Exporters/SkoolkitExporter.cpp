@@ -195,8 +195,7 @@ public:
 			
 			if (pCodeInfo != nullptr)
 			{
-				UpdateCodeInfoForAddress(State, addr); // what does this do again?
-				operationText = pCodeInfo->Text;
+				operationText = GetCodeInfoText(State, pCodeInfo);
 				pItem = pCodeInfo;
 			}
 			else if (pDataInfo != nullptr)
@@ -4,6 +4,7 @@
 #include "json.hpp"
 //#include "magic_enum.hpp"
 #include <iomanip>
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
@@ -60,6 +61,26 @@ bool SaveGameConfigToFile(const FGameConfig &config, const char *fname)
 		jsonConfigFile["SpriteConfigs"].push_back(spriteConfig);
 	}
 
+	// save cheats found with the cheat finder - .pok file cheats are loaded separately
+	for (const FCheat& cheat : config.Cheats)
+	{
+		if (cheat.bFromPOKFile)
+			continue;
+
+		json cheatJson;
+		cheatJson["Description"] = cheat.Description;
+		for (const FCheatMemoryEntry& entry : cheat.Entries)
+		{
+			json entryJson;
+			entryJson["Address"] = MakeHexString(entry.Address);
+			if (entry.Bank != -1)
+				entryJson["Bank"] = entry.Bank;
+			entryJson["Value"] = entry.Value;
+			cheatJson["Entries"].push_back(entryJson);
+		}
+		jsonConfigFile["Cheats"].push_back(cheatJson);
+	}
+
 	// save character sets
 
 	// save options
@@ -130,6 +151,22 @@ bool LoadGameConfigFromFile(FGameConfig &config, const char *fname)
 		sprConfig.Height = jsonSprConfig["Height"].get<int>();
 	}
 
+	for (const auto& cheatJson : jsonConfigFile["Cheats"])
+	{
+		FCheat cheat;
+		cheat.Description = cheatJson["Description"].get<std::string>();
+		for (const auto& entryJson : cheatJson["Entries"])
+		{
+			FCheatMemoryEntry entry;
+			entry.Address = ParseHexString16bit(entryJson["Address"].get<std::string>());
+			if (entryJson.contains("Bank"))
+				entry.Bank = entryJson["Bank"].get<int>();
+			entry.Value = entryJson["Value"].get<uint8_t>();
+			cheat.Entries.push_back(entry);
+		}
+		config.Cheats.push_back(cheat);
+	}
+
 	// load options
 	if (jsonConfigFile.contains("Options"))
 	{
@@ -178,7 +215,8 @@ bool LoadPOKFile(FGameConfig &config, const char *fname)
 	if (inFileStream.is_open() == false)
 		return false;
 
-	config.Cheats.clear();
+	// keep cheats from the game config
+	config.Cheats.erase(std::remove_if(config.Cheats.begin(), config.Cheats.end(), [](const FCheat& cheat) { return cheat.bFromPOKFile; }), config.Cheats.end());
 
 	// Read entire file 
 	std::ostringstream buffer;
@@ -200,6 +238,7 @@ bool LoadPOKFile(FGameConfig &config, const char *fname)
 
 				FCheat cheat;
 				cheat.Description = line.substr(1);
+				cheat.bFromPOKFile = true;
 				config.Cheats.push_back(cheat);
 				state = PokeReaderState::ProcessPokeEntries;
 				break;
@@ -216,6 +255,9 @@ bool LoadPOKFile(FGameConfig &config, const char *fname)
 				// todo deal with incorrect number of entries
 
 				FCheatMemoryEntry pokeEntry;
+				const int bank = std::stoi(tokens[1]);	// bit 3 set means no bank
+				if ((bank & 8) == 0)
+					pokeEntry.Bank = bank & 7;
 				pokeEntry.Address = std::stoi(tokens[2]);
 				uint16_t value = std::stoi(tokens[3]);
 
@@ -16,6 +16,7 @@ struct FGameSnapshot;
 struct FCheatMemoryEntry
 {
 	uint16_t	Address;
+	int			Bank = -1;	// 128K RAM bank to write to whatever is paged in, -1 to write to Address as currently paged
 	uint8_t		Value;
 	uint8_t		OldValue;
 	bool		bUserDefined = false;
@@ -27,6 +28,7 @@ struct FCheat
 	std::string						Description;
 	bool							bEnabled = false;
 	bool							bHasUserDefinedEntries = false;
+	bool							bFromPOKFile = false;	// only cheats found in the analyser are saved in the config
 	std::vector< FCheatMemoryEntry>	Entries;
 };
 
@@ -13,10 +13,17 @@
 #include "GameConfig.h"
 #include "Debug/DebugLog.h"
 #include "Util/Misc.h"
+#include "Util/MemoryBuffer.h"
 #include <Util/GraphicsView.h>
+#include "CodeAnalyser/AnalysisSnapshot.h"
 
-static const int g_kBinaryFileVersionNo = 17;
+#include <zlib.h>
+
+static const int g_kBinaryFileVersionNo = 18;
+static const int g_kChunkedFileVersionNo = 18;	// first version using the compressed section format
 static const int g_kBinaryFileMagic = 0xdeadface;
+static constexpr uint32_t g_kMachineStateMagic = MakeFourCC("ZXMS");
+static const int g_kMachineStateVersionNo = 1;
 
 const char *GetLabelEnumString(ELabelType labelType)
 {
@@ -87,9 +94,59 @@ EDataType GetDataEnumValue(const char* pString)
 	return EDataType::None;
 }
 
+// Strings are stored with an int length, as the original file based format did
+static void WriteStringToBuffer(const std::string& str, FMemoryBuffer& buffer)
+{
+	buffer.Write<int>((int)str.size());
+	buffer.WriteBytes(str.c_str(), str.size());
+}
+
+static void ReadStringFromBuffer(std::string& str, FMemoryBuffer& buffer)
+{
+	const int stringLength = buffer.Read<int>();
+	str.resize(stringLength > 0 ? stringLength : 0);
+	if (stringLength > 0)
+		buffer.ReadBytes(&str[0], stringLength);
+}
+
+// Write references from the region we are saving
+static void WriteReferencesToBuffer(const FCodeReferenceSet& references, FMemoryBuffer& buffer, uint16_t startAddress, uint16_t endAddress)
+{
+	int noReferences = 0;
+	for (const auto& ref : references)
+	{
+		if (ref.first >= startAddress && ref.first <= endAddress)
+			noReferences++;
+	}
+
+	buffer.Write<int>(noReferences);
+	for (const auto& ref : references)
+	{
+		if (ref.first >= startAddress && ref.first <= endAddress)
+			buffer.Write<uint16_t>(ref.first);
+	}
+}
+
+// Last Writers
+
+void SaveLastWritersBin(const FCodeAnalysisState& state, FMemoryBuffer& buffer, uint16_t startAddress, uint16_t endAddress)
+{
+	for (int i = startAddress; i <= endAddress; i++)
+	{
+		const uint16_t addr = state.GetLastWriterForAddress(i);
+		buffer.Write<uint16_t>(addr >= startAddress && addr <= endAddress ? addr : 0);
+	}
+}
+
+void LoadLastWritersBin(FCodeAnalysisState& state, FMemoryBuffer& buffer, uint16_t startAddress, uint16_t endAddress)
+{
+	for (int i = startAddress; i <= endAddress; i++)
+		state.SetLastWriterForAddress(i, buffer.Read<uint16_t>());
+}
+
 // Labels
 
-void SaveLabelsBin(const FCodeAnalysisState& state, FILE* fp, uint16_t startAddress, uint16_t endAddress)
+void SaveLabelsBin(const FCodeAnalysisState& state, FMemoryBuffer& buffer, uint16_t startAddress, uint16_t endAddress)
 {
 	int recordCount = 0;
 	for (int i = startAddress; i <= endAddress; i++)
@@ -98,81 +155,52 @@ void SaveLabelsBin(const FCodeAnalysisState& state, FILE* fp, uint16_t startAddr
 			recordCount++;
 	}
 
-	fwrite(&recordCount, sizeof(int), 1, fp);
+	buffer.Write<int>(recordCount);
 
 	for (int i = startAddress; i <= endAddress; i++)
 	{
 		const FLabelInfo* pLabel = state.GetLabelForAddress(i);
 		if (pLabel != nullptr)
 		{
-			const std::string funcName = GetLabelEnumString(pLabel->LabelType);
-			//const std::string meName = std::string(magic_enum::enum_name(pLabel->LabelType));
-			//assert(meName == funcName);
-			WriteStringToFile(funcName, fp);
-			fwrite(&pLabel->Address, sizeof(pLabel->Address), 1, fp);
-			fwrite(&pLabel->ByteSize, sizeof(pLabel->ByteSize), 1, fp);
-			WriteStringToFile(pLabel->Name, fp);
-			WriteStringToFile(pLabel->Comment, fp);
-			fwrite(&pLabel->Global, sizeof(bool), 1, fp);
-
-			// References?
-			long refCountPos = ftell(fp);
-			int noReferences = (int)pLabel->References.size();
-			fwrite(&noReferences, sizeof(int), 1, fp);
-			noReferences = 0;
-			for (const auto& ref : pLabel->References)
-			{
-				const uint16_t refAddr = ref.first;
-				if (refAddr >= startAddress && refAddr <= endAddress)	// only add references from region we are saving
-				{
-					fwrite(&refAddr, sizeof(refAddr), 1, fp);
-					noReferences++;
-				}
-			}
-
-			// fix up reference count
-			fseek(fp, refCountPos, SEEK_SET);
-			fwrite(&noReferences, sizeof(int), 1, fp);	// new reference count
-			fseek(fp, 0, SEEK_END);	// point back to end of file
+			WriteStringToBuffer(GetLabelEnumString(pLabel->LabelType), buffer);
+			buffer.Write(pLabel->Address);
+			buffer.Write(pLabel->ByteSize);
+			WriteStringToBuffer(pLabel->Name, buffer);
+			WriteStringToBuffer(pLabel->Comment, buffer);
+			buffer.Write<bool>(pLabel->Global);
+			WriteReferencesToBuffer(pLabel->References, buffer, startAddress, endAddress);
 		}
 	}
 }
 
-void LoadLabelsBin(FCodeAnalysisState& state, FILE* fp, int versionNo, uint16_t startAddress, uint16_t endAddress)
+void LoadLabelsBin(FCodeAnalysisState& state, FMemoryBuffer& buffer, int versionNo, uint16_t startAddress, uint16_t endAddress)
 {
-	int recordCount = 0;
-
 	state.ResetLabelNames();
 
-	fread(&recordCount, sizeof(int), 1, fp);
+	const int recordCount = buffer.Read<int>();
 
 	for (int i = 0; i < recordCount; i++)
 	{
 		FLabelInfo* pLabel = FLabelInfo::Allocate();
 
 		std::string enumVal;
-		ReadStringFromFile(enumVal, fp);
-		const ELabelType funcType = GetLabelEnumValue(enumVal.c_str());
-		//const ELabelType meType = magic_enum::enum_cast<ELabelType>(enumVal).value();
-		//assert(meType == funcType);
-		pLabel->LabelType = funcType;
-		fread(&pLabel->Address, sizeof(pLabel->Address), 1, fp);
-		fread(&pLabel->ByteSize, sizeof(pLabel->ByteSize), 1, fp);
-		ReadStringFromFile(pLabel->Name, fp);
-		ReadStringFromFile(pLabel->Comment, fp);
+		ReadStringFromBuffer(enumVal, buffer);
+		pLabel->LabelType = GetLabelEnumValue(enumVal.c_str());
+		buffer.Read(pLabel->Address);
+		buffer.Read(pLabel->ByteSize);
+		ReadStringFromBuffer(pLabel->Name, buffer);
+		ReadStringFromBuffer(pLabel->Comment, buffer);
 
 		if (versionNo > 2)
-			fread(&pLabel->Global, sizeof(bool), 1, fp);
+			buffer.Read(pLabel->Global);
 
 		// References?
 		if (versionNo > 1)
 		{
-			int noReferences = 0;
-			fread(&noReferences, sizeof(int), 1, fp);
+			const int noReferences = buffer.Read<int>();
 			for (int i = 0; i < noReferences; i++)
 			{
-				uint16_t refAddr;
-				fread(&refAddr, sizeof(refAddr), 1, fp);
+				const uint16_t refAddr = buffer.Read<uint16_t>();
 				if (refAddr >= startAddress && refAddr <= endAddress)
 				{
 					pLabel->References[refAddr] = 1;
@@ -190,7 +218,7 @@ void LoadLabelsBin(FCodeAnalysisState& state, FILE* fp, int versionNo, uint16_t
 
 // Code Info
 
-void SaveCodeInfoBin(const FCodeAnalysisState& state, FILE* fp, uint16_t startAddress, uint16_t endAddress)
+void SaveCodeInfoBin(const FCodeAnalysisState& state, FMemoryBuffer& buffer, uint16_t startAddress, uint16_t endAddress)
 {
 	int recordCount = 0;
 	for (int i = startAddress; i <= endAddress; i++)
@@ -199,48 +227,46 @@ void SaveCodeInfoBin(const FCodeAnalysisState& state, FILE* fp, uint16_t startAd
 			recordCount++;
 	}
 
-	fwrite(&recordCount, sizeof(int), 1, fp);
+	buffer.Write<int>(recordCount);
 
 	for (int i = startAddress; i <= endAddress; i++)
 	{
 		const FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(i);
 		if (pCodeInfo != nullptr)
 		{
-			fwrite(&pCodeInfo->OperandType, sizeof(pCodeInfo->OperandType), 1, fp);
-			fwrite(&pCodeInfo->Flags, sizeof(pCodeInfo->Flags), 1, fp);
-			fwrite(&pCodeInfo->Address, sizeof(pCodeInfo->Address), 1, fp);
-			fwrite(&pCodeInfo->ByteSize, sizeof(pCodeInfo->ByteSize), 1, fp);
-			WriteStringToFile(pCodeInfo->Comment, fp);
+			buffer.Write(pCodeInfo->OperandType);
+			buffer.Write(pCodeInfo->Flags);
+			buffer.Write(pCodeInfo->Address);
+			buffer.Write(pCodeInfo->ByteSize);
+			WriteStringToBuffer(pCodeInfo->Comment, buffer);
 		}
 	}
 }
 
-void LoadCodeInfoBin(FCodeAnalysisState& state, FILE* fp, int versionNo, uint16_t startAddress, uint16_t endAddress)
+void LoadCodeInfoBin(FCodeAnalysisState& state, FMemoryBuffer& buffer, int versionNo, uint16_t startAddress, uint16_t endAddress)
 {
-	int recordCount;
-	fread(&recordCount, sizeof(int), 1, fp);
+	const int recordCount = buffer.Read<int>();
 
 	for (int i = 0; i < recordCount; i++)
 	{
 		FCodeInfo* pCodeInfo = FCodeInfo::Allocate();
 
 		if (versionNo > 8)
-			fread(&pCodeInfo->OperandType, sizeof(pCodeInfo->OperandType), 1, fp);
+			buffer.Read(pCodeInfo->OperandType);
 
 		if (versionNo >= 4)
-			fread(&pCodeInfo->Flags, sizeof(pCodeInfo->Flags), 1, fp);
+			buffer.Read(pCodeInfo->Flags);
 
-		fread(&pCodeInfo->Address, sizeof(pCodeInfo->Address), 1, fp);
-		fread(&pCodeInfo->ByteSize, sizeof(pCodeInfo->ByteSize), 1, fp);
+		buffer.Read(pCodeInfo->Address);
+		buffer.Read(pCodeInfo->ByteSize);
 		if (versionNo < 10)
 		{
-			fread(&pCodeInfo->JumpAddress, sizeof(pCodeInfo->JumpAddress), 1, fp);
-			fread(&pCodeInfo->PointerAddress, sizeof(pCodeInfo->PointerAddress), 1, fp);
+			buffer.Read(pCodeInfo->JumpAddress);
+			buffer.Read(pCodeInfo->PointerAddress);
 			std::string tmp;
-			ReadStringFromFile(tmp, fp);
+			ReadStringFromBuffer(tmp, buffer);
 		}
-		//ReadStringFromFile(pCodeInfo->Text, fp);
-		ReadStringFromFile(pCodeInfo->Comment, fp);
+		ReadStringFromBuffer(pCodeInfo->Comment, buffer);
 		for (int codeByte = 0; codeByte < pCodeInfo->ByteSize; codeByte++)	// set for whole instruction address range
 			state.SetCodeInfoForAddress(pCodeInfo->Address + codeByte, pCodeInfo);
 	}
@@ -248,7 +274,7 @@ void LoadCodeInfoBin(FCodeAnalysisState& state, FILE* fp, int versionNo, uint16_
 
 // Data Info
 
-void SaveDataInfoBin(const FCodeAnalysisState& state, FILE* fp, uint16_t startAddress, uint16_t endAddress)
+void SaveDataInfoBin(const FCodeAnalysisState& state, FMemoryBuffer& buffer, uint16_t startAddress, uint16_t endAddress)
 {
 	int recordCount = 0;
 	for (int i = startAddress; i <= endAddress; i++)
@@ -257,90 +283,46 @@ void SaveDataInfoBin(const FCodeAnalysisState& state, FILE* fp, uint16_t startAd
 			recordCount++;
 	}
 
-	fwrite(&recordCount, sizeof(int), 1, fp);
+	buffer.Write<int>(recordCount);
 
 	for (int i = startAddress; i <= endAddress; i++)
 	{
 		const FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(i);
 		if (pDataInfo != nullptr)
 		{
-			const std::string funcName = GetDataEnumString(pDataInfo->DataType);
-			//const std::string meName = std::string(magic_enum::enum_name(pDataInfo->DataType));
-			//assert(meName == funcName);
-			WriteStringToFile(funcName, fp);
-			fwrite(&pDataInfo->Address, sizeof(pDataInfo->Address), 1, fp);
-			fwrite(&pDataInfo->ByteSize, sizeof(pDataInfo->ByteSize), 1, fp);
-			fwrite(&pDataInfo->Flags, sizeof(pDataInfo->Flags), 1, fp);
-			fwrite(&pDataInfo->CharSetAddress, sizeof(pDataInfo->CharSetAddress), 1, fp);
-			fwrite(&pDataInfo->OperandType, sizeof(pDataInfo->OperandType), 1, fp);
-			fwrite(&pDataInfo->EmptyCharNo, sizeof(pDataInfo->EmptyCharNo), 1, fp);
-			WriteStringToFile(pDataInfo->Comment, fp);
-
-			// Reads & Writes?
-			int noReads = 0;
-			const long noReadsFilePos = ftell(fp);
-			fwrite(&noReads, sizeof(int), 1, fp);
-			for (const auto& ref : pDataInfo->Reads)
-			{
-				const uint16_t refAddr = ref.first;
-				if (refAddr >= startAddress && refAddr <= endAddress)
-				{
-					fwrite(&refAddr, sizeof(refAddr), 1, fp);
-					noReads++;
-				}
-			}
-
-			// patch number of reads
-			fseek(fp, noReadsFilePos, SEEK_SET);
-			fwrite(&noReads, sizeof(int), 1, fp);
-			fseek(fp, 0, SEEK_END);
-
-
-			int noWrites = 0;
-			const long noWritesFilePos = ftell(fp);
-			fwrite(&noWrites, sizeof(int), 1, fp);
-			for (const auto& ref : pDataInfo->Writes)
-			{
-				const uint16_t refAddr = ref.first;
-				if (refAddr >= startAddress && refAddr <= endAddress)
-				{
-					fwrite(&refAddr, sizeof(refAddr), 1, fp);
-					noWrites++;
-				}
-			}
-
-			// patch number of writes
-			fseek(fp, noWritesFilePos, SEEK_SET);
-			fwrite(&noWrites, sizeof(int), 1, fp);
-			fseek(fp, 0, SEEK_END);
+			WriteStringToBuffer(GetDataEnumString(pDataInfo->DataType), buffer);
+			buffer.Write(pDataInfo->Address);
+			buffer.Write(pDataInfo->ByteSize);
+			buffer.Write(pDataInfo->Flags);
+			buffer.Write(pDataInfo->CharSetAddress);
+			buffer.Write(pDataInfo->OperandType);
+			buffer.Write(pDataInfo->EmptyCharNo);
+			WriteStringToBuffer(pDataInfo->Comment, buffer);
+
+			// Reads & Writes
+			WriteReferencesToBuffer(pDataInfo->Reads, buffer, startAddress, endAddress);
+			WriteReferencesToBuffer(pDataInfo->Writes, buffer, startAddress, endAddress);
 		}
 	}
-
-
 }
 
-void LoadDataInfoBin(FCodeAnalysisState& state, FILE* fp, int versionNo, uint16_t startAddress, uint16_t endAddress)
+void LoadDataInfoBin(FCodeAnalysisState& state, FMemoryBuffer& buffer, int versionNo, uint16_t startAddress, uint16_t endAddress)
 {
-	int recordCount;
-	fread(&recordCount, sizeof(int), 1, fp);
+	const int recordCount = buffer.Read<int>();
 
 	for (int i = 0; i < recordCount; i++)
 	{
 		std::string enumVal;
-		ReadStringFromFile(enumVal, fp);
-		uint16_t address = 0;
-		fread(&address, sizeof(address), 1, fp);
+		ReadStringFromBuffer(enumVal, buffer);
+		const uint16_t address = buffer.Read<uint16_t>();
 
 		FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(address);
 		pDataInfo->Address = address;
-		const EDataType funcType = GetDataEnumValue(enumVal.c_str());
-		//const EDataType meType = magic_enum::enum_cast<EDataType>(enumVal).value();
-		//assert(funcType == meType);
-		pDataInfo->DataType = funcType;
-		fread(&pDataInfo->ByteSize, sizeof(pDataInfo->ByteSize), 1, fp);
+		pDataInfo->DataType = GetDataEnumValue(enumVal.c_str());
+		buffer.Read(pDataInfo->ByteSize);
 		if (versionNo > 5)
 		{
-			fread(&pDataInfo->Flags, sizeof(pDataInfo->Flags), 1, fp);
+			buffer.Read(pDataInfo->Flags);
 			if (pDataInfo->bShowCharMap)
 			{
 				pDataInfo->DataType = EDataType::CharacterMap;
@@ -356,26 +338,24 @@ void LoadDataInfoBin(FCodeAnalysisState& state, FILE* fp, int versionNo, uint16_
 
 		if (versionNo > 10)
 		{
-			fread(&pDataInfo->CharSetAddress, sizeof(pDataInfo->CharSetAddress), 1, fp);
-			fread(&pDataInfo->OperandType, sizeof(pDataInfo->OperandType), 1, fp);
+			buffer.Read(pDataInfo->CharSetAddress);
+			buffer.Read(pDataInfo->OperandType);
 		}
 
 		if (versionNo > 12)
 		{
-			fread(&pDataInfo->EmptyCharNo, sizeof(pDataInfo->EmptyCharNo), 1, fp);
+			buffer.Read(pDataInfo->EmptyCharNo);
 		}
 
-		ReadStringFromFile(pDataInfo->Comment, fp);
+		ReadStringFromBuffer(pDataInfo->Comment, buffer);
 
 		// References?
 		if (versionNo > 1)
 		{
-			int noReads;
-			fread(&noReads, sizeof(int), 1, fp);
+			const int noReads = buffer.Read<int>();
 			for (int i = 0; i < noReads; i++)
 			{
-				uint16_t dataAddr;
-				fread(&dataAddr, sizeof(uint16_t), 1, fp);
+				const uint16_t dataAddr = buffer.Read<uint16_t>();
 				if (dataAddr >= startAddress && dataAddr <= endAddress)
 					pDataInfo->Reads[dataAddr] = 1;
 				else
@@ -384,25 +364,22 @@ void LoadDataInfoBin(FCodeAnalysisState& state, FILE* fp, int versionNo, uint16_
 		}
 		if (versionNo > 2)
 		{
-			int noWrites;
-			fread(&noWrites, sizeof(int), 1, fp);
+			const int noWrites = buffer.Read<int>();
 			for (int i = 0; i < noWrites; i++)
 			{
-				uint16_t dataAddr;
-				fread(&dataAddr, sizeof(uint16_t), 1, fp);
+				const uint16_t dataAddr = buffer.Read<uint16_t>();
 				if (dataAddr >= startAddress && dataAddr <= endAddress)
 					pDataInfo->Writes[dataAddr] = 1;
 				else
 					LOGWARNING("LoadDataInfoBin: Address %x outside of range", dataAddr);
 			}
 		}
-
-		//state.SetReadDataInfoForAddress(pDataInfo->Address, pDataInfo);
-		//state.SetWriteDataInfoForAddress(pDataInfo->Address, pDataInfo);
 	}
 }
 
-void SaveCommentBlocksBin(const FCodeAnalysisState& state, FILE* fp, uint16_t startAddress, uint16_t endAddress)
+// Comment Blocks
+
+void SaveCommentBlocksBin(const FCodeAnalysisState& state, FMemoryBuffer& buffer, uint16_t startAddress, uint16_t endAddress)
 {
 	int recordCount = 0;
 	for (int i = startAddress; i <= endAddress; i++)
@@ -411,224 +388,154 @@ void SaveCommentBlocksBin(const FCodeAnalysisState& state, FILE* fp, uint16_t st
 			recordCount++;
 	}
 
-	fwrite(&recordCount, sizeof(int), 1, fp);
+	buffer.Write<int>(recordCount);
 
 	for (int i = startAddress; i <= endAddress; i++)
 	{
 		const FCommentBlock* pCommentBlock = state.GetCommentBlockForAddress(i);
 		if (pCommentBlock != nullptr)
 		{
-			fwrite(&pCommentBlock->Address, sizeof(pCommentBlock->Address), 1, fp);
-			WriteStringToFile(pCommentBlock->Comment, fp);
+			buffer.Write(pCommentBlock->Address);
+			WriteStringToBuffer(pCommentBlock->Comment, buffer);
 		}
 	}
 }
 
-void LoadCommentBlocksBin(FCodeAnalysisState& state, FILE* fp, int versionNo, uint16_t startAddress, uint16_t endAddress)
+void LoadCommentBlocksBin(FCodeAnalysisState& state, FMemoryBuffer& buffer, int versionNo, uint16_t startAddress, uint16_t endAddress)
 {
-	int recordCount;
-	fread(&recordCount, sizeof(int), 1, fp);
+	const int recordCount = buffer.Read<int>();
 
 	for (int i = 0; i < recordCount; i++)
 	{
 		FCommentBlock* pCommentBlock = FCommentBlock::Allocate();
-		fread(&pCommentBlock->Address, sizeof(pCommentBlock->Address), 1, fp);
-		ReadStringFromFile(pCommentBlock->Comment, fp);
+		buffer.Read(pCommentBlock->Address);
+		ReadStringFromBuffer(pCommentBlock->Comment, buffer);
 		state.SetCommentBlockForAddress(pCommentBlock->Address, pCommentBlock);
 	}
 }
 
+// Watches
 
-
-// Binary save
-void SaveGameDataBin(const FCodeAnalysisState& state, FILE *fp, uint16_t addrStart, uint16_t addrEnd)
+void SaveWatchesBin(const FCodeAnalysisState& state, FMemoryBuffer& buffer, uint16_t startAddress, uint16_t endAddress)
 {
-	fwrite(&g_kBinaryFileMagic, sizeof(int), 1, fp);
-	fwrite(&g_kBinaryFileVersionNo, sizeof(int), 1, fp);
-
-	fwrite(&addrStart, sizeof(uint16_t), 1, fp);	// write memory range of this block
-	fwrite(&addrEnd, sizeof(uint16_t), 1, fp);
-
-	for (int i = addrStart; i <= addrEnd; i++)
+	int noWatches = 0;
+	for (const auto& watch : state.GetWatches())
 	{
-		const uint16_t invalid = 0;
-		const uint16_t addr = state.GetLastWriterForAddress(i);
-		if (addr >= addrStart && addr <= addrEnd)
-			fwrite(&addr, sizeof(uint16_t), 1, fp);
-		else
-			fwrite(&invalid, sizeof(uint16_t), 1, fp);
+		if (watch >= startAddress && watch <= endAddress)
+			noWatches++;
 	}
 
-	SaveLabelsBin(state, fp, addrStart, addrEnd);
-	SaveCodeInfoBin(state, fp, addrStart, addrEnd);
-	SaveDataInfoBin(state, fp, addrStart, addrEnd);
-	SaveCommentBlocksBin(state, fp, addrStart, addrEnd);
-
-	// Save Watches
-	int noWatches = 0;// (int)state.GetWatches().size();
-	const long noWatchPos = ftell(fp);
-	fwrite(&noWatches, sizeof(noWatches), 1, fp);
-
+	buffer.Write<int>(noWatches);
 	for (const auto& watch : state.GetWatches())
 	{
-		if (watch >= addrStart && watch <= addrEnd)
-		{
-			fwrite(&watch, sizeof(uint16_t), 1, fp);
-			noWatches++;
-		}
+		if (watch >= startAddress && watch <= endAddress)
+			buffer.Write<uint16_t>(watch);
 	}
+}
 
-	// patch up watch count
-	fseek(fp, noWatchPos, SEEK_SET);
-	fwrite(&noWatches, sizeof(noWatches), 1, fp);
-	fseek(fp, 0, SEEK_END);
+void LoadWatchesBin(FCodeAnalysisState& state, FMemoryBuffer& buffer, uint16_t startAddress, uint16_t endAddress)
+{
+	const int noWatches = buffer.Read<int>();
 
-	// Save char sets
+	for (int i = 0; i < noWatches; i++)
 	{
-		int noCharSets = 0;
-		const long noCharSetsPos = ftell(fp);
-		fwrite(&noCharSets, sizeof(noCharSets), 1, fp);
+		const uint16_t watch = buffer.Read<uint16_t>();
+		if (watch >= startAddress && watch <= endAddress)
+			state.AddWatch(watch);
+	}
+}
 
-		for (int i = 0; i < GetNoCharacterSets(); i++)
-		{
-			const FCharacterSet* pCharSet = GetCharacterSetFromIndex(i);
-			const uint16_t addr = pCharSet->Params.Address;
-			if (addr >= addrStart && addr <= addrEnd)
-			{
-				EColourInfo		ColourInfo = EColourInfo::None;
-				fwrite(&pCharSet->Params.Address, sizeof(pCharSet->Params.Address), 1, fp);
-				fwrite(&pCharSet->Params.AttribsAddress, sizeof(pCharSet->Params.AttribsAddress), 1, fp);
-				fwrite(&pCharSet->Params.MaskInfo, sizeof(pCharSet->Params.MaskInfo), 1, fp);
-				fwrite(&pCharSet->Params.ColourInfo, sizeof(pCharSet->Params.ColourInfo), 1, fp);
-				fwrite(&pCharSet->Params.bDynamic, sizeof(pCharSet->Params.bDynamic), 1, fp);
-				noCharSets++;
-			}
-		}
+// Character Sets
 
-		// patch up char set count
-		fseek(fp, noCharSetsPos, SEEK_SET);
-		fwrite(&noCharSets, sizeof(noCharSets), 1, fp);
-		fseek(fp, 0, SEEK_END);
+void SaveCharacterSetsBin(const std::vector<FCharSetCreateParams>& charSets, FMemoryBuffer& buffer, uint16_t startAddress, uint16_t endAddress)
+{
+	int noCharSets = 0;
+	for (const FCharSetCreateParams& params : charSets)
+	{
+		if (params.Address >= startAddress && params.Address <= endAddress)
+			noCharSets++;
 	}
 
-	// Save char maps
+	buffer.Write<int>(noCharSets);
+	for (const FCharSetCreateParams& params : charSets)
 	{
-		int noCharMaps = 0;
-		const long noCharMapsPos = ftell(fp);
-		fwrite(&noCharMaps, sizeof(noCharMaps), 1, fp);
-
-		for (int i = 0; i < GetNoCharacterMaps(); i++)
+		if (params.Address >= startAddress && params.Address <= endAddress)
 		{
-			const FCharacterMap* pCharMap = GetCharacterMapFromIndex(i);
-			const uint16_t addr = pCharMap->Params.Address;
-			if (addr >= addrStart && addr <= addrEnd)
-			{
-				fwrite(&pCharMap->Params.Address, sizeof(pCharMap->Params.Address), 1, fp);
-				fwrite(&pCharMap->Params.Width, sizeof(pCharMap->Params.Width), 1, fp);
-				fwrite(&pCharMap->Params.Height, sizeof(pCharMap->Params.Height), 1, fp);
-				fwrite(&pCharMap->Params.CharacterSet, sizeof(pCharMap->Params.CharacterSet), 1, fp);
-				fwrite(&pCharMap->Params.IgnoreCharacter, sizeof(pCharMap->Params.IgnoreCharacter), 1, fp);
-				noCharMaps++;
-			}
+			buffer.Write(params.Address);
+			buffer.Write(params.AttribsAddress);
+			buffer.Write(params.MaskInfo);
+			buffer.Write(params.ColourInfo);
+			buffer.Write(params.bDynamic);
 		}
-
-		// patch up char set count
-		fseek(fp, noCharMapsPos, SEEK_SET);
-		fwrite(&noCharMaps, sizeof(noCharMaps), 1, fp);
-		fseek(fp, 0, SEEK_END);
 	}
 }
 
-// Binary load
-void LoadGameDataBin(FCodeAnalysisState& state, FILE *fp, int versionNo, uint16_t addrStart, uint16_t addrEnd)
+void LoadCharacterSetsBin(FCodeAnalysisState& state, FMemoryBuffer& buffer, int versionNo)
 {
-	if (versionNo >= 8)
-	{
-		fread(&addrStart, sizeof(uint16_t), 1, fp);
-		fread(&addrEnd, sizeof(uint16_t), 1, fp);
+	const int noCharSets = buffer.Read<int>();
 
-		for (int i = addrStart; i <= addrEnd; i++)
+	for (int i = 0; i < noCharSets; i++)
+	{
+		FCharSetCreateParams params;
+		buffer.Read(params.Address);
+		if (versionNo > 11)
 		{
-			uint16_t lastWriter;
-			fread(&lastWriter, sizeof(uint16_t), 1, fp);
-			state.SetLastWriterForAddress(i, lastWriter);
+			buffer.Read(params.AttribsAddress);
+			buffer.Read(params.MaskInfo);
+			buffer.Read(params.ColourInfo);
 		}
-	}
-	else if (versionNo >= 4)
-	{
-		for (int i = 0; i < (1 << 16); i++)
+		if (versionNo > 14)
 		{
-			uint16_t lastWriter;
-			fread(&lastWriter, sizeof(uint16_t), 1, fp);
-			state.SetLastWriterForAddress(i, lastWriter);
+			buffer.Read(params.bDynamic);
 		}
+		CreateCharacterSetAt(state, params);
 	}
+}
 
-	LoadLabelsBin(state, fp, versionNo, addrStart, addrEnd);
-	LoadCodeInfoBin(state, fp, versionNo, addrStart, addrEnd);
-	LoadDataInfoBin(state, fp, versionNo, addrStart, addrEnd);
-	if (versionNo >= 5)
-		LoadCommentBlocksBin(state, fp, versionNo, addrStart, addrEnd);
+// Character Maps
 
-	// watches
-	if (versionNo >= 7)
+void SaveCharacterMapsBin(const std::vector<FCharMapCreateParams>& charMaps, FMemoryBuffer& buffer, uint16_t startAddress, uint16_t endAddress)
+{
+	int noCharMaps = 0;
+	for (const FCharMapCreateParams& params : charMaps)
 	{
-		int noWatches;
-		fread(&noWatches, sizeof(noWatches), 1, fp);
-
-		for (int i = 0; i < noWatches; i++)
-		{
-			uint16_t watch;
-			fread(&watch, sizeof(uint16_t), 1, fp);
-			if (watch >= addrStart && watch <= addrEnd)
-				state.AddWatch(watch);
-		}
+		if (params.Address >= startAddress && params.Address <= endAddress)
+			noCharMaps++;
 	}
 
-	// char sets
-	if (versionNo > 10)
+	buffer.Write<int>(noCharMaps);
+	for (const FCharMapCreateParams& params : charMaps)
 	{
-		int noCharSets;
-		fread(&noCharSets, sizeof(noCharSets), 1, fp);
-
-		for (int i = 0; i < noCharSets; i++)
+		if (params.Address >= startAddress && params.Address <= endAddress)
 		{
-			FCharSetCreateParams params;
-			fread(&params.Address, sizeof(params.Address), 1, fp);
-			if (versionNo > 11)
-			{
-				fread(&params.AttribsAddress, sizeof(params.AttribsAddress), 1, fp);
-				fread(&params.MaskInfo, sizeof(params.MaskInfo), 1, fp);
-				fread(&params.ColourInfo, sizeof(params.ColourInfo), 1, fp);
-			}
-			if (versionNo > 14)
-			{
-				fread(&params.bDynamic, sizeof(params.bDynamic), 1, fp);
-			}
-			CreateCharacterSetAt(state, params);
+			buffer.Write(params.Address);
+			buffer.Write(params.Width);
+			buffer.Write(params.Height);
+			buffer.Write(params.CharacterSet);
+			buffer.Write(params.IgnoreCharacter);
 		}
 	}
+}
 
-	// char maps
-	if (versionNo > 13)
-	{
-		int noCharMaps;
-		fread(&noCharMaps, sizeof(noCharMaps), 1, fp);
+void LoadCharacterMapsBin(FCodeAnalysisState& state, FMemoryBuffer& buffer)
+{
+	const int noCharMaps = buffer.Read<int>();
 
-		for (int i = 0; i < noCharMaps; i++)
-		{
-			FCharMapCreateParams params;
-			fread(&params.Address, sizeof(params.Address), 1, fp);
-			fread(&params.Width, sizeof(params.Width), 1, fp);
-			fread(&params.Height, sizeof(params.Height), 1, fp);
-			fread(&params.CharacterSet, sizeof(params.CharacterSet), 1, fp);
-			fread(&params.IgnoreCharacter, sizeof(params.IgnoreCharacter), 1, fp);
-			CreateCharacterMap(state, params);
-		}
+	for (int i = 0; i < noCharMaps; i++)
+	{
+		FCharMapCreateParams params;
+		buffer.Read(params.Address);
+		buffer.Read(params.Width);
+		buffer.Read(params.Height);
+		buffer.Read(params.CharacterSet);
+		buffer.Read(params.IgnoreCharacter);
+		CreateCharacterMap(state, params);
 	}
 }
 
-void SaveMachineState(FSpectrumEmu* pSpectrumEmu, FILE *fp)
+// Machine State
+
+void SaveMachineState(FSpectrumEmu* pSpectrumEmu, FMemoryBuffer& buffer)
 {
 	FCodeAnalysisState& state = pSpectrumEmu->CodeAnalysis;
 	FGameConfig& config = *pSpectrumEmu->pActiveGame->pConfig;
@@ -640,7 +547,7 @@ void SaveMachineState(FSpectrumEmu* pSpectrumEmu, FILE *fp)
 		{
 			if (cheat.bEnabled)	// cheat activated so revert
 			{
-				pSpectrumEmu->WriteByte(entry.Address, entry.OldValue);
+				pSpectrumEmu->WriteCheatByte(entry, entry.OldValue);
 				cheat.bEnabled = false;
 			}
 		}
@@ -660,163 +567,479 @@ void SaveMachineState(FSpectrumEmu* pSpectrumEmu, FILE *fp)
 		}
 	}
 
-	// copy memory
-	for (int i = 0; i < 1 << 16; i++)
-	{
-		const uint8_t memByte = pSpectrumEmu->ReadByte(i);
-		fwrite(&memByte, sizeof(memByte), 1, fp);
-	}
-
-	// get CPU state
-	//z80_t* pCPUState = (z80_t*)frame.CPUState;
-	fwrite(&pSpectrumEmu->ZXEmuState.cpu.bc_de_hl_fa, sizeof(uint64_t), 1, fp);
-	fwrite(&pSpectrumEmu->ZXEmuState.cpu.bc_de_hl_fa_, sizeof(uint64_t), 1, fp);
-	fwrite(&pSpectrumEmu->ZXEmuState.cpu.wz_ix_iy_sp, sizeof(uint64_t), 1, fp);
-	fwrite(&pSpectrumEmu->ZXEmuState.cpu.im_ir_pc_bits, sizeof(uint64_t), 1, fp);
-	fwrite(&pSpectrumEmu->ZXEmuState.cpu.pins, sizeof(uint64_t), 1, fp);
+	// banked state - all RAM banks, paging & AY
+	FSpectrumMachineState machineState;
+	pSpectrumEmu->GetMachineState(machineState);
+
+	const uint8_t noRAMBanks = (uint8_t)pSpectrumEmu->GetNoRAMBanks();
+	buffer.Write(g_kMachineStateMagic);
+	buffer.Write(g_kMachineStateVersionNo);
+	buffer.Write(noRAMBanks);
+	buffer.WriteBytes(pSpectrumEmu->ZXEmuState.ram, noRAMBanks * 0x4000);
+
+	buffer.WriteBytes(machineState.CPURegs, sizeof(machineState.CPURegs));
+	buffer.Write(machineState.LastMemConfig);
+	buffer.Write(machineState.LastFEOut);
+	buffer.Write(machineState.bMemoryPagingDisabled);
+	buffer.Write(machineState.BorderColour);
+	buffer.Write<uint8_t>(machineState.AY.addr);
+	buffer.WriteBytes(machineState.AY.reg, sizeof(machineState.AY.reg));
 }
 
-void LoadMachineState(FSpectrumEmu* pSpectrumEmu, FILE* fp)
+// Old format - CPU visible 64K & registers
+static void LoadMachineState64K(FSpectrumEmu* pSpectrumEmu, FMemoryBuffer& buffer)
 {
 	// read memory
+	static thread_local uint8_t memory[1 << 16];
+	buffer.ReadBytes(memory, sizeof(memory));
 	for (int i = 0; i < 1 << 16; i++)
-	{
-		uint8_t memByte = 0;
-		fread(&memByte, sizeof(memByte), 1, fp);
-		pSpectrumEmu->WriteByte(i, memByte);
-	}
+		pSpectrumEmu->WriteByte(i, memory[i]);
 
 	// get CPU state
-	//z80_t* pCPUState = (z80_t*)frame.CPUState;
-	fread(&pSpectrumEmu->ZXEmuState.cpu.bc_de_hl_fa, sizeof(uint64_t), 1, fp);
-	fread(&pSpectrumEmu->ZXEmuState.cpu.bc_de_hl_fa_, sizeof(uint64_t), 1, fp);
-	fread(&pSpectrumEmu->ZXEmuState.cpu.wz_ix_iy_sp, sizeof(uint64_t), 1, fp);
-	fread(&pSpectrumEmu->ZXEmuState.cpu.im_ir_pc_bits, sizeof(uint64_t), 1, fp);
-	fread(&pSpectrumEmu->ZXEmuState.cpu.pins, sizeof(uint64_t), 1, fp);
-
+	buffer.Read(pSpectrumEmu->ZXEmuState.cpu.bc_de_hl_fa);
+	buffer.Read(pSpectrumEmu->ZXEmuState.cpu.bc_de_hl_fa_);
+	buffer.Read(pSpectrumEmu->ZXEmuState.cpu.wz_ix_iy_sp);
+	buffer.Read(pSpectrumEmu->ZXEmuState.cpu.im_ir_pc_bits);
+	buffer.Read(pSpectrumEmu->ZXEmuState.cpu.pins);
 }
 
-bool SaveGameState(FSpectrumEmu* pSpectrumEmu, const char* fname)
+bool LoadMachineState(FSpectrumEmu* pSpectrumEmu, FMemoryBuffer& buffer)
 {
-	FILE* fp = fopen(fname, "wb");
-	if (fp == NULL)
+	const size_t startPos = buffer.GetReadPosition();
+	if (buffer.Read<uint32_t>() != g_kMachineStateMagic)
+	{
+		// no header - the old 64K format
+		buffer.SetReadPosition(startPos);
+		LoadMachineState64K(pSpectrumEmu, buffer);
+		return true;
+	}
+
+	const int versionNo = buffer.Read<int>();
+	const uint8_t noRAMBanks = buffer.Read<uint8_t>();
+	if (versionNo > g_kMachineStateVersionNo || noRAMBanks != pSpectrumEmu->GetNoRAMBanks())
+	{
+		LOGERROR("Machine state (version %d, %d RAM banks) doesn't match this machine", versionNo, noRAMBanks);
 		return false;
-	SaveMachineState(pSpectrumEmu, fp);
-	fclose(fp);
+	}
 
+	std::vector<uint8_t> ram(noRAMBanks * 0x4000);
+	buffer.ReadBytes(ram.data(), ram.size());
+
+	// start from the current state so the AY keeps anything we don't store
+	FSpectrumMachineState machineState;
+	pSpectrumEmu->GetMachineState(machineState);
+	buffer.ReadBytes(machineState.CPURegs, sizeof(machineState.CPURegs));
+	buffer.Read(machineState.LastMemConfig);
+	buffer.Read(machineState.LastFEOut);
+	buffer.Read(machineState.bMemoryPagingDisabled);
+	buffer.Read(machineState.BorderColour);
+	machineState.AY.addr = buffer.Read<uint8_t>();
+	buffer.ReadBytes(machineState.AY.reg, sizeof(machineState.AY.reg));
+
+	pSpectrumEmu->SetRAM(ram.data());
+	pSpectrumEmu->SetMachineState(machineState);
 	return true;
 }
 
-bool LoadGameState(FSpectrumEmu* pSpectrumEmu, const char* fname)
+// Chunked file format
+// Header, section table, then each section zlib compressed
+// Sections can be loaded on their own (see EGameDataSection) so we don't need to decode the whole file to get at the labels
+
+static constexpr uint32_t g_kSectionId_LastWriters = MakeFourCC("LWRT");
+static constexpr uint32_t g_kSectionId_Labels = MakeFourCC("LABL");
+static constexpr uint32_t g_kSectionId_CodeInfo = MakeFourCC("CODE");
+static constexpr uint32_t g_kSectionId_DataInfo = MakeFourCC("DATA");
+static constexpr uint32_t g_kSectionId_CommentBlocks = MakeFourCC("CMNT");
+static constexpr uint32_t g_kSectionId_Watches = MakeFourCC("WTCH");
+static constexpr uint32_t g_kSectionId_CharacterSets = MakeFourCC("CSET");
+static constexpr uint32_t g_kSectionId_CharacterMaps = MakeFourCC("CMAP");
+static constexpr uint32_t g_kSectionId_Stack = MakeFourCC("STCK");
+static constexpr uint32_t g_kSectionId_MachineState = MakeFourCC("SNAP");
+static constexpr uint32_t g_kMaxCompressionRatio = 1032;	// the most zlib can compress by - a bigger section size is corrupt
+
+struct FGameDataSectionHeader
 {
-	FILE* fp = fopen(fname, "rb");
-	if (fp == NULL)
-		return false;
+	uint32_t	Id;
+	uint32_t	Offset;			// from start of file
+	uint32_t	CompressedSize;
+	uint32_t	Size;			// uncompressed
+};
 
-	LoadMachineState(pSpectrumEmu, fp);
-	fclose(fp);
+// Sections are compressed as they are added then written out with the header in one go
+struct FGameDataFile
+{
+	std::vector<FGameDataSectionHeader>	Sections;
+	std::vector<uint8_t>				SectionData;
+};
 
-	return true;
+static void AddSection(FGameDataFile& file, uint32_t id, const FMemoryBuffer& sectionBuffer)
+{
+	uLongf compressedSize = compressBound((uLong)sectionBuffer.GetSize());
+	const size_t dataOffset = file.SectionData.size();
+	file.SectionData.resize(dataOffset + compressedSize);
+	if (compress2(&file.SectionData[dataOffset], &compressedSize, (const Bytef*)sectionBuffer.GetData(), (uLong)sectionBuffer.GetSize(), Z_BEST_SPEED) != Z_OK)
+	{
+		LOGERROR("Failed to compress game data section %x", id);
+		file.SectionData.resize(dataOffset);
+		return;
+	}
+	file.SectionData.resize(dataOffset + compressedSize);
+
+	FGameDataSectionHeader section;
+	section.Id = id;
+	section.Offset = (uint32_t)dataOffset;	// fixed up when the file is written
+	section.CompressedSize = (uint32_t)compressedSize;
+	section.Size = (uint32_t)sectionBuffer.GetSize();
+	file.Sections.push_back(section);
 }
 
-bool SaveGameData(FSpectrumEmu* pSpectrumEmu, const char* fname)
+static bool WriteGameDataFile(FGameDataFile& file, const char* fname, uint16_t addrStart, uint16_t addrEnd)
 {
-	FCodeAnalysisState& state = pSpectrumEmu->CodeAnalysis;
-	FGameConfig& config = *pSpectrumEmu->pActiveGame->pConfig;
+	const uint32_t headerSize = sizeof(int) * 2 + sizeof(uint16_t) * 2 + sizeof(int) + (uint32_t)(file.Sections.size() * sizeof(FGameDataSectionHeader));
+
+	FMemoryBuffer fileBuffer;
+	fileBuffer.Init(headerSize + file.SectionData.size());
+	fileBuffer.Write(g_kBinaryFileMagic);
+	fileBuffer.Write(g_kBinaryFileVersionNo);
+	fileBuffer.Write(addrStart);	// memory range of this file
+	fileBuffer.Write(addrEnd);
+	fileBuffer.Write<int>((int)file.Sections.size());
+	for (FGameDataSectionHeader section : file.Sections)
+	{
+		section.Offset += headerSize;
+		fileBuffer.Write(section);
+	}
+	fileBuffer.WriteBytes(file.SectionData.data(), file.SectionData.size());
 
-	FILE* fp = fopen(fname, "wb");
-	if (fp == NULL)
-		return false;
+	return fileBuffer.SaveToFile(fname);
+}
 
-	SaveGameDataBin(state, fp, 0x4000, 0xffff);
+enum class EGetSectionResult
+{
+	Found,
+	Absent,
+	Corrupt,
+};
 
-	fwrite(&state.StackMin, sizeof(uint16_t), 1, fp);
-	fwrite(&state.StackMax, sizeof(uint16_t), 1, fp);
+// Find a section in the file & decompress it
+static EGetSectionResult GetSection(const FMemoryBuffer& fileBuffer, const std::vector<FGameDataSectionHeader>& sections, uint32_t id, FMemoryBuffer& outBuffer)
+{
+	for (const FGameDataSectionHeader& section : sections)
+	{
+		if (section.Id != id)
+			continue;
 
-	const uint8_t hasSnapshot = config.WriteSnapshot ? 1 : 0;
+		if ((size_t)section.Offset + section.CompressedSize > fileBuffer.GetSize())
+		{
+			LOGERROR("Game data section %x is truncated", id);
+			return EGetSectionResult::Corrupt;
+		}
 
-	fwrite(&hasSnapshot, sizeof(uint8_t), 1, fp);
+		if ((uint64_t)section.Size > (uint64_t)section.CompressedSize * g_kMaxCompressionRatio)
+		{
+			LOGERROR("Game data section %x has a bad size (%u bytes from %u)", id, section.Size, section.CompressedSize);
+			return EGetSectionResult::Corrupt;
+		}
 
-	if (hasSnapshot == 1)
-	{
-		SaveMachineState(pSpectrumEmu, fp);
-	}
+		uLongf size = section.Size;
+		Bytef* pData = (Bytef*)outBuffer.InitForData(section.Size);
+		const Bytef* pCompressed = (const Bytef*)fileBuffer.GetData() + section.Offset;
+		if (uncompress(pData, &size, pCompressed, section.CompressedSize) != Z_OK || size != section.Size)
+		{
+			LOGERROR("Failed to decompress game data section %x", id);
+			outBuffer.Init();
+			return EGetSectionResult::Corrupt;
+		}
 
-	fclose(fp);
+		return EGetSectionResult::Found;
+	}
 
-	return true;
+	return EGetSectionResult::Absent;
 }
 
-bool SaveROMData(const FCodeAnalysisState& state, const char* fname)
+// Binary save
+// character sets & maps are passed in as the registry is per thread
+static void SaveGameDataBin(const FCodeAnalysisState& state, const std::vector<FCharSetCreateParams>& charSets, const std::vector<FCharMapCreateParams>& charMaps, FGameDataFile& file, uint16_t addrStart, uint16_t addrEnd)
 {
-	FILE* fp = fopen(fname, "wb");
-	if (fp == NULL)
-		return false;
+	FMemoryBuffer buffer;
 
-	SaveGameDataBin(state, fp, 0x0000, 0x3fff);
+	buffer.Init(sizeof(uint16_t) * (addrEnd - addrStart + 1));
+	SaveLastWritersBin(state, buffer, addrStart, addrEnd);
+	AddSection(file, g_kSectionId_LastWriters, buffer);
 
-	return true;
+	buffer.Init();
+	SaveLabelsBin(state, buffer, addrStart, addrEnd);
+	AddSection(file, g_kSectionId_Labels, buffer);
+
+	buffer.Init();
+	SaveCodeInfoBin(state, buffer, addrStart, addrEnd);
+	AddSection(file, g_kSectionId_CodeInfo, buffer);
+
+	buffer.Init();
+	SaveDataInfoBin(state, buffer, addrStart, addrEnd);
+	AddSection(file, g_kSectionId_DataInfo, buffer);
+
+	buffer.Init();
+	SaveCommentBlocksBin(state, buffer, addrStart, addrEnd);
+	AddSection(file, g_kSectionId_CommentBlocks, buffer);
+
+	buffer.Init();
+	SaveWatchesBin(state, buffer, addrStart, addrEnd);
+	AddSection(file, g_kSectionId_Watches, buffer);
 
+	buffer.Init();
+	SaveCharacterSetsBin(charSets, buffer, addrStart, addrEnd);
+	AddSection(file, g_kSectionId_CharacterSets, buffer);
+
+	buffer.Init();
+	SaveCharacterMapsBin(charMaps, buffer, addrStart, addrEnd);
+	AddSection(file, g_kSectionId_CharacterMaps, buffer);
 }
 
-bool LoadGameData(FSpectrumEmu* pSpectrumEmu, const char* fname)
+// Binary load - chunked format
+static bool LoadGameDataChunked(FSpectrumEmu* pSpectrumEmu, FCodeAnalysisState& state, FMemoryBuffer& fileBuffer, int versionNo, uint32_t sectionMask)
 {
-	FCodeAnalysisState& state = pSpectrumEmu->CodeAnalysis;
+	const uint16_t addrStart = fileBuffer.Read<uint16_t>();
+	const uint16_t addrEnd = fileBuffer.Read<uint16_t>();
 
-	FILE* fp = fopen(fname, "rb");
-	if (fp == NULL)
+	// the section table has to fit in what's left of the file
+	const int noSections = fileBuffer.Read<int>();
+	const size_t remainingSize = fileBuffer.GetSize() - fileBuffer.GetReadPosition();
+	if (noSections < 0 || (size_t)noSections > remainingSize / sizeof(FGameDataSectionHeader))
+	{
+		LOGERROR("Game data file has a bad section count (%d)", noSections);
 		return false;
+	}
 
-	int magic, versionNo;
-	fread(&magic, sizeof(int), 1, fp);
-	if (magic != g_kBinaryFileMagic)
+	std::vector<FGameDataSectionHeader> sections(noSections);
+	for (FGameDataSectionHeader& section : sections)
+		fileBuffer.Read(section);
+
+	struct FLoadSection
 	{
-		fclose(fp);
-		return false;
+		EGameDataSection	Section;
+		uint32_t			Id;
+		FMemoryBuffer		Buffer;
+		bool				bFound = false;
+	};
+
+	FLoadSection loadSections[] =
+	{
+		{ GameDataSection_LastWriters, g_kSectionId_LastWriters },
+		{ GameDataSection_Labels, g_kSectionId_Labels },
+		{ GameDataSection_CodeInfo, g_kSectionId_CodeInfo },
+		{ GameDataSection_DataInfo, g_kSectionId_DataInfo },
+		{ GameDataSection_CommentBlocks, g_kSectionId_CommentBlocks },
+		{ GameDataSection_Watches, g_kSectionId_Watches },
+		{ GameDataSection_CharacterSets, g_kSectionId_CharacterSets },
+		{ GameDataSection_CharacterMaps, g_kSectionId_CharacterMaps },
+		{ GameDataSection_Stack, g_kSectionId_Stack },
+		{ GameDataSection_MachineState, g_kSectionId_MachineState },
+	};
+
+	// decompress all the wanted sections before applying any so a corrupt file doesn't half load
+	for (FLoadSection& loadSection : loadSections)
+	{
+		if ((sectionMask & loadSection.Section) == 0)
+			continue;
+
+		const EGetSectionResult result = GetSection(fileBuffer, sections, loadSection.Id, loadSection.Buffer);
+		if (result == EGetSectionResult::Corrupt)
+			return false;
+		loadSection.bFound = result == EGetSectionResult::Found;
 	}
 
-	fread(&versionNo, sizeof(int), 1, fp);
+	auto getSection = [&loadSections](EGameDataSection section) -> FMemoryBuffer*
+	{
+		for (FLoadSection& loadSection : loadSections)
+		{
+			if (loadSection.Section == section)
+				return loadSection.bFound ? &loadSection.Buffer : nullptr;
+		}
+		return nullptr;
+	};
+
+	if (FMemoryBuffer* pBuffer = getSection(GameDataSection_LastWriters))
+		LoadLastWritersBin(state, *pBuffer, addrStart, addrEnd);
+	if (FMemoryBuffer* pBuffer = getSection(GameDataSection_Labels))
+		LoadLabelsBin(state, *pBuffer, versionNo, addrStart, addrEnd);
+	if (FMemoryBuffer* pBuffer = getSection(GameDataSection_CodeInfo))
+		LoadCodeInfoBin(state, *pBuffer, versionNo, addrStart, addrEnd);
+	if (FMemoryBuffer* pBuffer = getSection(GameDataSection_DataInfo))
+		LoadDataInfoBin(state, *pBuffer, versionNo, addrStart, addrEnd);
+	if (FMemoryBuffer* pBuffer = getSection(GameDataSection_CommentBlocks))
+		LoadCommentBlocksBin(state, *pBuffer, versionNo, addrStart, addrEnd);
+	if (FMemoryBuffer* pBuffer = getSection(GameDataSection_Watches))
+		LoadWatchesBin(state, *pBuffer, addrStart, addrEnd);
+	if (FMemoryBuffer* pBuffer = getSection(GameDataSection_CharacterSets))
+		LoadCharacterSetsBin(state, *pBuffer, versionNo);
+	if (FMemoryBuffer* pBuffer = getSection(GameDataSection_CharacterMaps))
+		LoadCharacterMapsBin(state, *pBuffer);
+
+	if (FMemoryBuffer* pBuffer = getSection(GameDataSection_Stack))
+	{
+		pBuffer->Read(state.StackMin);
+		pBuffer->Read(state.StackMax);
+	}
 
-	LoadGameDataBin(state, fp, versionNo, 0x4000, 0xffff);
+	FMemoryBuffer* pMachineStateBuffer = getSection(GameDataSection_MachineState);
+	if (pSpectrumEmu != nullptr && pMachineStateBuffer != nullptr)
+		LoadMachineState(pSpectrumEmu, *pMachineStateBuffer);
+
+	return true;
+}
+
+// Binary load - files before the chunked format, everything is read in sequence
+static void LoadGameDataLegacy(FSpectrumEmu* pSpectrumEmu, FCodeAnalysisState& state, FMemoryBuffer& buffer, int versionNo, uint16_t addrStart, uint16_t addrEnd)
+{
+	if (versionNo >= 8)
+	{
+		buffer.Read(addrStart);
+		buffer.Read(addrEnd);
+		LoadLastWritersBin(state, buffer, addrStart, addrEnd);
+	}
+	else if (versionNo >= 4)
+	{
+		LoadLastWritersBin(state, buffer, 0, 0xffff);
+	}
+
+	LoadLabelsBin(state, buffer, versionNo, addrStart, addrEnd);
+	LoadCodeInfoBin(state, buffer, versionNo, addrStart, addrEnd);
+	LoadDataInfoBin(state, buffer, versionNo, addrStart, addrEnd);
+	if (versionNo >= 5)
+		LoadCommentBlocksBin(state, buffer, versionNo, addrStart, addrEnd);
+
+	if (versionNo >= 7)
+		LoadWatchesBin(state, buffer, addrStart, addrEnd);
+
+	if (versionNo > 10)
+		LoadCharacterSetsBin(state, buffer, versionNo);
+
+	if (versionNo > 13)
+		LoadCharacterMapsBin(state, buffer);
+
+	if (pSpectrumEmu == nullptr)	// ROM data stops here
+		return;
 
 	if (versionNo > 16)
 	{
-		fread(&state.StackMin, sizeof(uint16_t), 1, fp);
-		fread(&state.StackMax, sizeof(uint16_t), 1, fp);
+		buffer.Read(state.StackMin);
+		buffer.Read(state.StackMax);
 	}
 
 	if (versionNo > 15)
 	{
-		uint8_t hasSnapshot = 0;
+		if (buffer.Read<uint8_t>() == 1)	// has snapshot
+			LoadMachineState(pSpectrumEmu, buffer);
+	}
+}
 
-		fread(&hasSnapshot, sizeof(uint8_t), 1, fp);
+static bool LoadGameDataFile(FSpectrumEmu* pSpectrumEmu, FCodeAnalysisState& state, const char* fname, uint16_t addrStart, uint16_t addrEnd, uint32_t sectionMask)
+{
+	FMemoryBuffer fileBuffer;
+	if (fileBuffer.LoadFromFile(fname) == false)
+		return false;
+
+	if (fileBuffer.Read<int>() != g_kBinaryFileMagic)
+		return false;
+
+	const int versionNo = fileBuffer.Read<int>();
+	if (versionNo > g_kBinaryFileVersionNo)
+	{
+		LOGERROR("%s is version %d, newer than supported version %d", fname, versionNo, g_kBinaryFileVersionNo);
+		return false;
+	}
 
-		if (hasSnapshot == 1)
+	if (versionNo >= g_kChunkedFileVersionNo)
+	{
+		if (LoadGameDataChunked(pSpectrumEmu, state, fileBuffer, versionNo, sectionMask) == false)
 		{
-			LoadMachineState(pSpectrumEmu, fp);
+			LOGERROR("Failed to load %s", fname);
+			return false;
 		}
 	}
-	fclose(fp);
+	else
+		LoadGameDataLegacy(pSpectrumEmu, state, fileBuffer, versionNo, addrStart, addrEnd);
+
 	return true;
 }
 
-bool LoadROMData(FCodeAnalysisState& state, const char* fname)
+bool SaveGameState(FSpectrumEmu* pSpectrumEmu, const char* fname)
 {
-	FILE* fp = fopen(fname, "rb");
-	if (fp == NULL)
+	FMemoryBuffer buffer;
+	buffer.Init(pSpectrumEmu->GetRAMSize() + 1024);
+	SaveMachineState(pSpectrumEmu, buffer);
+	return buffer.SaveToFile(fname);
+}
+
+bool LoadGameState(FSpectrumEmu* pSpectrumEmu, const char* fname)
+{
+	FMemoryBuffer buffer;
+	if (buffer.LoadFromFile(fname) == false)
 		return false;
 
-	int magic, versionNo;
-	fread(&magic, sizeof(int), 1, fp);
-	if (magic != g_kBinaryFileMagic)
+	return LoadMachineState(pSpectrumEmu, buffer);
+}
+
+static bool SaveGameDataFile(const FCodeAnalysisState& state, const std::vector<FCharSetCreateParams>& charSets, const std::vector<FCharMapCreateParams>& charMaps, const FMemoryBuffer* pMachineState, const char* fname)
+{
+	FGameDataFile file;
+	SaveGameDataBin(state, charSets, charMaps, file, 0x4000, 0xffff);
+
+	FMemoryBuffer buffer;
+	buffer.Init();
+	buffer.Write(state.StackMin);
+	buffer.Write(state.StackMax);
+	AddSection(file, g_kSectionId_Stack, buffer);
+
+	if (pMachineState != nullptr)
+		AddSection(file, g_kSectionId_MachineState, *pMachineState);
+
+	return WriteGameDataFile(file, fname, 0x4000, 0xffff);
+}
+
+bool SaveGameData(FSpectrumEmu* pSpectrumEmu, const char* fname)
+{
+	FGameConfig& config = *pSpectrumEmu->pActiveGame->pConfig;
+
+	std::vector<FCharSetCreateParams> charSets;
+	std::vector<FCharMapCreateParams> charMaps;
+	GetCharacterSetParams(charSets);
+	GetCharacterMapParams(charMaps);
+
+	FMemoryBuffer machineState;
+	if (config.WriteSnapshot)
 	{
-		fclose(fp);
-		return false;
+		machineState.Init(pSpectrumEmu->GetRAMSize() + 1024);
+		SaveMachineState(pSpectrumEmu, machineState);
 	}
 
-	fread(&versionNo, sizeof(int), 1, fp);
-	LoadGameDataBin(state, fp, versionNo, 0x0000, 0x3fff);
+	return SaveGameDataFile(pSpectrumEmu->CodeAnalysis, charSets, charMaps, config.WriteSnapshot ? &machineState : nullptr, fname);
+}
 
-	fclose(fp);
-	return true;
+bool SaveGameData(const FAnalysisSnapshot& snapshot, const FMemoryBuffer* pMachineState, const char* fname)
+{
+	return SaveGameDataFile(snapshot.State, snapshot.CharacterSets, snapshot.CharacterMaps, pMachineState, fname);
+}
+
+bool SaveROMData(const FCodeAnalysisState& state, const char* fname)
+{
+	std::vector<FCharSetCreateParams> charSets;
+	std::vector<FCharMapCreateParams> charMaps;
+	GetCharacterSetParams(charSets);
+	GetCharacterMapParams(charMaps);
+
+	FGameDataFile file;
+	SaveGameDataBin(state, charSets, charMaps, file, 0x0000, 0x3fff);
+	return WriteGameDataFile(file, fname, 0x0000, 0x3fff);
+}
+
+bool LoadGameData(FSpectrumEmu* pSpectrumEmu, const char* fname, uint32_t sectionMask)
+{
+	return LoadGameDataFile(pSpectrumEmu, pSpectrumEmu->CodeAnalysis, fname, 0x4000, 0xffff, sectionMask);
+}
+
+bool LoadROMData(FCodeAnalysisState& state, const char* fname)
+{
+	return LoadGameDataFile(nullptr, state, fname, 0x0000, 0x3fff, GameDataSection_All);
 }
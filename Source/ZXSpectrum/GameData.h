@@ -1,13 +1,38 @@
 #pragma once
 
+#include <cstdint>
+
 struct FCodeAnalysisState;
+struct FAnalysisSnapshot;
 class FSpectrumEmu;
+class FMemoryBuffer;
+
+// Sections of the game data file - so part of a file can be loaded e.g. just the labels
+enum EGameDataSection : uint32_t
+{
+	GameDataSection_LastWriters		= 1 << 0,
+	GameDataSection_Labels			= 1 << 1,
+	GameDataSection_CodeInfo		= 1 << 2,
+	GameDataSection_DataInfo		= 1 << 3,
+	GameDataSection_CommentBlocks	= 1 << 4,
+	GameDataSection_Watches			= 1 << 5,
+	GameDataSection_CharacterSets	= 1 << 6,
+	GameDataSection_CharacterMaps	= 1 << 7,
+	GameDataSection_Stack			= 1 << 8,
+	GameDataSection_MachineState	= 1 << 9,
+
+	GameDataSection_All				= 0xffffffff
+};
 
 bool SaveGameData(FSpectrumEmu* pSpectrumEmu, const char* fname);
-bool LoadGameData(FSpectrumEmu* pSpectrumEmu, const char* fname);
+// for saving on a worker thread - the machine state is saved on the emulator thread, nullptr to leave it out
+bool SaveGameData(const FAnalysisSnapshot& snapshot, const FMemoryBuffer* pMachineState, const char* fname);
+// the section mask only applies to files in the chunked format, older files are always loaded whole
+bool LoadGameData(FSpectrumEmu* pSpectrumEmu, const char* fname, uint32_t sectionMask = GameDataSection_All);
 
 bool SaveROMData(const FCodeAnalysisState& state, const char* fname);
 bool LoadROMData(FCodeAnalysisState& state, const char* fname);
 
 bool SaveGameState(FSpectrumEmu* pSpectrumEmu, const char* fname);
+void SaveMachineState(FSpectrumEmu* pSpectrumEmu, FMemoryBuffer& buffer);
 bool LoadGameState(FSpectrumEmu* pSpectrumEmu, const char* fname);
@@ -10,6 +10,7 @@ struct FGlobalConfig
 	bool				bShowOpcodeValues = false;
 	ENumberDisplayMode	NumberDisplayMode = ENumberDisplayMode::HexAitch;
 	std::string			LastGame;
+	int					AutoSaveMinutes = 0;	// 0 for no autosave
 
 	std::string			WorkspaceRoot = "./";
 	std::string			SnapshotFolder = "./Games/";
@@ -17,6 +18,8 @@ struct FGlobalConfig
 	std::string			RZXFolder = "./RZX/";
 };
 
+extern const char* kGlobalConfigFilename;
+
 FGlobalConfig& GetGlobalConfig();
 bool LoadGlobalConfig(const char* fileName);
 bool SaveGlobalConfig(const char* fileName);
@@ -0,0 +1,7 @@
+#pragma once
+
+// ImGui config for the headless runner - set with IMGUI_USER_CONFIG in CMakeLists.txt
+// The current context is per thread so each corpus worker can have its own, emulator Init isn't thread safe on a shared one
+struct ImGuiContext;
+extern thread_local ImGuiContext* g_HeadlessImGuiContext;
+#define GImGui g_HeadlessImGuiContext
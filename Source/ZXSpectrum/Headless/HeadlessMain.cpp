@@ -0,0 +1,957 @@
+// Headless batch runner for the Spectrum Analyser
+// Runs a game for a fixed number of emulated frames as fast as the host allows, then writes the analysis .bin file.
+// No window, renderer or audio device is created so many instances can be run side by side on a batch machine.
+//
+// Usage: SpectrumAnalyserHeadless <game name | snapshot file> [-frames <n>] [-input <script>] [-out <file.bin>] [-128]
+//        SpectrumAnalyserHeadless -corpus <snapshot dir> [-threads <n>] [-frames <n>] [-input <script>] [-out <dir>] [-128]
+//        SpectrumAnalyserHeadless -benchmark [<game name | snapshot file>] [-frames <n>] [-128]
+//        SpectrumAnalyserHeadless -dasmcheck
+//
+// Corpus mode analyses every snapshot in the directory on a pool of worker threads, one emulator per game,
+// and writes a CorpusReport.csv summary alongside the .bin files.
+// Benchmark mode times the analyser's hot kernels on synthetic data, or with a game the decoded instruction cache,
+// the cost of the write journal, taking an analysis snapshot for saving and writing & reading the analysis json.
+// Dasm check mode compares the table driven disassembler against the chips z80dasm/m6502dasm for every opcode.
+//
+// Input script format - one event per line, '#' starts a comment:
+//   <frame no> down <key>
+//   <frame no> up <key>
+// where <key> is a single character or one of SPACE, ENTER, CAPS, SYM, LEFT, RIGHT, UP, DOWN
+
+#include "imgui.h"
+
+#include "../SpectrumEmu.h"
+#include "../GameConfig.h"
+#include "../GameData.h"
+#include "../GlobalConfig.h"
+#include "../App.h"
+#include "Util/FileUtil.h"
+#include "Util/MemoryDiff.h"
+#include "Util/MemorySearch.h"
+#include "Util/CheatSearch.h"
+#include "Util/TextDiscovery.h"
+#include "CodeAnalyser/Disassembler.h"
+#include "CodeAnalyser/AnalysisSnapshot.h"
+#include "../Exporters/JsonExport.h"
+
+#include <sokol_audio.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+thread_local ImGuiContext* g_HeadlessImGuiContext = nullptr;	// see HeadlessImConfig.h
+
+struct FHeadlessOptions
+{
+	std::string		Game;
+	std::string		InputScript;
+	std::string		OutputFile;
+	std::string		CorpusDir;
+	int				NoFrames = 50 * 60;	// 1 minute of emulated time
+	int				NoThreads = (int)std::thread::hardware_concurrency();
+	bool			b128K = false;
+	bool			bBenchmark = false;
+	bool			bDasmCheck = false;
+};
+
+struct FGameRunResult
+{
+	std::string		Name;
+	bool			bSuccess = false;
+	double			Seconds = 0.0;
+	int				NoInstructions = 0;
+	int				NoDataBytesRead = 0;
+	int				NoDataBytesWritten = 0;
+	int				NoLabels = 0;
+	int				NoBasicBlocks = 0;
+	int				NoFunctions = 0;
+};
+
+struct FScriptedKeyEvent
+{
+	int		FrameNo = 0;
+	int		KeyCode = 0;
+	bool	bDown = false;
+};
+
+// 50Hz PAL frame
+static const uint32_t kFrameMicroSeconds = 20000;
+
+static void PrintUsage()
+{
+	printf("Usage: SpectrumAnalyserHeadless <game name | snapshot file> [-frames <n>] [-input <script>] [-out <file.bin>] [-128]\n");
+	printf("       SpectrumAnalyserHeadless -corpus <snapshot dir> [-threads <n>] [-frames <n>] [-input <script>] [-out <dir>] [-128]\n");
+	printf("       SpectrumAnalyserHeadless -benchmark [<game name | snapshot file>] [-frames <n>] [-128]\n");
+	printf("       SpectrumAnalyserHeadless -dasmcheck\n");
+}
+
+static bool ParseCommandLine(int argc, char** argv, FHeadlessOptions& options)
+{
+	for (int argNo = 1; argNo < argc; argNo++)
+	{
+		const char* pArg = argv[argNo];
+		const bool bHasValue = argNo + 1 < argc;
+
+		if (strcmp(pArg, "-frames") == 0 && bHasValue)
+			options.NoFrames = atoi(argv[++argNo]);
+		else if (strcmp(pArg, "-input") == 0 && bHasValue)
+			options.InputScript = argv[++argNo];
+		else if (strcmp(pArg, "-out") == 0 && bHasValue)
+			options.OutputFile = argv[++argNo];
+		else if (strcmp(pArg, "-corpus") == 0 && bHasValue)
+			options.CorpusDir = argv[++argNo];
+		else if (strcmp(pArg, "-threads") == 0 && bHasValue)
+			options.NoThreads = atoi(argv[++argNo]);
+		else if (strcmp(pArg, "-128") == 0)
+			options.b128K = true;
+		else if (strcmp(pArg, "-benchmark") == 0)
+			options.bBenchmark = true;
+		else if (strcmp(pArg, "-dasmcheck") == 0)
+			options.bDasmCheck = true;
+		else if (pArg[0] == '-')
+			return false;
+		else
+			options.Game = pArg;
+	}
+
+	return options.bBenchmark || options.bDasmCheck || ((options.Game.empty() == false || options.CorpusDir.empty() == false) && options.NoFrames > 0);
+}
+
+// Get a key code as used by zx_key_down/zx_key_up
+static int GetKeyCodeFromName(const std::string& name)
+{
+	if (name.size() == 1)
+		return name[0];
+
+	std::string upperName = name;
+	std::transform(upperName.begin(), upperName.end(), upperName.begin(), ::toupper);
+
+	if (upperName == "SPACE")	return ' ';
+	if (upperName == "ENTER")	return 0x0D;
+	if (upperName == "CAPS")	return 0x0E;
+	if (upperName == "SYM")		return 0x0F;
+	if (upperName == "LEFT")	return 0x08;
+	if (upperName == "RIGHT")	return 0x09;
+	if (upperName == "DOWN")	return 0x0A;
+	if (upperName == "UP")		return 0x0B;
+
+	return 0;
+}
+
+static bool LoadInputScript(const char* pFileName, std::vector<FScriptedKeyEvent>& events)
+{
+	std::ifstream inFile(pFileName);
+	if (inFile.is_open() == false)
+		return false;
+
+	std::string line;
+	int lineNo = 0;
+	while (std::getline(inFile, line))
+	{
+		lineNo++;
+		const size_t commentPos = line.find('#');
+		if (commentPos != std::string::npos)
+			line.resize(commentPos);
+
+		std::stringstream lineStream(line);
+		FScriptedKeyEvent event;
+		std::string action, keyName;
+		if (!(lineStream >> event.FrameNo))
+			continue;	// blank line
+
+		if (!(lineStream >> action >> keyName) || (action != "down" && action != "up"))
+		{
+			fprintf(stderr, "%s(%d): expected '<frame> down|up <key>'\n", pFileName, lineNo);
+			return false;
+		}
+
+		event.bDown = action == "down";
+		event.KeyCode = GetKeyCodeFromName(keyName);
+		if (event.KeyCode == 0)
+		{
+			fprintf(stderr, "%s(%d): unknown key '%s'\n", pFileName, lineNo, keyName.c_str());
+			return false;
+		}
+		events.push_back(event);
+	}
+
+	std::stable_sort(events.begin(), events.end(), [](const FScriptedKeyEvent& a, const FScriptedKeyEvent& b) { return a.FrameNo < b.FrameNo; });
+	return true;
+}
+
+// Start a game either from its config name or directly from a snapshot file
+static bool StartHeadlessGame(FSpectrumEmu* pEmu, const std::string& game)
+{
+	if (GetSnapshotTypeFromFileName(game) != ESnapshotType::Unknown && FileExists(game.c_str()))
+	{
+		if (pEmu->GamesList.LoadGame(game.c_str()) == false)
+			return false;
+
+		FGameSnapshot snapshot;
+		snapshot.Type = GetSnapshotTypeFromFileName(game);
+		snapshot.FileName = game;
+		snapshot.DisplayName = GetFileFromPath(game.c_str());
+		FGameConfig* pNewConfig = CreateNewGameConfigFromSnapshot(snapshot);
+		if (pNewConfig == nullptr)
+			return false;
+		pEmu->StartGame(pNewConfig);
+		return true;
+	}
+
+	return pEmu->StartGame(game.c_str());
+}
+
+// Run a single game and write its analysis, this can be called from worker threads
+static void RunGame(const FHeadlessOptions& options, const std::string& game, const std::vector<FScriptedKeyEvent>& inputEvents, const std::string& outDir, FGameRunResult& result)
+{
+	FSpectrumConfig config;
+	config.Model = options.b128K ? ESpectrumModel::Spectrum128K : ESpectrumModel::Spectrum48K;
+	config.bHeadless = true;
+
+	FSpectrumEmu* pSpectrumEmulator = new FSpectrumEmu;
+	pSpectrumEmulator->Init(config);
+
+	result.Name = game;
+	if (StartHeadlessGame(pSpectrumEmulator, game) == false || pSpectrumEmulator->pActiveGame == nullptr)
+	{
+		fprintf(stderr, "Failed to start game '%s'\n", game.c_str());
+		delete pSpectrumEmulator;
+		return;
+	}
+
+	// StartGame leaves the emulator in break mode
+	pSpectrumEmulator->Continue();
+
+	const auto startTime = std::chrono::steady_clock::now();
+	size_t nextEvent = 0;
+
+	for (int frameNo = 0; frameNo < options.NoFrames; frameNo++)
+	{
+		while (nextEvent < inputEvents.size() && inputEvents[nextEvent].FrameNo <= frameNo)
+		{
+			const FScriptedKeyEvent& event = inputEvents[nextEvent++];
+			if (event.bDown)
+				zx_key_down(&pSpectrumEmulator->ZXEmuState, event.KeyCode);
+			else
+				zx_key_up(&pSpectrumEmulator->ZXEmuState, event.KeyCode);
+		}
+
+		pSpectrumEmulator->ExecuteFrame(kFrameMicroSeconds);
+
+		// nobody is here to continue from a breakpoint
+		if (pSpectrumEmulator->IsStopped())
+			pSpectrumEmulator->Continue();
+	}
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+	result.Seconds = elapsed.count();
+
+	// finish off any static analysis the frames didn't get through
+	FCodeAnalysisState& state = pSpectrumEmulator->CodeAnalysis;
+	while (UpdateStaticAnalysis(state, kStaticAnalysisFrameBudget) == false);
+
+	// gather coverage stats
+	for (int addr = 0; addr < (1 << 16); addr++)
+	{
+		if (state.GetCodeInfoForAddress(addr) != nullptr)
+			result.NoInstructions++;
+		if (state.GetLastFrameReadForAddress(addr) != -1)
+			result.NoDataBytesRead++;
+		if (state.GetLastFrameWrittenForAddress(addr) != -1)
+			result.NoDataBytesWritten++;
+		if (state.GetLabelForAddress(addr) != nullptr)
+			result.NoLabels++;
+	}
+
+	for (const FBasicBlock& block : state.StaticAnalysis.Blocks)
+	{
+		if (GetBasicBlockForAddress(state, block.StartAddress) != &block)	// block's memory has since been paged out
+			continue;
+		result.NoBasicBlocks++;
+		if (block.bFunctionEntry)
+			result.NoFunctions++;
+	}
+
+	FGameConfig* pGameConfig = pSpectrumEmulator->pActiveGame->pConfig;
+	result.Name = pGameConfig->Name;
+	std::string outFName = options.OutputFile;
+	if (outFName.empty() || options.CorpusDir.empty() == false)
+		outFName = outDir + pGameConfig->Name + ".bin";
+
+	// We don't call Shutdown() as that writes the global config, which would race between batch processes
+	result.bSuccess = SaveGameData(pSpectrumEmulator, outFName.c_str());
+	if (result.bSuccess == false)
+		fprintf(stderr, "Failed to write %s\n", outFName.c_str());
+
+	delete pSpectrumEmulator;
+}
+
+static void PrintResult(const FHeadlessOptions& options, const FGameRunResult& result)
+{
+	const double emulatedSeconds = (double)options.NoFrames * kFrameMicroSeconds / 1000000.0;
+	printf("%s: %s - %d frames (%.1fs emulated) in %.2fs - %.1fx real time\n", result.Name.c_str(), result.bSuccess ? "OK" : "FAILED",
+		options.NoFrames, emulatedSeconds, result.Seconds, emulatedSeconds / std::max(result.Seconds, 0.001));
+	printf("  %d instructions, %d basic blocks, %d functions, %d labels\n", result.NoInstructions, result.NoBasicBlocks, result.NoFunctions, result.NoLabels);
+}
+
+static bool WriteCorpusReport(const char* pFileName, const FHeadlessOptions& options, const std::vector<FGameRunResult>& results)
+{
+	FILE* fp = fopen(pFileName, "wt");
+	if (fp == nullptr)
+		return false;
+
+	fprintf(fp, "Game,Result,Frames,Seconds,Instructions,DataBytesRead,DataBytesWritten,Labels,BasicBlocks,Functions\n");
+	for (const FGameRunResult& result : results)
+	{
+		fprintf(fp, "\"%s\",%s,%d,%.3f,%d,%d,%d,%d,%d,%d\n", result.Name.c_str(), result.bSuccess ? "OK" : "FAILED", options.NoFrames,
+			result.Seconds, result.NoInstructions, result.NoDataBytesRead, result.NoDataBytesWritten, result.NoLabels, result.NoBasicBlocks, result.NoFunctions);
+	}
+
+	fclose(fp);
+	return true;
+}
+
+// Analyse every snapshot in a directory using a pool of worker threads - one emulator per game
+static int RunCorpus(const FHeadlessOptions& options, const std::vector<FScriptedKeyEvent>& inputEvents)
+{
+	std::string corpusDir = options.CorpusDir;
+	if (corpusDir.back() != '/' && corpusDir.back() != '\\')
+		corpusDir += "/";
+
+	FGamesList corpusList;
+	if (corpusList.EnumerateGames(corpusDir.c_str()) == false || corpusList.GetNoGames() == 0)
+	{
+		fprintf(stderr, "No snapshots found in '%s'\n", options.CorpusDir.c_str());
+		return 1;
+	}
+
+	std::string outDir = options.OutputFile.empty() ? GetGlobalConfig().WorkspaceRoot + "GameData" : options.OutputFile;
+	EnsureDirectoryExists(outDir.c_str());
+	outDir += "/";
+
+	const int noGames = corpusList.GetNoGames();
+	const int noThreads = std::max(1, std::min(options.NoThreads, noGames));
+	std::vector<FGameRunResult> results(noGames);
+	std::atomic<int> nextGame(0);
+	std::mutex printMutex;
+
+	printf("Analysing %d games on %d threads\n", noGames, noThreads);
+	const auto startTime = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	for (int threadNo = 0; threadNo < noThreads; threadNo++)
+	{
+		workers.emplace_back([&]()
+		{
+			// the chips debugger UI needs a context to look up key indices - each thread has its own current context
+			ImGuiContext* pContext = ImGui::CreateContext();
+			for (int gameNo = nextGame++; gameNo < noGames; gameNo = nextGame++)
+			{
+				RunGame(options, corpusList.GetGame(gameNo).FileName, inputEvents, outDir, results[gameNo]);
+
+				std::lock_guard<std::mutex> lock(printMutex);
+				PrintResult(options, results[gameNo]);
+			}
+			ImGui::DestroyContext(pContext);
+		});
+	}
+
+	for (std::thread& worker : workers)
+		worker.join();
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+	const int noSucceeded = (int)std::count_if(results.begin(), results.end(), [](const FGameRunResult& result) { return result.bSuccess; });
+	printf("%d/%d games analysed in %.2fs\n", noSucceeded, noGames, elapsed.count());
+
+	const std::string reportFName = outDir + "CorpusReport.csv";
+	if (WriteCorpusReport(reportFName.c_str(), options, results))
+		printf("Wrote %s\n", reportFName.c_str());
+	else
+		fprintf(stderr, "Failed to write %s\n", reportFName.c_str());
+
+	return noSucceeded == noGames ? 0 : 1;
+}
+
+// Time a function over a number of iterations, returns microseconds per iteration
+template <typename F>
+static double TimeIterations(int noIterations, F func)
+{
+	const auto startTime = std::chrono::steady_clock::now();
+	for (int i = 0; i < noIterations; i++)
+		func();
+	const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - startTime;
+	return elapsed.count() / noIterations;
+}
+
+// Compare the memory diff kernel against the byte loop the frame trace used to use
+static void BenchmarkMemoryDiff()
+{
+	static uint8_t oldMemory[1 << 16];
+	static uint8_t newMemory[1 << 16];
+	const int kNoIterations = 2000;
+
+	srand(1234);
+	for (int i = 0; i < (1 << 16); i++)
+		oldMemory[i] = (uint8_t)rand();
+
+	struct FDiffCase
+	{
+		const char*	Name;
+		int			NoScatteredBytes;
+		int			RunSize;	// contiguous change e.g. screen update
+	};
+
+	const FDiffCase diffCases[] =
+	{
+		{ "No changes", 0, 0 },
+		{ "Typical frame", 200, 512 },
+		{ "Screen redraw", 500, 6912 },
+		{ "Busy frame", 8000, 0 },
+	};
+
+	printf("Memory diff (64K, %d iterations)\n", kNoIterations);
+	printf("%-16s %12s %12s %12s %8s\n", "Case", "Byte loop", "Scalar runs", "DiffMemory", "Runs");
+
+	for (const FDiffCase& diffCase : diffCases)
+	{
+		memcpy(newMemory, oldMemory, sizeof(newMemory));
+		for (int i = 0; i < diffCase.NoScatteredBytes; i++)
+			newMemory[rand() & 0xffff]++;
+		for (int i = 0; i < diffCase.RunSize; i++)
+			newMemory[0x4000 + i]++;
+
+		std::vector<FMemoryDiffRun> runs;
+		std::vector<uint16_t> changedBytes;
+
+		const double byteLoopTime = TimeIterations(kNoIterations, [&]()
+		{
+			changedBytes.clear();
+			for (int i = 0; i < (1 << 16); i++)
+			{
+				if (newMemory[i] != oldMemory[i])
+					changedBytes.push_back((uint16_t)i);
+			}
+		});
+		const double scalarTime = TimeIterations(kNoIterations, [&]() { DiffMemoryScalar(newMemory, oldMemory, sizeof(newMemory), runs); });
+		const double diffTime = TimeIterations(kNoIterations, [&]() { DiffMemory(newMemory, oldMemory, sizeof(newMemory), runs); });
+
+		// check the kernel agrees with the byte loop
+		size_t noRunBytes = 0;
+		for (const FMemoryDiffRun& run : runs)
+			noRunBytes += run.Size;
+		if (noRunBytes != changedBytes.size())
+			printf("MISMATCH: %s - %d bytes in runs, %d changed bytes\n", diffCase.Name, (int)noRunBytes, (int)changedBytes.size());
+
+		printf("%-16s %10.2fus %10.2fus %10.2fus %8d\n", diffCase.Name, byteLoopTime, scalarTime, diffTime, (int)runs.size());
+	}
+}
+
+// Compare the memory search against the byte loop on 128K of banked memory
+static void BenchmarkMemorySearch()
+{
+	static uint8_t banks[8][0x4000];
+	const int kNoIterations = 200;
+
+	srand(1234);
+	for (int bankNo = 0; bankNo < 8; bankNo++)
+	{
+		for (int i = 0; i < 0x4000; i++)
+			banks[bankNo][i] = (i & 0x100) ? 0 : (uint8_t)rand();	// half the memory is zero filled
+	}
+
+	std::vector<FMemorySearchBank> searchBanks;
+	for (int bankNo = 0; bankNo < 8; bankNo++)
+		searchBanks.push_back({ "RAM " + std::to_string(bankNo), banks[bankNo], 0x4000 });
+
+	struct FSearchCase
+	{
+		const char*					Name;
+		std::vector<const char*>	Patterns;
+	};
+
+	const FSearchCase searchCases[] =
+	{
+		{ "Single pattern", { "3E 10 C9" } },
+		{ "Wildcards", { "21 ?? ?? 11 ?? ?? 01" } },
+		{ "Zero anchor", { "00 00 00 18" } },
+		{ "8 patterns", { "3E 10 C9", "CD ?? 80", "\"SCORE\"", "F? 00 F?", "18 3C 7E FF", "DD 21 ?? ??", "ED B0", "C3 00 00" } },
+	};
+
+	printf("Memory search (128K, %d iterations)\n", kNoIterations);
+	printf("%-16s %12s %12s %8s\n", "Case", "Byte loop", "SearchMemory", "Hits");
+
+	for (const FSearchCase& searchCase : searchCases)
+	{
+		std::vector<FMemorySearchPattern> patterns;
+		for (const char* pPatternText : searchCase.Patterns)
+		{
+			FMemorySearchPattern pattern;
+			if (ParseMemorySearchPattern(pPatternText, pattern))
+				patterns.push_back(pattern);
+		}
+
+		std::vector<FMemorySearchHit> scalarHits;
+		std::vector<FMemorySearchHit> hits;
+		const double scalarTime = TimeIterations(kNoIterations, [&]() { SearchMemoryScalar(searchBanks.data(), (int)searchBanks.size(), patterns, scalarHits); });
+		const double searchTime = TimeIterations(kNoIterations, [&]() { SearchMemory(searchBanks.data(), (int)searchBanks.size(), patterns, hits); });
+
+		// check the search agrees with the byte loop
+		bool bMatch = hits.size() == scalarHits.size();
+		for (size_t i = 0; bMatch && i < hits.size(); i++)
+			bMatch = hits[i].Bank == scalarHits[i].Bank && hits[i].Offset == scalarHits[i].Offset && hits[i].Pattern == scalarHits[i].Pattern;
+		if (bMatch == false)
+			printf("MISMATCH: %s - %d hits, %d from byte loop\n", searchCase.Name, (int)hits.size(), (int)scalarHits.size());
+
+		printf("%-16s %10.2fus %10.2fus %8d\n", searchCase.Name, scalarTime, searchTime, (int)hits.size());
+	}
+}
+
+// Compare cheat search filtering against the byte loop on 128K of banked memory
+static void BenchmarkCheatSearch()
+{
+	static uint8_t banks[8][0x4000];
+	const int kNoIterations = 200;
+
+	srand(1234);
+	for (int bankNo = 0; bankNo < 8; bankNo++)
+	{
+		for (int i = 0; i < 0x4000; i++)
+			banks[bankNo][i] = (uint8_t)rand();
+	}
+
+	std::vector<FMemorySearchBank> searchBanks;
+	for (int bankNo = 0; bankNo < 8; bankNo++)
+		searchBanks.push_back({ "RAM " + std::to_string(bankNo), banks[bankNo], 0x4000 });
+
+	// every filter is against an unchanged snapshot so the candidate count only drops on the first one
+	const ECheatSearchCompare compares[] = { ECheatSearchCompare::Unchanged, ECheatSearchCompare::Changed };
+
+	printf("Cheat search filter (128K, %d iterations)\n", kNoIterations);
+	printf("%-16s %12s %12s %10s\n", "Case", "Byte loop", "Filter", "Candidates");
+
+	for (const ECheatSearchCompare compare : compares)
+	{
+		FCheatSearch scalarSearch;
+		FCheatSearch search;
+		StartCheatSearch(scalarSearch, searchBanks.data(), (int)searchBanks.size());
+		StartCheatSearch(search, searchBanks.data(), (int)searchBanks.size());
+
+		const double scalarTime = TimeIterations(kNoIterations, [&]() { FilterCheatSearchScalar(scalarSearch, searchBanks.data(), (int)searchBanks.size(), compare); });
+		const double filterTime = TimeIterations(kNoIterations, [&]() { FilterCheatSearch(search, searchBanks.data(), (int)searchBanks.size(), compare); });
+
+		if (search.NoCandidates != scalarSearch.NoCandidates || search.Candidates != scalarSearch.Candidates)
+			printf("MISMATCH: %s - %d candidates, %d from byte loop\n", GetCheatSearchCompareName(compare), (int)search.NoCandidates, (int)scalarSearch.NoCandidates);
+
+		printf("%-16s %10.2fus %10.2fus %10d\n", GetCheatSearchCompareName(compare), scalarTime, filterTime, (int)search.NoCandidates);
+	}
+}
+
+// Compare text discovery on one thread against all hardware threads on 128K of banked memory
+static void BenchmarkTextDiscovery()
+{
+	static uint8_t banks[8][0x4000];
+	const int kNoIterations = 50;
+	const char* pStrings[] = { "GAME OVER", "PRESS FIRE TO START", "HIGH SCORE", "ENTER YOUR NAME", "Lives" };
+
+	srand(1234);
+	for (int bankNo = 0; bankNo < 8; bankNo++)
+	{
+		for (int i = 0; i < 0x4000; i++)
+			banks[bankNo][i] = (uint8_t)rand();
+
+		// scatter zero terminated strings through the random data
+		for (int i = 0; i < 32; i++)
+		{
+			const char* pString = pStrings[rand() % 5];
+			const int offset = rand() % (0x4000 - 32);
+			memcpy(&banks[bankNo][offset], pString, strlen(pString) + 1);
+		}
+	}
+
+	std::vector<FMemorySearchBank> searchBanks;
+	for (int bankNo = 0; bankNo < 8; bankNo++)
+		searchBanks.push_back({ "RAM " + std::to_string(bankNo), banks[bankNo], 0x4000 });
+
+	FTextDiscoveryOptions options;
+	options.bEncodings[(int)ETextEncoding::SpectrumTokens] = true;
+	std::vector<FTextCandidate> singleCandidates;
+	std::vector<FTextCandidate> candidates;
+
+	FTextDiscoveryOptions singleOptions = options;
+	singleOptions.NoThreads = 1;
+	const double singleTime = TimeIterations(kNoIterations, [&]() { DiscoverText(searchBanks.data(), (int)searchBanks.size(), singleOptions, singleCandidates); });
+	const double threadedTime = TimeIterations(kNoIterations, [&]() { DiscoverText(searchBanks.data(), (int)searchBanks.size(), options, candidates); });
+
+	bool bMatch = candidates.size() == singleCandidates.size();
+	for (size_t i = 0; bMatch && i < candidates.size(); i++)
+		bMatch = candidates[i].Bank == singleCandidates[i].Bank && candidates[i].Offset == singleCandidates[i].Offset && candidates[i].Length == singleCandidates[i].Length;
+	if (bMatch == false)
+		printf("MISMATCH: %d candidates, %d from one thread\n", (int)candidates.size(), (int)singleCandidates.size());
+
+	printf("Text discovery (128K, %d iterations)\n", kNoIterations);
+	printf("%-16s %12s %12s %10s\n", "Case", "1 thread", "Threaded", "Candidates");
+	printf("%-16s %10.2fus %10.2fus %10d\n", "All encodings", singleTime, threadedTime, (int)candidates.size());
+}
+
+static FSpectrumEmu* StartBenchmarkGame(const FHeadlessOptions& options)
+{
+	FSpectrumConfig config;
+	config.Model = options.b128K ? ESpectrumModel::Spectrum128K : ESpectrumModel::Spectrum48K;
+	config.bHeadless = true;
+
+	FSpectrumEmu* pSpectrumEmulator = new FSpectrumEmu;
+	pSpectrumEmulator->Init(config);
+	if (StartHeadlessGame(pSpectrumEmulator, options.Game) == false || pSpectrumEmulator->pActiveGame == nullptr)
+	{
+		fprintf(stderr, "Failed to start game '%s'\n", options.Game.c_str());
+		delete pSpectrumEmulator;
+		return nullptr;
+	}
+	return pSpectrumEmulator;
+}
+
+// Time emulating & analysing a game with and without the decoded instruction cache
+// then the decode on its own over the instructions executed in the last frames, which is the part the cache replaces
+static bool BenchmarkDecodeCache(const FHeadlessOptions& options)
+{
+	const int kNoPasses = 6;
+	const size_t kMaxTraceSize = 1 << 20;
+	double seconds[2] = { 1e9, 1e9 };
+	std::vector<uint16_t> trace;
+	double decodeTime[2] = { 0.0, 0.0 };
+	for (int pass = 0; pass < kNoPasses; pass++)
+	{
+		const bool bCache = (pass & 1) != 0;
+		FSpectrumEmu* pSpectrumEmulator = StartBenchmarkGame(options);
+		if (pSpectrumEmulator == nullptr)
+			return false;
+
+		FCodeAnalysisState& state = pSpectrumEmulator->CodeAnalysis;
+		state.bCacheDecodedInstructions = bCache;
+		pSpectrumEmulator->Continue();
+
+		const auto startTime = std::chrono::steady_clock::now();
+		for (int frameNo = 0; frameNo < options.NoFrames; frameNo++)
+		{
+			pSpectrumEmulator->ExecuteFrame(kFrameMicroSeconds);
+			if (pSpectrumEmulator->IsStopped())
+				pSpectrumEmulator->Continue();
+			if (pass == kNoPasses - 1 && trace.size() < kMaxTraceSize)
+				trace.insert(trace.end(), state.FrameTrace.begin(), state.FrameTrace.end());
+		}
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+		seconds[bCache] = std::min(seconds[bCache], elapsed.count());
+
+		if (pass == kNoPasses - 1)
+		{
+			for (int cacheOn = 0; cacheOn < 2; cacheOn++)
+			{
+				state.bCacheDecodedInstructions = cacheOn != 0;
+				decodeTime[cacheOn] = TimeIterations(10, [&]()
+				{
+					for (uint16_t pc : trace)
+						GetDecodedInstruction(state, pc);
+				});
+			}
+		}
+		delete pSpectrumEmulator;
+	}
+
+	printf("Decoded instruction cache (%s, %d frames, best of %d)\n", options.Game.c_str(), options.NoFrames, kNoPasses / 2);
+	printf("%-16s %12s %12s %10s\n", "Case", "No cache", "Cache", "Speedup");
+	printf("%-16s %11.2fs %11.2fs %9.2fx\n", "Emulation", seconds[0], seconds[1], seconds[0] / std::max(seconds[1], 0.001));
+	printf("%-16s %10.2fms %10.2fms %9.2fx\n", "Decode", decodeTime[0] / 1000.0, decodeTime[1] / 1000.0, decodeTime[0] / std::max(decodeTime[1], 0.001));
+	printf("(decode is over %d executed instructions)\n", (int)trace.size());
+	return true;
+}
+
+// Time emulating a game with and without the write journal recording
+// The runs alternate and the best of each is kept so the order they run in doesn't skew the result
+static bool BenchmarkWriteJournal(const FHeadlessOptions& options)
+{
+	const int kNoPasses = 6;
+	double seconds[2] = { 1e9, 1e9 };
+	for (int pass = 0; pass < kNoPasses; pass++)
+	{
+		const bool bJournal = (pass & 1) != 0;
+		FSpectrumConfig config;
+		config.Model = options.b128K ? ESpectrumModel::Spectrum128K : ESpectrumModel::Spectrum48K;
+		config.bHeadless = true;	// the journal is off in headless mode
+
+		FSpectrumEmu* pSpectrumEmulator = new FSpectrumEmu;
+		pSpectrumEmulator->Init(config);
+		if (StartHeadlessGame(pSpectrumEmulator, options.Game) == false || pSpectrumEmulator->pActiveGame == nullptr)
+		{
+			fprintf(stderr, "Failed to start game '%s'\n", options.Game.c_str());
+			delete pSpectrumEmulator;
+			return false;
+		}
+
+		if (bJournal)
+			pSpectrumEmulator->WriteJournal.Init(pSpectrumEmulator, FWriteJournal::kDefaultMemoryBudget);
+		pSpectrumEmulator->Continue();
+
+		const auto startTime = std::chrono::steady_clock::now();
+		for (int frameNo = 0; frameNo < options.NoFrames; frameNo++)
+		{
+			pSpectrumEmulator->ExecuteFrame(kFrameMicroSeconds);
+			if (pSpectrumEmulator->IsStopped())
+				pSpectrumEmulator->Continue();
+		}
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+		seconds[bJournal] = std::min(seconds[bJournal], elapsed.count());
+
+		pSpectrumEmulator->WriteJournal.Shutdown();
+		delete pSpectrumEmulator;
+	}
+
+	printf("Write journal (%s, %d frames, best of %d)\n", options.Game.c_str(), options.NoFrames, kNoPasses / 2);
+	printf("%-16s %12s %12s %10s\n", "Case", "No journal", "Journal", "Overhead");
+	printf("%-16s %11.2fs %11.2fs %9.1f%%\n", "Emulation", seconds[0], seconds[1], (seconds[1] / std::max(seconds[0], 0.001) - 1.0) * 100.0);
+	return true;
+}
+
+// Disassembler check
+
+struct FDasmCheckContext
+{
+	const uint8_t*	pBytes = nullptr;
+	int				ReadPos = 0;
+	char			Text[32];
+	int				TextLength = 0;
+};
+
+static uint8_t DasmCheckInput(void* pUserData)
+{
+	FDasmCheckContext* pContext = (FDasmCheckContext*)pUserData;
+	return pContext->ReadPos < kDasmMaxInstructionBytes ? pContext->pBytes[pContext->ReadPos++] : 0;
+}
+
+static void DasmCheckOutput(char c, void* pUserData)
+{
+	FDasmCheckContext* pContext = (FDasmCheckContext*)pUserData;
+	if (pContext->TextLength < (int)sizeof(pContext->Text) - 1)
+		pContext->Text[pContext->TextLength++] = c;
+	pContext->Text[pContext->TextLength] = 0;
+}
+
+// Disassemble one byte sequence with both disassemblers, returns false if the text or length differ
+static bool CheckDasmBytes(ECPUType cpuType, const uint8_t* pBytes, int& noMismatches)
+{
+	const uint16_t kPC = 0x8000;
+	FDasmCheckContext context;
+	context.pBytes = pBytes;
+	context.Text[0] = 0;
+
+	int oldLength = 0;
+	FDasmInstruction instruction;
+	int newLength = 0;
+	if (cpuType == ECPUType::Z80)
+	{
+		oldLength = (uint16_t)(z80dasm_op(kPC, DasmCheckInput, DasmCheckOutput, &context) - kPC);
+		newLength = DisassembleZ80(pBytes, kPC, instruction);
+	}
+	else
+	{
+		oldLength = (uint16_t)(m6502dasm_op(kPC, DasmCheckInput, DasmCheckOutput, &context) - kPC);
+		newLength = Disassemble6502(pBytes, kPC, instruction);
+	}
+
+	FDasmFormatOptions options;	// both disassemblers output $ hex
+	char newText[32];
+	FormatDasmInstruction(instruction, options, newText, sizeof(newText));
+
+	if (oldLength == newLength && strcmp(context.Text, newText) == 0)
+		return true;
+
+	if (noMismatches++ < 20)
+	{
+		printf("MISMATCH: %s", cpuType == ECPUType::Z80 ? "Z80 " : "6502");
+		for (int i = 0; i < kDasmMaxInstructionBytes; i++)
+			printf(" %02X", pBytes[i]);
+		printf(" - '%s' (%d bytes), '%s' (%d bytes) from old\n", newText, newLength, context.Text, oldLength);
+	}
+	return false;
+}
+
+// Every opcode is disassembled with every value of its operand bytes
+// Z80: all 3 byte sequences, then every DD/FD/ED prefixed instruction with all of its next 3 bytes to cover DDCB d op & 16 bit operands after a prefix
+// 6502: all 3 byte sequences
+static bool CheckDisassembler()
+{
+	SetNumberDisplayMode(ENumberDisplayMode::HexDollar);	// the chips number output hooks use the global mode
+
+	int noMismatches = 0;
+	uint64_t noChecked = 0;
+	uint8_t bytes[kDasmMaxInstructionBytes] = { 0 };
+	const auto startTime = std::chrono::steady_clock::now();
+
+	for (int seq = 0; seq < 0x1000000; seq++, noChecked++)
+	{
+		bytes[0] = (uint8_t)(seq >> 16);
+		bytes[1] = (uint8_t)(seq >> 8);
+		bytes[2] = (uint8_t)seq;
+		CheckDasmBytes(ECPUType::Z80, bytes, noMismatches);
+	}
+
+	const uint8_t prefixes[] = { 0xDD, 0xFD, 0xED };
+	for (uint8_t prefix : prefixes)
+	{
+		bytes[0] = prefix;
+		for (int seq = 0; seq < 0x1000000; seq++, noChecked++)
+		{
+			bytes[1] = (uint8_t)(seq >> 16);
+			bytes[2] = (uint8_t)(seq >> 8);
+			bytes[3] = (uint8_t)seq;
+			CheckDasmBytes(ECPUType::Z80, bytes, noMismatches);
+		}
+	}
+
+	memset(bytes, 0, sizeof(bytes));
+	for (int seq = 0; seq < 0x1000000; seq++, noChecked++)
+	{
+		bytes[0] = (uint8_t)(seq >> 16);
+		bytes[1] = (uint8_t)(seq >> 8);
+		bytes[2] = (uint8_t)seq;
+		CheckDasmBytes(ECPUType::M6502, bytes, noMismatches);
+	}
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+	printf("Disassembler check: %llu byte sequences, %d mismatches (%.1fs)\n", (unsigned long long)noChecked, noMismatches, elapsed.count());
+	return noMismatches == 0;
+}
+
+// Time saving the analysis after running the game to build one up - taking the snapshot the save thread writes from,
+// then writing the analysis json & reading it back into a freshly started copy of the game
+static bool BenchmarkAnalysisSave(const FHeadlessOptions& options)
+{
+	const int kNoIterations = 20;
+	const char* kJsonFileName = "HeadlessBenchmark.json";
+
+	FSpectrumEmu* pSpectrumEmulator = StartBenchmarkGame(options);
+	if (pSpectrumEmulator == nullptr)
+		return false;
+
+	pSpectrumEmulator->Continue();
+	for (int frameNo = 0; frameNo < options.NoFrames; frameNo++)
+	{
+		pSpectrumEmulator->ExecuteFrame(kFrameMicroSeconds);
+		if (pSpectrumEmulator->IsStopped())
+			pSpectrumEmulator->Continue();
+	}
+
+	const double snapshotTime = TimeIterations(kNoIterations, [&]() { delete pSpectrumEmulator->TakeAnalysisSnapshot(); });
+	bool bSuccess = true;
+	const double exportTime = TimeIterations(kNoIterations, [&]() { bSuccess &= ExportGameJson(pSpectrumEmulator, kJsonFileName); });
+	delete pSpectrumEmulator;
+
+	// importing twice would add everything twice, so this is a single run
+	double importTime = 0.0;
+	pSpectrumEmulator = StartBenchmarkGame(options);
+	if (pSpectrumEmulator != nullptr)
+	{
+		importTime = TimeIterations(1, [&]() { bSuccess &= ImportAnalysisJson(pSpectrumEmulator->CodeAnalysis, kJsonFileName); });
+		delete pSpectrumEmulator;
+	}
+	remove(kJsonFileName);
+
+	printf("Analysis save (%s, after %d frames)\n", options.Game.c_str(), options.NoFrames);
+	printf("%-16s %12s\n", "Case", "Time");
+	printf("%-16s %10.2fms\n", "Snapshot", snapshotTime / 1000.0);
+	printf("%-16s %10.2fms\n", "Json export", exportTime / 1000.0);
+	printf("%-16s %10.2fms\n", "Json import", importTime / 1000.0);
+	return bSuccess && pSpectrumEmulator != nullptr;
+}
+
+int main(int argc, char** argv)
+{
+	FHeadlessOptions options;
+	if (ParseCommandLine(argc, argv, options) == false)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (options.bDasmCheck)
+		return CheckDisassembler() ? 0 : 1;
+
+	if (options.bBenchmark && options.Game.empty() == false)
+	{
+		LoadGlobalConfig(kGlobalConfigFilename);
+		ImGui::CreateContext();
+		const bool bSuccess = BenchmarkDecodeCache(options) && BenchmarkWriteJournal(options) && BenchmarkAnalysisSave(options);
+		ImGui::DestroyContext();
+		return bSuccess ? 0 : 1;
+	}
+
+	if (options.bBenchmark)
+	{
+		BenchmarkMemoryDiff();
+		BenchmarkMemorySearch();
+		BenchmarkCheatSearch();
+		BenchmarkTextDiscovery();
+		return 0;
+	}
+
+	// the output folders come from the config, emulator Init would load it too late for those
+	LoadGlobalConfig(kGlobalConfigFilename);
+
+	std::vector<FScriptedKeyEvent> inputEvents;
+	if (options.InputScript.empty() == false && LoadInputScript(options.InputScript.c_str(), inputEvents) == false)
+	{
+		fprintf(stderr, "Failed to load input script '%s'\n", options.InputScript.c_str());
+		return 1;
+	}
+
+	int retVal = 0;
+	if (options.CorpusDir.empty() == false)
+	{
+		retVal = RunCorpus(options, inputEvents);	// the workers create their own ImGui contexts
+	}
+	else
+	{
+		// The chips debugger UI needs a context to look up key indices, we never build a frame
+		ImGui::CreateContext();
+
+		const std::string outDir = GetGlobalConfig().WorkspaceRoot + "GameData/";
+		if (options.OutputFile.empty())
+			EnsureDirectoryExists(outDir.c_str());
+
+		FGameRunResult result;
+		RunGame(options, options.Game, inputEvents, outDir, result);
+		PrintResult(options, result);
+		retVal = result.bSuccess ? 0 : 1;
+
+		ImGui::DestroyContext();
+	}
+
+	return retVal;
+}
+
+// sokol_audio - the implementation pulls in the platform audio libraries so we provide the calls the emulator uses
+int saudio_sample_rate(void)
+{
+	return 0;	// zx_init picks the default
+}
+
+int saudio_push(const float* frames, int num_frames)
+{
+	return num_frames;
+}
+
+// App.h - there's no window to update
+void SetWindowTitle(const char* pTitle)
+{
+}
+
+void SetWindowIcon(const char* pIconFile)
+{
+}
@@ -437,7 +437,7 @@ bool ImportSkoolKitFile(FCodeAnalysisState& state, const char* pTextFileName, FS
 			FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(instruction.Address);
 			if (pCodeInfo)
 			{
-				LOGWARNING("Item at $%02X was set to code: %s",instruction.Address, pCodeInfo->Text.c_str());
+				LOGWARNING("Item at $%02X was set to code: %s",instruction.Address, GetCodeInfoText(state, pCodeInfo));
 				LOGWARNING("Code item removed and replace as data");
 				// remove the code item
 				state.SetCodeInfoForAddress(instruction.Address, nullptr);	// memory will get cleared up 
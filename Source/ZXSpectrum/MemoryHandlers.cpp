@@ -3,6 +3,60 @@
 #include "SpectrumEmu.h"
 #include "CodeAnalyser/UI/CodeAnalyserUI.h"
 #include <Util/Misc.h>
+#include <Util/MemoryDiff.h>
+
+void BuildMemoryHandlerDispatch(FMemoryHandlerDispatch& dispatch, std::vector<FMemoryAccessHandler>& handlers)
+{
+	for (int type = 0; type < FMemoryHandlerDispatch::kNoAccessTypes; type++)
+	{
+		dispatch.PageMask[type] = 0;
+		for (int page = 0; page < FMemoryHandlerDispatch::kNoPages; page++)
+			dispatch.PageHandlers[type][page].clear();
+	}
+
+	for (int handlerIndex = 0; handlerIndex < (int)handlers.size(); handlerIndex++)
+	{
+		FMemoryAccessHandler& handler = handlers[handlerIndex];
+		if (handler.MemEnd < handler.MemStart)
+			continue;
+
+		handler.AddressCounts.resize(handler.MemEnd - handler.MemStart + 1);
+
+		const int type = (int)handler.Type;
+		const int startPage = handler.MemStart >> FMemoryHandlerDispatch::kPageShift;
+		const int endPage = handler.MemEnd >> FMemoryHandlerDispatch::kPageShift;
+		for (int page = startPage; page <= endPage; page++)
+		{
+			dispatch.PageHandlers[type][page].push_back((uint16_t)handlerIndex);
+			dispatch.PageMask[type] |= 1ull << page;
+		}
+	}
+
+	dispatch.bDirty = false;
+}
+
+// Call the handlers in a page's list that cover the address
+static int CallMemoryHandlers(FSpectrumEmu* pEmu, const std::vector<uint16_t>& handlerIndices, uint16_t addr, uint16_t pc, uint64_t pins)
+{
+	for (const uint16_t handlerIndex : handlerIndices)
+	{
+		FMemoryAccessHandler& handler = pEmu->MemoryAccessHandlers[handlerIndex];
+		if (handler.bEnabled == false || addr < handler.MemStart || addr > handler.MemEnd)
+			continue;
+
+		// update handler stats
+		handler.TotalCount++;
+		handler.CallerCounts[pc]++;
+		handler.AddressCounts[addr - handler.MemStart]++;
+		if (handler.pHandlerFunction != nullptr)
+			handler.pHandlerFunction(handler, pEmu->pActiveGame, pc, pins);
+
+		if (handler.bBreak)
+			return UI_DBG_STEP_TRAPID;
+	}
+
+	return 0;
+}
 
 int MemoryHandlerTrapFunction(uint16_t pc, int ticks, uint64_t pins, FSpectrumEmu*pEmu)
 {
@@ -23,49 +77,27 @@ int MemoryHandlerTrapFunction(uint16_t pc, int ticks, uint64_t pins, FSpectrumEm
 	if (bWrite)
 		pEmu->MemStats.WriteCount[addr]++;
 
+	FMemoryHandlerDispatch& dispatch = pEmu->MemoryHandlerDispatch;
+	if (dispatch.bDirty)
+		BuildMemoryHandlerDispatch(dispatch, pEmu->MemoryAccessHandlers);
+
 	// See if we can find a handler
-	for (auto& handler : pEmu->MemoryAccessHandlers)
-	{
-		if (handler.bEnabled == false)
-			continue;
+	int trapId = 0;
+	const int pcPage = pc >> FMemoryHandlerDispatch::kPageShift;
+	const int addrPage = addr >> FMemoryHandlerDispatch::kPageShift;
 
-		bool bCallHandler = false;
+	if (dispatch.PageMask[(int)MemoryAccessType::Execute] & (1ull << pcPage))
+		trapId = CallMemoryHandlers(pEmu, dispatch.PageHandlers[(int)MemoryAccessType::Execute][pcPage], pc, pc, pins);
 
-		if (handler.Type == MemoryAccessType::Execute)	// Execution
-		{
-			if (pc >= handler.MemStart && pc <= handler.MemEnd)
-				bCallHandler = true;
-		}
-		else // Memory access
-		{
-			if (addr >= handler.MemStart && addr <= handler.MemEnd)
-			{
-				bool bExecute = false;
+	if (trapId == 0 && bRead && (dispatch.PageMask[(int)MemoryAccessType::Read] & (1ull << addrPage)))
+		trapId = CallMemoryHandlers(pEmu, dispatch.PageHandlers[(int)MemoryAccessType::Read][addrPage], addr, pc, pins);
 
-				if (handler.Type == MemoryAccessType::Read && bRead)
-					bCallHandler = true;
-				else if (handler.Type == MemoryAccessType::Write && bWrite)
-					bCallHandler = true;
-			}
-		}
+	if (trapId == 0 && bWrite && (dispatch.PageMask[(int)MemoryAccessType::Write] & (1ull << addrPage)))
+		trapId = CallMemoryHandlers(pEmu, dispatch.PageHandlers[(int)MemoryAccessType::Write][addrPage], addr, pc, pins);
 
-		if (bCallHandler)
-		{
-			// update handler stats
-			handler.TotalCount++;
-			handler.CallerCounts[pc]++;
-			handler.AddressCounts[addr]++;
-			if (handler.pHandlerFunction != nullptr)
-				handler.pHandlerFunction(handler, pEmu->pActiveGame, pc, pins);
-
-			if (handler.bBreak)
-				return UI_DBG_STEP_TRAPID;
-		}
-	}
-	
 	assert(!(bRead == true && bWrite == true));
 
-	return 0;
+	return trapId;
 }
 
 
@@ -250,11 +282,18 @@ void DrawMemoryDiffUI(FSpectrumEmu* pSpectrumEmu)
 
 		if (ImGui::Button("Diff"))
 		{
-			g_DiffChangedLocations.clear();
+			static uint8_t currentMemory[1 << 16];
 			for (int addr = startAddr; addr < (1 << 16); addr++)
+				currentMemory[addr] = pSpectrumEmu->ReadByte(addr);
+
+			std::vector<FMemoryDiffRun> diffRuns;
+			DiffMemory(&currentMemory[startAddr], &g_DiffSnapShotMemory[startAddr], (1 << 16) - startAddr, diffRuns);
+
+			g_DiffChangedLocations.clear();
+			for (const FMemoryDiffRun& run : diffRuns)
 			{
-				if (pSpectrumEmu->ReadByte( addr) != g_DiffSnapShotMemory[addr])
-					g_DiffChangedLocations.push_back(addr);
+				for (uint32_t i = 0; i < run.Size; i++)
+					g_DiffChangedLocations.push_back((uint16_t)(startAddr + run.Offset + i));
 			}
 		}
 	}
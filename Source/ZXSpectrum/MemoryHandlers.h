@@ -1,9 +1,10 @@
 #pragma once
 #include <cstdint>
 #include <vector>
-#include <map>
 #include <string>
 
+#include "CodeAnalyser/CodeReferenceSet.h"
+
 class FSpectrumEmu;
 struct FGame;
 
@@ -54,11 +55,25 @@ struct FMemoryAccessHandler
 	void(*pHandlerFunction)(FMemoryAccessHandler &handler, FGame* pGame, uint16_t pc, uint64_t pins) = nullptr;
 
 	// stats
-	int						TotalCount = 0;
-	std::map<uint16_t, int>	CallerCounts;
-	std::map<uint16_t, int>	AddressCounts;
+	int					TotalCount = 0;
+	FCodeReferenceSet	CallerCounts;	// count for each calling PC
+	std::vector<int>	AddressCounts;	// count for each address from MemStart to MemEnd
+};
+
+// Lookup of which handlers cover each 1K page, for each access type
+// Rebuilt when the handler list changes so an access with no handler costs one bit test
+struct FMemoryHandlerDispatch
+{
+	static const int kPageShift = 10;
+	static const int kNoPages = 1 << (16 - kPageShift);
+	static const int kNoAccessTypes = 3;
+
+	bool					bDirty = true;
+	uint64_t				PageMask[kNoAccessTypes] = { 0 };	// bit set for pages with handlers
+	std::vector<uint16_t>	PageHandlers[kNoAccessTypes][kNoPages];	// handler indices for each page
 };
 
+void BuildMemoryHandlerDispatch(FMemoryHandlerDispatch& dispatch, std::vector<FMemoryAccessHandler>& handlers);
 
 
 int MemoryHandlerTrapFunction(uint16_t pc, int ticks, uint64_t pins, FSpectrumEmu* pEmu);
@@ -9,7 +9,8 @@
 
 #include "rzx.h"
 
-static FRZXManager* g_pManager = nullptr;
+// rzx callbacks don't carry user data so we need to find the manager from here
+static thread_local FRZXManager* g_pManager = nullptr;
 
 rzx_u32 RZXCallback(int msg, void* param)
 {
@@ -33,7 +34,7 @@ bool	FRZXManager::Init(FSpectrumEmu* pEmu)
         return false;
 
     Initialised = true;
-    g_pManager = this;  // crap
+    g_pManager = this;  // crap - rzx-sdk state is global so there can only be one manager in use
     return true;
 }
 
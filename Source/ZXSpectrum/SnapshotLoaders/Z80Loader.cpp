@@ -14,5 +14,10 @@ bool LoadZ80File(FSpectrumEmu* pEmu, const char* fName)
 
 bool LoadZ80FromMemory(FSpectrumEmu* pEmu, const uint8_t* pData, size_t dataSize)
 {
-	return zx_quickload(&pEmu->ZXEmuState, (const uint8_t*)pData, (int)dataSize);
+	if (zx_quickload(&pEmu->ZXEmuState, (const uint8_t*)pData, (int)dataSize) == false)
+		return false;
+
+	// quickload writes RAM directly
+	InvalidateAllDecodedInstructions(pEmu->CodeAnalysis);
+	return true;
 }
\ No newline at end of file
@@ -26,15 +26,21 @@ void DasmOutputD8(int8_t val, z80dasm_output_t out_cb, void* user_data);
 #include "Viewers/GraphicsViewer.h"
 #include "Viewers/BreakpointViewer.h"
 #include "Viewers/OverviewViewer.h"
+#include "Viewers/ProfilerViewer.h"
+#include "Viewers/CheatFinderViewer.h"
+#include "Viewers/TextDiscoveryViewer.h"
 #include "Util/FileUtil.h"
 
 #include "ui/ui_dbg.h"
 #include "MemoryHandlers.h"
 #include "CodeAnalyser/CodeAnalyser.h"
 #include "CodeAnalyser/UI/CodeAnalyserUI.h"
+#include "CodeAnalyser/Z80/CodeAnalyserZ80.h"
+#include "CodeAnalyser/Z80/OpcodeTableZ80.h"
 
 #include "zx-roms.h"
 #include <algorithm>
+#include <mutex>
 #include <sokol_audio.h>
 #include "Exporters/SkoolkitExporter.h"
 #include "Importers/SkoolkitImporter.h"
@@ -48,6 +54,8 @@ void DasmOutputD8(int8_t val, z80dasm_output_t out_cb, void* user_data);
 #include "Exporters/SkoolFileInfo.h"
 #include "Exporters/AssemblerExport.h"
 #include "Exporters/JsonExport.h"
+#include "CodeAnalyser/AnalysisSnapshot.h"
+#include "Util/MemoryBuffer.h"
 #include "CodeAnalyser/UI/CharacterMapViewer.h"
 #include "GameConfig.h"
 #include "App.h"
@@ -63,29 +71,40 @@ const char* kRomInfo48JsonFile = "RomInfo.json";
 const char* kRomInfo128JsonFile = "RomInfo128.json";
 const std::string kAppTitle = "Spectrum Analyser";
 
+// number output for the chips debugger disassembly windows
+static void DasmOutputString(const char* pString, z80dasm_output_t out_cb, void* user_data)
+{
+	if (out_cb == nullptr)
+		return;
+	while (*pString != 0)
+		out_cb(*pString++, user_data);
+}
+
 /* output an unsigned 8-bit value as hex string */
 void DasmOutputU8(uint8_t val, z80dasm_output_t out_cb, void* user_data) 
 {
-	IDasmNumberOutput* pNumberOutput = GetNumberOutput();
-	if(pNumberOutput)
-		pNumberOutput->OutputU8(val, out_cb);
-	
+	DasmOutputString(NumStr(val), out_cb, user_data);
 }
 
 /* output an unsigned 16-bit value as hex string */
 void DasmOutputU16(uint16_t val, z80dasm_output_t out_cb, void* user_data) 
 {
-	IDasmNumberOutput* pNumberOutput = GetNumberOutput();
-	if (pNumberOutput)
-		pNumberOutput->OutputU16(val, out_cb);
+	DasmOutputString(NumStr(val), out_cb, user_data);
 }
 
 /* output a signed 8-bit offset as hex string */
 void DasmOutputD8(int8_t val, z80dasm_output_t out_cb, void* user_data) 
 {
-	IDasmNumberOutput* pNumberOutput = GetNumberOutput();
-	if (pNumberOutput)
-		pNumberOutput->OutputD8(val, out_cb);
+	if (val < 0)
+	{
+		DasmOutputString("-", out_cb, user_data);
+		val = -val;
+	}
+	else
+	{
+		DasmOutputString("+", out_cb, user_data);
+	}
+	DasmOutputString(NumStr((uint8_t)val), out_cb, user_data);
 }
 
 // Memory access functions
@@ -190,6 +209,31 @@ const uint8_t* FSpectrumEmu::GetMemPtr(uint16_t address) const
 void FSpectrumEmu::WriteByte(uint16_t address, uint8_t value)
 {
 	MemWriteFunc(CurrentLayer, address, value, &ZXEmuState);
+	InvalidateDecodedInstructions(CodeAnalysis, address);
+}
+
+// Cheat entries with a bank go to that 128K RAM bank whatever is paged in
+uint8_t FSpectrumEmu::ReadCheatByte(const FCheatMemoryEntry& entry) const
+{
+	if (entry.Bank != -1 && ZXEmuState.type == ZX_TYPE_128)
+		return ZXEmuState.ram[entry.Bank & 7][entry.Address & 0x3fff];
+	return ReadByte(entry.Address);
+}
+
+void FSpectrumEmu::WriteCheatByte(const FCheatMemoryEntry& entry, uint8_t value)
+{
+	if (entry.Bank != -1 && ZXEmuState.type == ZX_TYPE_128)
+	{
+		const uint16_t bankAddr = entry.Address & 0x3fff;
+		ZXEmuState.ram[entry.Bank & 7][bankAddr] = value;
+		// the bank might not be paged in so go to its page rather than the one at the address
+		FCodeAnalysisPage& bankPage = RAMPages[(entry.Bank & 7) * kNoBankPages + bankAddr / FCodeAnalysisPage::kPageSize];
+		InvalidateDecodedInstructions(bankPage, bankAddr & FCodeAnalysisState::kPageMask);
+	}
+	else
+	{
+		WriteByte(entry.Address, value);
+	}
 }
 
 
@@ -211,59 +255,36 @@ void* FSpectrumEmu::GetCPUEmulator(void)
 
 bool FSpectrumEmu::IsAddressBreakpointed(uint16_t addr)
 {
-	for (int i = 0; i < UIZX.dbg.dbg.num_breakpoints; i++) 
-	{
-		if (UIZX.dbg.dbg.breakpoints[i].addr == addr)
-			return true;
-	}
-
-	return false;
+	return HasBreakpointAtAddress(CodeAnalysis, addr);
 }
 
 bool FSpectrumEmu::ToggleExecBreakpointAtAddress(uint16_t addr)
 {
-	int index = _ui_dbg_bp_find(&UIZX.dbg, UI_DBG_BREAKTYPE_EXEC, addr);
-	if (index >= 0) 
+	const int index = FindBreakpoint(CodeAnalysis, BreakpointType_Exec, addr);
+	if (index >= 0)
 	{
-		/* breakpoint already exists, remove */
-		_ui_dbg_bp_del(&UIZX.dbg, index);
+		// breakpoint already exists, remove
+		RemoveBreakpoint(CodeAnalysis, index);
 		return false;
 	}
-	else 
-	{
-		/* breakpoint doesn't exist, add a new one */
-		return _ui_dbg_bp_add_exec(&UIZX.dbg, true, addr);
-	}
+
+	AddBreakpoint(CodeAnalysis, BreakpointType_Exec, addr);
+	return true;
 }
 
+// data breakpoints watch for writes over the whole item
 bool FSpectrumEmu::ToggleDataBreakpointAtAddress(uint16_t addr, uint16_t dataSize)
 {
-	const int type = dataSize == 1 ? UI_DBG_BREAKTYPE_BYTE : UI_DBG_BREAKTYPE_WORD;
-	int index = _ui_dbg_bp_find(&UIZX.dbg, type, addr);
+	const int index = FindBreakpoint(CodeAnalysis, BreakpointType_Write, addr);
 	if (index >= 0)
 	{
 		// breakpoint already exists, remove 
-		_ui_dbg_bp_del(&UIZX.dbg, index);
+		RemoveBreakpoint(CodeAnalysis, index);
 		return false;
 	}
-	else
-	{
-		// breakpoint doesn't exist, add a new one 
-		if (UIZX.dbg.dbg.num_breakpoints < UI_DBG_MAX_BREAKPOINTS)
-		{
-			ui_dbg_breakpoint_t* bp = &UIZX.dbg.dbg.breakpoints[UIZX.dbg.dbg.num_breakpoints++];
-			bp->type = type;
-			bp->cond = UI_DBG_BREAKCOND_NONEQUAL;
-			bp->addr = addr;
-			bp->val = ReadByte(addr);
-			bp->enabled = true;
-			return true;
-		}
-		else 
-		{
-			return false;
-		}
-	}
+
+	AddBreakpoint(CodeAnalysis, BreakpointType_Write, addr, dataSize);
+	return true;
 }
 
 void FSpectrumEmu::Break(void)
@@ -298,6 +319,54 @@ void FSpectrumEmu::StepScreenWrite()
 	bStepToNextScreenWrite = true;
 }
 
+bool FSpectrumEmu::CanStepBack(void) const
+{
+	return IsStopped() && WriteJournal.IsEnabled() && WriteJournal.GetInstructionNo() > WriteJournal.GetOldestInstructionNo();
+}
+
+void FSpectrumEmu::StepBackInto(void)
+{
+	if (CanStepBack())
+		WriteJournal.StepBackTo(WriteJournal.GetInstructionNo() - 1);
+}
+
+static bool IsReturnInstructionZ80(const ICPUInterface* pCPUInterface, uint16_t pc)
+{
+	const EZ80Flow flow = GetOpcodeInfoZ80(pCPUInterface, pc).Flow;
+	return flow == EZ80Flow::Return || flow == EZ80Flow::ReturnCC;
+}
+
+// Step back to the previous instruction, if it was a return step back to the call instead
+void FSpectrumEmu::StepBackOver(void)
+{
+	if (CanStepBack() == false)
+		return;
+
+	const uint64_t oldestInstructionNo = WriteJournal.GetOldestInstructionNo();
+	uint64_t targetInstructionNo = WriteJournal.GetInstructionNo() - 1;
+
+	if (IsReturnInstructionZ80(this, WriteJournal.GetInstructionPC(targetInstructionNo)))
+	{
+		// find the call that returns here
+		const uint16_t returnAddress = GetPC();
+		for (uint64_t instructionNo = targetInstructionNo; instructionNo-- > oldestInstructionNo;)
+		{
+			const uint16_t callPC = WriteJournal.GetInstructionPC(instructionNo);
+			if (CheckCallInstructionZ80(this, callPC) == false)
+				continue;
+
+			const uint16_t callLength = GetOpcodeInfoZ80(this, callPC).Length;
+			if ((uint16_t)(callPC + callLength) == returnAddress && WriteJournal.GetInstructionPC(instructionNo + 1) != returnAddress)
+			{
+				targetInstructionNo = instructionNo;
+				break;
+			}
+		}
+	}
+
+	WriteJournal.StepBackTo(targetInstructionNo);
+}
+
 void FSpectrumEmu::GraphicsViewerSetView(uint16_t address, int charWidth)
 {
 	GraphicsViewerGoToAddress(address);
@@ -411,7 +480,8 @@ void gfx_destroy_texture(void* h)
 static void PushAudio(const float* samples, int num_samples, void* user_data)
 {
 	FSpectrumEmu* pEmu = (FSpectrumEmu*)user_data;
-	if(GetGlobalConfig().bEnableAudio)
+	// stepping back replays instructions which shouldn't be heard again
+	if(pEmu->bHeadless == false && GetGlobalConfig().bEnableAudio && pEmu->WriteJournal.IsReplaying() == false)
 		saudio_push(samples, num_samples);
 }
 
@@ -422,15 +492,21 @@ int ZXSpectrumTrapCallback(uint16_t pc, int ticks, uint64_t pins, void* user_dat
 }
 
 
-// Note - you can't read register values in Trap function
-// They are only written back at end of exec function
+// Writing the registers back for every trap is slow so it's only done for breakpoint conditions & journal snapshots
+void FSpectrumEmu::UpdateTrapRegisterFlush()
+{
+	ZXEmuState.cpu.trap_flush_regs = CodeAnalysis.bBreakpointConditions || WriteJournal.IsSnapshotDue();
+}
+
+// Note - register values are only written back to the cpu struct for the trap when trap_flush_regs is set
+// That is only done when something in here needs them - see UpdateTrapRegisterFlush
 int	FSpectrumEmu::TrapFunction(uint16_t pc, int ticks, uint64_t pins)
 {
 	FCodeAnalysisState &state = CodeAnalysis;
 	const uint16_t addr = Z80_GET_ADDR(pins);
 	const bool bMemAccess = !!((pins & Z80_CTRL_MASK) & Z80_MREQ);
 	const bool bWrite = (pins & Z80_CTRL_MASK) == (Z80_MREQ | Z80_WR);
-	const bool irq = (pins & Z80_INT) && z80_iff1(&ZXEmuState.cpu);	
+	const bool irq = ZXEmuState.cpu.internal_state.IRQ;	// interrupt taken after this instruction
 
 	const uint16_t nextpc = pc;
 	// store program count in history
@@ -440,6 +516,10 @@ int	FSpectrumEmu::TrapFunction(uint16_t pc, int ticks, uint64_t pins)
 
 	pc = prevPC;	// set PC to pc of instruction just executed
 
+	// so the write journal can undo this instruction's call stack change
+	const size_t callStackDepth = state.CallStack.size();
+	const FCPUFunctionCall callStackTop = callStackDepth != 0 ? state.CallStack.back() : FCPUFunctionCall();
+
 	if (irq)
 	{
 		FCPUFunctionCall callInfo;
@@ -451,11 +531,58 @@ int	FSpectrumEmu::TrapFunction(uint16_t pc, int ticks, uint64_t pins)
 	}
 
 	bool bBreak = RegisterCodeExecuted(state, pc, nextpc);
+
+	// replayed instructions are profiled again so the profiler's stack follows the call stack
+	if (Profiler.bEnabled)
+		Profiler.RegisterInstruction(state, ticks, irq, bHasInterruptHandler ? InterruptHandlerAddress : 0x0038);	// IM 1 handler is at 0x38
+
+	// journal the instruction - when stepping back the instructions being replayed don't break
+	if (WriteJournal.IsEnabled())
+	{
+		if (state.CallStack.size() != callStackDepth)
+			WriteJournal.RecordCallStackChange(callStackDepth, callStackTop);
+
+		const bool bReplayDone = WriteJournal.RecordInstruction(pc, pins);
+		UpdateTrapRegisterFlush();
+		if (bReplayDone || WriteJournal.IsReplaying())
+		{
+			NoBreakpointAccesses = 0;
+			return bReplayDone ? UI_DBG_STEP_TRAPID : 0;
+		}
+	}
+
 	//FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(pc);
 	//pCodeInfo->FrameLastAccessed = state.CurrentFrameNo;
 	// check for breakpointed code line
 	if (bBreak)
 		return UI_DBG_BP_BASE_TRAPID;
+
+	// breakpoints - data accesses were recorded in Z80Tick, exec is checked before the next instruction runs
+	// conditions are evaluated here because the registers are only valid in the trap
+	if (NoBreakpointAccesses != 0)
+	{
+		const int hit = RegisterBreakpointAccessHits(state, BreakpointAccesses, NoBreakpointAccesses);
+		NoBreakpointAccesses = 0;
+		if (hit != -1)
+		{
+			state.LastHitBreakpoint = hit;
+			return UI_DBG_BP_BASE_TRAPID;
+		}
+	}
+
+	if (state.IsExecBreakpointed(nextpc))
+	{
+		FBreakpointContext context;
+		context.pCPUInterface = this;
+		context.Address = nextpc;
+		context.FrameNo = state.CurrentFrameNo;
+		const int hit = RegisterBreakpointHit(state, BreakpointType_Exec, context);
+		if (hit != -1)
+		{
+			state.LastHitBreakpoint = hit;
+			return UI_DBG_BP_BASE_TRAPID;
+		}
+	}
 	
 	int trapId = MemoryHandlerTrapFunction(pc, ticks, pins, this);
 
@@ -477,7 +604,7 @@ int	FSpectrumEmu::TrapFunction(uint16_t pc, int ticks, uint64_t pins)
 	}
 #endif
 	// work out stack size
-	const uint16_t sp = z80_sp(&ZXEmuState.cpu);	// this won't get the proper stack pos (see comment above function)
+	const uint16_t sp = ZXEmuState.cpu.internal_state.SP;	// SP before the instruction - the registers may not have been flushed (see comment above function)
 	if (sp == state.StackMin - 2 || state.StackMin == 0xffff)
 		state.StackMin = sp;
 	if (sp == state.StackMax + 2 || state.StackMax == 0 )
@@ -485,7 +612,7 @@ int	FSpectrumEmu::TrapFunction(uint16_t pc, int ticks, uint64_t pins)
 
 	// work out instruction count
 	int iCount = 1;
-	uint8_t opcode = ReadByte(pc);
+	const uint8_t opcode = GetDecodedInstruction(state, pc).Opcode;
 	if (opcode == 0xED || opcode == 0xCB)
 		iCount++;
 
@@ -539,6 +666,15 @@ uint64_t FSpectrumEmu::Z80Tick(int num, uint64_t pins)
 			{
 				if (state.bRegisterDataAccesses)
 					RegisterDataRead(state, pc, addr);
+
+				// ignore opcode fetches
+				if ((pins & Z80_M1) == 0 && state.IsReadBreakpointed(addr) && NoBreakpointAccesses < kMaxBreakpointAccesses)
+				{
+					FBreakpointAccess& access = BreakpointAccesses[NoBreakpointAccesses++];
+					access.Type = BreakpointType_Read;
+					access.Address = addr;
+					access.Value = access.OldValue = ReadByte(addr);
+				}
 			}
 		}
 		else if (pins & Z80_WR) 
@@ -546,6 +682,24 @@ uint64_t FSpectrumEmu::Z80Tick(int num, uint64_t pins)
 			if (state.bRegisterDataAccesses)
 				RegisterDataWrite(state, pc, addr);
 
+			// journal RAM writes - ROM writes go to a junk page
+			if (WriteJournal.IsEnabled())
+			{
+				const uint8_t* pWrite = ZXEmuState.mem.page_table[addr >> MEM_PAGE_SHIFT].write_ptr + (addr & MEM_PAGE_MASK);
+				const size_t ramOffset = pWrite - &ZXEmuState.ram[0][0];
+				if (ramOffset < sizeof(ZXEmuState.ram))
+					WriteJournal.RecordWrite((uint32_t)ramOffset, *pWrite);
+			}
+
+			if (state.IsWriteBreakpointed(addr) && NoBreakpointAccesses < kMaxBreakpointAccesses)
+			{
+				FBreakpointAccess& access = BreakpointAccesses[NoBreakpointAccesses++];
+				access.Type = BreakpointType_Write;
+				access.Address = addr;
+				access.Value = value;
+				access.OldValue = ReadByte(addr);	// memory hasn't been written yet
+			}
+
 			state.SetLastWriterForAddress(addr,pc);
 
 			// Log screen pixel writes
@@ -564,6 +718,7 @@ uint64_t FSpectrumEmu::Z80Tick(int num, uint64_t pins)
 				// TODO: record some info such as what byte was written
 				pCodeWrittenTo->bSelfModifyingCode = true;
 			}
+			InvalidateDecodedInstructions(state, addr);
 		}
 	}
 	else if (pins & Z80_IORQ)
@@ -599,8 +754,8 @@ uint64_t FSpectrumEmu::Z80Tick(int num, uint64_t pins)
 	{
 	}
 
-	// RZX playback
-	if (RZXManager.GetReplayMode() == EReplayMode::Playback)
+	// RZX playback - the write journal supplies the input when replaying
+	if (RZXManager.GetReplayMode() == EReplayMode::Playback && WriteJournal.IsReplaying() == false)
 	{
 		if ((pins & Z80_IORQ) && (pins & Z80_RD))
 		{
@@ -612,6 +767,14 @@ uint64_t FSpectrumEmu::Z80Tick(int num, uint64_t pins)
 			}
 		}
 	}
+
+	// journal IO reads so replaying after a step back sees the same keyboard, AY & RZX input
+	if (WriteJournal.IsEnabled() && (pins & Z80_IORQ) && (pins & Z80_RD))
+	{
+		const uint8_t inVal = WriteJournal.RecordIORead(Z80_GET_DATA(pins));
+		Z80_SET_DATA(pins, (uint64_t)inVal);
+	}
+
 	return pins;
 }
 
@@ -682,13 +845,128 @@ void FSpectrumEmu::SetRAMBank(int slot, int bankNo)
 
 }
 
+void FSpectrumEmu::GetMachineState(FSpectrumMachineState& state) const
+{
+	const z80_t& cpu = ZXEmuState.cpu;
+	state.CPURegs[0] = cpu.bc_de_hl_fa;
+	state.CPURegs[1] = cpu.bc_de_hl_fa_;
+	state.CPURegs[2] = cpu.wz_ix_iy_sp;
+	state.CPURegs[3] = cpu.im_ir_pc_bits;
+	state.CPURegs[4] = cpu.pins;
+
+	state.LastMemConfig = ZXEmuState.last_mem_config;
+	state.LastFEOut = ZXEmuState.last_fe_out;
+	state.bMemoryPagingDisabled = ZXEmuState.memory_paging_disabled;
+	state.BorderColour = ZXEmuState.border_color;
+	state.AY = ZXEmuState.ay;
+}
+
+void FSpectrumEmu::SetMachineState(const FSpectrumMachineState& state)
+{
+	z80_t& cpu = ZXEmuState.cpu;
+	cpu.bc_de_hl_fa = state.CPURegs[0];
+	cpu.bc_de_hl_fa_ = state.CPURegs[1];
+	cpu.wz_ix_iy_sp = state.CPURegs[2];
+	cpu.im_ir_pc_bits = state.CPURegs[3];
+	cpu.pins = state.CPURegs[4];
+
+	ZXEmuState.last_fe_out = state.LastFEOut;
+	ZXEmuState.border_color = state.BorderColour;
+
+	if (ZXEmuState.type == ZX_TYPE_128)
+	{
+		// keep the live callbacks & recalculate the generator values from the registers
+		ay38910_t& ay = ZXEmuState.ay;
+		const ay38910_in_t inCB = ay.in_cb;
+		const ay38910_out_t outCB = ay.out_cb;
+		void* pUserData = ay.user_data;
+		ay = state.AY;
+		ay.in_cb = inCB;
+		ay.out_cb = outCB;
+		ay.user_data = pUserData;
+		_ay38910_update_values(&ay);
+
+		// same as a write to 0x7FFD
+		const uint8_t memConfig = state.LastMemConfig;
+		const int ramBank = memConfig & 0x7;
+		const int romBank = (memConfig & (1 << 4)) ? 1 : 0;
+		ZXEmuState.last_mem_config = memConfig;
+		ZXEmuState.display_ram_bank = (memConfig & (1 << 3)) ? 7 : 5;
+		ZXEmuState.memory_paging_disabled = state.bMemoryPagingDisabled;
+		mem_map_ram(&ZXEmuState.mem, 0, 0xC000, 0x4000, ZXEmuState.ram[ramBank]);
+		mem_map_rom(&ZXEmuState.mem, 0, 0x0000, 0x4000, ZXEmuState.rom[romBank]);
+
+		SetROMBank(romBank);
+		SetRAMBank(3, ramBank);
+	}
+}
+
+// Set all RAM banks in one go - pRAM is GetRAMSize() bytes
+void FSpectrumEmu::SetRAM(const uint8_t* pRAM)
+{
+	memcpy(ZXEmuState.ram, pRAM, GetRAMSize());
+	InvalidateAllDecodedInstructions(CodeAnalysis);
+}
+
+// All ROM & RAM banks for the memory search, with the address they're currently paged in at
+void FSpectrumEmu::GetMemorySearchBanks(std::vector<FMemorySearchBank>& outBanks) const
+{
+	outBanks.clear();
+
+	const int noROMBanks = ZXEmuState.type == ZX_TYPE_128 ? 2 : 1;
+	for (int bankNo = 0; bankNo < noROMBanks; bankNo++)
+		outBanks.push_back({ "ROM " + std::to_string(bankNo), ZXEmuState.rom[bankNo], 0x4000, -1, true, 0xffff, bankNo });
+	for (int bankNo = 0; bankNo < GetNoRAMBanks(); bankNo++)
+		outBanks.push_back({ "RAM " + std::to_string(bankNo), ZXEmuState.ram[bankNo], 0x4000, -1, false, 0xffff, bankNo });
+
+	mem_t* pMem = const_cast<mem_t*>(&ZXEmuState.mem);
+	for (FMemorySearchBank& bank : outBanks)
+	{
+		for (int slot = 0; slot < 4; slot++)
+		{
+			if (mem_readptr(pMem, slot * 0x4000) == bank.pData)
+				bank.CPUAddress = slot * 0x4000;
+		}
+	}
+}
+
+// Snapshot of the analysis for saving or exporting on the save thread, memory is copied a page at a time as the CPU sees it
+FAnalysisSnapshot* FSpectrumEmu::TakeAnalysisSnapshot()
+{
+	const uint8_t* memoryPages[FCodeAnalysisState::kAddressSize / FCodeAnalysisPage::kPageSize];
+	mem_t* pMem = &ZXEmuState.mem;
+	for (int pageNo = 0; pageNo < FCodeAnalysisState::kAddressSize / FCodeAnalysisPage::kPageSize; pageNo++)
+		memoryPages[pageNo] = mem_readptr(pMem, (uint16_t)(pageNo * FCodeAnalysisPage::kPageSize));
+
+	return CreateAnalysisSnapshot(CodeAnalysis, memoryPages);
+}
+
+// Setup for the global config & registries which are shared by all emulator instances
+static std::once_flag g_SharedInitFlag;
+
+static void InitSharedState(FSpectrumEmu* pEmu)
+{
+	LoadGlobalConfig(kGlobalConfigFilename);
+
+	// Setup memory description handlers
+	AddMemoryRegionDescGenerator(new FScreenPixMemDescGenerator());
+	AddMemoryRegionDescGenerator(new FScreenAttrMemDescGenerator());
+
+	// register Viewers
+	RegisterStarquakeViewer(pEmu);
+	RegisterGames(pEmu);
+
+	LoadGameConfigs(pEmu);
+}
+
 bool FSpectrumEmu::Init(const FSpectrumConfig& config)
 {
 	SetWindowTitle(kAppTitle.c_str());
 	SetWindowIcon("SALOGO.png");
 
 	// Initialise Emulator
-	LoadGlobalConfig(kGlobalConfigFilename);
+	bHeadless = config.bHeadless;
+	std::call_once(g_SharedInitFlag, InitSharedState, this);
 	FGlobalConfig& globalConfig = GetGlobalConfig();
 	SetNumberDisplayMode(globalConfig.NumberDisplayMode);
 	CodeAnalysis.Config.bShowOpcodeValues = globalConfig.bShowOpcodeValues;
@@ -724,9 +1002,13 @@ bool FSpectrumEmu::Init(const FSpectrumConfig& config)
 	GamesList.Init(this);
 	GamesList.EnumerateGames(globalConfig.SnapshotFolder.c_str());
 
-	RZXManager.Init(this);
-	RZXGamesList.Init(this);
-	RZXGamesList.EnumerateGames(globalConfig.RZXFolder.c_str());
+	// rzx-sdk keeps its state in globals so only the interactive emulator gets RZX support
+	if (bHeadless == false)
+	{
+		RZXManager.Init(this);
+		RZXGamesList.Init(this);
+		RZXGamesList.EnumerateGames(globalConfig.RZXFolder.c_str());
+	}
 
 	// Clear UI
 	memset(&UIZX, 0, sizeof(ui_zx_t));
@@ -768,6 +1050,9 @@ bool FSpectrumEmu::Init(const FSpectrumConfig& config)
 	// This is where we add the viewers we want
 	Viewers.push_back(new FBreakpointViewer(this));
 	Viewers.push_back(new FOverviewViewer(this));
+	Viewers.push_back(new FProfilerViewer(this));
+	Viewers.push_back(new FCheatFinderViewer(this));
+	Viewers.push_back(new FTextDiscoveryViewer(this));
 
 	// Initialise Viewers
 	for (auto Viewer : Viewers)
@@ -782,20 +1067,15 @@ bool FSpectrumEmu::Init(const FSpectrumConfig& config)
 	InitGraphicsViewer(GraphicsViewer);
 	IOAnalysis.Init(this);
 	SpectrumViewer.Init(this);
-	FrameTraceViewer.Init(this);
+	Profiler.Reset();
+	if (bHeadless == false)
+	{
+		FrameTraceViewer.Init(this);
+		WriteJournal.Init(this, FWriteJournal::kDefaultMemoryBudget);
+	}
 
 	CodeAnalysis.ViewState[0].Enabled = true;	// always have first view enabled
 
-	// Setup memory description handlers
-	AddMemoryRegionDescGenerator(new FScreenPixMemDescGenerator());
-	AddMemoryRegionDescGenerator(new FScreenAttrMemDescGenerator());	
-
-	// register Viewers
-	RegisterStarquakeViewer(this);
-	RegisterGames(this);
-
-	LoadGameConfigs(this);
-
 	// Set up code analysis
 	// initialise code analysis pages
 	
@@ -842,7 +1122,7 @@ bool FSpectrumEmu::Init(const FSpectrumConfig& config)
 	{
 		bLoadedGame = StartGame(config.SpecificGame.c_str());
 	}
-	else if (globalConfig.LastGame.empty() == false)
+	else if (bHeadless == false && globalConfig.LastGame.empty() == false)
 	{
 		bLoadedGame = StartGame(globalConfig.LastGame.c_str());
 	}
@@ -867,7 +1147,7 @@ bool FSpectrumEmu::Init(const FSpectrumConfig& config)
 
 void FSpectrumEmu::Shutdown()
 {
-	SaveCurrentGameData();	// save on close
+	SaveCurrentGameData(true);	// save on close
 
 	// Save Global Config - move to function?
 	FGlobalConfig& config = GetGlobalConfig();
@@ -879,13 +1159,19 @@ void FSpectrumEmu::Shutdown()
 	config.bShowOpcodeValues = CodeAnalysis.Config.bShowOpcodeValues;
 
 	SaveGlobalConfig(kGlobalConfigFilename);
+
+	WriteJournal.Shutdown();
 }
 
 
 
 void FSpectrumEmu::StartGame(FGameConfig *pGameConfig)
 {
+	SaveTasks.WaitForIdle();	// don't load data that's still being written
+	LastSaveTime = ImGui::GetTime();
+
 	MemoryAccessHandlers.clear();	// remove old memory handlers
+	MemoryHandlerDispatch.bDirty = true;
 
 	ResetMemoryStats(MemStats);
 
@@ -935,6 +1221,8 @@ void FSpectrumEmu::StartGame(FGameConfig *pGameConfig)
 		LoadGameData(this, dataFName.c_str());	// Load the old one - this needs to go in time
 
 	LoadGameState(this, saveStateFName.c_str());
+	WriteJournal.Reset();
+	Profiler.Reset();
 
 	if (FileExists(romJsonFName.c_str()))
 		ImportAnalysisJson(CodeAnalysis, romJsonFName.c_str());
@@ -982,7 +1270,7 @@ bool FSpectrumEmu::StartGame(const char *pGameName)
 }
 
 // save config & data
-void FSpectrumEmu::SaveCurrentGameData()
+void FSpectrumEmu::SaveCurrentGameData(bool bWaitForSave)
 {
 	if (pActiveGame != nullptr)
 	{
@@ -1014,14 +1302,28 @@ void FSpectrumEmu::SaveCurrentGameData()
 			}
 
 			SaveGameConfigToFile(*pGameConfig, configFName.c_str());
-			SaveGameData(this, dataFName.c_str());		// The Past
 
+			// the analysis & machine state are copied here, the files are written on the save thread
+			std::shared_ptr<FAnalysisSnapshot> pSnapshot(TakeAnalysisSnapshot());
+			std::shared_ptr<FMemoryBuffer> pMachineState = std::make_shared<FMemoryBuffer>();
+			pMachineState->Init(GetRAMSize() + 1024);
+			SaveMachineState(this, *pMachineState);
+			const bool bWriteSnapshot = pGameConfig->WriteSnapshot;
+
+			FBackgroundTask task;
+			task.Name = "Save " + pGameConfig->Name;
+			task.Steps.push_back({ "Game data", [=]() { return SaveGameData(*pSnapshot, bWriteSnapshot ? pMachineState.get() : nullptr, dataFName.c_str()); } });	// The Past
 			// The Future
-			SaveGameState(this, saveStateFName.c_str());
-			ExportGameJson(this, analysisJsonFName.c_str());
+			task.Steps.push_back({ "Save state", [=]() { return pMachineState->SaveToFile(saveStateFName.c_str()); } });
+			task.Steps.push_back({ "Analysis json", [=]() { return ExportGameJson(*pSnapshot, analysisJsonFName.c_str()); } });
+			SaveTasks.AddTask(std::move(task));
 		}
 	}
 
+	LastSaveTime = ImGui::GetTime();
+	if (bWaitForSave)
+		SaveTasks.WaitForIdle();
+
 	// TODO: this could use
 #if	SAVE_ROM_JSON
 	const std::string romJsonFName = root + kRomInfoJsonFile;
@@ -1247,17 +1549,9 @@ void FSpectrumEmu::DrawMainMenu(double timeMS)
 					bClearCode = true;
 				}
 
-				// clear code text so it can be written again
+				// old format text won't be looked up again so free up the cache
 				if (bClearCode)
-				{
-					for (int i = 0; i < 1 << 16; i++)
-					{
-						FCodeInfo* pCodeInfo = CodeAnalysis.GetCodeInfoForAddress(i);
-						if (pCodeInfo && pCodeInfo->Text.empty() == false)
-							pCodeInfo->Text.clear();
-
-					}
-				}
+					CodeAnalysis.CodeTextCache.Clear();
 
 				ImGui::EndMenu();
 			}
@@ -1267,6 +1561,21 @@ void FSpectrumEmu::DrawMainMenu(double timeMS)
 			ImGui::MenuItem("Show Opcode Values", 0, &CodeAnalysis.Config.bShowOpcodeValues);
 			if(pActiveGame!=nullptr)
 				ImGui::MenuItem("Save Snapshot with game", 0, &pActiveGame->pConfig->WriteSnapshot);
+			if (ImGui::BeginMenu("Autosave"))
+			{
+				const int kAutoSaveOptions[] = { 0, 1, 5, 10, 30 };
+				for (int minutes : kAutoSaveOptions)
+				{
+					char menuName[32];
+					if (minutes == 0)
+						snprintf(menuName, sizeof(menuName), "Off");
+					else
+						snprintf(menuName, sizeof(menuName), "Every %d min", minutes);
+					if (ImGui::MenuItem(menuName, 0, config.AutoSaveMinutes == minutes))
+						config.AutoSaveMinutes = minutes;
+				}
+				ImGui::EndMenu();
+			}
 
 #ifndef NDEBUG
 			ImGui::MenuItem("ImGui Demo", 0, &bShowImGuiDemo);
@@ -1274,17 +1583,6 @@ void FSpectrumEmu::DrawMainMenu(double timeMS)
 #endif // NDEBUG
 			ImGui::EndMenu();
 		}
-		// Note: this is a WIP menu, it'll be added in when it works properly!
-#ifndef NDEBUG
-		if (ImGui::BeginMenu("Tools"))
-		{
-			if (ImGui::MenuItem("Find Ascii Strings"))
-			{
-				CodeAnalysis.FindAsciiStrings(0x4000);
-			}
-			ImGui::EndMenu();
-		}
-#endif
 		if (ImGui::BeginMenu("Windows"))
 		{
 			ImGui::MenuItem("DebugLog", 0, &bShowDebugLog);
@@ -1349,6 +1647,19 @@ void FSpectrumEmu::DrawMainMenu(double timeMS)
 		
 		//ui_util_options_menu(timeMS, pZXUI->dbg.dbg.stopped);
 
+		// draw save progress
+		const FBackgroundTaskStatus saveStatus = SaveTasks.GetStatus();
+		if (saveStatus.bBusy)
+		{
+			ImGui::SameLine(ImGui::GetWindowWidth() - 440);
+			ImGui::Text("%s: %s (%d/%d)", saveStatus.TaskName.c_str(), saveStatus.StepName.c_str(), saveStatus.StepNo + 1, saveStatus.NoSteps);
+		}
+		else if (saveStatus.bLastFailed)
+		{
+			ImGui::SameLine(ImGui::GetWindowWidth() - 440);
+			ImGui::TextColored(ImVec4(1.0f, 0.25f, 0.25f, 1.0f), "%s", saveStatus.LastResult.c_str());
+		}
+
 		// draw emu timings
 		ImGui::SameLine(ImGui::GetWindowWidth() - 120);
 		if (pZXUI->dbg.dbg.stopped) 
@@ -1394,7 +1705,19 @@ void FSpectrumEmu::DrawMainMenu(double timeMS)
 
 					std::string outBinFname = dir + pActiveGame->pConfig->Name + addrRangeStr + ".asm";
 
-					ExportAssembler(CodeAnalysis, outBinFname.c_str(), addrStart, addrEnd);
+					// the item list is rebuilt for the snapshot on the save thread
+					std::shared_ptr<FAnalysisSnapshot> pSnapshot(TakeAnalysisSnapshot());
+					const uint16_t exportStart = addrStart, exportEnd = addrEnd;
+					FBackgroundTask task;
+					task.Name = "Export ASM";
+					task.Steps.push_back({ "Item list", [=]() { SetNumberDisplayMode(pSnapshot->NumberMode); BuildItemList(pSnapshot->State); return true; } });
+					task.Steps.push_back({ "Assembler", [=]() 
+					{
+						const bool bSuccess = ExportAssembler(pSnapshot->State, outBinFname.c_str(), exportStart, exportEnd);
+						FreeSnapshotThreadItems();
+						return bSuccess;
+					} });
+					SaveTasks.AddTask(std::move(task));
 				}
 				ImGui::CloseCurrentPopup(); 
 			}
@@ -1464,75 +1787,98 @@ void DrawDebuggerUI(ui_dbg_t *pDebugger)
 
 void StoreRegisters_Z80(FCodeAnalysisState& state);
 
-void FSpectrumEmu::Tick()
+// Run the emulator & analysis for the given amount of emulated time
+void FSpectrumEmu::ExecuteFrame(uint32_t microSeconds)
 {
-	SpectrumViewer.Tick();
-
-	ExecThisFrame = ui_zx_before_exec(&UIZX);
-
-	if (ExecThisFrame)
+	// TODO: Start frame method in analyser
+	CodeAnalysis.FrameTrace.clear();
+	StoreRegisters_Z80(CodeAnalysis);
+	Profiler.BeginExec();
+	WriteJournal.BeginExec();
+	UpdateTrapRegisterFlush();
+#if ENABLE_CAPTURES
+	const uint32_t ticks_to_run = clk_ticks_to_run(&ZXEmuState.clk, microSeconds);
+	uint32_t ticks_executed = 0;
+	while (UIZX.dbg.dbg.z80->trap_id != kCaptureTrapId && ticks_executed < ticks_to_run)
 	{
-		const float frameTime = std::min(1000000.0f / ImGui::GetIO().Framerate, 32000.0f) * ExecSpeedScale;
-		//const float frameTime = min(1000000.0f / 50, 32000.0f) * ExecSpeedScale;
-		const uint32_t microSeconds = std::max(static_cast<uint32_t>(frameTime), uint32_t(1));
+		ticks_executed += z80_exec(&ZXEmuState.cpu, ticks_to_run - ticks_executed);
 
-		// TODO: Start frame method in analyser
-		CodeAnalysis.FrameTrace.clear();
-		StoreRegisters_Z80(CodeAnalysis);
-#if ENABLE_CAPTURES
-		const uint32_t ticks_to_run = clk_ticks_to_run(&ZXEmuState.clk, microSeconds);
-		uint32_t ticks_executed = 0;
-		while (UIZX.dbg.dbg.z80->trap_id != kCaptureTrapId && ticks_executed < ticks_to_run)
+		if (UIZX.dbg.dbg.z80->trap_id == kCaptureTrapId)
 		{
-			ticks_executed += z80_exec(&ZXEmuState.cpu, ticks_to_run - ticks_executed);
-
-			if (UIZX.dbg.dbg.z80->trap_id == kCaptureTrapId)
+			const uint16_t PC = GetPC();
+			FMachineState* pMachineState = CodeAnalysis.GetMachineState(PC);
+			if (pMachineState == nullptr)
 			{
-				const uint16_t PC = GetPC();
-				FMachineState* pMachineState = CodeAnalysis.GetMachineState(PC);
-				if (pMachineState == nullptr)
-				{
-					pMachineState = AllocateMachineState(CodeAnalysis);
-					CodeAnalysis.SetMachineStateForAddress(PC, pMachineState);
-				}
-
-				CaptureMachineState(pMachineState, this);
-				UIZX.dbg.dbg.z80->trap_id = 0;
-				_ui_dbg_continue(&UIZX.dbg);
+				pMachineState = AllocateMachineState(CodeAnalysis);
+				CodeAnalysis.SetMachineStateForAddress(PC, pMachineState);
 			}
+
+			CaptureMachineState(pMachineState, this);
+			UIZX.dbg.dbg.z80->trap_id = 0;
+			_ui_dbg_continue(&UIZX.dbg);
 		}
-		clk_ticks_executed(&ZXEmuState.clk, ticks_executed);
-		kbd_update(&ZXEmuState.kbd);
+	}
+	clk_ticks_executed(&ZXEmuState.clk, ticks_executed);
+	kbd_update(&ZXEmuState.kbd);
 #else
-		zx_exec(&ZXEmuState, microSeconds);
+	zx_exec(&ZXEmuState, microSeconds);
 #endif
-		/*if (RZXManager.GetReplayMode() == EReplayMode::Playback)
-		{
-			assert(ZXEmuState.valid);
-			uint32_t icount = RZXManager.Update();
+	/*if (RZXManager.GetReplayMode() == EReplayMode::Playback)
+	{
+		assert(ZXEmuState.valid);
+		uint32_t icount = RZXManager.Update();
 
-			uint32_t ticks_to_run = clk_ticks_to_run(&ZXEmuState.clk, microSeconds);
-			uint32_t ticks_executed = z80_exec(&ZXEmuState.cpu, ticks_to_run);
-			clk_ticks_executed(&ZXEmuState.clk, ticks_executed);
-			kbd_update(&ZXEmuState.kbd);
-		}
-		else
-		{
-			uint32_t frameTicks = ZXEmuState.frame_scan_lines* ZXEmuState.scanline_period;
-			//zx_exec(&ZXEmuState, microSeconds);
-
-			//uint32_t ticks_to_run = clk_ticks_to_run(&ZXEmuState.clk, microSeconds);
-			//frameTicks = ticks_to_run;
-			ZXEmuState.clk.ticks_to_run = frameTicks;
-			const uint32_t ticksExecuted = z80_exec(&ZXEmuState.cpu, frameTicks);
-			clk_ticks_executed(&ZXEmuState.clk, ticksExecuted);
-			kbd_update(&ZXEmuState.kbd);
-		}*/
-		ImGui_UpdateTextureRGBA(Texture, FrameBuffer);
+		uint32_t ticks_to_run = clk_ticks_to_run(&ZXEmuState.clk, microSeconds);
+		uint32_t ticks_executed = z80_exec(&ZXEmuState.cpu, ticks_to_run);
+		clk_ticks_executed(&ZXEmuState.clk, ticks_executed);
+		kbd_update(&ZXEmuState.kbd);
+	}
+	else
+	{
+		uint32_t frameTicks = ZXEmuState.frame_scan_lines* ZXEmuState.scanline_period;
+		//zx_exec(&ZXEmuState, microSeconds);
 
+		//uint32_t ticks_to_run = clk_ticks_to_run(&ZXEmuState.clk, microSeconds);
+		//frameTicks = ticks_to_run;
+		ZXEmuState.clk.ticks_to_run = frameTicks;
+		const uint32_t ticksExecuted = z80_exec(&ZXEmuState.cpu, frameTicks);
+		clk_ticks_executed(&ZXEmuState.clk, ticksExecuted);
+		kbd_update(&ZXEmuState.kbd);
+	}*/
+	if (bHeadless == false)
+	{
+		ImGui_UpdateTextureRGBA(Texture, FrameBuffer);
 		FrameTraceViewer.CaptureFrame();
-		FrameScreenPixWrites.clear();
-		FrameScreenAttrWrites.clear();
+	}
+	FrameScreenPixWrites.clear();
+	FrameScreenAttrWrites.clear();
+
+	// carry on any queued static analysis - done here so headless runs make progress too
+	UpdateStaticAnalysis(CodeAnalysis, kStaticAnalysisFrameBudget);
+
+	// only end the profile frame if it ran to completion, not when stopped by the debugger
+	if (Profiler.bEnabled && ZXEmuState.cpu.trap_id == 0)
+		Profiler.EndFrame();
+}
+
+void FSpectrumEmu::Tick()
+{
+	SpectrumViewer.Tick();
+
+	ExecThisFrame = ui_zx_before_exec(&UIZX);
+
+	// autosave - skipped while a save or export is still running
+	// the analysis snapshot is taken in place of emulating a frame so the copy and the frame don't add up to a stall
+	const int autoSaveMinutes = GetGlobalConfig().AutoSaveMinutes;
+	const bool bAutoSave = autoSaveMinutes > 0 && pActiveGame != nullptr && ImGui::GetTime() - LastSaveTime > autoSaveMinutes * 60.0 && SaveTasks.IsBusy() == false;
+
+	if (ExecThisFrame && bAutoSave == false)
+	{
+		const float frameTime = std::min(1000000.0f / ImGui::GetIO().Framerate, 32000.0f) * ExecSpeedScale;
+		//const float frameTime = min(1000000.0f / 50, 32000.0f) * ExecSpeedScale;
+		const uint32_t microSeconds = std::max(static_cast<uint32_t>(frameTime), uint32_t(1));
+
+		ExecuteFrame(microSeconds);
 
 		if (bStepToNextFrame)
 		{
@@ -1551,6 +1897,11 @@ void FSpectrumEmu::Tick()
 
 	UpdateCharacterSets(CodeAnalysis);
 
+	if (bAutoSave)
+		SaveCurrentGameData();
+	else if (ExecThisFrame == false)	// ExecuteFrame does this when running
+		UpdateStaticAnalysis(CodeAnalysis, kStaticAnalysisFrameBudget);
+
 	// Draw UI
 	DrawDockingView();
 }
@@ -1581,6 +1932,13 @@ void FSpectrumEmu::DrawMemoryTools()
 			DrawMemoryDiffUI(this);
 			ImGui::EndTabItem();
 		}
+		if (ImGui::BeginTabItem("Search"))
+		{
+			std::vector<FMemorySearchBank> banks;
+			GetMemorySearchBanks(banks);
+			DrawMemorySearchUI(CodeAnalysis, MemorySearch, banks);
+			ImGui::EndTabItem();
+		}
 		if (ImGui::BeginTabItem("IO Analysis"))
 		{
 			IOAnalysis.DrawUI();
@@ -1855,6 +2213,11 @@ void FSpectrumEmu::DrawCheatsUI()
 			// Display memory locations in advanced mode
 			if (bAdvancedMode)
 			{
+				if (entry.Bank != -1)
+				{
+					ImGui::Text("RAM %d", entry.Bank);
+					ImGui::SameLine();
+				}
 				ImGui::Text("%s:%s", NumStr(entry.Address), entry.bUserDefined ? "" : NumStr((uint8_t)entry.Value)); 
 			}
 
@@ -1865,7 +2228,7 @@ void FSpectrumEmu::DrawCheatsUI()
 				
 				// Display the value of the memory location in the input field.
 				// If the user has modified the value then display that instead.
-				uint8_t value = entry.bUserDefinedValueDirty ? entry.Value : CodeAnalysis.CPUInterface->ReadByte(entry.Address);
+				uint8_t value = entry.bUserDefinedValueDirty ? entry.Value : ReadCheatByte(entry);
 				
 				if (bAdvancedMode)
 					ImGui::SameLine();
@@ -1917,19 +2280,14 @@ void FSpectrumEmu::DrawCheatsUI()
 				{
 					// store old value
 					if (!bWasEnabled)
-						entry.OldValue = ReadByte( entry.Address);
-					WriteByte( entry.Address, static_cast<uint8_t>(entry.Value));
+						entry.OldValue = ReadCheatByte(entry);
+					WriteCheatByte(entry, static_cast<uint8_t>(entry.Value));
 					entry.bUserDefinedValueDirty = false;
 				}
 				else
 				{
-					WriteByte( entry.Address, entry.OldValue);
+					WriteCheatByte(entry, entry.OldValue);
 				}
-
-				// if code has been modified then clear the code text so it gets regenerated
-				FCodeInfo* pCodeInfo = CodeAnalysis.GetCodeInfoForAddress(entry.Address);
-				if (pCodeInfo)
-					pCodeInfo->Text.clear();
 			}
 			CodeAnalysis.SetCodeAnalysisDirty();
 
@@ -1996,10 +2354,10 @@ bool FSpectrumEmu::ImportSkoolFile(const char* pFilename, const char* pOutSkoolI
 	return true;
 }
 
-bool FSpectrumEmu::ExportSkoolFile(bool bHexadecimal, const char* pName /* = nullptr*/)
+void FSpectrumEmu::ExportSkoolFile(bool bHexadecimal, const char* pName /* = nullptr*/)
 {
 	if (!pActiveGame)
-		return false;
+		return;
 	
 	const std::string outputDir = "OutputSkoolKit/";
 	EnsureDirectoryExists(outputDir.c_str());
@@ -2010,9 +2368,25 @@ bool FSpectrumEmu::ExportSkoolFile(bool bHexadecimal, const char* pName /* = nul
 	bool bLoadedSkoolFileInfo = LoadSkoolFileInfo(skoolInfo, skoolInfoFname.c_str());
 	
 	const std::string outFname = outputDir + name + ".skool";
-	::ExportSkoolFile(CodeAnalysis, outFname.c_str(), bHexadecimal ? FSkoolFile::Base::Hexadecimal : FSkoolFile::Base::Decimal, bLoadedSkoolFileInfo ? &skoolInfo : nullptr);
-	
-	return true;
+	const FSkoolFile::Base base = bHexadecimal ? FSkoolFile::Base::Hexadecimal : FSkoolFile::Base::Decimal;
+
+	// exported from a snapshot on the save thread
+	std::shared_ptr<FAnalysisSnapshot> pSnapshot(TakeAnalysisSnapshot());
+	std::shared_ptr<FSkoolFileInfo> pSkoolInfo = bLoadedSkoolFileInfo ? std::make_shared<FSkoolFileInfo>(std::move(skoolInfo)) : nullptr;
+	FBackgroundTask task;
+	task.Name = "Export Skool File";
+	task.Steps.push_back({ "Skool file", [=]() 
+	{
+		SetNumberDisplayMode(pSnapshot->NumberMode);
+		const bool bSuccess = ::ExportSkoolFile(pSnapshot->State, outFname.c_str(), base, pSkoolInfo.get());
+		FreeSnapshotThreadItems();
+		if (bSuccess)
+			LOGINFO("Exported skool file '%s'", outFname.c_str());
+		else
+			LOGERROR("Failed to export skool file '%s'", outFname.c_str());
+		return bSuccess;
+	} });
+	SaveTasks.AddTask(std::move(task));
 }
 
 // Start a game, import a skool file and then export it, to test the SkoolKit importer and exporter are working properly.
@@ -38,13 +38,19 @@
 #include "Viewers/FrameTraceViewer.h"
 #include "SnapshotLoaders/GamesList.h"
 #include "IOAnalysis.h"
+#include "WriteJournal.h"
+#include "CodeAnalyser/Profiler.h"
+#include "CodeAnalyser/UI/MemorySearchUI.h"
 #include "SnapshotLoaders/RZXLoader.h"
 #include "Util/Misc.h"
+#include "Util/BackgroundTasks.h"
 
 struct FGame;
 struct FGameViewer;
 struct FGameViewerData;
 struct FGameConfig;
+struct FCheatMemoryEntry;
+struct FAnalysisSnapshot;
 struct FViewerConfig;
 struct FSkoolFileInfo;
 
@@ -59,6 +65,19 @@ struct FSpectrumConfig
 	ESpectrumModel	Model;
 	int				NoStateBuffers = 0;
 	std::string		SpecificGame;
+	bool			bHeadless = false;	// no texture updates or frame trace - for batch analysis
+};
+
+// Machine state apart from RAM - CPU registers, paging & sound chip
+// RAM is held separately so it can be stored as diffs
+struct FSpectrumMachineState
+{
+	uint64_t	CPURegs[5] = { 0 };	// bc_de_hl_fa, bc_de_hl_fa_, wz_ix_iy_sp, im_ir_pc_bits, pins
+	uint8_t		LastMemConfig = 0;	// last write to 0x7FFD - 128K paging
+	uint8_t		LastFEOut = 0;
+	bool		bMemoryPagingDisabled = false;
+	uint32_t	BorderColour = 0;
+	ay38910_t	AY;
 };
 
 struct FGame
@@ -81,17 +100,19 @@ public:
 	void	Shutdown();
 	void	StartGame(FGameConfig* pGameConfig);
 	bool	StartGame(const char* pGameName);
-	void	SaveCurrentGameData();
+	void	SaveCurrentGameData(bool bWaitForSave = false);
 	void	DrawMainMenu(double timeMS);
 	void	DrawCheatsUI();
 	bool	ImportSkoolFile(const char* pFilename, const char* pOutSkoolInfoName = nullptr, FSkoolFileInfo* pSkoolInfo=nullptr);
-	bool	ExportSkoolFile(bool bHexadecimal, const char* pName = nullptr);
+	void	ExportSkoolFile(bool bHexadecimal, const char* pName = nullptr);	// queued on the save thread, the result is logged & shown in the menu bar
 	void	DoSkoolKitTest(const char* pGameName, const char* pInSkoolFileName, bool bHexadecimal, const char* pOutSkoolName = nullptr);
 
 	int		TrapFunction(uint16_t pc, int ticks, uint64_t pins);
+	void	UpdateTrapRegisterFlush();
 	uint64_t Z80Tick(int num, uint64_t pins);
 
 	void	Tick();
+	void	ExecuteFrame(uint32_t microSeconds);
 	void	DrawMemoryTools();
 	void	DrawUI();
 	bool	DrawDockingView();
@@ -116,6 +137,9 @@ public:
 	void		StepInto(void) override;
 	void		StepFrame(void) override;
 	void		StepScreenWrite(void) override;
+	bool		CanStepBack(void) const override;
+	void		StepBackInto(void) override;
+	void		StepBackOver(void) override;
 	void		GraphicsViewerSetView(uint16_t address, int charWidth) override;
 	bool		ShouldExecThisFrame(void) const override;
 	bool		IsStopped(void) const override;
@@ -126,9 +150,21 @@ public:
 	void SetROMBank(int bankNo);
 	void SetRAMBank(int slot, int bankNo);
 
+	// Banked state - all RAM banks are in ZXEmuState.ram
+	int		GetNoRAMBanks() const { return ZXEmuState.type == ZX_TYPE_128 ? 8 : 3; }
+	int		GetRAMSize() const { return GetNoRAMBanks() * 0x4000; }
+	void	GetMachineState(FSpectrumMachineState& state) const;
+	void	SetMachineState(const FSpectrumMachineState& state);
+	void	SetRAM(const uint8_t* pRAM);
+	void	GetMemorySearchBanks(std::vector<FMemorySearchBank>& outBanks) const;
+	FAnalysisSnapshot*	TakeAnalysisSnapshot();
+	uint8_t	ReadCheatByte(const FCheatMemoryEntry& entry) const;
+	void	WriteCheatByte(const FCheatMemoryEntry& entry, uint8_t value);
+
 	void AddMemoryHandler(const FMemoryAccessHandler& handler)
 	{
 		MemoryAccessHandlers.push_back(handler);
+		MemoryHandlerDispatch.bDirty = true;
 	}
 
 	void GraphicsViewerGoToAddress(uint16_t address)
@@ -149,6 +185,7 @@ public:
 	unsigned char*	FrameBuffer;	// pixel buffer to store emu output
 	ImTextureID		Texture;		// texture 
 	
+	bool			bHeadless = false;	// running without UI - see Headless/HeadlessMain.cpp
 	bool			ExecThisFrame = true; // Whether the emulator should execute this frame (controlled by UI)
 	float			ExecSpeedScale = 1.0f;
 
@@ -166,6 +203,8 @@ public:
 	FGraphicsViewerState	GraphicsViewer;
 	FCodeAnalysisState		CodeAnalysis;
 	FIOAnalysis				IOAnalysis;
+	FWriteJournal			WriteJournal;	// for stepping backwards
+	FProfiler				Profiler;
 
 	// Code analysis pages - to cover 48K & 128K Spectrums
 	static const int kNoBankPages = 16;	// no of pages per physical address slot (16k)
@@ -180,10 +219,12 @@ public:
 	// Memory handling
 	std::string				SelectedMemoryHandler;
 	std::vector< FMemoryAccessHandler>	MemoryAccessHandlers;
+	FMemoryHandlerDispatch	MemoryHandlerDispatch;
 	std::vector< FMemoryAccess>	FrameScreenPixWrites;
 	std::vector< FMemoryAccess>	FrameScreenAttrWrites;
 
 	FMemoryStats	MemStats;
+	FMemorySearchUIState	MemorySearch;
 
 	// interrupt handling info
 	bool		bHasInterruptHandler = false;
@@ -214,6 +255,15 @@ private:
 	bool	bStepToNextFrame = false;
 	bool	bStepToNextScreenWrite = false;
 
+	// data accesses that hit a breakpoint bitmap during the current instruction
+	static const int kMaxBreakpointAccesses = 4;
+	FBreakpointAccess	BreakpointAccesses[kMaxBreakpointAccesses];
+	int		NoBreakpointAccesses = 0;
+
+	// saving & exporting are done from snapshots on a worker thread
+	FBackgroundTaskQueue	SaveTasks;
+	double	LastSaveTime = 0;	// for autosave
+
 	bool	bShowDebugLog = false;
 	bool	bInitialised = false;
 
@@ -0,0 +1,172 @@
+#include "CheatFinderViewer.h"
+#include "../SpectrumEmu.h"
+#include "../GameConfig.h"
+
+#include <imgui.h>
+#include <CodeAnalyser/UI/CodeAnalyserUI.h>
+
+static const size_t kMaxListedCandidates = 1000;
+
+void FCheatFinderViewer::UpdateCandidates()
+{
+	SelectedCandidate = -1;
+	if (Search.NoCandidates <= kMaxListedCandidates)
+		GetCheatSearchCandidates(Search, Candidates, kMaxListedCandidates);
+	else
+		Candidates.clear();
+}
+
+void FCheatFinderViewer::DrawUI(void)
+{
+	std::vector<FMemorySearchBank> banks;
+	pSpectrumEmu->GetMemorySearchBanks(banks);
+
+	if (Search.IsActive() == false)
+	{
+		ImGui::TextWrapped("Take a snapshot, change the value in the game (e.g. lose a life) then filter the candidates by how they changed. Repeat until only a few are left.");
+		if (ImGui::Button("Start"))
+		{
+			StartCheatSearch(Search, banks.data(), (int)banks.size());
+			bBankLayoutChanged = false;
+			UpdateCandidates();
+		}
+		return;
+	}
+
+	ImGui::Text("%d candidates after %d filters", (int)Search.NoCandidates, Search.NoFilters);
+	ImGui::SameLine();
+	if (ImGui::Button("Restart"))
+	{
+		StartCheatSearch(Search, banks.data(), (int)banks.size());
+		bBankLayoutChanged = false;
+		UpdateCandidates();
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Stop"))
+	{
+		ResetCheatSearch(Search);
+		Candidates.clear();
+		return;
+	}
+
+	// comparison against the last snapshot
+	ImGui::SetNextItemWidth(120);
+	if (ImGui::BeginCombo("##Compare", GetCheatSearchCompareName(Compare)))
+	{
+		for (int i = 0; i < (int)ECheatSearchCompare::Count; i++)
+		{
+			if (ImGui::Selectable(GetCheatSearchCompareName((ECheatSearchCompare)i), (int)Compare == i))
+				Compare = (ECheatSearchCompare)i;
+		}
+		ImGui::EndCombo();
+	}
+	if (Compare == ECheatSearchCompare::DecreasedBy || Compare == ECheatSearchCompare::IncreasedBy || Compare == ECheatSearchCompare::EqualTo)
+	{
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(60);
+		ImGui::InputScalar("##CompareValue", ImGuiDataType_U8, &CompareValue, NULL, NULL, "%d");
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Filter"))
+	{
+		bBankLayoutChanged = FilterCheatSearch(Search, banks.data(), (int)banks.size(), Compare, CompareValue) == false;
+		UpdateCandidates();
+	}
+
+	if (bBankLayoutChanged)
+		ImGui::TextColored(ImVec4(1.0f, 0.25f, 0.25f, 1.0f), "Memory banks have changed - restart the search");
+
+	ImGui::Separator();
+	DrawCandidates(banks);
+}
+
+void FCheatFinderViewer::DrawCandidates(const std::vector<FMemorySearchBank>& banks)
+{
+	FCodeAnalysisState& state = pSpectrumEmu->CodeAnalysis;
+	FCodeAnalysisViewState& viewState = state.GetFocussedViewState();
+
+	if (Search.NoCandidates > kMaxListedCandidates)
+	{
+		ImGui::Text("Too many candidates to list");
+		return;
+	}
+
+	// add the selected candidate as a poke
+	if (SelectedCandidate != -1 && Candidates[SelectedCandidate].Bank < (int)banks.size())
+	{
+		const FCheatSearchCandidate& candidate = Candidates[SelectedCandidate];
+		const FMemorySearchBank& bank = banks[candidate.Bank];
+		// 128K banks are written to through the bank so the cheat works whatever is paged in
+		const bool b128K = pSpectrumEmu->GetNoRAMBanks() == 8;
+		const int bankCPUAddress = bank.GetCPUAddress(candidate.Offset);
+		const bool bCanAdd = (bankCPUAddress != -1 || b128K) && pSpectrumEmu->pActiveGame != nullptr;
+
+		ImGui::SetNextItemWidth(160);
+		ImGui::InputText("Description", CheatDescription, sizeof(CheatDescription));
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(60);
+		ImGui::InputScalar("Value", ImGuiDataType_U8, &CheatValue, NULL, NULL, "%d");
+		ImGui::SameLine();
+		if (bCanAdd == false)
+			ImGui::BeginDisabled();
+		if (ImGui::Button("Add Cheat"))
+		{
+			FCheat cheat;
+			cheat.Description = CheatDescription;
+			FCheatMemoryEntry entry;
+			entry.Address = bankCPUAddress != -1 ? (uint16_t)bankCPUAddress : (uint16_t)(0xC000 + candidate.Offset);
+			if (b128K)
+				entry.Bank = bank.BankId;
+			entry.Value = CheatValue;
+			cheat.Entries.push_back(entry);
+			pSpectrumEmu->pActiveGame->pConfig->Cheats.push_back(cheat);
+		}
+		if (bCanAdd == false)
+			ImGui::EndDisabled();
+		if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
+			ImGui::SetTooltip("Adds to the Pokes window, saved with the game config. 128K pokes write to the RAM bank whatever is paged in.");
+	}
+
+	if (ImGui::BeginChild("CheatCandidates", ImVec2(0, 0), true))
+	{
+		for (int i = 0; i < (int)Candidates.size(); i++)
+		{
+			const FCheatSearchCandidate& candidate = Candidates[i];
+			if (candidate.Bank >= (int)banks.size() || candidate.Offset >= banks[candidate.Bank].Size)
+				continue;
+
+			const FMemorySearchBank& bank = banks[candidate.Bank];
+			const uint8_t currentValue = bank.pData[candidate.Offset];
+			const int bankCPUAddress = bank.GetCPUAddress(candidate.Offset);
+			const bool bPagedIn = bankCPUAddress != -1;
+			const uint16_t cpuAddress = (uint16_t)bankCPUAddress;
+
+			ImGui::PushID(i);
+			if (ImGui::Selectable("##candidate", SelectedCandidate == i))
+			{
+				SelectedCandidate = i;
+				CheatValue = currentValue;
+				if (bPagedIn)
+					CodeAnalyserGoToAddress(viewState, cpuAddress);
+			}
+			ImGui::SetItemAllowOverlap();	// allow buttons
+			ImGui::SameLine();
+			ImGui::Text("%s:%04X", bank.Name.c_str(), candidate.Offset);
+			ImGui::SameLine(100);
+			ImGui::Text("%3d (was %3d)", currentValue, candidate.Value);
+			ImGui::SameLine(220);
+			if (bPagedIn)
+			{
+				ImGui::Text("%s", NumStr(cpuAddress));
+				ImGui::SameLine();
+				DrawAddressLabel(state, viewState, cpuAddress);
+			}
+			else
+			{
+				ImGui::TextDisabled("not paged in");
+			}
+			ImGui::PopID();
+		}
+	}
+	ImGui::EndChild();
+}
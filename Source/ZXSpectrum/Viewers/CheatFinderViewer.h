@@ -0,0 +1,27 @@
+#pragma once
+
+#include "ViewerBase.h"
+
+#include <Util/CheatSearch.h>
+
+#include <vector>
+
+class FCheatFinderViewer : public FViewerBase
+{
+public:
+			FCheatFinderViewer(FSpectrumEmu* pEmu) :FViewerBase(pEmu) { Name = "Cheat Finder"; }
+	bool	Init(void) override { return true; }
+	void	DrawUI() override;
+private:
+	void	DrawCandidates(const std::vector<FMemorySearchBank>& banks);
+	void	UpdateCandidates();
+
+	FCheatSearch						Search;
+	std::vector<FCheatSearchCandidate>	Candidates;	// only fetched when there are few enough to list
+	ECheatSearchCompare					Compare = ECheatSearchCompare::Decreased;
+	uint8_t								CompareValue = 1;
+	int									SelectedCandidate = -1;
+	char								CheatDescription[64] = "Infinite Lives";
+	uint8_t								CheatValue = 0;
+	bool								bBankLayoutChanged = false;
+};
@@ -7,6 +7,7 @@
 #include <ImGuiSupport/ImGuiTexture.h>
 
 #include <Util/Misc.h>
+#include <Util/MemoryDiff.h>
 
 
 void FFrameTraceViewer::Init(FSpectrumEmu* pEmu)
@@ -15,10 +16,13 @@ void FFrameTraceViewer::Init(FSpectrumEmu* pEmu)
 
 	// Init Frame Trace
 	for (int i = 0; i < kNoFramesInTrace; i++)
-	{
 		FrameTrace[i].Texture = ImGui_CreateTextureRGBA(static_cast<unsigned char*>(pEmu->FrameBuffer), 320, 256);
-		FrameTrace[i].CPUState = malloc(sizeof(z80_t));
-	}
+
+	FrameHistory = new FFrameHistory[kNoFramesInHistory];
+	HistoryMachineStates = new FSpectrumMachineState[kNoFramesInHistory];
+	for (int i = 0; i < kNoFramesInHistory; i++)
+		FrameHistory[i].pMachineState = &HistoryMachineStates[i];
+	HistoryBytes = kNoFramesInHistory * (sizeof(FFrameHistory) + sizeof(FSpectrumMachineState));
 
 	ShowWritesView = new FZXGraphicsView(320, 256);
 }
@@ -29,76 +33,234 @@ void	FFrameTraceViewer::Shutdown()
 	{
 		ImGui_FreeTexture(FrameTrace[i].Texture);
 		FrameTrace[i].Texture = nullptr;
-		free(FrameTrace[i].CPUState);
 	}
 
+	delete[] FrameHistory;
+	FrameHistory = nullptr;
+	delete[] HistoryMachineStates;
+	HistoryMachineStates = nullptr;
+	HistoryBytes = 0;
+
 	delete ShowWritesView;
 	ShowWritesView = nullptr;
 }
 
+static size_t GetHistoryFrameBytes(const FFrameHistory& history)
+{
+	return history.KeyFrameRAM.capacity() + history.RAMDiff.Runs.capacity() * sizeof(FMemoryDiffRun) + history.RAMDiff.NewBytes.capacity();
+}
 
 void FFrameTraceViewer::CaptureFrame()
 {
+	// machine type changed - old frames can't be rebuilt
+	const int ramSize = pSpectrumEmu->GetRAMSize();
+	if (ramSize != RAMSize)
+	{
+		ResetHistory();
+		RAMSize = ramSize;
+	}
+
+	// we've run on from a restored frame - the frames after it are no longer what happened
+	if (RestoredFrameNo != -1)
+	{
+		for (int frameNo = RestoredFrameNo + 1; frameNo < NextFrameNo; frameNo++)
+			ReleaseHistoryFrame(FrameHistory[frameNo % kNoFramesInHistory]);
+		NextFrameNo = RestoredFrameNo + 1;
+		RestoredFrameNo = -1;
+		PrevFrameRAMFrameNo = -1;
+	}
+
+	const int frameNo = NextFrameNo++;
+	while (OldestFrameNo <= frameNo - kNoFramesInHistory)
+		DropOldestHistory();
+
 	// set up new trace frame
-	FSpeccyFrameTrace& frame = FrameTrace[CurrentTraceFrame];
+	FSpeccyFrameTrace& frame = FrameTrace[frameNo % kNoFramesInTrace];
 	ImGui_UpdateTextureRGBA(frame.Texture, pSpectrumEmu->FrameBuffer);
 	frame.InstructionTrace = pSpectrumEmu->CodeAnalysis.FrameTrace;
 	frame.ScreenPixWrites = pSpectrumEmu->FrameScreenPixWrites;
 	frame.ScreenAttrWrites = pSpectrumEmu->FrameScreenAttrWrites;
 	frame.FrameOverview.clear();
+	frame.FrameNo = frameNo;
 
-	// copy memory
-	for (int i = 0; i < 1 << 16; i++)
-		frame.MemoryDump[i] = pSpectrumEmu->ReadByte(i);
+	FFrameHistory& history = FrameHistory[frameNo % kNoFramesInHistory];
+	HistoryBytes -= GetHistoryFrameBytes(history);
+	history.FrameNo = frameNo;
+	pSpectrumEmu->GetMachineState(*history.pMachineState);
 
-	// get CPU state
-	z80_t* pCPUState = (z80_t*)frame.CPUState;
-	pCPUState->bc_de_hl_fa = pSpectrumEmu->ZXEmuState.cpu.bc_de_hl_fa;
-	pCPUState->bc_de_hl_fa_ = pSpectrumEmu->ZXEmuState.cpu.bc_de_hl_fa_;
-	pCPUState->wz_ix_iy_sp = pSpectrumEmu->ZXEmuState.cpu.wz_ix_iy_sp;
-	pCPUState->im_ir_pc_bits = pSpectrumEmu->ZXEmuState.cpu.im_ir_pc_bits;
-	pCPUState->pins = pSpectrumEmu->ZXEmuState.cpu.pins;
+	// RAM banks are contiguous in the emulator so diff them in one go
+	const uint8_t* pRAM = &pSpectrumEmu->ZXEmuState.ram[0][0];
+	if (bLastFrameRAMValid)
+	{
+		GenerateRAMDiff(pRAM, LastFrameRAM, history.RAMDiff);
+	}
+	else
+	{
+		history.RAMDiff.Runs.clear();
+		history.RAMDiff.NewBytes.clear();
+	}
+	memcpy(LastFrameRAM, pRAM, RAMSize);
+	bLastFrameRAMValid = true;
 
-	// Generate diffs
-	const int prevFrameIndex = CurrentTraceFrame == 0 ? kNoFramesInTrace - 1 : CurrentTraceFrame - 1;
-	const FSpeccyFrameTrace& prevFrame = FrameTrace[prevFrameIndex];
+	// store a full copy for keyframes
+	if (bForceKeyFrame || frameNo % kKeyFrameInterval == 0)
+	{
+		history.KeyFrameRAM.assign(pRAM, pRAM + RAMSize);
+		bForceKeyFrame = false;
+	}
+	else
+	{
+		history.KeyFrameRAM.clear();
+		history.KeyFrameRAM.shrink_to_fit();
+	}
+	HistoryBytes += GetHistoryFrameBytes(history);
+
+	while (HistoryBytes > kHistoryMemoryBudget && OldestFrameNo < frameNo)
+		DropOldestHistory();
+
+	// budget is too small for a single keyframe interval - start again from this frame
+	if (history.KeyFrameRAM.empty() && OldestFrameNo == frameNo)
+	{
+		HistoryBytes -= GetHistoryFrameBytes(history);
+		history.KeyFrameRAM.assign(pRAM, pRAM + RAMSize);
+		HistoryBytes += GetHistoryFrameBytes(history);
+	}
+}
+
+void FFrameTraceViewer::ReleaseHistoryFrame(FFrameHistory& history)
+{
+	HistoryBytes -= GetHistoryFrameBytes(history);
+	history.FrameNo = -1;
+	std::vector<uint8_t>().swap(history.KeyFrameRAM);
+	std::vector<FMemoryDiffRun>().swap(history.RAMDiff.Runs);
+	std::vector<uint8_t>().swap(history.RAMDiff.NewBytes);
+}
+
+// Drop the oldest keyframe & the frames that are rebuilt from it
+void FFrameTraceViewer::DropOldestHistory()
+{
+	const int newestFrameNo = NextFrameNo - 1;
+	do
+	{
+		ReleaseHistoryFrame(FrameHistory[OldestFrameNo % kNoFramesInHistory]);
+		OldestFrameNo++;
+	} 
+	while (OldestFrameNo < newestFrameNo && FrameHistory[OldestFrameNo % kNoFramesInHistory].KeyFrameRAM.empty());
+
+	if (PrevFrameRAMFrameNo < OldestFrameNo)
+		PrevFrameRAMFrameNo = -1;
+}
+
+void FFrameTraceViewer::RestoreFrame(int frameNo)
+{
+	if (RAMSize != pSpectrumEmu->GetRAMSize())
+		return;
+
+	static thread_local uint8_t frameRAM[8 * 0x4000];
+	if (ReconstructFrameRAM(frameNo, frameRAM) == false)
+		return;
+
+	// restore RAM, then CPU, paging & AY
+	pSpectrumEmu->SetRAM(frameRAM);
+	pSpectrumEmu->SetMachineState(*FrameHistory[frameNo % kNoFramesInHistory].pMachineState);
+	pSpectrumEmu->WriteJournal.Reset();	// can't step back past a restore
+
+	// the next capture carries on from here
+	memcpy(LastFrameRAM, frameRAM, RAMSize);
+	bLastFrameRAMValid = true;
+	bForceKeyFrame = true;
+	RestoredFrameNo = frameNo;
+}
+
+void FFrameTraceViewer::ResetHistory()
+{
+	for (int i = 0; i < kNoFramesInTrace; i++)
+		FrameTrace[i].FrameNo = -1;
+	for (int i = 0; i < kNoFramesInHistory; i++)
+		ReleaseHistoryFrame(FrameHistory[i]);
+
+	OldestFrameNo = NextFrameNo;
+	RestoredFrameNo = -1;
+	PrevFrameRAMFrameNo = -1;
+	bForceKeyFrame = true;
+	bLastFrameRAMValid = false;
+}
+
+bool FFrameTraceViewer::IsFrameValid(int frameNo) const
+{
+	return frameNo >= OldestFrameNo && frameNo < NextFrameNo;
+}
 
-	GenerateMemoryDiff(frame, prevFrame, frame.MemoryDiffs);
+const FSpeccyFrameTrace* FFrameTraceViewer::GetFrameTrace(int frameNo) const
+{
+	if (IsFrameValid(frameNo) == false)
+		return nullptr;
 
-	if (++CurrentTraceFrame == kNoFramesInTrace)
-		CurrentTraceFrame = 0;
+	const FSpeccyFrameTrace& frame = FrameTrace[frameNo % kNoFramesInTrace];
+	return frame.FrameNo == frameNo ? &frame : nullptr;
 }
 
+static void ApplyRAMDiff(const FRAMDiff& diff, uint8_t* pRAM)
+{
+	uint32_t byteIndex = 0;
+	for (const FMemoryDiffRun& run : diff.Runs)
+	{
+		memcpy(pRAM + run.Offset, &diff.NewBytes[byteIndex], run.Size);
+		byteIndex += run.Size;
+	}
+}
 
-void FFrameTraceViewer::RestoreFrame(const FSpeccyFrameTrace& frame)
+// Rebuild RAM for a frame by playing the changes forward from the keyframe before it
+bool FFrameTraceViewer::ReconstructFrameRAM(int frameNo, uint8_t* pRAM) const
 {
-	// restore CPU regs
-	const z80_t* pCPUState = (const z80_t*)frame.CPUState;
-	pSpectrumEmu->ZXEmuState.cpu.bc_de_hl_fa = pCPUState->bc_de_hl_fa;
-	pSpectrumEmu->ZXEmuState.cpu.bc_de_hl_fa_ = pCPUState->bc_de_hl_fa_;
-	pSpectrumEmu->ZXEmuState.cpu.wz_ix_iy_sp = pCPUState->wz_ix_iy_sp;
-	pSpectrumEmu->ZXEmuState.cpu.im_ir_pc_bits = pCPUState->im_ir_pc_bits;
-	pSpectrumEmu->ZXEmuState.cpu.pins = pCPUState->pins;
-
-	// restore memory
-	for (int i = 0; i < 1 << 16; i++)
-		pSpectrumEmu->WriteByte(i, frame.MemoryDump[i]);
+	if (IsFrameValid(frameNo) == false)
+		return false;
+
+	for (int keyFrameNo = frameNo; IsFrameValid(keyFrameNo); keyFrameNo--)
+	{
+		const FFrameHistory& keyFrame = FrameHistory[keyFrameNo % kNoFramesInHistory];
+		if (keyFrame.KeyFrameRAM.empty())
+			continue;
+
+		memcpy(pRAM, keyFrame.KeyFrameRAM.data(), RAMSize);
+		for (int applyFrameNo = keyFrameNo + 1; applyFrameNo <= frameNo; applyFrameNo++)
+			ApplyRAMDiff(FrameHistory[applyFrameNo % kNoFramesInHistory].RAMDiff, pRAM);
+		return true;
+	}
+
+	return false;
 }
 
 void FFrameTraceViewer::Draw()
 {
+	const int noFrames = NextFrameNo - OldestFrameNo;
+	const int maxShowFrame = std::max(noFrames - 1, 0);
+	bool bScrubbed = false;
+
 	if (ImGui::ArrowButton("##left", ImGuiDir_Left))
-		ShowFrame = std::max(--ShowFrame, 0);
+	{
+		ShowFrame = std::max(ShowFrame - 1, 0);
+		bScrubbed = true;
+	}
 
 	ImGui::SameLine();
 
 	if (ImGui::ArrowButton("##right", ImGuiDir_Right))
-		ShowFrame = std::min(++ShowFrame, kNoFramesInTrace - 1);
+	{
+		ShowFrame = std::min(ShowFrame + 1, maxShowFrame);
+		bScrubbed = true;
+	}
 
 	ImGui::SameLine();
-	int frameNo = 0;
 
-	if (ImGui::SliderInt("Backwards Offset", &ShowFrame, 0, kNoFramesInTrace - 1))
+	if (ImGui::SliderInt("Backwards Offset", &ShowFrame, 0, maxShowFrame))
+		bScrubbed = true;
+	ShowFrame = std::min(ShowFrame, maxShowFrame);
+
+	const int frameNo = NextFrameNo - ShowFrame - 1;
+	const FSpeccyFrameTrace* pFrame = GetFrameTrace(frameNo);
+
+	if (bScrubbed)
 	{
 		if (ShowFrame == 0)
 			pSpectrumEmu->CodeAnalysis.CPUInterface->Continue();
@@ -107,36 +269,35 @@ void FFrameTraceViewer::Draw()
 
 		PixelWriteline = -1;
 		SelectedTraceLine = -1;
-		frameNo = CurrentTraceFrame - ShowFrame - 1;
-		if (frameNo < 0)
-			frameNo += kNoFramesInTrace;
-		DrawFrameScreenWritePixels(FrameTrace[frameNo]);
+		if (pFrame != nullptr)
+			DrawFrameScreenWritePixels(*pFrame);
 
 		if (RestoreOnScrub)
-			RestoreFrame(FrameTrace[frameNo]);
+			RestoreFrame(frameNo);
 	}
-	else
-	{
-		frameNo = CurrentTraceFrame - ShowFrame - 1;
-		if (frameNo < 0)
-			frameNo += kNoFramesInTrace;
-	}
-	const FSpeccyFrameTrace& frame = FrameTrace[frameNo];
-	
 
-	if (ImGui::Button("Restore"))
+	if (ImGui::Button("Restore") && IsFrameValid(frameNo))
 	{
-		RestoreFrame(frame);
+		RestoreFrame(frameNo);
 
-		// continue running
+		// continue running, later frames get dropped
 		pSpectrumEmu->CodeAnalysis.CPUInterface->Continue();
-
-		CurrentTraceFrame = frameNo;
 		ShowFrame = 0;
 	}
 	ImGui::SameLine();
 	ImGui::Checkbox("Restore On Scrub", &RestoreOnScrub);
-	
+	ImGui::SameLine();
+	ImGui::Text("History: %.1fs, %.1fMB", noFrames / 50.0f, HistoryBytes / (1024.0f * 1024.0f));
+
+	if (pFrame == nullptr)
+	{
+		ImGui::Text("Only RAM & machine state are kept for frames more than %d frames back", kNoFramesInTrace);
+		if (IsFrameValid(frameNo))
+			DrawMemoryDiffs(frameNo);
+		return;
+	}
+
+	const FSpeccyFrameTrace& frame = *pFrame;
 	ImGui::Image(frame.Texture, ImVec2(320, 256));
 	ImGui::SameLine();
 	ShowWritesView->Draw();
@@ -153,7 +314,7 @@ void FFrameTraceViewer::Draw()
 		if (ImGui::BeginTabItem("Trace Overview"))
 		{
 			if (frame.FrameOverview.size() == 0)
-				GenerateTraceOverview(FrameTrace[frameNo]);
+				GenerateTraceOverview(FrameTrace[frameNo % kNoFramesInTrace]);
 			DrawTraceOverview(frame);
 			ImGui::EndTabItem();
 		}
@@ -166,7 +327,7 @@ void FFrameTraceViewer::Draw()
 
 		if (ImGui::BeginTabItem("Diff"))
 		{
-			DrawMemoryDiffs(frame);
+			DrawMemoryDiffs(frameNo);
 			ImGui::EndTabItem();
 		}
 
@@ -201,7 +362,7 @@ void	FFrameTraceViewer::DrawInstructionTrace(const FSpeccyFrameTrace& frame)
 			FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(instAddr);
 			if (pCodeInfo)
 			{
-				ImGui::Text("%s %s", NumStr(instAddr), pCodeInfo->Text.c_str());
+				ImGui::Text("%s %s", NumStr(instAddr), GetCodeInfoText(state, pCodeInfo));
 				ImGui::SameLine();
 				DrawAddressLabel(state, viewState, instAddr);
 			}
@@ -267,24 +428,32 @@ void	FFrameTraceViewer::GenerateTraceOverview(FSpeccyFrameTrace& frame)
 	}
 }
 
-void FFrameTraceViewer::GenerateMemoryDiff(const FSpeccyFrameTrace& frame, const FSpeccyFrameTrace& otherFrame, std::vector<FMemoryDiff>& outDiff)
+void FFrameTraceViewer::GenerateRAMDiff(const uint8_t* pNewRAM, const uint8_t* pOldRAM, FRAMDiff& outDiff)
 {
-	outDiff.clear();
+	// diff all RAM banks - frames are rebuilt from these
+	DiffMemory(pNewRAM, pOldRAM, RAMSize, outDiff.Runs);
 
-	// diff RAM with previous frame
-	// skip ROM & screen memory
-	// might want to exclude stack (once we determine where it is)
-	for (int i = 0x5C00; i < 1 << 16; i++)	
+	// merge runs with small gaps, the unchanged bytes in between take less space than a run
+	size_t noRuns = 0;
+	for (size_t runNo = 0; runNo < outDiff.Runs.size(); runNo++)
 	{
-		if (frame.MemoryDump[i] != otherFrame.MemoryDump[i])
+		const FMemoryDiffRun run = outDiff.Runs[runNo];
+		if (noRuns > 0)
 		{
-			FMemoryDiff diff;
-			diff.Address = i;
-			diff.NewVal = frame.MemoryDump[i];
-			diff.OldVal = otherFrame.MemoryDump[i];
-			outDiff.push_back(diff);
+			FMemoryDiffRun& lastRun = outDiff.Runs[noRuns - 1];
+			if (run.Offset - (lastRun.Offset + lastRun.Size) <= sizeof(FMemoryDiffRun))
+			{
+				lastRun.Size = run.Offset + run.Size - lastRun.Offset;
+				continue;
+			}
 		}
+		outDiff.Runs[noRuns++] = run;
 	}
+	outDiff.Runs.resize(noRuns);
+
+	outDiff.NewBytes.clear();
+	for (const FMemoryDiffRun& run : outDiff.Runs)
+		outDiff.NewBytes.insert(outDiff.NewBytes.end(), pNewRAM + run.Offset, pNewRAM + run.Offset + run.Size);
 }
 
 void	FFrameTraceViewer::DrawTraceOverview(const FSpeccyFrameTrace& frame)
@@ -371,16 +540,68 @@ void	FFrameTraceViewer::DrawScreenWrites(const FSpeccyFrameTrace& frame)
 	ImGui::EndChild();
 }
 
-void FFrameTraceViewer::DrawMemoryDiffs(const FSpeccyFrameTrace& frame)
+// Get the CPU address a RAM offset was paged in at, -1 if it wasn't visible
+static int GetCPUAddressForRAMOffset(uint32_t ramOffset, bool b128K, uint8_t memConfig)
+{
+	if (b128K == false)
+		return 0x4000 + ramOffset;	// 48K banks are 0x4000-0xffff
+
+	const int bank = ramOffset / 0x4000;
+	const int bankOffset = ramOffset & 0x3fff;
+	if (bank == 5)
+		return 0x4000 + bankOffset;
+	if (bank == 2)
+		return 0x8000 + bankOffset;
+	if (bank == (memConfig & 7))
+		return 0xC000 + bankOffset;
+	return -1;
+}
+
+void FFrameTraceViewer::DrawMemoryDiffs(int frameNo)
 {
 	FCodeAnalysisState& state = pSpectrumEmu->CodeAnalysis;
 	FCodeAnalysisViewState& viewState = state.GetFocussedViewState();
+	const bool b128K = RAMSize == 8 * 0x4000;
+	const FFrameHistory& history = FrameHistory[frameNo % kNoFramesInHistory];
+	const FRAMDiff& diff = history.RAMDiff;
+	uint32_t byteIndex = 0;
 
-	for (const auto& diff : frame.MemoryDiffs)
+	// old values come from the previous frame, which isn't there for the oldest frame
+	if (PrevFrameRAMFrameNo != frameNo - 1)
+		PrevFrameRAMFrameNo = ReconstructFrameRAM(frameNo - 1, PrevFrameRAM) ? frameNo - 1 : -1;
+	const bool bHaveOldValues = PrevFrameRAMFrameNo == frameNo - 1;
+
+	for (const FMemoryDiffRun& run : diff.Runs)
 	{
-		ImGui::Text("%s : ", NumStr(diff.Address));
-		DrawAddressLabel(state, viewState, diff.Address);
-		ImGui::SameLine();
-		ImGui::Text("%d(%s) -> %d(%s)", diff.OldVal, NumStr(diff.OldVal), diff.NewVal, NumStr(diff.NewVal));
+		for (uint32_t i = 0; i < run.Size; i++, byteIndex++)
+		{
+			const uint32_t ramOffset = run.Offset + i;
+			const uint8_t newVal = diff.NewBytes[byteIndex];
+			const uint8_t oldVal = PrevFrameRAM[ramOffset];
+			if (bHaveOldValues && oldVal == newVal)	// gap in a merged run
+				continue;
+
+			const int addr = GetCPUAddressForRAMOffset(ramOffset, b128K, history.pMachineState->LastMemConfig);
+
+			if (addr == -1)	// paged out bank
+			{
+				ImGui::Text("Bank %d:%s : ", ramOffset / 0x4000, NumStr((uint16_t)(ramOffset & 0x3fff)));
+			}
+			else
+			{
+				// skip screen memory
+				// might want to exclude stack (once we determine where it is)
+				if (addr < 0x5C00)
+					continue;
+
+				ImGui::Text("%s : ", NumStr((uint16_t)addr));
+				DrawAddressLabel(state, viewState, (uint16_t)addr);
+			}
+			ImGui::SameLine();
+			if (bHaveOldValues)
+				ImGui::Text("%d(%s) -> %d(%s)", oldVal, NumStr(oldVal), newVal, NumStr(newVal));
+			else
+				ImGui::Text("-> %d(%s)", newVal, NumStr(newVal));
+		}
 	}
 }
@@ -2,6 +2,7 @@
 
 
 #include "CodeAnalyser/CodeAnalyser.h"
+#include "Util/MemoryDiff.h"
 
 #include <cstdint>
 #include <vector>
@@ -9,6 +10,7 @@
 
 class FSpectrumEmu;
 class FZXGraphicsView;
+struct FSpectrumMachineState;
 
 struct FFrameOverviewItem
 {
@@ -17,24 +19,35 @@ struct FFrameOverviewItem
 	uint16_t		LabelAddress;
 };
 
-struct FMemoryDiff
+// Changes to RAM since the previous frame - runs of changed bytes with their new values
+// Runs a few bytes apart are merged as the gap costs less than another run
+struct FRAMDiff
 {
-	uint16_t	Address;
-	uint8_t		OldVal;
-	uint8_t		NewVal;
+	std::vector<FMemoryDiffRun>	Runs;
+	std::vector<uint8_t>		NewBytes;
 };
 
+// RAM & machine state for a frame in the rewind history
+// RAM is stored as a periodic keyframe plus per-frame changes
+// All RAM banks are stored so 128K games can be rewound, not just the CPU visible 64K
+struct FFrameHistory
+{
+	int						FrameNo = -1;			// capture number, -1 if not captured
+	std::vector<uint8_t>	KeyFrameRAM;			// all RAM banks - keyframes only
+	FRAMDiff				RAMDiff;				// changes since previous frame
+	FSpectrumMachineState*	pMachineState = nullptr;	// CPU, paging & AY
+};
+
+// What the frame did - only kept for the most recent frames
 struct FSpeccyFrameTrace
 {
-	void*					Texture;
-	uint8_t					MemoryDump[1 << 16];	// 64K
-	void*					CPUState = nullptr;
+	void*					Texture = nullptr;
+	int						FrameNo = -1;			// capture number, -1 if not captured
 	std::vector<uint16_t>	InstructionTrace;
 	std::vector<FMemoryAccess>	ScreenPixWrites;
 	std::vector<FMemoryAccess>	ScreenAttrWrites;
 
 	std::vector<FFrameOverviewItem>	FrameOverview;
-	std::vector<FMemoryDiff>	MemoryDiffs;
 };
 
 class FFrameTraceViewer
@@ -45,23 +58,49 @@ public:
 	void	CaptureFrame();
 	void	Draw();
 private:
-	void	RestoreFrame(const FSpeccyFrameTrace& frame);
+	bool	IsFrameValid(int frameNo) const;
+	const FSpeccyFrameTrace*	GetFrameTrace(int frameNo) const;
+	void	ResetHistory();
+	void	ReleaseHistoryFrame(FFrameHistory& history);
+	void	DropOldestHistory();
+	bool	ReconstructFrameRAM(int frameNo, uint8_t* pRAM) const;
+	void	RestoreFrame(int frameNo);
 	void	DrawInstructionTrace(const FSpeccyFrameTrace& frame);
 	void	GenerateTraceOverview(FSpeccyFrameTrace& frame);
-	void	GenerateMemoryDiff(const FSpeccyFrameTrace& frameA, const FSpeccyFrameTrace& frameB, std::vector<FMemoryDiff>& outDiff);
+	void	GenerateRAMDiff(const uint8_t* pNewRAM, const uint8_t* pOldRAM, FRAMDiff& outDiff);
 	void	DrawTraceOverview(const FSpeccyFrameTrace& frame);
 	void	DrawFrameScreenWritePixels(const FSpeccyFrameTrace& frame, int lastIndex = -1);
 	void	DrawScreenWrites(const FSpeccyFrameTrace& frame);
-	void	DrawMemoryDiffs(const FSpeccyFrameTrace& frame);
+	void	DrawMemoryDiffs(int frameNo);
 
 	FSpectrumEmu* pSpectrumEmu = nullptr;
 
-	int					ShowFrame = 0;
-	int					CurrentTraceFrame = 0;
+	int					ShowFrame = 0;		// frames back from the latest
 	bool				RestoreOnScrub = false;
+
+	// traces & screen images are big so only the last few seconds are kept
 	static const int	kNoFramesInTrace = 300;
 	FSpeccyFrameTrace	FrameTrace[kNoFramesInTrace];
 
+	// RAM history is kept for as long as it fits in the budget, the old 300 frames of 64K dumps used about this much
+	// the budget includes the fixed size per-frame entries & machine states
+	static const int	kNoFramesInHistory = 50 * 60 * 5;	// 5 minutes
+	static const int	kKeyFrameInterval = 250;	// one keyframe every 5 seconds
+	static const size_t	kHistoryMemoryBudget = 20 * 1024 * 1024;
+	FFrameHistory*		FrameHistory = nullptr;	// kNoFramesInHistory entries, slot is frame no % size
+	FSpectrumMachineState*	HistoryMachineStates = nullptr;
+	size_t				HistoryBytes = 0;
+
+	int					NextFrameNo = 0;
+	int					OldestFrameNo = 0;		// oldest frame in the history, always a keyframe
+	int					RestoredFrameNo = -1;	// frames after this are dropped when the emulator runs on from a restore
+	bool				bForceKeyFrame = true;
+	bool				bLastFrameRAMValid = false;
+	int					RAMSize = 0;	// 48K or 128K
+	uint8_t				LastFrameRAM[8 * 0x4000];	// RAM at last capture - used to generate diffs
+	uint8_t				PrevFrameRAM[8 * 0x4000];	// RAM before the frame shown in the diff tab
+	int					PrevFrameRAMFrameNo = -1;
+
 	int		SelectedTraceLine = -1;
 	int		PixelWriteline = -1;
 	FZXGraphicsView*	ShowWritesView = nullptr;
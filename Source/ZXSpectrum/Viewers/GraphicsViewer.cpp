@@ -63,22 +63,13 @@ uint8_t GetHeatmapColourForMemoryAddress(FCodeAnalysisState &state, uint16_t add
 			return 6;	// yellow code
 	}
 	
-	const FDataInfo* pReadDataInfo = state.GetReadDataInfoForAddress(addr);
-	if (pReadDataInfo && pReadDataInfo->LastFrameRead != -1)
-	{
-		const int framesSinceRead = state.CurrentFrameNo - pReadDataInfo->LastFrameRead;
-		
-		if (pReadDataInfo->LastFrameRead != -1 && (framesSinceRead < frameThreshold))
-			return 4;	// green
-	}
+	const int lastFrameRead = state.GetLastFrameReadForAddress(addr);
+	if (lastFrameRead != -1 && (state.CurrentFrameNo - lastFrameRead < frameThreshold))
+		return 4;	// green
 
-	const FDataInfo* pWriteDataInfo = state.GetWriteDataInfoForAddress(addr);
-	if (pWriteDataInfo && pWriteDataInfo->LastFrameWritten != -1)
-	{
-		const int framesSinceWritten = state.CurrentFrameNo - pWriteDataInfo->LastFrameWritten;
-		if (pWriteDataInfo->LastFrameWritten != -1 && (framesSinceWritten < frameThreshold))
-			return 2; // red
-	}
+	const int lastFrameWritten = state.GetLastFrameWrittenForAddress(addr);
+	if (lastFrameWritten != -1 && (state.CurrentFrameNo - lastFrameWritten < frameThreshold))
+		return 2; // red
 
 	return col;
 }
@@ -38,29 +38,34 @@ void FOverviewViewer::CalculateStats()
     int ReadWriteDataCount = 0;
     int UnknownCount = 0;
 
-    for (int i = 0; i < (1 << 16); i++)
+    FCodeAnalysisState& state = pSpectrumEmu->CodeAnalysis;
+
+    // go a page at a time so the scan walks the page arrays linearly
+    for (int pageBase = 0; pageBase < (1 << 16); pageBase += FCodeAnalysisPage::kPageSize)
     {
-        const bool bInRom = i < 0x4000;
-        const FCodeInfo* pCodeInfo = pSpectrumEmu->CodeAnalysis.GetCodeInfoForAddress(i);
-        if (pCodeInfo != nullptr)
-        {
-            if (pCodeInfo->Comment.empty())
-                UnCommentedCodeCount++;
-            else
-                CommentedCodeCount++;
-        }
-        else
-        {
-            const FDataInfo *pDataInfo = pSpectrumEmu->CodeAnalysis.GetReadDataInfoForAddress(i);
-            const bool bRead = pDataInfo->LastFrameRead != -1;
-            const bool bWrite = pDataInfo->LastFrameWritten != -1;
+        const bool bInRom = pageBase < 0x4000;
+        const FCodeAnalysisPage* pReadPage = state.GetReadPage(pageBase);
+        const FCodeAnalysisPage* pWritePage = state.GetWritePage(pageBase);
 
-            if (bInRom)
+        for (int pageAddr = 0; pageAddr < FCodeAnalysisPage::kPageSize; pageAddr++)
+        {
+            const FCodeInfo* pCodeInfo = pReadPage->CodeInfo[pageAddr];
+            if (pCodeInfo != nullptr)
+            {
+                if (pCodeInfo->Comment.empty())
+                    UnCommentedCodeCount++;
+                else
+                    CommentedCodeCount++;
+            }
+            else if (bInRom)
             {
                 ReadOnlyDataCount++;
             }
             else
             {
+                const bool bRead = pReadPage->LastFrameRead[pageAddr] != -1;
+                const bool bWrite = pWritePage->LastFrameWritten[pageAddr] != -1;
+
                 if (bRead && !bWrite)
                     ReadOnlyDataCount++;
                 else if (!bRead && bWrite)
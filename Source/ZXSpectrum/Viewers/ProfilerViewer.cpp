@@ -0,0 +1,151 @@
+#include "ProfilerViewer.h"
+#include "../SpectrumEmu.h"
+#include "../GameConfig.h"
+#include "../GlobalConfig.h"
+
+#include <imgui.h>
+#include <implot.h>
+#include <algorithm>
+#include <CodeAnalyser/UI/CodeAnalyserUI.h>
+#include <Util/FileUtil.h>
+
+void FProfilerViewer::DrawUI(void)
+{
+	FProfiler& profiler = pSpectrumEmu->Profiler;
+
+	// profiling costs time on every instruction so it's off until asked for, each run starts afresh
+	if (ImGui::Checkbox("Enabled", &profiler.bEnabled) && profiler.bEnabled)
+		profiler.Reset();
+	ImGui::SameLine();
+	if (ImGui::Button("Reset"))
+		profiler.Reset();
+	ImGui::SameLine();
+	if (ImGui::Button("Export Flame Graph") && pSpectrumEmu->pActiveGame != nullptr)
+	{
+		const std::string outputDir = GetGlobalConfig().WorkspaceRoot + "OutputProfiles/";
+		EnsureDirectoryExists(outputDir.c_str());
+		const std::string outFname = outputDir + pSpectrumEmu->pActiveGame->pConfig->Name + ".folded";
+		profiler.ExportCollapsedStacks(pSpectrumEmu->CodeAnalysis, outFname.c_str());
+	}
+	if (ImGui::IsItemHovered())
+		ImGui::SetTooltip("Export cumulative call stacks in collapsed format for flame graph tools");
+	ImGui::SameLine();
+	ImGui::Checkbox("Cumulative", &bShowCumulative);
+
+	DrawTimeline();
+	DrawFunctionTable();
+}
+
+void FProfilerViewer::DrawTimeline()
+{
+	const FProfiler& profiler = pSpectrumEmu->Profiler;
+
+	// unwrap the history ring, oldest first
+	static float mainTicks[FProfiler::kNoHistoryFrames];
+	static float interruptTicks[FProfiler::kNoHistoryFrames];
+	static float selectedTicks[FProfiler::kNoHistoryFrames];
+	const int noFrames = profiler.NoHistoryFrames;
+	const int firstFrame = (profiler.HistoryPos - noFrames + FProfiler::kNoHistoryFrames) % FProfiler::kNoHistoryFrames;
+	for (int i = 0; i < noFrames; i++)
+	{
+		const FProfileFrameInfo& frameInfo = profiler.History[(firstFrame + i) % FProfiler::kNoHistoryFrames];
+		mainTicks[i] = (float)frameInfo.MainTicks;
+		interruptTicks[i] = (float)frameInfo.InterruptTicks;
+		selectedTicks[i] = (float)frameInfo.SelectedFunctionTicks;
+	}
+
+	if (ImPlot::BeginPlot("##ProfileTimeline", ImVec2(-1, 150)))
+	{
+		ImPlot::SetupAxes("Frame", "T-States", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+		ImPlot::PlotLine("Main", mainTicks, noFrames);
+		ImPlot::PlotLine("Interrupt", interruptTicks, noFrames);
+		if (profiler.SelectedFunction != -1)
+			ImPlot::PlotLine("Selected", selectedTicks, noFrames);
+		ImPlot::EndPlot();
+	}
+}
+
+void FProfilerViewer::DrawFunctionTable()
+{
+	FProfiler& profiler = pSpectrumEmu->Profiler;
+	FCodeAnalysisState& state = pSpectrumEmu->CodeAnalysis;
+	FCodeAnalysisViewState& viewState = state.GetFocussedViewState();
+	const bool bCumulative = bShowCumulative;
+
+	enum EColumn { Column_Function, Column_Calls, Column_Inclusive, Column_Exclusive, Column_Percent };
+
+	const ImGuiTableFlags tableFlags = ImGuiTableFlags_Sortable | ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter | ImGuiTableFlags_Resizable;
+	if (ImGui::BeginTable("##ProfileFunctions", 5, tableFlags) == false)
+		return;
+
+	ImGui::TableSetupScrollFreeze(0, 1);
+	ImGui::TableSetupColumn("Function", ImGuiTableColumnFlags_NoSort, 0.0f, Column_Function);
+	ImGui::TableSetupColumn("Calls", 0, 0.0f, Column_Calls);
+	ImGui::TableSetupColumn("Inclusive", 0, 0.0f, Column_Inclusive);
+	ImGui::TableSetupColumn("Exclusive", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending, 0.0f, Column_Exclusive);
+	ImGui::TableSetupColumn("Excl %", ImGuiTableColumnFlags_NoSort, 0.0f, Column_Percent);
+	ImGui::TableHeadersRow();
+
+	// sort every draw - the counts change each frame
+	const int noFunctions = (int)profiler.Functions.size();
+	SortedFunctions.resize(noFunctions);
+	for (int i = 0; i < noFunctions; i++)
+		SortedFunctions[i] = i;
+
+	ImGuiTableSortSpecs* pSortSpecs = ImGui::TableGetSortSpecs();
+	if (pSortSpecs != nullptr && pSortSpecs->SpecsCount > 0)
+	{
+		const ImGuiTableColumnSortSpecs& spec = pSortSpecs->Specs[0];
+		const bool bAscending = spec.SortDirection == ImGuiSortDirection_Ascending;
+		auto getValue = [&](const FProfileFunction& function) -> uint64_t
+		{
+			switch (spec.ColumnUserID)
+			{
+			case Column_Calls:		return bCumulative ? function.CallCount : function.LastFrameCallCount;
+			case Column_Inclusive:	return bCumulative ? function.InclusiveTicks : function.LastFrameInclusiveTicks;
+			default:				return bCumulative ? function.ExclusiveTicks : function.LastFrameExclusiveTicks;
+			}
+		};
+		std::sort(SortedFunctions.begin(), SortedFunctions.end(), [&](int a, int b)
+		{
+			const uint64_t valueA = getValue(profiler.Functions[a]);
+			const uint64_t valueB = getValue(profiler.Functions[b]);
+			return bAscending ? valueA < valueB : valueA > valueB;
+		});
+	}
+
+	uint64_t totalTicks = 0;
+	for (const FProfileFunction& function : profiler.Functions)
+		totalTicks += bCumulative ? function.ExclusiveTicks : function.LastFrameExclusiveTicks;
+
+	ImGuiListClipper clipper;
+	clipper.Begin(noFunctions);
+	while (clipper.Step())
+	{
+		for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+		{
+			const int functionIndex = SortedFunctions[row];
+			const FProfileFunction& function = profiler.Functions[functionIndex];
+			const uint64_t exclusiveTicks = bCumulative ? function.ExclusiveTicks : function.LastFrameExclusiveTicks;
+
+			ImGui::PushID(functionIndex);
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			if (ImGui::Selectable(profiler.GetFunctionName(state, functionIndex).c_str(), profiler.SelectedFunction == functionIndex, ImGuiSelectableFlags_SpanAllColumns))
+				profiler.SelectedFunction = functionIndex;
+			if (functionIndex != 0 && ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(0))
+				CodeAnalyserGoToAddress(viewState, function.Address);
+			ImGui::TableNextColumn();
+			ImGui::Text("%u", bCumulative ? function.CallCount : function.LastFrameCallCount);
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", (unsigned long long)(bCumulative ? function.InclusiveTicks : function.LastFrameInclusiveTicks));
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", (unsigned long long)exclusiveTicks);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f%%", totalTicks != 0 ? (float)exclusiveTicks * 100.0f / (float)totalTicks : 0.0f);
+			ImGui::PopID();
+		}
+	}
+
+	ImGui::EndTable();
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "ViewerBase.h"
+
+#include <vector>
+
+class FProfilerViewer : public FViewerBase
+{
+public:
+			FProfilerViewer(FSpectrumEmu* pEmu) :FViewerBase(pEmu) { Name = "Profiler"; }
+	bool	Init(void) override { return true; }
+	void	DrawUI() override;
+private:
+	void	DrawTimeline();
+	void	DrawFunctionTable();
+
+	bool				bShowCumulative = false;
+	std::vector<int>	SortedFunctions;
+};
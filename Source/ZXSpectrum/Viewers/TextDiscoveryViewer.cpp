@@ -0,0 +1,229 @@
+#include "TextDiscoveryViewer.h"
+#include "../SpectrumEmu.h"
+
+#include <imgui.h>
+#include <CodeAnalyser/UI/CodeAnalyserUI.h>
+#include <CodeAnalyser/Commands/FormatDataCommand.h>
+
+#include <chrono>
+
+enum class ETextCandidateStatus
+{
+	Ok,
+	NotPagedIn,
+	Code,		// overlaps code
+	Formatted,	// start isn't plain byte data
+	Encoding,	// the text data type can't display the encoding
+};
+
+// the text data type shows ASCII, with an optional bit 7 terminator
+static bool CanFormatAsText(ETextEncoding encoding)
+{
+	return encoding == ETextEncoding::Ascii || encoding == ETextEncoding::Bit7Terminated;
+}
+
+static ETextCandidateStatus GetCandidateStatus(FCodeAnalysisState& state, const FMemorySearchBank& bank, const FTextCandidate& candidate)
+{
+	// the whole string has to be visible to the CPU
+	const int bankCPUAddress = bank.GetCPUAddress(candidate.Offset);
+	if (bankCPUAddress == -1 || bank.GetCPUAddress(candidate.Offset + candidate.Length - 1) != bankCPUAddress + candidate.Length - 1 || bankCPUAddress + candidate.Length > 0x10000)
+		return ETextCandidateStatus::NotPagedIn;
+
+	const uint16_t startAddress = (uint16_t)bankCPUAddress;
+	for (int i = 0; i < candidate.Length; i++)
+	{
+		const FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(startAddress + i);
+		if (pCodeInfo != nullptr && pCodeInfo->bDisabled == false)
+			return ETextCandidateStatus::Code;
+	}
+
+	if (state.GetReadDataInfoForAddress(startAddress)->DataType != EDataType::Byte)
+		return ETextCandidateStatus::Formatted;
+
+	if (CanFormatAsText(candidate.Encoding) == false)
+		return ETextCandidateStatus::Encoding;
+
+	return ETextCandidateStatus::Ok;
+}
+
+void FTextDiscoveryViewer::DrawUI(void)
+{
+	std::vector<FMemorySearchBank> banks;
+	pSpectrumEmu->GetMemorySearchBanks(banks);
+
+	DrawOptions();
+
+	if (ImGui::Button("Scan"))
+	{
+		const auto startTime = std::chrono::steady_clock::now();
+		DiscoverText(banks.data(), (int)banks.size(), Options, Candidates);
+		const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+		ScanTimeMS = elapsed.count();
+		Selected.assign(Candidates.size(), false);
+		NoFormatted = -1;
+	}
+	ImGui::SameLine();
+	ImGui::Text("%d candidates (%.2fms)", (int)Candidates.size(), ScanTimeMS);
+
+	ImGui::Separator();
+	if (ImGui::Button("Select All"))
+		Selected.assign(Candidates.size(), true);
+	ImGui::SameLine();
+	if (ImGui::Button("Select None"))
+		Selected.assign(Candidates.size(), false);
+	ImGui::SameLine();
+	ImGui::Checkbox("Add Labels", &bAddLabels);
+	ImGui::SameLine();
+	if (ImGui::Button("Format Selected"))
+		FormatSelected(banks);
+	if (ImGui::IsItemHovered())
+		ImGui::SetTooltip("Formats the selected candidates as text in one step. Candidates that aren't paged in, overlap code, are already formatted or use an encoding the text view can't show (tokens, character maps) are skipped.");
+	ImGui::SameLine();
+	FCodeAnalysisState& state = pSpectrumEmu->CodeAnalysis;
+	const bool bCanUndo = pFormatCommand != nullptr && state.CommandStack.empty() == false && state.CommandStack.back() == pFormatCommand;
+	if (bCanUndo == false)
+		ImGui::BeginDisabled();
+	if (ImGui::Button("Undo"))
+	{
+		UndoCommand(state);
+		pFormatCommand = nullptr;
+		NoFormatted = -1;
+	}
+	if (bCanUndo == false)
+		ImGui::EndDisabled();
+	if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
+		ImGui::SetTooltip("Undoes the last format from this window, as long as nothing else has been done since.");
+	if (NoFormatted != -1)
+	{
+		ImGui::SameLine();
+		ImGui::Text("Formatted %d strings", NoFormatted);
+	}
+
+	DrawCandidates(banks);
+}
+
+void FTextDiscoveryViewer::DrawOptions()
+{
+	for (int i = 0; i < (int)ETextEncoding::Count; i++)
+	{
+		if (i != 0)
+			ImGui::SameLine();
+		ImGui::Checkbox(GetTextEncodingName((ETextEncoding)i), &Options.bEncodings[i]);
+	}
+
+	if (Options.bEncodings[(int)ETextEncoding::CharacterMap])
+	{
+		ImGui::Text("Character codes (-1 if not used)");
+		ImGui::SetNextItemWidth(80);
+		ImGui::InputInt("'A'", &Options.CharacterMap.LetterA);
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(80);
+		ImGui::InputInt("'0'", &Options.CharacterMap.Digit0);
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(80);
+		ImGui::InputInt("Space", &Options.CharacterMap.Space);
+	}
+
+	ImGui::SetNextItemWidth(80);
+	ImGui::InputInt("Min Length", &Options.MinLength);
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(80);
+	ImGui::InputInt("Min Score", &Options.MinScore);
+	ImGui::SameLine();
+	ImGui::Checkbox("Include ROM", &Options.bIncludeROM);
+	Options.MinLength = std::max(Options.MinLength, 1);
+}
+
+void FTextDiscoveryViewer::FormatSelected(const std::vector<FMemorySearchBank>& banks)
+{
+	FCodeAnalysisState& state = pSpectrumEmu->CodeAnalysis;
+	std::vector<FDataFormattingOptions> formats;
+
+	for (int i = 0; i < (int)Candidates.size(); i++)
+	{
+		const FTextCandidate& candidate = Candidates[i];
+		if (Selected[i] == false || candidate.Bank >= (int)banks.size())
+			continue;
+
+		const FMemorySearchBank& bank = banks[candidate.Bank];
+		if (GetCandidateStatus(state, bank, candidate) != ETextCandidateStatus::Ok)
+			continue;
+
+		FDataFormattingOptions format;
+		format.DataType = EDataType::Text;
+		format.StartAddress = bank.GetCPUAddress(candidate.Offset);
+		format.ItemSize = candidate.Length;
+		format.NoItems = 1;
+		format.AddLabelAtStart = bAddLabels;
+		formats.push_back(format);
+	}
+
+	NoFormatted = (int)formats.size();
+	if (formats.empty() == false)
+	{
+		FFormatDataCommand* pCommand = new FFormatDataCommand(formats);
+		DoCommand(state, pCommand);
+		pFormatCommand = pCommand;
+	}
+}
+
+void FTextDiscoveryViewer::DrawCandidates(const std::vector<FMemorySearchBank>& banks)
+{
+	FCodeAnalysisState& state = pSpectrumEmu->CodeAnalysis;
+	FCodeAnalysisViewState& viewState = state.GetFocussedViewState();
+
+	if (ImGui::BeginChild("TextCandidates", ImVec2(0, 0), true, ImGuiWindowFlags_HorizontalScrollbar))
+	{
+		ImGuiListClipper clipper((int)Candidates.size(), ImGui::GetFrameHeightWithSpacing());
+
+		while (clipper.Step())
+		{
+			for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+			{
+				const FTextCandidate& candidate = Candidates[i];
+				if (candidate.Bank >= (int)banks.size())
+					continue;
+
+				// use current paging - it may have changed since the scan
+				const FMemorySearchBank& bank = banks[candidate.Bank];
+				const ETextCandidateStatus status = GetCandidateStatus(state, bank, candidate);
+				const uint16_t cpuAddress = (uint16_t)bank.GetCPUAddress(candidate.Offset);
+
+				ImGui::PushID(i);
+				bool bSelected = Selected[i];
+				if (ImGui::Checkbox("##select", &bSelected))
+					Selected[i] = bSelected;
+				ImGui::SameLine();
+				ImGui::Text("%s:%04X", bank.Name.c_str(), candidate.Offset);
+				ImGui::SameLine(130);
+				if (status == ETextCandidateStatus::NotPagedIn)
+				{
+					ImGui::TextDisabled("not paged in");
+				}
+				else
+				{
+					ImGui::Text("%s", NumStr(cpuAddress));
+					if (ImGui::IsItemClicked())
+						CodeAnalyserGoToAddress(viewState, cpuAddress);
+					ImGui::SameLine();
+					DrawAddressLabel(state, viewState, cpuAddress);
+				}
+				ImGui::SameLine(330);
+				ImGui::Text("%3d", candidate.Score);
+				ImGui::SameLine(370);
+				if (status == ETextCandidateStatus::Code)
+					ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.25f, 1.0f), "code");
+				else if (status == ETextCandidateStatus::Formatted)
+					ImGui::TextDisabled("formatted");
+				else if (status == ETextCandidateStatus::Encoding)
+					ImGui::TextDisabled("%s (can't format)", GetTextEncodingName(candidate.Encoding));
+				else
+					ImGui::TextDisabled("%s", GetTextEncodingName(candidate.Encoding));
+				ImGui::SameLine(500);
+				ImGui::Text("\"%.64s\"", candidate.Text.c_str());
+				ImGui::PopID();
+			}
+		}
+	}
+	ImGui::EndChild();
+}
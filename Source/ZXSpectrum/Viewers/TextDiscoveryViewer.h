@@ -0,0 +1,29 @@
+#pragma once
+
+#include "ViewerBase.h"
+
+#include <Util/TextDiscovery.h>
+
+#include <vector>
+
+class FCommand;
+
+class FTextDiscoveryViewer : public FViewerBase
+{
+public:
+			FTextDiscoveryViewer(FSpectrumEmu* pEmu) :FViewerBase(pEmu) { Name = "Text Discovery"; }
+	bool	Init(void) override { return true; }
+	void	DrawUI() override;
+private:
+	void	DrawOptions();
+	void	DrawCandidates(const std::vector<FMemorySearchBank>& banks);
+	void	FormatSelected(const std::vector<FMemorySearchBank>& banks);
+
+	FTextDiscoveryOptions		Options;
+	std::vector<FTextCandidate>	Candidates;
+	std::vector<bool>			Selected;	// per candidate
+	bool						bAddLabels = true;
+	double						ScanTimeMS = 0.0;
+	int							NoFormatted = -1;	// result of the last format, -1 if none
+	const FCommand*				pFormatCommand = nullptr;	// last format command, only undone while it's on top of the command stack
+};
@@ -0,0 +1,214 @@
+#include "WriteJournal.h"
+#include "SpectrumEmu.h"
+
+#include "Debug/DebugLog.h"
+
+// round down to a power of 2 so ring indices are a mask
+static uint64_t GetRingSize(size_t budget, size_t itemSize)
+{
+	uint64_t size = 1;
+	while (size * 2 * itemSize <= budget)
+		size *= 2;
+	return size;
+}
+
+void FWriteJournal::Init(FSpectrumEmu* pEmu, size_t memoryBudget)
+{
+	// half the budget for writes, a quarter for snapshots & the rest split between PCs, IO reads and call stack changes
+	const uint64_t noWrites = GetRingSize(memoryBudget / 2, sizeof(uint32_t));
+	const uint64_t noPCs = GetRingSize(memoryBudget / 8, sizeof(uint16_t));
+	const uint64_t noIOReads = GetRingSize(memoryBudget / 16, sizeof(uint8_t));
+	const uint64_t noCallStackChanges = GetRingSize(memoryBudget / 16, sizeof(FCallStackChange));
+	const uint64_t noSnapshots = GetRingSize(memoryBudget / 4, sizeof(FWriteJournalSnapshot) + sizeof(FSpectrumMachineState));
+
+	Writes.resize(noWrites);
+	WriteMask = noWrites - 1;
+	IOReads.resize(noIOReads);
+	IOReadMask = noIOReads - 1;
+	CallStackChanges.resize(noCallStackChanges);
+	CallStackChangeMask = noCallStackChanges - 1;
+	PCs.resize(noPCs);
+	PCMask = noPCs - 1;
+	Snapshots.resize(noSnapshots);
+	SnapshotMask = noSnapshots - 1;
+	for (FWriteJournalSnapshot& snapshot : Snapshots)
+		snapshot.pMachineState = new FSpectrumMachineState;
+
+	pSpectrumEmu = pEmu;
+	Reset();
+
+	LOGINFO("Write journal: %d writes, %d instructions, %d IO reads, %d call stack changes, %d snapshots", (int)noWrites, (int)noPCs, (int)noIOReads, (int)noCallStackChanges, (int)noSnapshots);
+}
+
+void FWriteJournal::Shutdown()
+{
+	for (FWriteJournalSnapshot& snapshot : Snapshots)
+		delete snapshot.pMachineState;
+	Snapshots.clear();
+	Writes.clear();
+	IOReads.clear();
+	CallStackChanges.clear();
+	PCs.clear();
+	pSpectrumEmu = nullptr;
+}
+
+void FWriteJournal::Reset()
+{
+	if (pSpectrumEmu == nullptr)
+		return;
+
+	ReplayRemaining = 0;
+	ResetInstructionNo = InstructionNo;
+	ExecStartInstructionNo = InstructionNo;
+	TakeSnapshot(pSpectrumEmu->ZXEmuState.cpu.pins);
+	OldestSnapshotNo = SnapshotNo - 1;
+}
+
+void FWriteJournal::TakeSnapshot(uint64_t pins)
+{
+	const zx_t& zx = pSpectrumEmu->ZXEmuState;
+	FWriteJournalSnapshot& snapshot = Snapshots[SnapshotNo & SnapshotMask];
+	SnapshotNo++;
+
+	snapshot.InstructionNo = InstructionNo;
+	snapshot.WriteNo = WriteNo;
+	snapshot.IOReadNo = IOReadNo;
+	snapshot.CallStackChangeNo = CallStackChangeNo;
+	snapshot.ProfilerStackChangeNo = pSpectrumEmu->Profiler.GetStackChangeNo();
+	pSpectrumEmu->GetMachineState(*snapshot.pMachineState);
+
+	// match the state exec continues with after the trap - the INT pin is cleared & a pending EI takes effect
+	z80_t cpu;
+	cpu.im_ir_pc_bits = snapshot.pMachineState->CPURegs[3];
+	if (z80_ei_pending(&cpu))
+	{
+		z80_set_ei_pending(&cpu, false);
+		z80_set_iff1(&cpu, true);
+		z80_set_iff2(&cpu, true);
+	}
+	snapshot.pMachineState->CPURegs[3] = cpu.im_ir_pc_bits;
+	snapshot.pMachineState->CPURegs[4] = pins & ~Z80_INT;	// pins are only written back at the end of exec
+	snapshot.TickCount = zx.tick_count;
+	snapshot.ScanlineCounter = zx.scanline_counter;
+	snapshot.ScanlineY = zx.scanline_y;
+	snapshot.NoScreenPixWrites = (int)pSpectrumEmu->FrameScreenPixWrites.size();
+	snapshot.NoScreenAttrWrites = (int)pSpectrumEmu->FrameScreenAttrWrites.size();
+
+	UpdateOldestSnapshot();
+}
+
+bool FWriteJournal::IsSnapshotValid(const FWriteJournalSnapshot& snapshot) const
+{
+	// everything journaled after the snapshot must still be in the rings
+	return snapshot.InstructionNo >= ResetInstructionNo &&
+		snapshot.WriteNo + Writes.size() >= WriteNo &&
+		snapshot.IOReadNo + IOReads.size() >= IOReadNo &&
+		snapshot.CallStackChangeNo + CallStackChanges.size() >= CallStackChangeNo &&
+		pSpectrumEmu->Profiler.CanRewindStack(snapshot.ProfilerStackChangeNo);
+}
+
+// Snapshots only become invalid as the rings wrap so the oldest valid one only moves forward
+void FWriteJournal::UpdateOldestSnapshot()
+{
+	const uint64_t firstSnapshotNo = SnapshotNo > Snapshots.size() ? SnapshotNo - Snapshots.size() : 0;
+	if (OldestSnapshotNo < firstSnapshotNo)
+		OldestSnapshotNo = firstSnapshotNo;
+	while (OldestSnapshotNo < SnapshotNo && IsSnapshotValid(Snapshots[OldestSnapshotNo & SnapshotMask]) == false)
+		OldestSnapshotNo++;
+}
+
+uint64_t FWriteJournal::GetOldestInstructionNo() const
+{
+	if (OldestSnapshotNo >= SnapshotNo)
+		return InstructionNo;
+
+	// also need PCs to step over
+	const uint64_t oldestSnapshot = Snapshots[OldestSnapshotNo & SnapshotMask].InstructionNo;
+	const uint64_t oldestPC = InstructionNo > PCs.size() ? InstructionNo - PCs.size() : 0;
+	return oldestSnapshot > oldestPC ? oldestSnapshot : oldestPC;
+}
+
+bool FWriteJournal::StepBackTo(uint64_t targetInstructionNo)
+{
+	if (pSpectrumEmu == nullptr || targetInstructionNo >= InstructionNo || targetInstructionNo < GetOldestInstructionNo())
+		return false;
+
+	// find the latest snapshot at or before the target
+	uint64_t snapshotNo = SnapshotNo;
+	while (snapshotNo > OldestSnapshotNo && Snapshots[(snapshotNo - 1) & SnapshotMask].InstructionNo > targetInstructionNo)
+		snapshotNo--;
+
+	if (snapshotNo <= OldestSnapshotNo)
+		return false;
+
+	const FWriteJournalSnapshot& snapshot = Snapshots[(snapshotNo - 1) & SnapshotMask];
+	if (IsSnapshotValid(snapshot) == false)
+		return false;
+
+	// undo writes, newest first
+	zx_t& zx = pSpectrumEmu->ZXEmuState;
+	uint8_t* pRAM = &zx.ram[0][0];
+	while (WriteNo > snapshot.WriteNo)
+	{
+		WriteNo--;
+		const uint32_t write = Writes[WriteNo & WriteMask];
+		pRAM[write >> 8] = (uint8_t)write;
+	}
+
+	// undo call stack changes, the replay applies them again
+	std::vector<FCPUFunctionCall>& callStack = pSpectrumEmu->CodeAnalysis.CallStack;
+	while (CallStackChangeNo > snapshot.CallStackChangeNo)
+	{
+		const FCallStackChange& change = CallStackChanges[--CallStackChangeNo & CallStackChangeMask];
+		callStack.resize(change.OldDepth);
+		if (change.OldDepth != 0)
+			callStack.back() = change.OldTop;
+	}
+	pSpectrumEmu->Profiler.RewindStack(snapshot.ProfilerStackChangeNo);
+
+	pSpectrumEmu->SetMachineState(*snapshot.pMachineState);
+	zx.tick_count = snapshot.TickCount;
+	zx.scanline_counter = snapshot.ScanlineCounter;
+	zx.scanline_y = snapshot.ScanlineY;
+	InvalidateAllDecodedInstructions(pSpectrumEmu->CodeAnalysis);
+
+	// the trap takes the pc of the instruction just executed from the PC history so that has to be rewound too
+	const uint64_t oldestPC = InstructionNo > PCs.size() ? InstructionNo - PCs.size() : 0;
+	for (int i = 0; i < FSpectrumEmu::kPCHistorySize && snapshot.InstructionNo >= oldestPC + i; i++)
+	{
+		const int historyPos = (pSpectrumEmu->PCHistoryPos - i + FSpectrumEmu::kPCHistorySize) % FSpectrumEmu::kPCHistorySize;
+		pSpectrumEmu->PCHistory[historyPos] = GetInstructionPC(snapshot.InstructionNo - i);
+	}
+
+	// trim this exec's trace & screen writes to match, if the snapshot is from an earlier exec the replayed instructions start them again
+	std::vector<uint16_t>& frameTrace = pSpectrumEmu->CodeAnalysis.FrameTrace;
+	if (snapshot.InstructionNo > ExecStartInstructionNo)
+	{
+		frameTrace.resize(snapshot.InstructionNo - ExecStartInstructionNo);
+		if (snapshot.NoScreenPixWrites < (int)pSpectrumEmu->FrameScreenPixWrites.size())
+			pSpectrumEmu->FrameScreenPixWrites.resize(snapshot.NoScreenPixWrites);
+		if (snapshot.NoScreenAttrWrites < (int)pSpectrumEmu->FrameScreenAttrWrites.size())
+			pSpectrumEmu->FrameScreenAttrWrites.resize(snapshot.NoScreenAttrWrites);
+	}
+	else
+	{
+		ExecStartInstructionNo = snapshot.InstructionNo;
+		frameTrace.clear();
+		pSpectrumEmu->FrameScreenPixWrites.clear();
+		pSpectrumEmu->FrameScreenAttrWrites.clear();
+	}
+
+	InstructionNo = snapshot.InstructionNo;
+	IOReadNo = snapshot.IOReadNo;
+	SnapshotNo = snapshotNo;
+
+	// run forward to the target, the trap stops exec when it is reached
+	ReplayRemaining = targetInstructionNo - snapshot.InstructionNo;
+	pSpectrumEmu->Profiler.BeginExec();
+	pSpectrumEmu->UpdateTrapRegisterFlush();
+	while (ReplayRemaining != 0)
+		z80_exec(&zx.cpu, 0x7FFFFFFF);
+	zx.cpu.trap_id = 0;
+
+	return true;
+}
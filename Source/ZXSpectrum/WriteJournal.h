@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CodeAnalyser/CodeAnaysisPage.h"
+
+class FSpectrumEmu;
+struct FSpectrumMachineState;
+
+// Machine state at an instruction boundary - taken every kSnapshotInterval instructions
+struct FWriteJournalSnapshot
+{
+	uint64_t				InstructionNo = 0;
+	uint64_t				WriteNo = 0;
+	uint64_t				IOReadNo = 0;
+	uint64_t				CallStackChangeNo = 0;
+	uint64_t				ProfilerStackChangeNo = 0;
+	FSpectrumMachineState*	pMachineState = nullptr;
+	uint32_t				TickCount = 0;
+	int						ScanlineCounter = 0;
+	int						ScanlineY = 0;
+	int						NoScreenPixWrites = 0;
+	int						NoScreenAttrWrites = 0;
+};
+
+// The analyser call stack's depth & top entry before an instruction that changed it
+// An instruction pops at most one entry so this is enough to undo it
+struct FCallStackChange
+{
+	uint32_t			OldDepth = 0;
+	FCPUFunctionCall	OldTop;
+};
+
+// Journal of RAM writes for stepping backwards through execution
+// Every write stores its RAM offset & the value it overwrote, packed into 32 bits
+// Stepping back undoes writes to the nearest snapshot before the target then replays forward to it
+// IO reads are journaled too so the replay sees the same input, and call stack changes so they aren't applied twice
+// All storage is allocated up front in fixed size rings so recording never allocates
+class FWriteJournal
+{
+public:
+	static const int	kSnapshotInterval = 256;	// instructions - must be a power of 2
+	static const size_t	kDefaultMemoryBudget = 16 * 1024 * 1024;
+
+	void	Init(FSpectrumEmu* pEmu, size_t memoryBudget);
+	void	Shutdown();
+	void	Reset();	// call when the machine state is changed outside of emulation
+	void	BeginExec() { ExecStartInstructionNo = InstructionNo; }	// call before each exec - the frame trace starts here
+	bool	IsEnabled() const { return pSpectrumEmu != nullptr; }
+
+	// called from the tick for each RAM write, before the write happens
+	void	RecordWrite(uint32_t ramOffset, uint8_t oldValue)
+	{
+		Writes[WriteNo & WriteMask] = (ramOffset << 8) | oldValue;
+		WriteNo++;
+	}
+
+	// called from the tick for each IO read, when replaying the recorded value is returned instead
+	uint8_t	RecordIORead(uint8_t value)
+	{
+		uint8_t& ioRead = IOReads[IOReadNo & IOReadMask];
+		IOReadNo++;
+		if (ReplayRemaining != 0)
+			return ioRead;
+		ioRead = value;
+		return value;
+	}
+
+	// called from the trap when an instruction changed the analyser call stack
+	void	RecordCallStackChange(size_t oldDepth, const FCPUFunctionCall& oldTop)
+	{
+		FCallStackChange& change = CallStackChanges[CallStackChangeNo & CallStackChangeMask];
+		change.OldDepth = (uint32_t)oldDepth;
+		change.OldTop = oldTop;
+		CallStackChangeNo++;
+	}
+
+	// called from the trap after each instruction, returns true if replaying has reached its target
+	bool	RecordInstruction(uint16_t pc, uint64_t pins)
+	{
+		PCs[InstructionNo & PCMask] = pc;
+		InstructionNo++;
+		if ((InstructionNo & (kSnapshotInterval - 1)) == 0)
+			TakeSnapshot(pins);
+		return ReplayRemaining != 0 && --ReplayRemaining == 0;
+	}
+
+	bool		IsReplaying() const { return ReplayRemaining != 0; }
+	bool		IsSnapshotDue() const { return IsEnabled() && ((InstructionNo + 1) & (kSnapshotInterval - 1)) == 0; }	// the next instruction's trap takes a snapshot
+	uint64_t	GetInstructionNo() const { return InstructionNo; }
+	uint64_t	GetOldestInstructionNo() const;	// up to kSnapshotInterval instructions out of date
+	uint16_t	GetInstructionPC(uint64_t instructionNo) const { return PCs[instructionNo & PCMask]; }
+
+	// rewind so the next instruction to execute is instructionNo
+	bool	StepBackTo(uint64_t instructionNo);
+
+private:
+	void	TakeSnapshot(uint64_t pins);
+	bool	IsSnapshotValid(const FWriteJournalSnapshot& snapshot) const;
+	void	UpdateOldestSnapshot();
+
+	FSpectrumEmu*	pSpectrumEmu = nullptr;
+
+	std::vector<uint32_t>	Writes;	// RAM offset << 8 | old value
+	uint64_t				WriteMask = 0;
+	uint64_t				WriteNo = 0;
+
+	std::vector<uint8_t>	IOReads;	// value of each IO read
+	uint64_t				IOReadMask = 0;
+	uint64_t				IOReadNo = 0;
+
+	std::vector<FCallStackChange>	CallStackChanges;
+	uint64_t				CallStackChangeMask = 0;
+	uint64_t				CallStackChangeNo = 0;
+
+	std::vector<uint16_t>	PCs;	// PC of each executed instruction
+	uint64_t				PCMask = 0;
+	uint64_t				InstructionNo = 0;
+
+	std::vector<FWriteJournalSnapshot>	Snapshots;
+	uint64_t				SnapshotMask = 0;
+	uint64_t				SnapshotNo = 0;
+	uint64_t				OldestSnapshotNo = 0;	// oldest snapshot that can be stepped back to
+
+	uint64_t				ResetInstructionNo = 0;	// can't step back past a reset
+	uint64_t				ExecStartInstructionNo = 0;
+	uint64_t				ReplayRemaining = 0;
+};